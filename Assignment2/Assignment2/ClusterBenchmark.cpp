@@ -0,0 +1,163 @@
+//***************************************************************************************
+// ClusterBenchmark.cpp
+//
+// Headless console benchmark for Common/ClusteredLights.h.  Build it as its own console
+// project with Common/ClusteredLights.cpp, Common/Culling.cpp and Common/MathHelper.cpp.
+//
+// It scatters 1000 and then 10000 lights, three point lights to every spot light, over
+// a 400x400 town at roof height and circles the camera around it.  For each count it
+// prints the average time of a Build on the calling thread and on the PPL workers,
+// how full the clusters got and how large the two structured buffers would be.
+//
+// The first frame of each count is checked against a plain test of every light's
+// sphere against every cluster's box; any difference is printed as a mismatch.
+//***************************************************************************************
+
+#include <windows.h>
+#include <iostream>
+#include <iomanip>
+#include "../../Common/ClusteredLights.h"
+
+using namespace std;
+using namespace DirectX;
+
+double Milliseconds(const LARGE_INTEGER& start, const LARGE_INTEGER& end)
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+
+	return 1000.0 * (double)(end.QuadPart - start.QuadPart) / (double)frequency.QuadPart;
+}
+
+bool SphereHitsBox(const BoundingSphere& sphere, const BoundingBox& box)
+{
+	float d = 0.0f;
+	float distSq = 0.0f;
+
+	d = MathHelper::Max(fabsf(sphere.Center.x - box.Center.x) - box.Extents.x, 0.0f);
+	distSq += d*d;
+	d = MathHelper::Max(fabsf(sphere.Center.y - box.Center.y) - box.Extents.y, 0.0f);
+	distSq += d*d;
+	d = MathHelper::Max(fabsf(sphere.Center.z - box.Center.z) - box.Extents.z, 0.0f);
+	distSq += d*d;
+
+	return distSq <= sphere.Radius*sphere.Radius;
+}
+
+// Number of (cluster, light) pairs the builder got wrong.
+UINT CountMismatches(const ClusteredLights& clusters, UINT lightCount)
+{
+	const vector<ClusterRange>& ranges = clusters.GetRanges();
+	const vector<UINT>& indices = clusters.GetLightIndices();
+
+	vector<bool> listed(lightCount);
+
+	UINT mismatches = 0;
+	for(UINT cluster = 0; cluster < clusters.ClusterCount(); ++cluster)
+	{
+		fill(listed.begin(), listed.end(), false);
+
+		const ClusterRange& range = ranges[cluster];
+		for(UINT i = 0; i < range.Count; ++i)
+			listed[indices[range.Offset + i]] = true;
+
+		BoundingBox box = clusters.GetClusterBounds(cluster);
+		for(UINT i = 0; i < lightCount; ++i)
+		{
+			if(SphereHitsBox(clusters.GetLightBounds(i), box) != listed[i])
+				mismatches++;
+		}
+	}
+
+	return mismatches;
+}
+
+int main()
+{
+	const float townSize = 400.0f;
+	const UINT frameCount = 200;
+
+	ClusteredLights clusters;
+	clusters.SetGrid(16, 9, 24);
+	clusters.SetLens(0.25f*MathHelper::Pi, 16.0f / 9.0f, 1.0f, 1000.0f);
+
+	cout << clusters.ClusterCount() << " clusters, "
+		<< clusters.TilesX() << "x" << clusters.TilesY() << " tiles by "
+		<< clusters.SliceCount() << " slices" << endl << endl;
+
+	for(UINT lightCount : { 1000u, 10000u })
+	{
+		srand(46);
+
+		// Point lights first, then spot lights, as in the pass constants.
+		UINT pointCount = lightCount*3/4;
+		UINT spotCount = lightCount - pointCount;
+
+		vector<Light> lights(lightCount);
+		for(UINT i = 0; i < lightCount; ++i)
+		{
+			Light& light = lights[i];
+			light.Position = XMFLOAT3(
+				MathHelper::RandF(-0.5f, 0.5f)*townSize,
+				MathHelper::RandF(1.0f, 12.0f),
+				MathHelper::RandF(-0.5f, 0.5f)*townSize);
+			light.FalloffStart = 1.0f;
+			light.FalloffEnd = MathHelper::RandF(4.0f, 20.0f);
+
+			if(i >= pointCount)
+			{
+				XMVECTOR dir = XMVectorSet(MathHelper::RandF(-0.5f, 0.5f), -1.0f, MathHelper::RandF(-0.5f, 0.5f), 0.0f);
+				XMStoreFloat3(&light.Direction, XMVector3Normalize(dir));
+				light.SpotPower = MathHelper::RandF(8.0f, 64.0f);
+			}
+		}
+
+		double serialMs = 0.0;
+		double parallelMs = 0.0;
+		UINT mismatches = 0;
+		ClusterStats stats;
+
+		for(UINT frame = 0; frame < frameCount; ++frame)
+		{
+			// Circle the town looking across it.
+			float angle = 2.0f*MathHelper::Pi*frame / frameCount;
+
+			XMVECTOR eye = XMVectorSet(0.4f*townSize*cosf(angle), 20.0f, 0.4f*townSize*sinf(angle), 1.0f);
+			XMVECTOR look = XMVectorSet(-sinf(angle + 0.3f), -0.2f, cosf(angle + 0.3f), 0.0f);
+			XMMATRIX view = XMMatrixLookToLH(eye, look, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+
+			LARGE_INTEGER start, end;
+
+			clusters.Parallel = false;
+			QueryPerformanceCounter(&start);
+			clusters.Build(lights.data(), pointCount, spotCount, view);
+			QueryPerformanceCounter(&end);
+			serialMs += Milliseconds(start, end);
+
+			clusters.Parallel = true;
+			QueryPerformanceCounter(&start);
+			clusters.Build(lights.data(), pointCount, spotCount, view, &stats);
+			QueryPerformanceCounter(&end);
+			parallelMs += Milliseconds(start, end);
+
+			if(frame == 0)
+				mismatches = CountMismatches(clusters, lightCount);
+		}
+
+		UINT bufferBytes = clusters.ClusterCount()*sizeof(ClusterRange) + stats.IndexCount*sizeof(UINT);
+
+		cout << fixed << setprecision(3)
+			<< lightCount << " lights (" << pointCount << " point, " << spotCount << " spot)" << endl
+			<< "  serial:     " << serialMs / frameCount << " ms per build" << endl
+			<< "  parallel:   " << parallelMs / frameCount << " ms per build" << endl
+			<< "  last frame: " << stats.LightsInView << " lights near the frustum, "
+			<< stats.NonEmptyClusters << " clusters lit, "
+			<< setprecision(1) << (float)stats.IndexCount / MathHelper::Max(stats.NonEmptyClusters, 1u)
+			<< " lights per lit cluster, " << stats.MaxLightsPerCluster << " at most" << endl
+			<< "  buffers:    " << stats.IndexCount << " indices, " << bufferBytes / 1024 << " KB" << endl
+			<< "  mismatches: " << mismatches << endl << endl;
+	}
+
+	system("pause");
+	return 0;
+}
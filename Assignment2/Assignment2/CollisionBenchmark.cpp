@@ -0,0 +1,230 @@
+//***************************************************************************************
+// CollisionBenchmark.cpp
+//
+// Headless console benchmark for Common/CameraController.h.  Build it as its own console
+// project with Common/CameraController.cpp, Common/CollisionQuery.cpp, Common/SceneBvh.cpp,
+// Common/TriangleBvh.cpp, Common/BvhBuild.cpp, Common/RayPacket.cpp, Common/Culling.cpp,
+// Common/Camera.cpp, Common/GeometryGenerator.cpp and Common/MathHelper.cpp.
+//
+// It builds a town from the meshes the app draws, with the same tessellation: box
+// buildings, cylinder towers, cones and spheres on a ground grid.  A camera wanders
+// through it at the app's walking speed, turning at random, so it keeps running into
+// walls and sliding along them.  It prints the average and worst time of a move, and
+// how often and how deep the camera ended up closer to a surface than its radius.
+//
+// First it sweeps a sphere along a single triangle, a wall with open edges, from
+// positions where it already reaches into the wall's plane.  Moving along the wall or
+// away from it must still stop at the edge ahead, and must not stop over the face.
+//***************************************************************************************
+
+#include <windows.h>
+#include <iostream>
+#include <iomanip>
+#include "../../Common/CameraController.h"
+#include "../../Common/GeometryGenerator.h"
+
+using namespace std;
+using namespace DirectX;
+
+double Milliseconds(const LARGE_INTEGER& start, const LARGE_INTEGER& end)
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+
+	return 1000.0 * (double)(end.QuadPart - start.QuadPart) / (double)frequency.QuadPart;
+}
+
+void BuildMesh(TriangleBvh& bvh, const GeometryGenerator::MeshData& mesh)
+{
+	bvh.Build(&mesh.Vertices[0].Position, sizeof(GeometryGenerator::Vertex),
+		mesh.Indices32.data(), (UINT)mesh.Indices32.size() / 3);
+}
+
+// Sweeps against one triangle in the z = 0 plane and checks the hit against the
+// expected T, or that nothing is hit when expectedT is 1.
+bool CheckOpenWallSweep(CollisionQuery& query, const char* name, FXMVECTOR center,
+	FXMVECTOR motion, float expectedT)
+{
+	SweepHit hit;
+	bool found = query.SweepSphere(center, 1.1f, motion, hit);
+	bool ok = expectedT < 1.0f ? found && fabsf(hit.T - expectedT) < 1e-3f : !found;
+
+	cout << "  " << left << setw(28) << name << right << fixed << setprecision(4)
+		<< (found ? "hit at T " : "no hit   ") << (found ? hit.T : 1.0f)
+		<< (ok ? "" : "  WRONG") << endl;
+
+	return ok;
+}
+
+void CheckOpenWall()
+{
+	XMFLOAT3 positions[3] = { { 0.0f, 0.0f, 0.0f }, { 10.0f, 0.0f, 0.0f }, { 0.0f, 10.0f, 0.0f } };
+	std::uint32_t indices[3] = { 0, 1, 2 };
+
+	TriangleBvh wall;
+	wall.Build(positions, sizeof(XMFLOAT3), indices, 1);
+
+	SceneBvh scene;
+	scene.AddInstance(&wall, XMMatrixIdentity());
+	scene.Build();
+
+	CollisionQuery query;
+	query.SetScene(&scene);
+
+	// The center is 0.5 off the plane with a radius of 1.1, left of the edge
+	// along the y axis.  The sphere reaches the edge when 0.5^2 + x^2 = 1.1^2.
+	// Moving away as well, (5t - 3)^2 + (0.5 + 0.2t)^2 = 1.1^2 gives the first t.
+	float edgeX = sqrtf(1.1f*1.1f - 0.5f*0.5f);
+	float qa = 25.04f, qb = -29.8f, qc = 9.25f - 1.21f;
+	float awayT = (-qb - sqrtf(qb*qb - 4.0f*qa*qc)) / (2.0f*qa);
+
+	cout << "open wall, sphere radius 1.1 reaching into its plane:" << endl;
+	bool ok = CheckOpenWallSweep(query, "along the wall to the edge", XMVectorSet(-3.0f, 2.0f, 0.5f, 1.0f),
+		XMVectorSet(5.0f, 0.0f, 0.0f, 0.0f), (3.0f - edgeX) / 5.0f);
+	ok &= CheckOpenWallSweep(query, "away from it to the edge", XMVectorSet(-3.0f, 2.0f, 0.5f, 1.0f),
+		XMVectorSet(5.0f, 0.0f, 0.2f, 0.0f), awayT);
+	ok &= CheckOpenWallSweep(query, "along the face", XMVectorSet(2.0f, 2.0f, 0.5f, 1.0f),
+		XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f), 1.0f);
+	cout << (ok ? "  ok" : "  FAILED") << endl << endl;
+}
+
+int main()
+{
+	const int blockCount = 10;
+	const float blockSize = 12.0f;
+	const float cameraSpeed = 10.0f;
+	const float dt = 1.0f / 60.0f;
+	const UINT frameCount = 6000;
+
+	CheckOpenWall();
+
+	srand(2020);
+
+	GeometryGenerator geoGen;
+	TriangleBvh box, grid, sphere, cylinder, cone;
+	BuildMesh(box, geoGen.CreateBox(1.0f, 1.0f, 1.0f, 0));
+	BuildMesh(grid, geoGen.CreateGrid(10.0f, 10.0f, 10, 10));
+	BuildMesh(sphere, geoGen.CreateSphere(0.5f, 20, 20));
+	BuildMesh(cylinder, geoGen.CreateCylinder(0.5f, 0.5f, 3.0f, 20, 20));
+	BuildMesh(cone, geoGen.CreateCone(1.0f, 1.0f, 40, 6));
+
+	SceneBvh scene;
+
+	float townSize = blockCount*blockSize;
+	scene.AddInstance(&grid, XMMatrixScaling(townSize / 10.0f, 1.0f, townSize / 10.0f));
+
+	for(int i = 0; i < blockCount; ++i)
+	{
+		for(int j = 0; j < blockCount; ++j)
+		{
+			float x = (i - blockCount / 2 + 0.5f)*blockSize;
+			float z = (j - blockCount / 2 + 0.5f)*blockSize;
+
+			// A building with a tower on two corners, a cone roof and a sphere on
+			// the street, all turned a little.
+			float width = MathHelper::RandF(4.0f, 7.0f);
+			float height = MathHelper::RandF(4.0f, 15.0f);
+			XMMATRIX turn = XMMatrixRotationY(MathHelper::RandF(-0.3f, 0.3f));
+
+			scene.AddInstance(&box, XMMatrixScaling(width, height, width) * turn *
+				XMMatrixTranslation(x, 0.5f*height, z));
+
+			for(float corner : { -0.5f, 0.5f })
+			{
+				XMVECTOR offset = XMVector3TransformNormal(XMVectorSet(corner*width, 0.0f, corner*width, 0.0f), turn);
+				scene.AddInstance(&cylinder, XMMatrixScaling(1.5f, height / 2.5f, 1.5f) *
+					XMMatrixTranslation(x + XMVectorGetX(offset), 0.6f*height, z + XMVectorGetZ(offset)));
+			}
+
+			scene.AddInstance(&cone, XMMatrixScaling(0.7f*width, 3.0f, 0.7f*width) *
+				XMMatrixTranslation(x, height + 1.5f, z));
+
+			scene.AddInstance(&sphere, XMMatrixScaling(2.0f, 2.0f, 2.0f) *
+				XMMatrixTranslation(x + 0.5f*blockSize, 1.0f, z + MathHelper::RandF(-0.4f, 0.4f)*blockSize));
+		}
+	}
+
+	scene.Build();
+
+	CollisionQuery query;
+	query.SetScene(&scene);
+
+	CameraController controller;
+	controller.Radius = 1.1f;
+
+	Camera camera;
+	camera.SetPosition(0.5f*blockSize, 3.0f, 0.0f);
+
+	cout << scene.InstanceCount() << " instances, camera radius " << controller.Radius << endl << endl;
+	cout << "frame   sweeps   contacts   triangles   ms" << endl;
+
+	double totalMs = 0.0;
+	double worstMs = 0.0;
+	UINT64 totalContacts = 0;
+	UINT64 totalTriangles = 0;
+	UINT penetrations = 0;
+	float deepest = 0.0f;
+
+	float yaw = 0.0f;
+	for(UINT frame = 0; frame < frameCount; ++frame)
+	{
+		// Wander, mostly level but now and then up or down, turning around
+		// before leaving the town.
+		XMFLOAT3 p = camera.GetPosition3f();
+		if(fabsf(p.x) > 0.5f*townSize || fabsf(p.z) > 0.5f*townSize)
+			yaw = atan2f(-p.x, -p.z);
+		yaw += MathHelper::RandF(-0.05f, 0.05f);
+		float climb = p.y > 12.0f ? -0.3f : 0.3f*sinf(0.005f*frame);
+		XMVECTOR motion = cameraSpeed*dt*XMVector3Normalize(XMVectorSet(sinf(yaw), climb, cosf(yaw), 0.0f));
+
+		CameraMoveStats stats;
+		LARGE_INTEGER start, end;
+
+		QueryPerformanceCounter(&start);
+		controller.Move(camera, motion, query, &stats);
+		QueryPerformanceCounter(&end);
+
+		double ms = Milliseconds(start, end);
+		totalMs += ms;
+		worstMs = MathHelper::Max(worstMs, ms);
+		totalContacts += stats.Contacts;
+		totalTriangles += stats.Triangles;
+
+		// How far the sphere ended up inside a surface, if at all.
+		XMVECTOR position = camera.GetPosition();
+		if(query.OverlapCapsule(position, position, 0.999f*controller.Radius))
+		{
+			float inside = 0.0f;
+			float outside = controller.Radius;
+			for(int i = 0; i < 20; ++i)
+			{
+				float radius = 0.5f*(inside + outside);
+				if(query.OverlapCapsule(position, position, radius))
+					outside = radius;
+				else
+					inside = radius;
+			}
+
+			penetrations++;
+			deepest = MathHelper::Max(deepest, controller.Radius - outside);
+		}
+
+		if(frame % 300 == 0)
+		{
+			cout << setw(5) << frame << setw(9) << stats.Sweeps << setw(11) << stats.Contacts
+				<< setw(12) << stats.Triangles << setw(9) << fixed << setprecision(4) << ms << endl;
+		}
+	}
+
+	cout << endl << fixed << setprecision(4)
+		<< "move:         " << totalMs / frameCount << " ms/frame average, "
+		<< worstMs << " ms worst" << endl
+		<< setprecision(2)
+		<< "contacts:     " << totalContacts / (double)frameCount << " per frame" << endl
+		<< "triangles:    " << totalTriangles / (double)frameCount << " gathered per frame" << endl
+		<< "penetrations: " << penetrations << " of " << frameCount << " frames, "
+		<< setprecision(4) << deepest << " deepest" << endl;
+
+	system("pause");
+	return 0;
+}
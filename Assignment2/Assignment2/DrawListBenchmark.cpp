@@ -0,0 +1,271 @@
+//***************************************************************************************
+// DrawListBenchmark.cpp
+//
+// Headless console benchmark for Common/DrawList.h.  Build it as its own console
+// project with Common/DrawList.cpp.
+//
+// It makes the draws of two scenes, in TreeBillboardsApp's layers:
+//   -"assignment 2": 57 draws like the app's: the ground, the water, 6 tree sprites and
+//    49 opaque building blocks over a handful of geometries and 20 materials.
+//   -"synthetic": 100000 draws, mostly opaque with some alpha tested and transparent,
+//    over 32 geometries and 256 materials.
+// Each frame the draws get a new view depth and are keyed and sorted, once with
+// DrawList::Sort and once with std::stable_sort.  The average time of both is printed
+// and the two orders have to match.  The sorted transparent draws have to come back to
+// front, up to the precision the keys keep of the depth.
+//
+// It also counts the bindings a frame makes.  The old DrawRenderItems walked each layer
+// in item order and bound the buffers, topology and material of every draw; the sorted
+// list only binds what differs from the previous draw.  Last, it counts the draw calls
+// left once each run of sorted draws with the same layer, material and submesh is
+// drawn instanced.
+//***************************************************************************************
+
+#include <windows.h>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <random>
+#include "../../Common/DrawList.h"
+
+using namespace std;
+
+double Milliseconds(const LARGE_INTEGER& start, const LARGE_INTEGER& end)
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+
+	return 1000.0 * (double)(end.QuadPart - start.QuadPart) / (double)frequency.QuadPart;
+}
+
+enum class RenderLayer : int
+{
+	Opaque = 0,
+	Transparent,
+	AlphaTested,
+	AlphaTestedTreeSprites,
+	Count
+};
+
+// As in TreeBillboardsApp.
+const UINT gLayerDrawOrder[(int)RenderLayer::Count] = { 0, 3, 1, 2 };
+
+// The state one draw binds.  Geometry numbers the submesh, as TreeBillboardsApp
+// does.
+struct Draw
+{
+	UINT Layer;
+	UINT Material;
+	UINT Geometry;
+	D3D12_PRIMITIVE_TOPOLOGY PrimitiveType;
+	float Depth;
+};
+
+struct Scene
+{
+	const char* Name;
+	UINT Opaque;
+	UINT AlphaTested;
+	UINT TreeSprites;
+	UINT Transparent;
+	UINT GeometryCount;
+	UINT MaterialCount;
+	UINT FrameCount;
+};
+
+// The depth as precisely as the keys keep it.
+float KeyDepth(float depth)
+{
+	UINT bits;
+	memcpy(&bits, &depth, sizeof(bits));
+	bits &= ~((1u << (31 - DrawList::DepthBits)) - 1);
+	memcpy(&depth, &bits, sizeof(depth));
+
+	return depth;
+}
+
+UINT64 KeyOf(const Draw& draw)
+{
+	UINT layer = gLayerDrawOrder[draw.Layer];
+
+	return draw.Layer == (UINT)RenderLayer::Transparent ?
+		DrawList::MakeBlendedKey(layer, draw.Layer, draw.Material, draw.Geometry, draw.Depth) :
+		DrawList::MakeKey(layer, draw.Layer, draw.Material, draw.Geometry, draw.Depth);
+}
+
+// Bindings made when the draws come in the given order: PSO, vertex and index
+// buffers, topology, descriptor table and material constants, each only when it
+// differs from the previous draw's unless bindAll.
+UINT CountBindings(const vector<Draw>& draws, const UINT* order, UINT count, bool bindAll)
+{
+	UINT bindings = 0;
+	UINT layer = (UINT)-1;
+	UINT geometry = (UINT)-1;
+	UINT material = (UINT)-1;
+	D3D12_PRIMITIVE_TOPOLOGY primitiveType = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+
+	for(UINT i = 0; i < count; ++i)
+	{
+		const Draw& draw = draws[order[i]];
+
+		if(draw.Layer != layer)
+			bindings++;
+		if(bindAll || draw.Geometry != geometry)
+			bindings += 2;
+		if(bindAll || draw.PrimitiveType != primitiveType)
+			bindings++;
+		if(bindAll || draw.Material != material)
+			bindings += 2;
+
+		layer = draw.Layer;
+		geometry = draw.Geometry;
+		material = draw.Material;
+		primitiveType = draw.PrimitiveType;
+	}
+
+	return bindings;
+}
+
+// Draw calls left when the runs of draws that share layer, material and
+// geometry are drawn as instances.
+UINT CountInstancedDraws(const vector<Draw>& draws, const UINT* order, UINT count)
+{
+	UINT drawCalls = 0;
+
+	for(UINT i = 0; i < count; ++i)
+	{
+		const Draw& draw = draws[order[i]];
+
+		if(i == 0)
+		{
+			drawCalls++;
+			continue;
+		}
+
+		const Draw& previous = draws[order[i - 1]];
+		if(draw.Layer != previous.Layer || draw.Material != previous.Material ||
+			draw.Geometry != previous.Geometry)
+			drawCalls++;
+	}
+
+	return drawCalls;
+}
+
+int main()
+{
+	const Scene scenes[] =
+	{
+		{ "assignment 2", 50, 0, 6, 1, 4, 20, 200000 },
+		{ "synthetic", 90000, 6000, 0, 4000, 32, 256, 200 },
+	};
+
+	for(const Scene& scene : scenes)
+	{
+		mt19937 random(49);
+
+		vector<Draw> draws;
+		auto addDraws = [&](UINT count, RenderLayer layer)
+		{
+			for(UINT i = 0; i < count; ++i)
+			{
+				Draw draw;
+				draw.Layer = (UINT)layer;
+				draw.Material = random() % scene.MaterialCount;
+				draw.Geometry = random() % scene.GeometryCount;
+				draw.PrimitiveType = layer == RenderLayer::AlphaTestedTreeSprites ?
+					D3D_PRIMITIVE_TOPOLOGY_POINTLIST : D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+				draw.Depth = 0.0f;
+				draws.push_back(draw);
+			}
+		};
+
+		addDraws(scene.Opaque, RenderLayer::Opaque);
+		addDraws(scene.AlphaTested, RenderLayer::AlphaTested);
+		addDraws(scene.TreeSprites, RenderLayer::AlphaTestedTreeSprites);
+		addDraws(scene.Transparent, RenderLayer::Transparent);
+
+		// The items were added in the order the scene was built, not by layer.
+		shuffle(draws.begin(), draws.end(), random);
+
+		UINT drawCount = (UINT)draws.size();
+		uniform_real_distribution<float> depths(0.5f, 500.0f);
+
+		DrawList drawList;
+		drawList.Reserve(drawCount);
+		vector<pair<UINT64, UINT>> pairs;
+		pairs.reserve(drawCount);
+
+		double radixMs = 0.0;
+		double stdMs = 0.0;
+		bool ordersMatch = true;
+		bool backToFront = true;
+
+		for(UINT frame = 0; frame < scene.FrameCount; ++frame)
+		{
+			for(Draw& draw : draws)
+				draw.Depth = depths(random);
+
+			LARGE_INTEGER start, end;
+
+			QueryPerformanceCounter(&start);
+			drawList.Clear();
+			for(UINT i = 0; i < drawCount; ++i)
+				drawList.Add(KeyOf(draws[i]), i);
+			drawList.Sort();
+			QueryPerformanceCounter(&end);
+			radixMs += Milliseconds(start, end);
+
+			QueryPerformanceCounter(&start);
+			pairs.clear();
+			for(UINT i = 0; i < drawCount; ++i)
+				pairs.push_back(make_pair(KeyOf(draws[i]), i));
+			stable_sort(pairs.begin(), pairs.end(),
+				[](const pair<UINT64, UINT>& a, const pair<UINT64, UINT>& b) { return a.first < b.first; });
+			QueryPerformanceCounter(&end);
+			stdMs += Milliseconds(start, end);
+
+			const UINT* items = drawList.Items();
+			for(UINT i = 0; i < drawCount; ++i)
+			{
+				ordersMatch &= items[i] == pairs[i].second;
+
+				if(i > 0 && draws[items[i]].Layer == (UINT)RenderLayer::Transparent &&
+					draws[items[i - 1]].Layer == (UINT)RenderLayer::Transparent)
+					backToFront &= KeyDepth(draws[items[i]].Depth) <= KeyDepth(draws[items[i - 1]].Depth);
+			}
+		}
+
+		// The old order: layer by layer in the order Draw set the PSOs, each in
+		// item order.
+		vector<UINT> layerOrder;
+		for(RenderLayer layer : { RenderLayer::Opaque, RenderLayer::AlphaTested,
+			RenderLayer::AlphaTestedTreeSprites, RenderLayer::Transparent })
+		{
+			for(UINT i = 0; i < drawCount; ++i)
+			{
+				if(draws[i].Layer == (UINT)layer)
+					layerOrder.push_back(i);
+			}
+		}
+
+		UINT oldBindings = CountBindings(draws, layerOrder.data(), drawCount, true);
+		UINT sortedBindings = CountBindings(draws, drawList.Items(), drawCount, false);
+		UINT instancedDraws = CountInstancedDraws(draws, drawList.Items(), drawCount);
+
+		cout << fixed << setprecision(4)
+			<< scene.Name << ": " << drawCount << " draws, " << scene.GeometryCount << " geometries, "
+			<< scene.MaterialCount << " materials, " << scene.FrameCount << " frames" << endl
+			<< "  DrawList::Sort:    " << radixMs / scene.FrameCount << " ms" << endl
+			<< "  std::stable_sort:  " << stdMs / scene.FrameCount << " ms" << endl
+			<< setprecision(2)
+			<< "  speedup:           " << stdMs / radixMs << "x" << endl
+			<< "  bindings:          " << oldBindings << " by layer, " << sortedBindings << " sorted, "
+			<< oldBindings - sortedBindings << " skipped" << endl
+			<< "  instanced:         " << instancedDraws << " draw calls for " << drawCount << " draws" << endl
+			<< "  orders " << (ordersMatch ? "match" : "DIFFER")
+			<< ", transparent draws " << (backToFront ? "back to front" : "OUT OF ORDER") << endl << endl;
+	}
+
+	system("pause");
+	return 0;
+}
@@ -9,7 +9,8 @@ FrameResource::FrameResource(ID3D12Device* device, UINT passCount, UINT objectCo
   //  FrameCB = std::make_unique<UploadBuffer<FrameConstants>>(device, 1, true);
     PassCB = std::make_unique<UploadBuffer<PassConstants>>(device, passCount, true);
     MaterialCB = std::make_unique<UploadBuffer<MaterialConstants>>(device, materialCount, true);
-    ObjectCB = std::make_unique<UploadBuffer<ObjectConstants>>(device, objectCount, true);
+    ObjectBuffer = std::make_unique<UploadBuffer<ObjectConstants>>(device, objectCount, false);
+    InstanceBuffer = std::make_unique<UploadBuffer<UINT>>(device, objectCount, false);
 
     WavesVB = std::make_unique<UploadBuffer<Vertex>>(device, waveVertCount, false);
 }
@@ -23,7 +24,8 @@ FrameResource::FrameResource(ID3D12Device* device, UINT passCount, UINT objectCo
 	//  FrameCB = std::make_unique<UploadBuffer<FrameConstants>>(device, 1, true);
 	PassCB = std::make_unique<UploadBuffer<PassConstants>>(device, passCount, true);
 	MaterialCB = std::make_unique<UploadBuffer<MaterialConstants>>(device, materialCount, true);
-	ObjectCB = std::make_unique<UploadBuffer<ObjectConstants>>(device, objectCount, true);
+	ObjectBuffer = std::make_unique<UploadBuffer<ObjectConstants>>(device, objectCount, false);
+	InstanceBuffer = std::make_unique<UploadBuffer<UINT>>(device, objectCount, false);
 
 }
 
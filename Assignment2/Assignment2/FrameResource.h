@@ -69,7 +69,11 @@ public:
    // std::unique_ptr<UploadBuffer<FrameConstants>> FrameCB = nullptr;
     std::unique_ptr<UploadBuffer<PassConstants>> PassCB = nullptr;
     std::unique_ptr<UploadBuffer<MaterialConstants>> MaterialCB = nullptr;
-    std::unique_ptr<UploadBuffer<ObjectConstants>> ObjectCB = nullptr;
+
+    // The objects by render item handle, and the handles of each frame's draws
+    // in draw order; both structured buffers the vertex shaders index.
+    std::unique_ptr<UploadBuffer<ObjectConstants>> ObjectBuffer = nullptr;
+    std::unique_ptr<UploadBuffer<UINT>> InstanceBuffer = nullptr;
 
     // We cannot update a dynamic vertex buffer until the GPU is done processing
     // the commands that reference it.  So each frame needs their own.
@@ -0,0 +1,131 @@
+//***************************************************************************************
+// OcclusionBenchmark.cpp
+//
+// Headless console benchmark for Common/OcclusionCuller.h.  Build it as its own console
+// project with Common/OcclusionCuller.cpp and Common/MathHelper.cpp.
+//
+// It lays out a city of 16x16 blocks, each a large building used as an occluder with
+// smaller props around it, and walks the camera down a street at eye height while it
+// looks around.  Every 30 frames it prints how many props were visible, occluded or off
+// screen, and at the end the average time spent rasterizing the occluders and testing
+// the props.
+//***************************************************************************************
+
+#include <windows.h>
+#include <iostream>
+#include <iomanip>
+#include "../../Common/OcclusionCuller.h"
+
+using namespace std;
+using namespace DirectX;
+
+double Milliseconds(const LARGE_INTEGER& start, const LARGE_INTEGER& end)
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+
+	return 1000.0 * (double)(end.QuadPart - start.QuadPart) / (double)frequency.QuadPart;
+}
+
+int main()
+{
+	const int blockCount = 16;
+	const float blockSize = 30.0f;
+	const float streetWidth = 10.0f;
+	const UINT propsPerBlock = 24;
+	const UINT frameCount = 600;
+
+	srand(2020);
+
+	OcclusionCuller culler(256, 144);
+	std::vector<BoundingBox> props;
+
+	BoundingBox unitBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+
+	for(int i = 0; i < blockCount; ++i)
+	{
+		for(int j = 0; j < blockCount; ++j)
+		{
+			float x = (i - blockCount / 2)*(blockSize + streetWidth);
+			float z = (j - blockCount / 2)*(blockSize + streetWidth);
+
+			// One building filling most of the block.
+			float halfWidth = 0.5f*blockSize*MathHelper::RandF(0.6f, 0.9f);
+			float halfHeight = MathHelper::RandF(8.0f, 40.0f);
+			culler.AddOccluderBox(unitBox, XMMatrixScaling(halfWidth, halfHeight, halfWidth) *
+				XMMatrixTranslation(x, halfHeight, z));
+
+			// Props of 1 to 4 units anywhere on the block, some hidden inside or
+			// behind the building.
+			for(UINT k = 0; k < propsPerBlock; ++k)
+			{
+				float extent = MathHelper::RandF(0.5f, 2.0f);
+				props.push_back(BoundingBox(
+					XMFLOAT3(x + MathHelper::RandF(-0.5f, 0.5f)*blockSize, extent,
+						z + MathHelper::RandF(-0.5f, 0.5f)*blockSize),
+					XMFLOAT3(extent, extent, extent)));
+			}
+		}
+	}
+
+	UINT propCount = (UINT)props.size();
+	std::unique_ptr<bool[]> visible = std::make_unique<bool[]>(propCount);
+
+	XMMATRIX proj = XMMatrixPerspectiveFovLH(0.25f*MathHelper::Pi, 1280.0f / 720.0f, 1.0f, 1000.0f);
+
+	cout << propCount << " props, " << blockCount*blockCount << " occluders, "
+		<< culler.GetWidth() << "x" << culler.GetHeight() << " depth buffer" << endl << endl;
+	cout << "frame   visible   occluded   off screen   triangles" << endl;
+
+	double renderMs = 0.0;
+	double testMs = 0.0;
+	UINT64 totalVisible = 0;
+	UINT64 totalOccluded = 0;
+
+	// Walk down the street between the middle two rows of blocks.
+	float streetX = -0.5f*(blockSize + streetWidth);
+	float startZ = -0.5f*blockCount*(blockSize + streetWidth);
+
+	for(UINT frame = 0; frame < frameCount; ++frame)
+	{
+		float z = startZ + 1.0f*frame;
+		float yaw = 0.8f*sinf(0.01f*frame);
+
+		XMVECTOR eye = XMVectorSet(streetX, 1.8f, z, 1.0f);
+		XMVECTOR look = XMVectorSet(sinf(yaw), 0.0f, cosf(yaw), 0.0f);
+		XMMATRIX view = XMMatrixLookToLH(eye, look, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+
+		LARGE_INTEGER start, end;
+
+		QueryPerformanceCounter(&start);
+		culler.RenderOccluders(XMMatrixMultiply(view, proj));
+		QueryPerformanceCounter(&end);
+		renderMs += Milliseconds(start, end);
+
+		QueryPerformanceCounter(&start);
+		culler.TestOccludees(props.data(), propCount, visible.get());
+		QueryPerformanceCounter(&end);
+		testMs += Milliseconds(start, end);
+
+		const OcclusionStats& stats = culler.GetStats();
+		totalVisible += stats.Visible;
+		totalOccluded += stats.Occluded;
+
+		if(frame % 30 == 0)
+		{
+			cout << setw(5) << frame << setw(10) << stats.Visible << setw(11) << stats.Occluded
+				<< setw(13) << stats.OutsideScreen << setw(12) << stats.RasterizedTriangles << endl;
+		}
+	}
+
+	cout << endl << fixed << setprecision(3)
+		<< "rasterize occluders + hierarchy: " << renderMs / frameCount << " ms/frame" << endl
+		<< "test props:                      " << testMs / frameCount << " ms/frame" << endl
+		<< setprecision(1)
+		<< "occluded:                        "
+		<< 100.0*totalOccluded / (double)MathHelper::Max(totalVisible + totalOccluded, (UINT64)1)
+		<< "% of the props on screen" << endl;
+
+	system("pause");
+	return 0;
+}
@@ -0,0 +1,391 @@
+//***************************************************************************************
+// RenderItemBenchmark.cpp
+//
+// Headless console benchmark for Common/RenderItemStore.h.  Build it as its own console
+// project with Common/RenderItemStore.cpp, Common/DirtyTracker.cpp and
+// Common/MathHelper.cpp.
+//
+// It runs the per-frame loops of TreeBillboardsApp over two scenes, once with the
+// render items it used to keep, each its own heap allocation reached through a
+// vector<unique_ptr<RenderItem>> and per-layer pointer lists, and once with a
+// RenderItemStore:
+//   -"assignment 2": 57 items in the app's layers: the ground, the water, 6 tree
+//    sprites and 49 opaque building blocks.
+//   -"synthetic": 100000 items, mostly opaque with some alpha tested and transparent.
+// The old items are allocated in a shuffled order between other allocations, as a
+// long running app's heap would leave them, so walking the list jumps around memory.
+//
+// Each frame moves 1% of the items, writes the object constants of the dirty items to
+// an array standing in for the mapped upload buffer, and records a draw per visible
+// item the way DrawRenderItems does.  The average time of both loops and the number of
+// constant buffer writes per frame are printed for each layout, along with a checksum
+// that has to match between them.  The old items find their dirty ones by checking
+// every NumFramesDirty; the store only visits the handles on its dirty lists.
+//***************************************************************************************
+
+#include <windows.h>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <random>
+#include "../../Common/RenderItemStore.h"
+
+using namespace std;
+using namespace DirectX;
+
+const int gNumFrameResources = 3;
+
+double Milliseconds(const LARGE_INTEGER& start, const LARGE_INTEGER& end)
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+
+	return 1000.0 * (double)(end.QuadPart - start.QuadPart) / (double)frequency.QuadPart;
+}
+
+enum class RenderLayer : int
+{
+	Opaque = 0,
+	Transparent,
+	AlphaTested,
+	AlphaTestedTreeSprites,
+	Count
+};
+
+// TreeBillboardsApp's RenderItem before the store.
+struct RenderItem
+{
+	BoundingBox Bounds;
+	XMFLOAT4X4 World = MathHelper::Identity4x4();
+	XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
+	int NumFramesDirty = gNumFrameResources;
+	UINT ObjCBIndex = -1;
+	Material* Mat = nullptr;
+	MeshGeometry* Geo = nullptr;
+	D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	UINT IndexCount = 0;
+	UINT StartIndexLocation = 0;
+	int BaseVertexLocation = 0;
+	bool Visible = true;
+};
+
+// As in FrameResource.h.
+struct ObjectConstants
+{
+	XMFLOAT4X4 World = MathHelper::Identity4x4();
+	XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
+};
+
+// What DrawRenderItems hands the command list for one item.
+struct DrawRecord
+{
+	const MeshGeometry* Geo;
+	D3D12_PRIMITIVE_TOPOLOGY PrimitiveType;
+	UINT64 Texture;
+	UINT64 ObjectCB;
+	UINT64 MaterialCB;
+	UINT IndexCount;
+	UINT StartIndexLocation;
+	int BaseVertexLocation;
+};
+
+const UINT64 ObjCBByteSize = 256;
+const UINT64 MatCBByteSize = 256;
+const UINT64 SrvDescriptorSize = 32;
+
+struct Scene
+{
+	const char* Name;
+	UINT Opaque;
+	UINT AlphaTested;
+	UINT TreeSprites;
+	UINT Transparent;
+	UINT FrameCount;
+};
+
+struct Timings
+{
+	double UpdateMs = 0.0;
+	double DrawMs = 0.0;
+	double Writes = 0.0;
+	UINT64 Checksum = 0;
+};
+
+UINT64 Hash(const DrawRecord& record)
+{
+	return record.ObjectCB*31 + record.MaterialCB*17 + record.Texture + record.IndexCount;
+}
+
+XMFLOAT4X4 RandomWorld()
+{
+	XMFLOAT4X4 world;
+	XMStoreFloat4x4(&world, XMMatrixScaling(MathHelper::RandF(0.5f, 3.0f), MathHelper::RandF(0.5f, 3.0f), MathHelper::RandF(0.5f, 3.0f)) *
+		XMMatrixRotationY(MathHelper::RandF(0.0f, XM_2PI)) *
+		XMMatrixTranslation(MathHelper::RandF(-500.0f, 500.0f), 0.0f, MathHelper::RandF(-500.0f, 500.0f)));
+
+	return world;
+}
+
+Timings RunOld(const vector<RenderItemDesc>& descs, const vector<UINT>& moved, UINT frameCount)
+{
+	UINT count = (UINT)descs.size();
+
+	// Allocate the items in a random order with other allocations between
+	// them, then keep them in the order they were added.
+	vector<UINT> order(count);
+	for(UINT i = 0; i < count; ++i)
+		order[i] = i;
+	shuffle(order.begin(), order.end(), mt19937(47));
+
+	vector<unique_ptr<RenderItem>> allRitems(count);
+	vector<unique_ptr<char[]>> clutter;
+	for(UINT i : order)
+	{
+		const RenderItemDesc& desc = descs[i];
+
+		auto ri = make_unique<RenderItem>();
+		ri->Bounds = desc.Bounds;
+		ri->World = desc.World;
+		ri->TexTransform = desc.TexTransform;
+		ri->ObjCBIndex = i;
+		ri->Mat = desc.Mat;
+		ri->Geo = desc.Geo;
+		ri->PrimitiveType = desc.PrimitiveType;
+		ri->IndexCount = desc.IndexCount;
+		ri->StartIndexLocation = desc.StartIndexLocation;
+		ri->BaseVertexLocation = desc.BaseVertexLocation;
+		allRitems[i] = move(ri);
+
+		clutter.push_back(make_unique<char[]>(16 + rand() % 240));
+	}
+
+	vector<RenderItem*> ritemLayer[(int)RenderLayer::Count];
+	for(UINT i = 0; i < count; ++i)
+		ritemLayer[descs[i].Layer].push_back(allRitems[i].get());
+
+	vector<ObjectConstants> objectCB(count);
+	vector<DrawRecord> commands(count);
+
+	Timings timings;
+	for(UINT frame = 0; frame < frameCount; ++frame)
+	{
+		LARGE_INTEGER start, mid, end;
+		QueryPerformanceCounter(&start);
+
+		for(UINT i : moved)
+		{
+			allRitems[i]->World(3, 1) += 0.01f;
+			allRitems[i]->NumFramesDirty = gNumFrameResources;
+		}
+
+		for(auto& e : allRitems)
+		{
+			if(e->NumFramesDirty > 0)
+			{
+				ObjectConstants objConstants;
+				XMStoreFloat4x4(&objConstants.World, XMMatrixTranspose(XMLoadFloat4x4(&e->World)));
+				XMStoreFloat4x4(&objConstants.TexTransform, XMMatrixTranspose(XMLoadFloat4x4(&e->TexTransform)));
+				objectCB[e->ObjCBIndex] = objConstants;
+
+				e->NumFramesDirty--;
+				timings.Writes++;
+			}
+		}
+
+		QueryPerformanceCounter(&mid);
+
+		UINT commandCount = 0;
+		for(auto& layer : ritemLayer)
+		{
+			for(RenderItem* ri : layer)
+			{
+				if(!ri->Visible)
+					continue;
+
+				DrawRecord& record = commands[commandCount++];
+				record.Geo = ri->Geo;
+				record.PrimitiveType = ri->PrimitiveType;
+				record.Texture = ri->Mat->DiffuseSrvHeapIndex*SrvDescriptorSize;
+				record.ObjectCB = ri->ObjCBIndex*ObjCBByteSize;
+				record.MaterialCB = ri->Mat->MatCBIndex*MatCBByteSize;
+				record.IndexCount = ri->IndexCount;
+				record.StartIndexLocation = ri->StartIndexLocation;
+				record.BaseVertexLocation = ri->BaseVertexLocation;
+			}
+		}
+
+		QueryPerformanceCounter(&end);
+		timings.UpdateMs += Milliseconds(start, mid);
+		timings.DrawMs += Milliseconds(mid, end);
+
+		if(frame == frameCount - 1)
+		{
+			for(UINT i = 0; i < commandCount; ++i)
+				timings.Checksum += Hash(commands[i]);
+			for(UINT i = 0; i < count; ++i)
+				timings.Checksum += (UINT64)(objectCB[i].World(1, 3)*1000.0f);
+		}
+	}
+
+	timings.UpdateMs /= frameCount;
+	timings.DrawMs /= frameCount;
+	timings.Writes /= frameCount;
+	return timings;
+}
+
+Timings RunStore(const vector<RenderItemDesc>& descs, const vector<UINT>& moved, UINT frameCount)
+{
+	UINT count = (UINT)descs.size();
+
+	RenderItemStore ritems;
+	ritems.Reserve(count);
+	for(const RenderItemDesc& desc : descs)
+		ritems.Add(desc);
+
+	vector<ObjectConstants> objectCB(ritems.Capacity());
+	vector<DrawRecord> commands(count);
+
+	Timings timings;
+	for(UINT frame = 0; frame < frameCount; ++frame)
+	{
+		LARGE_INTEGER start, mid, end;
+		QueryPerformanceCounter(&start);
+
+		for(UINT handle : moved)
+		{
+			XMFLOAT4X4 world = ritems.GetWorld(handle);
+			world(3, 1) += 0.01f;
+			ritems.SetWorld(handle, world);
+		}
+
+		ObjectConstants* cb = objectCB.data();
+		timings.Writes += ritems.UpdateDirty([cb](UINT handle, const XMFLOAT4X4& world, const XMFLOAT4X4& texTransform)
+		{
+			ObjectConstants objConstants;
+			XMStoreFloat4x4(&objConstants.World, XMMatrixTranspose(XMLoadFloat4x4(&world)));
+			XMStoreFloat4x4(&objConstants.TexTransform, XMMatrixTranspose(XMLoadFloat4x4(&texTransform)));
+			cb[handle] = objConstants;
+		});
+
+		QueryPerformanceCounter(&mid);
+
+		const UINT* handles = ritems.Handles();
+		const UINT8* layers = ritems.Layers();
+		const UINT8* visible = ritems.Visible();
+		const RenderItemMaterial* materials = ritems.Materials();
+		const RenderItemDrawArgs* drawArgs = ritems.DrawArgs();
+		UINT itemCount = ritems.Size();
+
+		UINT commandCount = 0;
+		for(UINT layer = 0; layer < (UINT)RenderLayer::Count; ++layer)
+		{
+			for(UINT slot = 0; slot < itemCount; ++slot)
+			{
+				if(layers[slot] != layer || !visible[slot])
+					continue;
+
+				const RenderItemDrawArgs& ri = drawArgs[slot];
+
+				DrawRecord& record = commands[commandCount++];
+				record.Geo = ri.Geo;
+				record.PrimitiveType = ri.PrimitiveType;
+				record.Texture = materials[slot].DiffuseSrvHeapIndex*SrvDescriptorSize;
+				record.ObjectCB = handles[slot]*ObjCBByteSize;
+				record.MaterialCB = materials[slot].MatCBIndex*MatCBByteSize;
+				record.IndexCount = ri.IndexCount;
+				record.StartIndexLocation = ri.StartIndexLocation;
+				record.BaseVertexLocation = ri.BaseVertexLocation;
+			}
+		}
+
+		QueryPerformanceCounter(&end);
+		timings.UpdateMs += Milliseconds(start, mid);
+		timings.DrawMs += Milliseconds(mid, end);
+
+		if(frame == frameCount - 1)
+		{
+			for(UINT i = 0; i < commandCount; ++i)
+				timings.Checksum += Hash(commands[i]);
+			for(UINT i = 0; i < count; ++i)
+				timings.Checksum += (UINT64)(objectCB[i].World(1, 3)*1000.0f);
+		}
+	}
+
+	timings.UpdateMs /= frameCount;
+	timings.DrawMs /= frameCount;
+	timings.Writes /= frameCount;
+	return timings;
+}
+
+int main()
+{
+	// A few meshes and materials for the items to share.
+	const UINT geoCount = 4;
+	const UINT matCount = 24;
+
+	MeshGeometry geos[geoCount];
+	Material mats[matCount];
+	for(UINT i = 0; i < matCount; ++i)
+	{
+		mats[i].MatCBIndex = i;
+		mats[i].DiffuseSrvHeapIndex = i;
+	}
+
+	const Scene scenes[] =
+	{
+		{ "assignment 2", 50, 0, 6, 1, 200000 },
+		{ "synthetic", 90000, 6000, 0, 4000, 200 },
+	};
+
+	for(const Scene& scene : scenes)
+	{
+		srand(47);
+
+		vector<RenderItemDesc> descs;
+		auto addItems = [&](UINT count, RenderLayer layer)
+		{
+			for(UINT i = 0; i < count; ++i)
+			{
+				RenderItemDesc desc;
+				desc.World = RandomWorld();
+				desc.Mat = &mats[rand() % matCount];
+				desc.Geo = &geos[rand() % geoCount];
+				desc.PrimitiveType = layer == RenderLayer::AlphaTestedTreeSprites ?
+					D3D_PRIMITIVE_TOPOLOGY_POINTLIST : D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+				desc.IndexCount = 36 + 6*(rand() % 16);
+				desc.StartIndexLocation = 36*(rand() % 64);
+				desc.Layer = (UINT)layer;
+				descs.push_back(desc);
+			}
+		};
+
+		addItems(scene.Opaque, RenderLayer::Opaque);
+		addItems(scene.AlphaTested, RenderLayer::AlphaTested);
+		addItems(scene.TreeSprites, RenderLayer::AlphaTestedTreeSprites);
+		addItems(scene.Transparent, RenderLayer::Transparent);
+
+		// Every 100th item moves each frame; the store hands out handles in
+		// the order items are added, so the indices serve for both.
+		vector<UINT> moved;
+		for(UINT i = 0; i < (UINT)descs.size(); i += 100)
+			moved.push_back(i);
+
+		Timings before = RunOld(descs, moved, scene.FrameCount);
+		Timings after = RunStore(descs, moved, scene.FrameCount);
+
+		cout << fixed << setprecision(4)
+			<< scene.Name << ": " << descs.size() << " items, " << moved.size() << " moving, "
+			<< scene.FrameCount << " frames" << endl
+			<< "  unique_ptr items:  update " << before.UpdateMs << " ms, draw " << before.DrawMs << " ms, "
+			<< setprecision(1) << before.Writes << " cbuffer writes" << endl << setprecision(4)
+			<< "  RenderItemStore:   update " << after.UpdateMs << " ms, draw " << after.DrawMs << " ms, "
+			<< setprecision(1) << after.Writes << " cbuffer writes" << endl
+			<< setprecision(2)
+			<< "  speedup:           update " << before.UpdateMs / after.UpdateMs
+			<< "x, draw " << before.DrawMs / after.DrawMs << "x" << endl
+			<< "  checksums " << (before.Checksum == after.Checksum ? "match" : "DIFFER") << endl << endl;
+	}
+
+	system("pause");
+	return 0;
+}
@@ -30,13 +30,17 @@ SamplerState gsamLinearClamp      : register(s3);
 SamplerState gsamAnisotropicWrap  : register(s4);
 SamplerState gsamAnisotropicClamp : register(s5);
 
-// Constant data that varies per frame.
-cbuffer cbPerObject : register(b0)
+// Per-object data, by render item handle, and the handles of the current draw's
+// instances.  Put in space1, so they do not overlap the texture in t0.
+struct ObjectConstants
 {
-    float4x4 gWorld;
-	float4x4 gTexTransform;
+    float4x4 World;
+	float4x4 TexTransform;
 };
 
+StructuredBuffer<ObjectConstants> gObjects : register(t0, space1);
+StructuredBuffer<uint> gInstanceObjects : register(t1, space1);
+
 // Constant data that varies per material.
 cbuffer cbPass : register(b1)
 {
@@ -91,22 +95,27 @@ struct VertexOut
 	float2 TexC    : TEXCOORD;
 };
 
-VertexOut VS(VertexIn vin)
+VertexOut VS(VertexIn vin, uint instanceID : SV_InstanceID)
 {
 	VertexOut vout = (VertexOut)0.0f;
+
+	// Fetch the object this instance draws.
+	ObjectConstants obj = gObjects[gInstanceObjects[instanceID]];
+	float4x4 world = obj.World;
+	float4x4 texTransform = obj.TexTransform;
 	
     // Transform to world space.
-    float4 posW = mul(float4(vin.PosL, 1.0f), gWorld);
+    float4 posW = mul(float4(vin.PosL, 1.0f), world);
     vout.PosW = posW.xyz;
 
     // Assumes nonuniform scaling; otherwise, need to use inverse-transpose of world matrix.
-    vout.NormalW = mul(vin.NormalL, (float3x3)gWorld);
+    vout.NormalW = mul(vin.NormalL, (float3x3)world);
 
     // Transform to homogeneous clip space.
     vout.PosH = mul(posW, gViewProj);
 	
 	// Output vertex attributes for interpolation across triangle.
-	float4 texC = mul(float4(vin.TexC, 0.0f, 1.0f), gTexTransform);
+	float4 texC = mul(float4(vin.TexC, 0.0f, 1.0f), texTransform);
 	vout.TexC = mul(texC, gMatTransform).xy;
 
     return vout;
@@ -31,13 +31,17 @@ SamplerState gsamLinearClamp      : register(s3);
 SamplerState gsamAnisotropicWrap  : register(s4);
 SamplerState gsamAnisotropicClamp : register(s5);
 
-// Constant data that varies per frame.
-cbuffer cbPerObject : register(b0)
+// Per-object data, by render item handle, and the handles of the current draw's
+// instances.  Put in space1, so they do not overlap the texture in t0.
+struct ObjectConstants
 {
-    float4x4 gWorld;
-	float4x4 gTexTransform;
+    float4x4 World;
+	float4x4 TexTransform;
 };
 
+StructuredBuffer<ObjectConstants> gObjects : register(t0, space1);
+StructuredBuffer<uint> gInstanceObjects : register(t1, space1);
+
 // Constant data that varies per material.
 cbuffer cbPass : register(b1)
 {
@@ -98,14 +102,17 @@ struct GeoOut
     uint   PrimID  : SV_PrimitiveID;
 };
 
-VertexOut VS(VertexIn vin)
+VertexOut VS(VertexIn vin, uint instanceID : SV_InstanceID)
 {
 	VertexOut vout;
 
+	// Fetch the object this instance draws.
+	float4x4 world = gObjects[gInstanceObjects[instanceID]].World;
+
 	// Just pass data over to geometry shader.
 	//vout.CenterW = vin.PosW;
 
-	float4 posW = mul(float4(vin.PosW, 1.0f), gWorld);
+	float4 posW = mul(float4(vin.PosW, 1.0f), world);
 	vout.CenterW = posW.xyz;
 
 	vout.SizeW   = vin.SizeW;
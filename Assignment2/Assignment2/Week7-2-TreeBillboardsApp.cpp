@@ -1,5 +1,7 @@
 ﻿//***************************************************************************************
 // TreeBillboardsApp.cpp 
+//
+// Hold 2 to draw without CPU occlusion culling.
 //***************************************************************************************
 
 #include "../../Common/d3dApp.h"
@@ -7,9 +9,16 @@
 #include "../../Common/UploadBuffer.h"
 #include "../../Common/GeometryGenerator.h"
 #include "../../Common/Camera.h"
+#include "../../Common/OcclusionCuller.h"
+#include "../../Common/CameraController.h"
+#include "../../Common/RenderItemStore.h"
+#include "../../Common/DrawList.h"
 #include "FrameResource.h"
 #include "Waves.h"
 
+#include <map>
+#include <tuple>
+
 using Microsoft::WRL::ComPtr;
 using namespace DirectX;
 using namespace DirectX::PackedVector;
@@ -19,42 +28,6 @@ using namespace DirectX::PackedVector;
 
 const int gNumFrameResources = 3;
 
-// Lightweight structure stores parameters to draw a shape.  This will
-// vary from app-to-app.
-struct RenderItem
-{
-	RenderItem() = default;
-
-	BoundingBox Bounds;
-
-    // World matrix of the shape that describes the object's local space
-    // relative to the world space, which defines the position, orientation,
-    // and scale of the object in the world.
-    XMFLOAT4X4 World = MathHelper::Identity4x4();
-
-	XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
-
-	// Dirty flag indicating the object data has changed and we need to update the constant buffer.
-	// Because we have an object cbuffer for each FrameResource, we have to apply the
-	// update to each FrameResource.  Thus, when we modify obect data we should set 
-	// NumFramesDirty = gNumFrameResources so that each frame resource gets the update.
-	int NumFramesDirty = gNumFrameResources;
-
-	// Index into GPU constant buffer corresponding to the ObjectCB for this render item.
-	UINT ObjCBIndex = -1;
-
-	Material* Mat = nullptr;
-	MeshGeometry* Geo = nullptr;
-
-    // Primitive topology.
-    D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-
-    // DrawIndexedInstanced parameters.
-    UINT IndexCount = 0;
-    UINT StartIndexLocation = 0;
-    int BaseVertexLocation = 0;
-};
-
 enum class RenderLayer : int
 {
 	Opaque = 0,
@@ -64,6 +37,21 @@ enum class RenderLayer : int
 	Count
 };
 
+// Where each RenderLayer comes in the frame: opaque first, blended last.
+const UINT gLayerDrawOrder[(int)RenderLayer::Count] = { 0, 3, 1, 2 };
+
+// A run of the sorted draw list whose items share layer, submesh and material,
+// drawn as instances of one draw.
+struct DrawBatch
+{
+	// Slot of the first item; the others draw the same way.
+	UINT Slot = 0;
+
+	// Where the items' handles are in the frame resource's InstanceBuffer.
+	UINT InstanceStart = 0;
+	UINT InstanceCount = 0;
+};
+
 class TreeBillboardsApp : public D3DApp
 {
 public:
@@ -86,10 +74,12 @@ private:
     void OnKeyboardInput(const GameTimer& gt);
 	//void UpdateCamera(const GameTimer& gt);
 	void AnimateMaterials(const GameTimer& gt);
-	void UpdateObjectCBs(const GameTimer& gt);
+	void UpdateObjectBuffer(const GameTimer& gt);
 	void UpdateMaterialCBs(const GameTimer& gt);
 	void UpdateMainPassCB(const GameTimer& gt);
 	void UpdateWaves(const GameTimer& gt); 
+	void UpdateOcclusion(const GameTimer& gt);
+	void UpdateDrawList(const GameTimer& gt);
 
 	void LoadTextures();
 	void CreateTexture(std::string name, std::wstring path, bool bTextureArray = false);
@@ -119,10 +109,11 @@ private:
 	void Tower(FXMVECTOR pos, FXMVECTOR scale = XMVectorSet(1.f, 1.f, 1.f, 0.f), FXMVECTOR rotation = XMVectorSet(0.f, 0.f, 0.f, 0.f));
 	void Park(FXMVECTOR pos, FXMVECTOR scale = XMVectorSet(1.f, 1.f, 1.f, 0.f), FXMVECTOR rotation = XMVectorSet(0.f, 0.f, 0.f, 0.f));
 	void Barrigates(FXMVECTOR pos, FXMVECTOR scale = XMVectorSet(1.f, 1.f, 1.f, 0.f), FXMVECTOR rotation = XMVectorSet(0.f, 0.f, 0.f, 0.f));
+	void BuildOcclusion();
+	void BuildCollision();
+	void BuildDrawList();
 
-	bool CheckCameraCollision(FXMVECTOR predictPos);
-
-    void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems);
+    void DrawRenderItems(ID3D12GraphicsCommandList* cmdList);
 
 	std::array<const CD3DX12_STATIC_SAMPLER_DESC, 6> GetStaticSamplers();
 
@@ -147,16 +138,32 @@ private:
 	std::unordered_map<std::string, ComPtr<ID3DBlob>> mShaders;
 	std::unordered_map<std::string, ComPtr<ID3D12PipelineState>> mPSOs;
 
+	// The PSO of each RenderLayer.
+	ID3D12PipelineState* mLayerPSOs[(int)RenderLayer::Count] = {};
+
     std::vector<D3D12_INPUT_ELEMENT_DESC> mStdInputLayout;
 	std::vector<D3D12_INPUT_ELEMENT_DESC> mTreeSpriteInputLayout;
 
-    RenderItem* mWavesRitem = nullptr;
+    UINT mWavesRitem = RenderItemStore::InvalidHandle;
 
-	// List of all the render items.
-	std::vector<std::unique_ptr<RenderItem>> mAllRitems;
+	// All the render items, each tagged with its RenderLayer.
+	RenderItemStore mRitems;
 
-	// Render items divided by PSO.
-	std::vector<RenderItem*> mRitemLayer[(int)RenderLayer::Count];
+	// Materials by MatCBIndex, and the ones whose constants changed lately.
+	std::vector<Material*> mMaterialList;
+	DirtyTracker mMaterialDirty;
+
+	// Constant buffer writes of the current frame.
+	DirtyStats mObjectDirtyStats;
+	DirtyStats mMaterialDirtyStats;
+
+	// The visible items sorted by layer and state, blended ones back to front,
+	// with each item's submesh numbered by handle for the keys.  Runs of equal
+	// state become instanced draws.
+	DrawList mDrawList;
+	std::vector<UINT> mSubmeshIds;
+	std::vector<DrawBatch> mDrawBatches;
+	DrawListStats mDrawStats;
 
 	std::unique_ptr<Waves> mWaves;
 
@@ -178,11 +185,24 @@ private:
 
 	Camera mCamera;
 	float mCameraSpeed = 10.f;
-	BoundingBox mCameraBoundbox;
+
+	// Large buildings are rasterized as occluders; every opaque and alpha
+	// tested item is an occludee, with its world bounds computed once.
+	OcclusionCuller mOcclusionCuller;
+	bool mOcclusionCullingEnabled = true;
+	std::vector<UINT> mOccludees;
+	std::vector<BoundingBox> mOccludeeBounds;
+	std::unique_ptr<bool[]> mOccludeeVisible;
+
+	// The camera is a sphere sliding along the triangles of the opaque items,
+	// one hierarchy per distinct submesh.
+	std::unordered_map<std::string, std::unique_ptr<TriangleBvh>> mMeshBvhs;
+	SceneBvh mCollisionScene;
+	CollisionQuery mCollision;
+	CameraController mCameraController;
 
     POINT mLastMousePos;
 
-	UINT mObjCBIndex = 0;
 	UINT mNumOfTex = 0;
 	int mMatCBIdx = 0;
 	int mDiffuseSrvHeapIdx = 0;
@@ -238,8 +258,6 @@ bool TreeBillboardsApp::Initialize()
     mCbvSrvDescriptorSize = md3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
 	mCamera.SetPosition(-5.f, 3.0f, -10.0f);
-	mCameraBoundbox.Center = mCamera.GetPosition3f();
-	mCameraBoundbox.Extents = XMFLOAT3(1.1f, 1.1f, 1.1f);
 
     mWaves = std::make_unique<Waves>(32, 32, 1.0f, 0.03f, 4.0f, 0.2f);
  
@@ -252,6 +270,9 @@ bool TreeBillboardsApp::Initialize()
 	BuildTreeSpritesGeometry();
 	BuildMaterials();
     BuildRenderItems();
+	BuildOcclusion();
+	BuildCollision();
+	BuildDrawList();
     BuildFrameResources();
     BuildPSOs();
 
@@ -277,6 +298,9 @@ void TreeBillboardsApp::OnResize()
 	//step2: When the window is resized, we no longer rebuild the projection matrix explicitly, 
 	//and instead delegate the work to the Camera class with SetLens:
 	mCamera.SetLens(0.25f * MathHelper::Pi, AspectRatio(), 1.0f, 1000.0f);
+
+	// Keep the occlusion buffer 256 pixels wide with the window's aspect ratio.
+	mOcclusionCuller.Resize(256, (UINT)MathHelper::Max(256.0f / AspectRatio(), 1.0f));
 }
 
 void TreeBillboardsApp::Update(const GameTimer& gt)
@@ -299,7 +323,9 @@ void TreeBillboardsApp::Update(const GameTimer& gt)
     }
 
 	AnimateMaterials(gt);
-	UpdateObjectCBs(gt);
+	UpdateOcclusion(gt);
+	UpdateDrawList(gt);
+	UpdateObjectBuffer(gt);
 	UpdateMaterialCBs(gt);
 	UpdateMainPassCB(gt);
     UpdateWaves(gt);
@@ -339,16 +365,12 @@ void TreeBillboardsApp::Draw(const GameTimer& gt)
 	auto passCB = mCurrFrameResource->PassCB->Resource();
 	mCommandList->SetGraphicsRootConstantBufferView(2, passCB->GetGPUVirtualAddress());
 
-    DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Opaque]);
-
-	mCommandList->SetPipelineState(mPSOs["alphaTested"].Get());
-	DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::AlphaTested]);
+	// Every draw's instances index the same object buffer.
+	auto objectBuffer = mCurrFrameResource->ObjectBuffer->Resource();
+	mCommandList->SetGraphicsRootShaderResourceView(1, objectBuffer->GetGPUVirtualAddress());
 
-	mCommandList->SetPipelineState(mPSOs["treeSprites"].Get());
-	DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::AlphaTestedTreeSprites]);
-
-	mCommandList->SetPipelineState(mPSOs["transparent"].Get());
-	DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Transparent]);
+	// Every layer in one walk of the sorted draw list, switching PSOs as it goes.
+    DrawRenderItems(mCommandList.Get());
 
     // Indicate a state transition on the resource usage.
 	mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
@@ -432,67 +454,34 @@ void TreeBillboardsApp::OnKeyboardInput(const GameTimer& gt)
 	else
 		mIsWireframe = false;
 
+	mOcclusionCullingEnabled = (GetAsyncKeyState('2') & 0x8000) == 0;
+
 	const float dt = gt.DeltaTime();
 
 	//GetAsyncKeyState returns a short (2 bytes)
-	XMVECTOR predictPos = XMVectorSet(0.f, 0.f, 0.f, 0.f);
+	XMVECTOR motion = XMVectorZero();
 	if (GetAsyncKeyState('W') & 0x8000) //most significant bit (MSB) is 1 when key is pressed (1000 000 000 000)
-	{
-		XMVECTOR s = XMVectorReplicate(mCameraSpeed * dt);
-		predictPos = XMVectorMultiplyAdd(s, mCamera.GetLook(), mCamera.GetPosition());
-
-		if (CheckCameraCollision(predictPos) == false)
-			mCamera.Walk(mCameraSpeed * dt);
-	}
+		motion += mCamera.GetLook();
 
 	if (GetAsyncKeyState('S') & 0x8000)
-	{
-		XMVECTOR s = XMVectorReplicate(-mCameraSpeed * dt);
-		predictPos = XMVectorMultiplyAdd(s, mCamera.GetLook(), mCamera.GetPosition());
-
-		if (CheckCameraCollision(predictPos) == false)
-			mCamera.Walk(-mCameraSpeed * dt);
-	}
-
+		motion -= mCamera.GetLook();
 
 	if (GetAsyncKeyState('A') & 0x8000)
-	{
-		XMVECTOR s = XMVectorReplicate(-mCameraSpeed * dt);
-		predictPos = XMVectorMultiplyAdd(s, mCamera.GetRight(), mCamera.GetPosition());
-
-		if (CheckCameraCollision(predictPos) == false)
-			mCamera.Strafe(-mCameraSpeed * dt);
-
-	}
+		motion -= mCamera.GetRight();
 
 	if (GetAsyncKeyState('D') & 0x8000)
-	{
-		XMVECTOR s = XMVectorReplicate(mCameraSpeed * dt);
-		predictPos = XMVectorMultiplyAdd(s, mCamera.GetRight(), mCamera.GetPosition());
-
-
-		if (CheckCameraCollision(predictPos) == false)
-			mCamera.Strafe(mCameraSpeed * dt);
-	}
+		motion += mCamera.GetRight();
 
 	//step1
 	if (GetAsyncKeyState(VK_UP) & 0x8000)
-	{
-		XMVECTOR s = XMVectorReplicate(mCameraSpeed * dt);
-		predictPos = XMVectorMultiplyAdd(s, mCamera.GetUp(), mCamera.GetPosition());
-
-		if (CheckCameraCollision(predictPos) == false)
-			mCamera.Pedestal(mCameraSpeed * dt);
-	}
+		motion += mCamera.GetUp();
 
 	if (GetAsyncKeyState(VK_DOWN) & 0x8000)
-	{
-		XMVECTOR s = XMVectorReplicate(-mCameraSpeed * dt);
-		predictPos = XMVectorMultiplyAdd(s, mCamera.GetUp(), mCamera.GetPosition());
+		motion -= mCamera.GetUp();
 
-		if (CheckCameraCollision(predictPos) == false)
-			mCamera.Pedestal(-mCameraSpeed * dt);
-	}
+	// One sweep for the combined motion, sliding along walls instead of
+	// stopping dead against them.
+	mCameraController.Move(mCamera, mCameraSpeed * dt * motion, mCollision);
 
 	if (GetAsyncKeyState(VK_RIGHT) & 0x8000)
 		mCamera.Roll(10.0f * dt);
@@ -502,7 +491,6 @@ void TreeBillboardsApp::OnKeyboardInput(const GameTimer& gt)
 	
 
 	mCamera.UpdateViewMatrix();
-	mCameraBoundbox.Center = mCamera.GetPosition3f();
 }
  
 //void TreeBillboardsApp::UpdateCamera(const GameTimer& gt)
@@ -561,57 +549,51 @@ void TreeBillboardsApp::AnimateMaterials(const GameTimer& gt)
 	waterMat->MatTransform(3, 1) = tv;
 
 	// Material has changed, so need to update cbuffer.
-	waterMat->NumFramesDirty = gNumFrameResources;
+	mMaterialDirty.MarkDirty(waterMat->MatCBIndex);
 }
 
-void TreeBillboardsApp::UpdateObjectCBs(const GameTimer& gt)
+void TreeBillboardsApp::UpdateObjectBuffer(const GameTimer& gt)
 {
-	auto currObjectCB = mCurrFrameResource->ObjectCB.get();
-	for(auto& e : mAllRitems)
-	{
-		// Only update the cbuffer data if the constants have changed.  
-		// This needs to be tracked per frame resource.
-		if(e->NumFramesDirty > 0)
-		{
-			XMMATRIX world = XMLoadFloat4x4(&e->World);
-			XMMATRIX texTransform = XMLoadFloat4x4(&e->TexTransform);
-
-			ObjectConstants objConstants;
-			XMStoreFloat4x4(&objConstants.World, XMMatrixTranspose(world));
-			XMStoreFloat4x4(&objConstants.TexTransform, XMMatrixTranspose(texTransform));
+	auto currObjectBuffer = mCurrFrameResource->ObjectBuffer.get();
 
-			currObjectCB->CopyData(e->ObjCBIndex, objConstants);
+	// Only the items whose constants changed, tracked per frame resource.
+	// An item's handle is its index in the object buffer.
+	mRitems.UpdateDirty([currObjectBuffer](UINT handle, const XMFLOAT4X4& world, const XMFLOAT4X4& texTransform)
+	{
+		ObjectConstants objConstants;
+		XMStoreFloat4x4(&objConstants.World, XMMatrixTranspose(XMLoadFloat4x4(&world)));
+		XMStoreFloat4x4(&objConstants.TexTransform, XMMatrixTranspose(XMLoadFloat4x4(&texTransform)));
 
-			// Next FrameResource need to be updated too.
-			e->NumFramesDirty--;
-		}
-	}
+		currObjectBuffer->CopyData(handle, objConstants);
+	}, &mObjectDirtyStats);
 }
 
 void TreeBillboardsApp::UpdateMaterialCBs(const GameTimer& gt)
 {
 	auto currMaterialCB = mCurrFrameResource->MaterialCB.get();
-	for(auto& e : mMaterials)
+
+	// Only the materials whose constants changed, tracked per frame resource.
+	mMaterialDirty.Update([this, currMaterialCB](UINT index)
 	{
-		// Only update the cbuffer data if the constants have changed.  If the cbuffer
-		// data changes, it needs to be updated for each FrameResource.
-		Material* mat = e.second.get();
-		if(mat->NumFramesDirty > 0)
-		{
-			XMMATRIX matTransform = XMLoadFloat4x4(&mat->MatTransform);
+		Material* mat = mMaterialList[index];
 
-			MaterialConstants matConstants;
-			matConstants.DiffuseAlbedo = mat->DiffuseAlbedo;
-			matConstants.FresnelR0 = mat->FresnelR0;
-			matConstants.Roughness = mat->Roughness;
-			XMStoreFloat4x4(&matConstants.MatTransform, XMMatrixTranspose(matTransform));
+		XMMATRIX matTransform = XMLoadFloat4x4(&mat->MatTransform);
 
-			currMaterialCB->CopyData(mat->MatCBIndex, matConstants);
+		MaterialConstants matConstants;
+		matConstants.DiffuseAlbedo = mat->DiffuseAlbedo;
+		matConstants.FresnelR0 = mat->FresnelR0;
+		matConstants.Roughness = mat->Roughness;
+		XMStoreFloat4x4(&matConstants.MatTransform, XMMatrixTranspose(matTransform));
 
-			// Next FrameResource need to be updated too.
-			mat->NumFramesDirty--;
-		}
-	}
+		currMaterialCB->CopyData(mat->MatCBIndex, matConstants);
+		return true;
+	}, &mMaterialDirtyStats);
+
+	// Both buffers are written by now; UpdateOcclusion started this frame's caption.
+	std::wostringstream outs;
+	outs << L"    buffer writes: " << mObjectDirtyStats.Written << L" objects, " <<
+		mMaterialDirtyStats.Written << L" materials";
+	mMainWndCaption += outs.str();
 }
 
 void TreeBillboardsApp::UpdateMainPassCB(const GameTimer& gt)
@@ -663,6 +645,111 @@ void TreeBillboardsApp::UpdateMainPassCB(const GameTimer& gt)
 	currPassCB->CopyData(0, mMainPassCB);
 }
 
+void TreeBillboardsApp::UpdateOcclusion(const GameTimer& gt)
+{
+	UINT occludeeCount = (UINT)mOccludees.size();
+
+	if (!mOcclusionCullingEnabled)
+	{
+		for (UINT handle : mOccludees)
+			mRitems.SetVisible(handle, true);
+
+		mMainWndCaption = L"Assignment 2    occlusion culling off";
+		return;
+	}
+
+	// Rasterize the occluders on the worker threads, then test every item's
+	// world bounds against the depth hierarchy.
+	XMMATRIX viewProj = XMMatrixMultiply(mCamera.GetView(), mCamera.GetProj());
+	mOcclusionCuller.RenderOccluders(viewProj);
+	mOcclusionCuller.TestOccludees(mOccludeeBounds.data(), occludeeCount, mOccludeeVisible.get());
+
+	for (UINT i = 0; i < occludeeCount; ++i)
+		mRitems.SetVisible(mOccludees[i], mOccludeeVisible[i]);
+
+	const OcclusionStats& stats = mOcclusionCuller.GetStats();
+
+	std::wostringstream outs;
+	outs << L"Assignment 2    " << stats.Visible << L" visible, " << stats.Occluded <<
+		L" occluded, " << stats.OutsideScreen << L" off screen of " << stats.Tested;
+	mMainWndCaption = outs.str();
+}
+
+void TreeBillboardsApp::UpdateDrawList(const GameTimer& gt)
+{
+	XMMATRIX view = mCamera.GetView();
+
+	const UINT* handles = mRitems.Handles();
+	const XMFLOAT4X4* world = mRitems.World();
+	const BoundingBox* bounds = mRitems.LocalBounds();
+	const RenderItemMaterial* materials = mRitems.Materials();
+	const UINT8* layers = mRitems.Layers();
+	const UINT8* visible = mRitems.Visible();
+	UINT itemCount = mRitems.Size();
+
+	// A key per visible item, with the view depth of its bounds' center.
+	mDrawList.Clear();
+	for (UINT slot = 0; slot < itemCount; ++slot)
+	{
+		if (!visible[slot])
+			continue;
+
+		XMVECTOR center = XMVector3Transform(XMLoadFloat3(&bounds[slot].Center), XMLoadFloat4x4(&world[slot]));
+		float depth = XMVectorGetZ(XMVector3Transform(center, view));
+
+		UINT layer = layers[slot];
+		UINT material = materials[slot].MatCBIndex;
+		UINT submesh = mSubmeshIds[handles[slot]];
+
+		UINT64 key = layer == (UINT)RenderLayer::Transparent ?
+			DrawList::MakeBlendedKey(gLayerDrawOrder[layer], layer, material, submesh, depth) :
+			DrawList::MakeKey(gLayerDrawOrder[layer], layer, material, submesh, depth);
+		mDrawList.Add(key, slot);
+	}
+
+	mDrawList.Sort();
+
+	// Items of the same layer, submesh and material now come one after another,
+	// blended ones only when nothing lies between them.  Each run becomes one
+	// instanced draw, its handles copied to the instance buffer in draw order.
+	auto currInstanceBuffer = mCurrFrameResource->InstanceBuffer.get();
+	const UINT* items = mDrawList.Items();
+	UINT drawCount = mDrawList.Size();
+
+	mDrawBatches.clear();
+	for (UINT i = 0; i < drawCount; ++i)
+	{
+		UINT slot = items[i];
+		currInstanceBuffer->CopyData(i, handles[slot]);
+
+		if (!mDrawBatches.empty())
+		{
+			DrawBatch& batch = mDrawBatches.back();
+			UINT first = batch.Slot;
+
+			if (layers[slot] == layers[first] &&
+				materials[slot].MatCBIndex == materials[first].MatCBIndex &&
+				mSubmeshIds[handles[slot]] == mSubmeshIds[handles[first]])
+			{
+				batch.InstanceCount++;
+				continue;
+			}
+		}
+
+		DrawBatch batch;
+		batch.Slot = slot;
+		batch.InstanceStart = i;
+		batch.InstanceCount = 1;
+		mDrawBatches.push_back(batch);
+	}
+
+	// What last frame's DrawRenderItems bound.
+	std::wostringstream outs;
+	outs << L"    " << mDrawStats.Instances << L" items in " << mDrawStats.Draws << L" draws, " << mDrawStats.StateChanges <<
+		L" state changes, " << mDrawStats.StateChangesSkipped << L" skipped";
+	mMainWndCaption += outs.str();
+}
+
 void TreeBillboardsApp::UpdateWaves(const GameTimer& gt)
 {
 	// Every quarter second, generate a random wave.
@@ -700,7 +787,7 @@ void TreeBillboardsApp::UpdateWaves(const GameTimer& gt)
 	}
 
 	// Set the dynamic VB of the wave renderitem to the current frame VB.
-	mWavesRitem->Geo->VertexBufferGPU = currWavesVB->Resource();
+	mRitems.GetDrawArgs(mWavesRitem).Geo->VertexBufferGPU = currWavesVB->Resource();
 }
 
 void TreeBillboardsApp::BuildRootSignature()
@@ -709,18 +796,21 @@ void TreeBillboardsApp::BuildRootSignature()
 	texTable.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
 
     // Root parameter can be a table, root descriptor or root constants.
-    CD3DX12_ROOT_PARAMETER slotRootParameter[4];
+    CD3DX12_ROOT_PARAMETER slotRootParameter[5];
 
 	// Perfomance TIP: Order from most frequent to least frequent.
+	// The object and instance buffers are structured buffers in space1, so
+	// they can be root descriptors next to the texture table.
 	slotRootParameter[0].InitAsDescriptorTable(1, &texTable, D3D12_SHADER_VISIBILITY_PIXEL);
-    slotRootParameter[1].InitAsConstantBufferView(0);
+    slotRootParameter[1].InitAsShaderResourceView(0, 1);
     slotRootParameter[2].InitAsConstantBufferView(1);
     slotRootParameter[3].InitAsConstantBufferView(2);
+	slotRootParameter[4].InitAsShaderResourceView(1, 1);
 
 	auto staticSamplers = GetStaticSamplers();
 
     // A root signature is an array of root parameters.
-	CD3DX12_ROOT_SIGNATURE_DESC rootSigDesc(4, slotRootParameter,
+	CD3DX12_ROOT_SIGNATURE_DESC rootSigDesc(5, slotRootParameter,
 		(UINT)staticSamplers.size(), staticSamplers.data(),
 		D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
 
@@ -903,6 +993,8 @@ void TreeBillboardsApp::CreateMaterials(std::string name, XMFLOAT4 diffuseAlbedo
 	material->DiffuseAlbedo = diffuseAlbedo;
 	material->FresnelR0 = fresnelR0;
 	material->Roughness = roughness;
+	mMaterialList.push_back(material.get());
+	mMaterialDirty.MarkDirty(material->MatCBIndex);
 	mMaterials[name] = std::move(material);
 }
 
@@ -1521,6 +1613,11 @@ void TreeBillboardsApp::BuildPSOs()
 	treeSpritePsoDesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
 
 	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&treeSpritePsoDesc, IID_PPV_ARGS(&mPSOs["treeSprites"])));
+
+	mLayerPSOs[(int)RenderLayer::Opaque] = mPSOs["opaque"].Get();
+	mLayerPSOs[(int)RenderLayer::Transparent] = mPSOs["transparent"].Get();
+	mLayerPSOs[(int)RenderLayer::AlphaTested] = mPSOs["alphaTested"].Get();
+	mLayerPSOs[(int)RenderLayer::AlphaTestedTreeSprites] = mPSOs["treeSprites"].Get();
 }
 
 void TreeBillboardsApp::BuildFrameResources()
@@ -1528,7 +1625,7 @@ void TreeBillboardsApp::BuildFrameResources()
     for(int i = 0; i < gNumFrameResources; ++i)
     {
         mFrameResources.push_back(std::make_unique<FrameResource>(md3dDevice.Get(),
-            1, (UINT)mAllRitems.size(), (UINT)mMaterials.size(), mWaves->VertexCount()));
+            1, mRitems.Capacity(), (UINT)mMaterials.size(), mWaves->VertexCount()));
     }
 }
 
@@ -1574,1187 +1671,1147 @@ void TreeBillboardsApp::BuildRenderItems()
 void TreeBillboardsApp::BuildGround(FXMVECTOR pos, FXMVECTOR scale, FXMVECTOR rotation)
 {
 	//Ground
-	auto ground = std::make_unique<RenderItem>();
+	RenderItemDesc ground;
 
 	//Local
-	XMStoreFloat4x4(&ground->World, XMMatrixScaling(1.0f, 1.0f, 1.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.0f, 0.f, 0.0f));
+	XMStoreFloat4x4(&ground.World, XMMatrixScaling(1.0f, 1.0f, 1.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.0f, 0.f, 0.0f));
 
 	//World
-	XMStoreFloat4x4(&ground->World,
-		XMLoadFloat4x4(&ground->World) *
+	XMStoreFloat4x4(&ground.World,
+		XMLoadFloat4x4(&ground.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	ground->Mat = mMaterials["Floor2"].get();
+	ground.Mat = mMaterials["Floor2"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&ground->TexTransform, XMMatrixScaling(5.0f, 5.0f, 1.0f));
-
-	ground->ObjCBIndex = mObjCBIndex++;
-	ground->Geo = mGeometries["shapeGeo"].get();
-	ground->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	ground->Bounds = ground->Geo->DrawArgs["grid"].Bounds;
-	ground->IndexCount = ground->Geo->DrawArgs["grid"].IndexCount;
-	ground->StartIndexLocation = ground->Geo->DrawArgs["grid"].StartIndexLocation;
-	ground->BaseVertexLocation = ground->Geo->DrawArgs["grid"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(ground.get());
-	mAllRitems.push_back(std::move(ground));
+	XMStoreFloat4x4(&ground.TexTransform, XMMatrixScaling(5.0f, 5.0f, 1.0f));
+
+	ground.Geo = mGeometries["shapeGeo"].get();
+	ground.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	ground.Bounds = ground.Geo->DrawArgs["grid"].Bounds;
+	ground.IndexCount = ground.Geo->DrawArgs["grid"].IndexCount;
+	ground.StartIndexLocation = ground.Geo->DrawArgs["grid"].StartIndexLocation;
+	ground.BaseVertexLocation = ground.Geo->DrawArgs["grid"].BaseVertexLocation;
+	ground.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(ground);
 }
 
 void TreeBillboardsApp::BuildWater(FXMVECTOR pos, FXMVECTOR scale, FXMVECTOR rotation)
 {
-	auto water = std::make_unique<RenderItem>();
+	RenderItemDesc water;
 	
 	//Local
-	XMStoreFloat4x4(&water->World, XMMatrixScaling(1.0f, 1.0f, 1.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.0f, 0.f, 0.0f));
+	XMStoreFloat4x4(&water.World, XMMatrixScaling(1.0f, 1.0f, 1.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.0f, 0.f, 0.0f));
 
 	//World
-	XMStoreFloat4x4(&water->World,
-		XMLoadFloat4x4(&water->World) *
+	XMStoreFloat4x4(&water.World,
+		XMLoadFloat4x4(&water.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	water->Mat = mMaterials["water"].get();
+	water.Mat = mMaterials["water"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&water->TexTransform, XMMatrixScaling(5.0f, 5.0f, 1.0f));
-
-	water->ObjCBIndex = mObjCBIndex++;
-	water->Geo = mGeometries["waterGeo"].get();
-	water->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	water->IndexCount = water->Geo->DrawArgs["water"].IndexCount;
-	water->StartIndexLocation = water->Geo->DrawArgs["water"].StartIndexLocation;
-	water->BaseVertexLocation = water->Geo->DrawArgs["water"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Transparent].push_back(water.get());
-	mWavesRitem = water.get();
-
-	mAllRitems.push_back(std::move(water));
+	XMStoreFloat4x4(&water.TexTransform, XMMatrixScaling(5.0f, 5.0f, 1.0f));
+
+	water.Geo = mGeometries["waterGeo"].get();
+	water.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	water.IndexCount = water.Geo->DrawArgs["water"].IndexCount;
+	water.StartIndexLocation = water.Geo->DrawArgs["water"].StartIndexLocation;
+	water.BaseVertexLocation = water.Geo->DrawArgs["water"].BaseVertexLocation;
+	water.Layer = (UINT)RenderLayer::Transparent;
+
+	mWavesRitem = mRitems.Add(water);
 }
 
 void TreeBillboardsApp::BuildHospital(FXMVECTOR pos, FXMVECTOR scale, FXMVECTOR rotation)
 {
 	//Main Box
-	auto mainBox = std::make_unique<RenderItem>();
+	RenderItemDesc mainBox;
 
 	//Local
-	XMStoreFloat4x4(&mainBox->World, XMMatrixScaling(3.0f, 2.0f, 1.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.0f, 0.f, 0.0f));
+	XMStoreFloat4x4(&mainBox.World, XMMatrixScaling(3.0f, 2.0f, 1.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.0f, 0.f, 0.0f));
 
 	//World
-	XMStoreFloat4x4(&mainBox->World,
-		XMLoadFloat4x4(&mainBox->World) *
+	XMStoreFloat4x4(&mainBox.World,
+		XMLoadFloat4x4(&mainBox.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	mainBox->Mat = mMaterials["White"].get();
+	mainBox.Mat = mMaterials["White"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&mainBox->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+	XMStoreFloat4x4(&mainBox.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
 
-	mainBox->ObjCBIndex = mObjCBIndex++;
-	mainBox->Geo = mGeometries["shapeGeo"].get();
-	mainBox->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	mainBox->Bounds = mainBox->Geo->DrawArgs["box"].Bounds;
-	mainBox->IndexCount = mainBox->Geo->DrawArgs["box"].IndexCount;
-	mainBox->StartIndexLocation = mainBox->Geo->DrawArgs["box"].StartIndexLocation;
-	mainBox->BaseVertexLocation = mainBox->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(mainBox.get());
-	mAllRitems.push_back(std::move(mainBox));
+	mainBox.Geo = mGeometries["shapeGeo"].get();
+	mainBox.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	mainBox.Bounds = mainBox.Geo->DrawArgs["box"].Bounds;
+	mainBox.IndexCount = mainBox.Geo->DrawArgs["box"].IndexCount;
+	mainBox.StartIndexLocation = mainBox.Geo->DrawArgs["box"].StartIndexLocation;
+	mainBox.BaseVertexLocation = mainBox.Geo->DrawArgs["box"].BaseVertexLocation;
+	mainBox.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(mainBox);
 
 
 	//Top Box
-	auto topBox = std::make_unique<RenderItem>();
+	RenderItemDesc topBox;
 
 	//Local
-	XMStoreFloat4x4(&topBox->World, XMMatrixScaling(1.0f, 1.0f, 0.6f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.0f, 1.5f, 0.2f));
+	XMStoreFloat4x4(&topBox.World, XMMatrixScaling(1.0f, 1.0f, 0.6f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.0f, 1.5f, 0.2f));
 
 	//World
-	XMStoreFloat4x4(&topBox->World,
-		XMLoadFloat4x4(&topBox->World) *
+	XMStoreFloat4x4(&topBox.World,
+		XMLoadFloat4x4(&topBox.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	topBox->Mat = mMaterials["White"].get();
+	topBox.Mat = mMaterials["White"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&topBox->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+	XMStoreFloat4x4(&topBox.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
 
-	topBox->ObjCBIndex = mObjCBIndex++;
-	topBox->Geo = mGeometries["shapeGeo"].get();
-	topBox->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	topBox->Bounds = topBox->Geo->DrawArgs["box"].Bounds;
-	topBox->IndexCount = topBox->Geo->DrawArgs["box"].IndexCount;
-	topBox->StartIndexLocation = topBox->Geo->DrawArgs["box"].StartIndexLocation;
-	topBox->BaseVertexLocation = topBox->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(topBox.get());
-	mAllRitems.push_back(std::move(topBox));
+	topBox.Geo = mGeometries["shapeGeo"].get();
+	topBox.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	topBox.Bounds = topBox.Geo->DrawArgs["box"].Bounds;
+	topBox.IndexCount = topBox.Geo->DrawArgs["box"].IndexCount;
+	topBox.StartIndexLocation = topBox.Geo->DrawArgs["box"].StartIndexLocation;
+	topBox.BaseVertexLocation = topBox.Geo->DrawArgs["box"].BaseVertexLocation;
+	topBox.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(topBox);
 
 
 	//Left BIg Box
-	auto leftBigBox = std::make_unique<RenderItem>();
+	RenderItemDesc leftBigBox;
 
 	//Local
-	XMStoreFloat4x4(&leftBigBox->World, XMMatrixScaling(1.0f, 4.0f, 0.7f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-2.0f, 1.f, 0.3f));
+	XMStoreFloat4x4(&leftBigBox.World, XMMatrixScaling(1.0f, 4.0f, 0.7f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-2.0f, 1.f, 0.3f));
 
 	//World
-	XMStoreFloat4x4(&leftBigBox->World,
-		XMLoadFloat4x4(&leftBigBox->World) *
+	XMStoreFloat4x4(&leftBigBox.World,
+		XMLoadFloat4x4(&leftBigBox.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	leftBigBox->Mat = mMaterials["White"].get();
+	leftBigBox.Mat = mMaterials["White"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&leftBigBox->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+	XMStoreFloat4x4(&leftBigBox.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
 
-	leftBigBox->ObjCBIndex = mObjCBIndex++;
-	leftBigBox->Geo = mGeometries["shapeGeo"].get();
-	leftBigBox->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	leftBigBox->Bounds = leftBigBox->Geo->DrawArgs["box"].Bounds;
-	leftBigBox->IndexCount = leftBigBox->Geo->DrawArgs["box"].IndexCount;
-	leftBigBox->StartIndexLocation = leftBigBox->Geo->DrawArgs["box"].StartIndexLocation;
-	leftBigBox->BaseVertexLocation = leftBigBox->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(leftBigBox.get());
-	mAllRitems.push_back(std::move(leftBigBox));
+	leftBigBox.Geo = mGeometries["shapeGeo"].get();
+	leftBigBox.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	leftBigBox.Bounds = leftBigBox.Geo->DrawArgs["box"].Bounds;
+	leftBigBox.IndexCount = leftBigBox.Geo->DrawArgs["box"].IndexCount;
+	leftBigBox.StartIndexLocation = leftBigBox.Geo->DrawArgs["box"].StartIndexLocation;
+	leftBigBox.BaseVertexLocation = leftBigBox.Geo->DrawArgs["box"].BaseVertexLocation;
+	leftBigBox.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(leftBigBox);
 
 
 	//Right BIg Box
-	auto rightBigBox = std::make_unique<RenderItem>();
+	RenderItemDesc rightBigBox;
 
 	//Local
-	XMStoreFloat4x4(&rightBigBox->World, XMMatrixScaling(1.0f, 4.0f, 0.7f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(2.0f, 1.f, 0.3f));
+	XMStoreFloat4x4(&rightBigBox.World, XMMatrixScaling(1.0f, 4.0f, 0.7f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(2.0f, 1.f, 0.3f));
 
 	//World
-	XMStoreFloat4x4(&rightBigBox->World,
-		XMLoadFloat4x4(&rightBigBox->World) *
+	XMStoreFloat4x4(&rightBigBox.World,
+		XMLoadFloat4x4(&rightBigBox.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	rightBigBox->Mat = mMaterials["White"].get();
+	rightBigBox.Mat = mMaterials["White"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&rightBigBox->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+	XMStoreFloat4x4(&rightBigBox.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
 
-	rightBigBox->ObjCBIndex = mObjCBIndex++;
-	rightBigBox->Geo = mGeometries["shapeGeo"].get();
-	rightBigBox->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	rightBigBox->Bounds = rightBigBox->Geo->DrawArgs["box"].Bounds;
-	rightBigBox->IndexCount = rightBigBox->Geo->DrawArgs["box"].IndexCount;
-	rightBigBox->StartIndexLocation = rightBigBox->Geo->DrawArgs["box"].StartIndexLocation;
-	rightBigBox->BaseVertexLocation = rightBigBox->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(rightBigBox.get());
-	mAllRitems.push_back(std::move(rightBigBox));
+	rightBigBox.Geo = mGeometries["shapeGeo"].get();
+	rightBigBox.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	rightBigBox.Bounds = rightBigBox.Geo->DrawArgs["box"].Bounds;
+	rightBigBox.IndexCount = rightBigBox.Geo->DrawArgs["box"].IndexCount;
+	rightBigBox.StartIndexLocation = rightBigBox.Geo->DrawArgs["box"].StartIndexLocation;
+	rightBigBox.BaseVertexLocation = rightBigBox.Geo->DrawArgs["box"].BaseVertexLocation;
+	rightBigBox.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(rightBigBox);
 
 
 	//left small Box
-	auto leftSmallBox = std::make_unique<RenderItem>();
+	RenderItemDesc leftSmallBox;
 
 	//Local
-	XMStoreFloat4x4(&leftSmallBox->World, XMMatrixScaling(1.0f, 1.0f, 1.f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-2.0f, -0.5f, -0.6f));
+	XMStoreFloat4x4(&leftSmallBox.World, XMMatrixScaling(1.0f, 1.0f, 1.f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-2.0f, -0.5f, -0.6f));
 
 	//World
-	XMStoreFloat4x4(&leftSmallBox->World,
-		XMLoadFloat4x4(&leftSmallBox->World) *
+	XMStoreFloat4x4(&leftSmallBox.World,
+		XMLoadFloat4x4(&leftSmallBox.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	leftSmallBox->Mat = mMaterials["White"].get();
+	leftSmallBox.Mat = mMaterials["White"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&leftSmallBox->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+	XMStoreFloat4x4(&leftSmallBox.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
 
-	leftSmallBox->ObjCBIndex = mObjCBIndex++;
-	leftSmallBox->Geo = mGeometries["shapeGeo"].get();
-	leftSmallBox->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	leftSmallBox->Bounds = leftSmallBox->Geo->DrawArgs["box"].Bounds;
-	leftSmallBox->IndexCount = leftSmallBox->Geo->DrawArgs["box"].IndexCount;
-	leftSmallBox->StartIndexLocation = leftSmallBox->Geo->DrawArgs["box"].StartIndexLocation;
-	leftSmallBox->BaseVertexLocation = leftSmallBox->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(leftSmallBox.get());
-	mAllRitems.push_back(std::move(leftSmallBox));
+	leftSmallBox.Geo = mGeometries["shapeGeo"].get();
+	leftSmallBox.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	leftSmallBox.Bounds = leftSmallBox.Geo->DrawArgs["box"].Bounds;
+	leftSmallBox.IndexCount = leftSmallBox.Geo->DrawArgs["box"].IndexCount;
+	leftSmallBox.StartIndexLocation = leftSmallBox.Geo->DrawArgs["box"].StartIndexLocation;
+	leftSmallBox.BaseVertexLocation = leftSmallBox.Geo->DrawArgs["box"].BaseVertexLocation;
+	leftSmallBox.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(leftSmallBox);
 
 
 	//right small Box
-	auto rightSmallBox = std::make_unique<RenderItem>();
+	RenderItemDesc rightSmallBox;
 
 	//Local
-	XMStoreFloat4x4(&rightSmallBox->World, XMMatrixScaling(1.0f, 1.0f, 1.f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(2.0f, -0.5f, -0.6f));
+	XMStoreFloat4x4(&rightSmallBox.World, XMMatrixScaling(1.0f, 1.0f, 1.f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(2.0f, -0.5f, -0.6f));
 
 	//World
-	XMStoreFloat4x4(&rightSmallBox->World,
-		XMLoadFloat4x4(&rightSmallBox->World) *
+	XMStoreFloat4x4(&rightSmallBox.World,
+		XMLoadFloat4x4(&rightSmallBox.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	rightSmallBox->Mat = mMaterials["White"].get();
+	rightSmallBox.Mat = mMaterials["White"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&rightSmallBox->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+	XMStoreFloat4x4(&rightSmallBox.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
 
 
-	rightSmallBox->ObjCBIndex = mObjCBIndex++;
-	rightSmallBox->Geo = mGeometries["shapeGeo"].get();
-	rightSmallBox->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	rightSmallBox->Bounds = rightSmallBox->Geo->DrawArgs["box"].Bounds;
-	rightSmallBox->IndexCount = rightSmallBox->Geo->DrawArgs["box"].IndexCount;
-	rightSmallBox->StartIndexLocation = rightSmallBox->Geo->DrawArgs["box"].StartIndexLocation;
-	rightSmallBox->BaseVertexLocation = rightSmallBox->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(rightSmallBox.get());
-	mAllRitems.push_back(std::move(rightSmallBox));
+	rightSmallBox.Geo = mGeometries["shapeGeo"].get();
+	rightSmallBox.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	rightSmallBox.Bounds = rightSmallBox.Geo->DrawArgs["box"].Bounds;
+	rightSmallBox.IndexCount = rightSmallBox.Geo->DrawArgs["box"].IndexCount;
+	rightSmallBox.StartIndexLocation = rightSmallBox.Geo->DrawArgs["box"].StartIndexLocation;
+	rightSmallBox.BaseVertexLocation = rightSmallBox.Geo->DrawArgs["box"].BaseVertexLocation;
+	rightSmallBox.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(rightSmallBox);
 
 
 	//Cross Vertical Box
-	auto crossVerticalBox = std::make_unique<RenderItem>();
+	RenderItemDesc crossVerticalBox;
 
 	//Local
-	XMStoreFloat4x4(&crossVerticalBox->World, XMMatrixScaling(0.7f, 0.2f, 0.1f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.0f, 1.5f, -0.1f));
+	XMStoreFloat4x4(&crossVerticalBox.World, XMMatrixScaling(0.7f, 0.2f, 0.1f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.0f, 1.5f, -0.1f));
 
 	//World
-	XMStoreFloat4x4(&crossVerticalBox->World,
-		XMLoadFloat4x4(&crossVerticalBox->World) *
+	XMStoreFloat4x4(&crossVerticalBox.World,
+		XMLoadFloat4x4(&crossVerticalBox.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	crossVerticalBox->Mat = mMaterials["redBrick"].get();
+	crossVerticalBox.Mat = mMaterials["redBrick"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&crossVerticalBox->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+	XMStoreFloat4x4(&crossVerticalBox.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
 
-	crossVerticalBox->ObjCBIndex = mObjCBIndex++;
-	crossVerticalBox->Geo = mGeometries["shapeGeo"].get();
-	crossVerticalBox->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	crossVerticalBox->Bounds = crossVerticalBox->Geo->DrawArgs["box"].Bounds;
-	crossVerticalBox->IndexCount = crossVerticalBox->Geo->DrawArgs["box"].IndexCount;
-	crossVerticalBox->StartIndexLocation = crossVerticalBox->Geo->DrawArgs["box"].StartIndexLocation;
-	crossVerticalBox->BaseVertexLocation = crossVerticalBox->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(crossVerticalBox.get());
-	mAllRitems.push_back(std::move(crossVerticalBox));
+	crossVerticalBox.Geo = mGeometries["shapeGeo"].get();
+	crossVerticalBox.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	crossVerticalBox.Bounds = crossVerticalBox.Geo->DrawArgs["box"].Bounds;
+	crossVerticalBox.IndexCount = crossVerticalBox.Geo->DrawArgs["box"].IndexCount;
+	crossVerticalBox.StartIndexLocation = crossVerticalBox.Geo->DrawArgs["box"].StartIndexLocation;
+	crossVerticalBox.BaseVertexLocation = crossVerticalBox.Geo->DrawArgs["box"].BaseVertexLocation;
+	crossVerticalBox.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(crossVerticalBox);
 
 
 	//Cross Horizontal Box
-	auto crossHorizontalBox = std::make_unique<RenderItem>();
+	RenderItemDesc crossHorizontalBox;
 
 	//Local
-	XMStoreFloat4x4(&crossHorizontalBox->World, XMMatrixScaling(0.2f, 0.7f, 0.1f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.0f, 1.5f, -0.1f));
+	XMStoreFloat4x4(&crossHorizontalBox.World, XMMatrixScaling(0.2f, 0.7f, 0.1f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.0f, 1.5f, -0.1f));
 
 	//World
-	XMStoreFloat4x4(&crossHorizontalBox->World,
-		XMLoadFloat4x4(&crossHorizontalBox->World) *
+	XMStoreFloat4x4(&crossHorizontalBox.World,
+		XMLoadFloat4x4(&crossHorizontalBox.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	crossHorizontalBox->Mat = mMaterials["redBrick"].get();
+	crossHorizontalBox.Mat = mMaterials["redBrick"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&crossHorizontalBox->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	crossHorizontalBox->ObjCBIndex = mObjCBIndex++;
-	crossHorizontalBox->Geo = mGeometries["shapeGeo"].get();
-	crossHorizontalBox->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	crossHorizontalBox->Bounds = crossHorizontalBox->Geo->DrawArgs["box"].Bounds;
-	crossHorizontalBox->IndexCount = crossHorizontalBox->Geo->DrawArgs["box"].IndexCount;
-	crossHorizontalBox->StartIndexLocation = crossHorizontalBox->Geo->DrawArgs["box"].StartIndexLocation;
-	crossHorizontalBox->BaseVertexLocation = crossHorizontalBox->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(crossHorizontalBox.get());
-	mAllRitems.push_back(std::move(crossHorizontalBox));
+	XMStoreFloat4x4(&crossHorizontalBox.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	crossHorizontalBox.Geo = mGeometries["shapeGeo"].get();
+	crossHorizontalBox.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	crossHorizontalBox.Bounds = crossHorizontalBox.Geo->DrawArgs["box"].Bounds;
+	crossHorizontalBox.IndexCount = crossHorizontalBox.Geo->DrawArgs["box"].IndexCount;
+	crossHorizontalBox.StartIndexLocation = crossHorizontalBox.Geo->DrawArgs["box"].StartIndexLocation;
+	crossHorizontalBox.BaseVertexLocation = crossHorizontalBox.Geo->DrawArgs["box"].BaseVertexLocation;
+	crossHorizontalBox.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(crossHorizontalBox);
 }
 
 void TreeBillboardsApp::BuildTree(FXMVECTOR pos, FXMVECTOR scale, FXMVECTOR rotation)
 {
-	auto treeBillboard = std::make_unique<RenderItem>();
+	RenderItemDesc treeBillboard;
 
 	//Local
-	XMStoreFloat4x4(&treeBillboard->World, XMMatrixScaling(1.0f, 1.0f, 1.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.0f, 0.f, 0.0f));
+	XMStoreFloat4x4(&treeBillboard.World, XMMatrixScaling(1.0f, 1.0f, 1.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.0f, 0.f, 0.0f));
 
 	//World
-	XMStoreFloat4x4(&treeBillboard->World,
-		XMLoadFloat4x4(&treeBillboard->World) *
+	XMStoreFloat4x4(&treeBillboard.World,
+		XMLoadFloat4x4(&treeBillboard.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	treeBillboard->Mat = mMaterials["treeSprites"].get();
+	treeBillboard.Mat = mMaterials["treeSprites"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&treeBillboard->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+	XMStoreFloat4x4(&treeBillboard.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
 
 
-	treeBillboard->ObjCBIndex = mObjCBIndex++;
-	treeBillboard->Geo = mGeometries["treeSpritesGeo"].get();
-	treeBillboard->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_POINTLIST;
-	treeBillboard->IndexCount = treeBillboard->Geo->DrawArgs["points"].IndexCount;
-	treeBillboard->StartIndexLocation = treeBillboard->Geo->DrawArgs["points"].StartIndexLocation;
-	treeBillboard->BaseVertexLocation = treeBillboard->Geo->DrawArgs["points"].BaseVertexLocation;
+	treeBillboard.Geo = mGeometries["treeSpritesGeo"].get();
+	treeBillboard.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_POINTLIST;
+	treeBillboard.IndexCount = treeBillboard.Geo->DrawArgs["points"].IndexCount;
+	treeBillboard.StartIndexLocation = treeBillboard.Geo->DrawArgs["points"].StartIndexLocation;
+	treeBillboard.BaseVertexLocation = treeBillboard.Geo->DrawArgs["points"].BaseVertexLocation;
 
-	mRitemLayer[(int)RenderLayer::AlphaTestedTreeSprites].push_back(treeBillboard.get());
-	mAllRitems.push_back(std::move(treeBillboard));
+	treeBillboard.Layer = (UINT)RenderLayer::AlphaTestedTreeSprites;
+	mRitems.Add(treeBillboard);
 }
 
 void TreeBillboardsApp::BuildFourBuildings(FXMVECTOR pos, FXMVECTOR scale, FXMVECTOR rotation)
 {
 	//1st Building
-	auto firstBuilding = std::make_unique<RenderItem>();
+	RenderItemDesc firstBuilding;
 
 	//Local
-	XMStoreFloat4x4(&firstBuilding->World, XMMatrixScaling(2.0f, 10.0f, 2.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-2.0f, 0.f, 0.0f));
+	XMStoreFloat4x4(&firstBuilding.World, XMMatrixScaling(2.0f, 10.0f, 2.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-2.0f, 0.f, 0.0f));
 
 	//World
-	XMStoreFloat4x4(&firstBuilding->World,
-		XMLoadFloat4x4(&firstBuilding->World) *
+	XMStoreFloat4x4(&firstBuilding.World,
+		XMLoadFloat4x4(&firstBuilding.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	firstBuilding->Mat = mMaterials["brick3"].get();
+	firstBuilding.Mat = mMaterials["brick3"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&firstBuilding->TexTransform, XMMatrixScaling(2.0f, 2.0f, 1.0f));
+	XMStoreFloat4x4(&firstBuilding.TexTransform, XMMatrixScaling(2.0f, 2.0f, 1.0f));
 
-	firstBuilding->ObjCBIndex = mObjCBIndex++;
-	firstBuilding->Geo = mGeometries["shapeGeo"].get();
-	firstBuilding->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	firstBuilding->Bounds = firstBuilding->Geo->DrawArgs["box"].Bounds;
-	firstBuilding->IndexCount = firstBuilding->Geo->DrawArgs["box"].IndexCount;
-	firstBuilding->StartIndexLocation = firstBuilding->Geo->DrawArgs["box"].StartIndexLocation;
-	firstBuilding->BaseVertexLocation = firstBuilding->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(firstBuilding.get());
-	mAllRitems.push_back(std::move(firstBuilding));
+	firstBuilding.Geo = mGeometries["shapeGeo"].get();
+	firstBuilding.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	firstBuilding.Bounds = firstBuilding.Geo->DrawArgs["box"].Bounds;
+	firstBuilding.IndexCount = firstBuilding.Geo->DrawArgs["box"].IndexCount;
+	firstBuilding.StartIndexLocation = firstBuilding.Geo->DrawArgs["box"].StartIndexLocation;
+	firstBuilding.BaseVertexLocation = firstBuilding.Geo->DrawArgs["box"].BaseVertexLocation;
+	firstBuilding.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(firstBuilding);
 
 
 
 	//2nd Building
-	auto secondBuilding = std::make_unique<RenderItem>();
+	RenderItemDesc secondBuilding;
 
 	//Local
-	XMStoreFloat4x4(&secondBuilding->World, XMMatrixScaling(2.0f, 10.0f, 2.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-2.0f, 0.f, -5.0f));
+	XMStoreFloat4x4(&secondBuilding.World, XMMatrixScaling(2.0f, 10.0f, 2.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-2.0f, 0.f, -5.0f));
 
 	//World
-	XMStoreFloat4x4(&secondBuilding->World,
-		XMLoadFloat4x4(&secondBuilding->World) *
+	XMStoreFloat4x4(&secondBuilding.World,
+		XMLoadFloat4x4(&secondBuilding.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	secondBuilding->Mat = mMaterials["ice"].get();
+	secondBuilding.Mat = mMaterials["ice"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&secondBuilding->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+	XMStoreFloat4x4(&secondBuilding.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
 
-	secondBuilding->ObjCBIndex = mObjCBIndex++;
-	secondBuilding->Geo = mGeometries["shapeGeo"].get();
-	secondBuilding->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	secondBuilding->Bounds = secondBuilding->Geo->DrawArgs["box"].Bounds;
-	secondBuilding->IndexCount = secondBuilding->Geo->DrawArgs["box"].IndexCount;
-	secondBuilding->StartIndexLocation = secondBuilding->Geo->DrawArgs["box"].StartIndexLocation;
-	secondBuilding->BaseVertexLocation = secondBuilding->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(secondBuilding.get());
-	mAllRitems.push_back(std::move(secondBuilding));
+	secondBuilding.Geo = mGeometries["shapeGeo"].get();
+	secondBuilding.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	secondBuilding.Bounds = secondBuilding.Geo->DrawArgs["box"].Bounds;
+	secondBuilding.IndexCount = secondBuilding.Geo->DrawArgs["box"].IndexCount;
+	secondBuilding.StartIndexLocation = secondBuilding.Geo->DrawArgs["box"].StartIndexLocation;
+	secondBuilding.BaseVertexLocation = secondBuilding.Geo->DrawArgs["box"].BaseVertexLocation;
+	secondBuilding.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(secondBuilding);
 
 
 
 	//3rd Building
-	auto thirdBuilding = std::make_unique<RenderItem>();
+	RenderItemDesc thirdBuilding;
 
 	//Local
-	XMStoreFloat4x4(&thirdBuilding->World, XMMatrixScaling(2.0f, 10.0f, 2.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(3.0f, 0.f, 0.0f));
+	XMStoreFloat4x4(&thirdBuilding.World, XMMatrixScaling(2.0f, 10.0f, 2.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(3.0f, 0.f, 0.0f));
 
 	//World
-	XMStoreFloat4x4(&thirdBuilding->World,
-		XMLoadFloat4x4(&thirdBuilding->World) *
+	XMStoreFloat4x4(&thirdBuilding.World,
+		XMLoadFloat4x4(&thirdBuilding.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	thirdBuilding->Mat = mMaterials["brick3"].get();
+	thirdBuilding.Mat = mMaterials["brick3"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&thirdBuilding->TexTransform, XMMatrixScaling(2.0f, 2.0f, 1.0f));
+	XMStoreFloat4x4(&thirdBuilding.TexTransform, XMMatrixScaling(2.0f, 2.0f, 1.0f));
 
-	thirdBuilding->ObjCBIndex = mObjCBIndex++;
-	thirdBuilding->Geo = mGeometries["shapeGeo"].get();
-	thirdBuilding->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	thirdBuilding->Bounds = thirdBuilding->Geo->DrawArgs["box"].Bounds;
-	thirdBuilding->IndexCount = thirdBuilding->Geo->DrawArgs["box"].IndexCount;
-	thirdBuilding->StartIndexLocation = thirdBuilding->Geo->DrawArgs["box"].StartIndexLocation;
-	thirdBuilding->BaseVertexLocation = thirdBuilding->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(thirdBuilding.get());
-	mAllRitems.push_back(std::move(thirdBuilding));
+	thirdBuilding.Geo = mGeometries["shapeGeo"].get();
+	thirdBuilding.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	thirdBuilding.Bounds = thirdBuilding.Geo->DrawArgs["box"].Bounds;
+	thirdBuilding.IndexCount = thirdBuilding.Geo->DrawArgs["box"].IndexCount;
+	thirdBuilding.StartIndexLocation = thirdBuilding.Geo->DrawArgs["box"].StartIndexLocation;
+	thirdBuilding.BaseVertexLocation = thirdBuilding.Geo->DrawArgs["box"].BaseVertexLocation;
+	thirdBuilding.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(thirdBuilding);
 
 
 	//4th Building
-	auto fourthBuilding = std::make_unique<RenderItem>();
+	RenderItemDesc fourthBuilding;
 
 	//Local
-	XMStoreFloat4x4(&fourthBuilding->World, XMMatrixScaling(2.0f, 10.0f, 2.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(3.0f, 0.f, -5.0f));
+	XMStoreFloat4x4(&fourthBuilding.World, XMMatrixScaling(2.0f, 10.0f, 2.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(3.0f, 0.f, -5.0f));
 
 	//World
-	XMStoreFloat4x4(&fourthBuilding->World,
-		XMLoadFloat4x4(&fourthBuilding->World) *
+	XMStoreFloat4x4(&fourthBuilding.World,
+		XMLoadFloat4x4(&fourthBuilding.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	fourthBuilding->Mat = mMaterials["ice"].get();
+	fourthBuilding.Mat = mMaterials["ice"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&fourthBuilding->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	fourthBuilding->ObjCBIndex = mObjCBIndex++;
-	fourthBuilding->Geo = mGeometries["shapeGeo"].get();
-	fourthBuilding->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	fourthBuilding->Bounds = fourthBuilding->Geo->DrawArgs["box"].Bounds;
-	fourthBuilding->IndexCount = fourthBuilding->Geo->DrawArgs["box"].IndexCount;
-	fourthBuilding->StartIndexLocation = fourthBuilding->Geo->DrawArgs["box"].StartIndexLocation;
-	fourthBuilding->BaseVertexLocation = fourthBuilding->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(fourthBuilding.get());
-	mAllRitems.push_back(std::move(fourthBuilding));
+	XMStoreFloat4x4(&fourthBuilding.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	fourthBuilding.Geo = mGeometries["shapeGeo"].get();
+	fourthBuilding.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	fourthBuilding.Bounds = fourthBuilding.Geo->DrawArgs["box"].Bounds;
+	fourthBuilding.IndexCount = fourthBuilding.Geo->DrawArgs["box"].IndexCount;
+	fourthBuilding.StartIndexLocation = fourthBuilding.Geo->DrawArgs["box"].StartIndexLocation;
+	fourthBuilding.BaseVertexLocation = fourthBuilding.Geo->DrawArgs["box"].BaseVertexLocation;
+	fourthBuilding.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(fourthBuilding);
 }
 
 void TreeBillboardsApp::BuildWaterBuilding(FXMVECTOR pos, FXMVECTOR scale, FXMVECTOR rotation)
 {
 	//Main Box
-	auto mainBox = std::make_unique<RenderItem>();
+	RenderItemDesc mainBox;
 
 	//Local
-	XMStoreFloat4x4(&mainBox->World, XMMatrixScaling(4.0f, 3.0f, 4.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.0f, 0.f, 0.0f));
+	XMStoreFloat4x4(&mainBox.World, XMMatrixScaling(4.0f, 3.0f, 4.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.0f, 0.f, 0.0f));
 
 	//World
-	XMStoreFloat4x4(&mainBox->World,
-		XMLoadFloat4x4(&mainBox->World) *
+	XMStoreFloat4x4(&mainBox.World,
+		XMLoadFloat4x4(&mainBox.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	mainBox->Mat = mMaterials["tile"].get();
+	mainBox.Mat = mMaterials["tile"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&mainBox->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+	XMStoreFloat4x4(&mainBox.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
 
-	mainBox->ObjCBIndex = mObjCBIndex++;
-	mainBox->Geo = mGeometries["shapeGeo"].get();
-	mainBox->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	mainBox->Bounds = mainBox->Geo->DrawArgs["box"].Bounds;
-	mainBox->IndexCount = mainBox->Geo->DrawArgs["box"].IndexCount;
-	mainBox->StartIndexLocation = mainBox->Geo->DrawArgs["box"].StartIndexLocation;
-	mainBox->BaseVertexLocation = mainBox->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(mainBox.get());
-	mAllRitems.push_back(std::move(mainBox));
+	mainBox.Geo = mGeometries["shapeGeo"].get();
+	mainBox.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	mainBox.Bounds = mainBox.Geo->DrawArgs["box"].Bounds;
+	mainBox.IndexCount = mainBox.Geo->DrawArgs["box"].IndexCount;
+	mainBox.StartIndexLocation = mainBox.Geo->DrawArgs["box"].StartIndexLocation;
+	mainBox.BaseVertexLocation = mainBox.Geo->DrawArgs["box"].BaseVertexLocation;
+	mainBox.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(mainBox);
 
 
 	//Upper Box
-	auto upperBox = std::make_unique<RenderItem>();
+	RenderItemDesc upperBox;
 
 	//Local
-	XMStoreFloat4x4(&upperBox->World, XMMatrixScaling(3.5f, 2.0f, 3.5f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.0f, 2.f, 0.0f));
+	XMStoreFloat4x4(&upperBox.World, XMMatrixScaling(3.5f, 2.0f, 3.5f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.0f, 2.f, 0.0f));
 
 	//World
-	XMStoreFloat4x4(&upperBox->World,
-		XMLoadFloat4x4(&upperBox->World) *
+	XMStoreFloat4x4(&upperBox.World,
+		XMLoadFloat4x4(&upperBox.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	upperBox->Mat = mMaterials["Glass2"].get();
+	upperBox.Mat = mMaterials["Glass2"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&upperBox->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+	XMStoreFloat4x4(&upperBox.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
 
-	upperBox->ObjCBIndex = mObjCBIndex++;
-	upperBox->Geo = mGeometries["shapeGeo"].get();
-	upperBox->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	upperBox->Bounds = upperBox->Geo->DrawArgs["box"].Bounds;
-	upperBox->IndexCount = upperBox->Geo->DrawArgs["box"].IndexCount;
-	upperBox->StartIndexLocation = upperBox->Geo->DrawArgs["box"].StartIndexLocation;
-	upperBox->BaseVertexLocation = upperBox->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(upperBox.get());
-	mAllRitems.push_back(std::move(upperBox));
+	upperBox.Geo = mGeometries["shapeGeo"].get();
+	upperBox.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	upperBox.Bounds = upperBox.Geo->DrawArgs["box"].Bounds;
+	upperBox.IndexCount = upperBox.Geo->DrawArgs["box"].IndexCount;
+	upperBox.StartIndexLocation = upperBox.Geo->DrawArgs["box"].StartIndexLocation;
+	upperBox.BaseVertexLocation = upperBox.Geo->DrawArgs["box"].BaseVertexLocation;
+	upperBox.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(upperBox);
 
 
 	//Door
-	auto door = std::make_unique<RenderItem>();
+	RenderItemDesc door;
 
 	//Local
-	XMStoreFloat4x4(&door->World, XMMatrixScaling(1.f, 1.f, 0.1f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-1.0f, -0.5f, -2.f));
+	XMStoreFloat4x4(&door.World, XMMatrixScaling(1.f, 1.f, 0.1f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-1.0f, -0.5f, -2.f));
 
 	//World
-	XMStoreFloat4x4(&door->World,
-		XMLoadFloat4x4(&door->World) *
+	XMStoreFloat4x4(&door.World,
+		XMLoadFloat4x4(&door.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	door->Mat = mMaterials["door"].get();
+	door.Mat = mMaterials["door"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&door->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+	XMStoreFloat4x4(&door.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
 
 
-	door->ObjCBIndex = mObjCBIndex++;
-	door->Geo = mGeometries["shapeGeo"].get();
-	door->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	door->Bounds = door->Geo->DrawArgs["box"].Bounds;
-	door->IndexCount = door->Geo->DrawArgs["box"].IndexCount;
-	door->StartIndexLocation = door->Geo->DrawArgs["box"].StartIndexLocation;
-	door->BaseVertexLocation = door->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(door.get());
-	mAllRitems.push_back(std::move(door));
+	door.Geo = mGeometries["shapeGeo"].get();
+	door.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	door.Bounds = door.Geo->DrawArgs["box"].Bounds;
+	door.IndexCount = door.Geo->DrawArgs["box"].IndexCount;
+	door.StartIndexLocation = door.Geo->DrawArgs["box"].StartIndexLocation;
+	door.BaseVertexLocation = door.Geo->DrawArgs["box"].BaseVertexLocation;
+	door.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(door);
 
 
 	//Bridge
-	auto bridge = std::make_unique<RenderItem>();
+	RenderItemDesc bridge;
 
 	//Local
-	XMStoreFloat4x4(&bridge->World, XMMatrixScaling(1.f, 1.f, 0.1f) * XMMatrixRotationRollPitchYaw(1.6f, 0.f, 0.f) * XMMatrixTranslation(-1.0f, -1.0f, -2.5f));
+	XMStoreFloat4x4(&bridge.World, XMMatrixScaling(1.f, 1.f, 0.1f) * XMMatrixRotationRollPitchYaw(1.6f, 0.f, 0.f) * XMMatrixTranslation(-1.0f, -1.0f, -2.5f));
 
 	//World
-	XMStoreFloat4x4(&bridge->World,
-		XMLoadFloat4x4(&bridge->World) *
+	XMStoreFloat4x4(&bridge.World,
+		XMLoadFloat4x4(&bridge.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	bridge->Mat = mMaterials["woodFloor"].get();
+	bridge.Mat = mMaterials["woodFloor"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&bridge->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+	XMStoreFloat4x4(&bridge.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
 
-	bridge->ObjCBIndex = mObjCBIndex++;
-	bridge->Geo = mGeometries["shapeGeo"].get();
-	bridge->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	bridge->Bounds = bridge->Geo->DrawArgs["box"].Bounds;
-	bridge->IndexCount = bridge->Geo->DrawArgs["box"].IndexCount;
-	bridge->StartIndexLocation = bridge->Geo->DrawArgs["box"].StartIndexLocation;
-	bridge->BaseVertexLocation = bridge->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(bridge.get());
-	mAllRitems.push_back(std::move(bridge));
+	bridge.Geo = mGeometries["shapeGeo"].get();
+	bridge.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	bridge.Bounds = bridge.Geo->DrawArgs["box"].Bounds;
+	bridge.IndexCount = bridge.Geo->DrawArgs["box"].IndexCount;
+	bridge.StartIndexLocation = bridge.Geo->DrawArgs["box"].StartIndexLocation;
+	bridge.BaseVertexLocation = bridge.Geo->DrawArgs["box"].BaseVertexLocation;
+	bridge.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(bridge);
 
 
 	//Wood Ground
-	auto woodGround = std::make_unique<RenderItem>();
+	RenderItemDesc woodGround;
 
 	//Local
-	XMStoreFloat4x4(&woodGround->World, XMMatrixScaling(3.f, 3.f, 0.2f) * XMMatrixRotationRollPitchYaw(1.6f, 0.f, 0.f) * XMMatrixTranslation(0.0f, -1.0f, -4.5f));
+	XMStoreFloat4x4(&woodGround.World, XMMatrixScaling(3.f, 3.f, 0.2f) * XMMatrixRotationRollPitchYaw(1.6f, 0.f, 0.f) * XMMatrixTranslation(0.0f, -1.0f, -4.5f));
 
 	//World
-	XMStoreFloat4x4(&woodGround->World,
-		XMLoadFloat4x4(&woodGround->World) *
+	XMStoreFloat4x4(&woodGround.World,
+		XMLoadFloat4x4(&woodGround.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	woodGround->Mat = mMaterials["woodFloor"].get();
+	woodGround.Mat = mMaterials["woodFloor"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&woodGround->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	woodGround->ObjCBIndex = mObjCBIndex++;
-	woodGround->Geo = mGeometries["shapeGeo"].get();
-	woodGround->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	woodGround->Bounds = woodGround->Geo->DrawArgs["box"].Bounds;
-	woodGround->IndexCount = woodGround->Geo->DrawArgs["box"].IndexCount;
-	woodGround->StartIndexLocation = woodGround->Geo->DrawArgs["box"].StartIndexLocation;
-	woodGround->BaseVertexLocation = woodGround->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(woodGround.get());
-	mAllRitems.push_back(std::move(woodGround));
+	XMStoreFloat4x4(&woodGround.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	woodGround.Geo = mGeometries["shapeGeo"].get();
+	woodGround.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	woodGround.Bounds = woodGround.Geo->DrawArgs["box"].Bounds;
+	woodGround.IndexCount = woodGround.Geo->DrawArgs["box"].IndexCount;
+	woodGround.StartIndexLocation = woodGround.Geo->DrawArgs["box"].StartIndexLocation;
+	woodGround.BaseVertexLocation = woodGround.Geo->DrawArgs["box"].BaseVertexLocation;
+	woodGround.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(woodGround);
 }
 
 void TreeBillboardsApp::BuildTwoBuildings(FXMVECTOR pos, FXMVECTOR scale, FXMVECTOR rotation)
 {
 	//1st Building
-	auto firstBuilding = std::make_unique<RenderItem>();
+	RenderItemDesc firstBuilding;
 
 	//Local
-	XMStoreFloat4x4(&firstBuilding->World, XMMatrixScaling(2.0f, 10.0f, 2.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-2.0f, 0.f, 0.0f));
+	XMStoreFloat4x4(&firstBuilding.World, XMMatrixScaling(2.0f, 10.0f, 2.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-2.0f, 0.f, 0.0f));
 
 	//World
-	XMStoreFloat4x4(&firstBuilding->World,
-		XMLoadFloat4x4(&firstBuilding->World) *
+	XMStoreFloat4x4(&firstBuilding.World,
+		XMLoadFloat4x4(&firstBuilding.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	firstBuilding->Mat = mMaterials["Navy"].get();
+	firstBuilding.Mat = mMaterials["Navy"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&firstBuilding->TexTransform, XMMatrixScaling(3.0f, 3.0f, 1.0f));
-
-	firstBuilding->ObjCBIndex = mObjCBIndex++;
-	firstBuilding->Geo = mGeometries["shapeGeo"].get();
-	firstBuilding->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	firstBuilding->Bounds = firstBuilding->Geo->DrawArgs["box"].Bounds;
-	firstBuilding->IndexCount = firstBuilding->Geo->DrawArgs["box"].IndexCount;
-	firstBuilding->StartIndexLocation = firstBuilding->Geo->DrawArgs["box"].StartIndexLocation;
-	firstBuilding->BaseVertexLocation = firstBuilding->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(firstBuilding.get());
-	mAllRitems.push_back(std::move(firstBuilding));
+	XMStoreFloat4x4(&firstBuilding.TexTransform, XMMatrixScaling(3.0f, 3.0f, 1.0f));
+
+	firstBuilding.Geo = mGeometries["shapeGeo"].get();
+	firstBuilding.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	firstBuilding.Bounds = firstBuilding.Geo->DrawArgs["box"].Bounds;
+	firstBuilding.IndexCount = firstBuilding.Geo->DrawArgs["box"].IndexCount;
+	firstBuilding.StartIndexLocation = firstBuilding.Geo->DrawArgs["box"].StartIndexLocation;
+	firstBuilding.BaseVertexLocation = firstBuilding.Geo->DrawArgs["box"].BaseVertexLocation;
+	firstBuilding.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(firstBuilding);
 
 	//2nd Building
-	auto secondBuilding = std::make_unique<RenderItem>();
+	RenderItemDesc secondBuilding;
 
 	//Local
-	XMStoreFloat4x4(&secondBuilding->World, XMMatrixScaling(2.0f, 10.0f, 2.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(3.0f, 0.f, 0.0f));
+	XMStoreFloat4x4(&secondBuilding.World, XMMatrixScaling(2.0f, 10.0f, 2.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(3.0f, 0.f, 0.0f));
 
 	//World
-	XMStoreFloat4x4(&secondBuilding->World,
-		XMLoadFloat4x4(&secondBuilding->World) *
+	XMStoreFloat4x4(&secondBuilding.World,
+		XMLoadFloat4x4(&secondBuilding.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	secondBuilding->Mat = mMaterials["Navy"].get();
+	secondBuilding.Mat = mMaterials["Navy"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&secondBuilding->TexTransform, XMMatrixScaling(3.0f, 3.0f, 1.0f));
+	XMStoreFloat4x4(&secondBuilding.TexTransform, XMMatrixScaling(3.0f, 3.0f, 1.0f));
 
-	secondBuilding->ObjCBIndex = mObjCBIndex++;
-	secondBuilding->Geo = mGeometries["shapeGeo"].get();
-	secondBuilding->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	secondBuilding->Bounds = secondBuilding->Geo->DrawArgs["box"].Bounds;
-	secondBuilding->IndexCount = secondBuilding->Geo->DrawArgs["box"].IndexCount;
-	secondBuilding->StartIndexLocation = secondBuilding->Geo->DrawArgs["box"].StartIndexLocation;
-	secondBuilding->BaseVertexLocation = secondBuilding->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(secondBuilding.get());
-	mAllRitems.push_back(std::move(secondBuilding));
+	secondBuilding.Geo = mGeometries["shapeGeo"].get();
+	secondBuilding.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	secondBuilding.Bounds = secondBuilding.Geo->DrawArgs["box"].Bounds;
+	secondBuilding.IndexCount = secondBuilding.Geo->DrawArgs["box"].IndexCount;
+	secondBuilding.StartIndexLocation = secondBuilding.Geo->DrawArgs["box"].StartIndexLocation;
+	secondBuilding.BaseVertexLocation = secondBuilding.Geo->DrawArgs["box"].BaseVertexLocation;
+	secondBuilding.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(secondBuilding);
 
 
 	//bridge
-	auto bridge = std::make_unique<RenderItem>();
+	RenderItemDesc bridge;
 
 	//Local
-	XMStoreFloat4x4(&bridge->World, XMMatrixScaling(3.0f, 2.0f, 2.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.5f, 1.f, 0.0f));
+	XMStoreFloat4x4(&bridge.World, XMMatrixScaling(3.0f, 2.0f, 2.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.5f, 1.f, 0.0f));
 
 	//World
-	XMStoreFloat4x4(&bridge->World,
-		XMLoadFloat4x4(&bridge->World) *
+	XMStoreFloat4x4(&bridge.World,
+		XMLoadFloat4x4(&bridge.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	bridge->Mat = mMaterials["Navy"].get();
+	bridge.Mat = mMaterials["Navy"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&bridge->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	bridge->ObjCBIndex = mObjCBIndex++;
-	bridge->Geo = mGeometries["shapeGeo"].get();
-	bridge->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	bridge->Bounds = bridge->Geo->DrawArgs["box"].Bounds;
-	bridge->IndexCount = bridge->Geo->DrawArgs["box"].IndexCount;
-	bridge->StartIndexLocation = bridge->Geo->DrawArgs["box"].StartIndexLocation;
-	bridge->BaseVertexLocation = bridge->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(bridge.get());
-	mAllRitems.push_back(std::move(bridge));
+	XMStoreFloat4x4(&bridge.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	bridge.Geo = mGeometries["shapeGeo"].get();
+	bridge.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	bridge.Bounds = bridge.Geo->DrawArgs["box"].Bounds;
+	bridge.IndexCount = bridge.Geo->DrawArgs["box"].IndexCount;
+	bridge.StartIndexLocation = bridge.Geo->DrawArgs["box"].StartIndexLocation;
+	bridge.BaseVertexLocation = bridge.Geo->DrawArgs["box"].BaseVertexLocation;
+	bridge.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(bridge);
 }
 
 void TreeBillboardsApp::BuildStrangeBuildings(FXMVECTOR pos, FXMVECTOR scale, FXMVECTOR rotation)
 {
 	//1st Floor
-	auto firstBuilding = std::make_unique<RenderItem>();
+	RenderItemDesc firstBuilding;
 
 	//Local
-	XMStoreFloat4x4(&firstBuilding->World, XMMatrixScaling(8.0f, 4.0f, 4.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-2.0f, 0.f, 0.0f));
+	XMStoreFloat4x4(&firstBuilding.World, XMMatrixScaling(8.0f, 4.0f, 4.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-2.0f, 0.f, 0.0f));
 
 	//World
-	XMStoreFloat4x4(&firstBuilding->World,
-		XMLoadFloat4x4(&firstBuilding->World) *
+	XMStoreFloat4x4(&firstBuilding.World,
+		XMLoadFloat4x4(&firstBuilding.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	firstBuilding->Mat = mMaterials["Glass3"].get();
+	firstBuilding.Mat = mMaterials["Glass3"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&firstBuilding->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	firstBuilding->ObjCBIndex = mObjCBIndex++;
-	firstBuilding->Geo = mGeometries["shapeGeo"].get();
-	firstBuilding->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	firstBuilding->Bounds = firstBuilding->Geo->DrawArgs["box"].Bounds;
-	firstBuilding->IndexCount = firstBuilding->Geo->DrawArgs["box"].IndexCount;
-	firstBuilding->StartIndexLocation = firstBuilding->Geo->DrawArgs["box"].StartIndexLocation;
-	firstBuilding->BaseVertexLocation = firstBuilding->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(firstBuilding.get());
-	mAllRitems.push_back(std::move(firstBuilding));
+	XMStoreFloat4x4(&firstBuilding.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	firstBuilding.Geo = mGeometries["shapeGeo"].get();
+	firstBuilding.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	firstBuilding.Bounds = firstBuilding.Geo->DrawArgs["box"].Bounds;
+	firstBuilding.IndexCount = firstBuilding.Geo->DrawArgs["box"].IndexCount;
+	firstBuilding.StartIndexLocation = firstBuilding.Geo->DrawArgs["box"].StartIndexLocation;
+	firstBuilding.BaseVertexLocation = firstBuilding.Geo->DrawArgs["box"].BaseVertexLocation;
+	firstBuilding.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(firstBuilding);
 
 	//2nd Floor
-	auto secondFloor = std::make_unique<RenderItem>();
+	RenderItemDesc secondFloor;
 
 	//Local
-	XMStoreFloat4x4(&secondFloor->World, XMMatrixScaling(7.0f, 3.0f, 4.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-1.5f, 3.f, 0.0f));
+	XMStoreFloat4x4(&secondFloor.World, XMMatrixScaling(7.0f, 3.0f, 4.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-1.5f, 3.f, 0.0f));
 
 	//World
-	XMStoreFloat4x4(&secondFloor->World,
-		XMLoadFloat4x4(&secondFloor->World) *
+	XMStoreFloat4x4(&secondFloor.World,
+		XMLoadFloat4x4(&secondFloor.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	secondFloor->Mat = mMaterials["Glass3"].get();
+	secondFloor.Mat = mMaterials["Glass3"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&secondFloor->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	secondFloor->ObjCBIndex = mObjCBIndex++;
-	secondFloor->Geo = mGeometries["shapeGeo"].get();
-	secondFloor->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	secondFloor->Bounds = secondFloor->Geo->DrawArgs["box"].Bounds;
-	secondFloor->IndexCount = secondFloor->Geo->DrawArgs["box"].IndexCount;
-	secondFloor->StartIndexLocation = secondFloor->Geo->DrawArgs["box"].StartIndexLocation;
-	secondFloor->BaseVertexLocation = secondFloor->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(secondFloor.get());
-	mAllRitems.push_back(std::move(secondFloor));
+	XMStoreFloat4x4(&secondFloor.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	secondFloor.Geo = mGeometries["shapeGeo"].get();
+	secondFloor.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	secondFloor.Bounds = secondFloor.Geo->DrawArgs["box"].Bounds;
+	secondFloor.IndexCount = secondFloor.Geo->DrawArgs["box"].IndexCount;
+	secondFloor.StartIndexLocation = secondFloor.Geo->DrawArgs["box"].StartIndexLocation;
+	secondFloor.BaseVertexLocation = secondFloor.Geo->DrawArgs["box"].BaseVertexLocation;
+	secondFloor.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(secondFloor);
 
 	//3rd Floor
-	auto thirdFloor = std::make_unique<RenderItem>();
+	RenderItemDesc thirdFloor;
 
 	//Local
-	XMStoreFloat4x4(&thirdFloor->World, XMMatrixScaling(5.0f, 3.0f, 4.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-0.5f, 6.f, 0.0f));
+	XMStoreFloat4x4(&thirdFloor.World, XMMatrixScaling(5.0f, 3.0f, 4.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-0.5f, 6.f, 0.0f));
 
 	//World
-	XMStoreFloat4x4(&thirdFloor->World,
-		XMLoadFloat4x4(&thirdFloor->World) *
+	XMStoreFloat4x4(&thirdFloor.World,
+		XMLoadFloat4x4(&thirdFloor.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	thirdFloor->Mat = mMaterials["Glass3"].get();
+	thirdFloor.Mat = mMaterials["Glass3"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&thirdFloor->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	thirdFloor->ObjCBIndex = mObjCBIndex++;
-	thirdFloor->Geo = mGeometries["shapeGeo"].get();
-	thirdFloor->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	thirdFloor->Bounds = thirdFloor->Geo->DrawArgs["box"].Bounds;
-	thirdFloor->IndexCount = thirdFloor->Geo->DrawArgs["box"].IndexCount;
-	thirdFloor->StartIndexLocation = thirdFloor->Geo->DrawArgs["box"].StartIndexLocation;
-	thirdFloor->BaseVertexLocation = thirdFloor->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(thirdFloor.get());
-	mAllRitems.push_back(std::move(thirdFloor));
+	XMStoreFloat4x4(&thirdFloor.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	thirdFloor.Geo = mGeometries["shapeGeo"].get();
+	thirdFloor.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	thirdFloor.Bounds = thirdFloor.Geo->DrawArgs["box"].Bounds;
+	thirdFloor.IndexCount = thirdFloor.Geo->DrawArgs["box"].IndexCount;
+	thirdFloor.StartIndexLocation = thirdFloor.Geo->DrawArgs["box"].StartIndexLocation;
+	thirdFloor.BaseVertexLocation = thirdFloor.Geo->DrawArgs["box"].BaseVertexLocation;
+	thirdFloor.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(thirdFloor);
 
 	//4th Floor
-	auto fourthFloor = std::make_unique<RenderItem>();
+	RenderItemDesc fourthFloor;
 
 	//Local
-	XMStoreFloat4x4(&fourthFloor->World, XMMatrixScaling(5.0f, 3.0f, 4.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-2.0f, 9.f, 0.0f));
+	XMStoreFloat4x4(&fourthFloor.World, XMMatrixScaling(5.0f, 3.0f, 4.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-2.0f, 9.f, 0.0f));
 
 	//World
-	XMStoreFloat4x4(&fourthFloor->World,
-		XMLoadFloat4x4(&fourthFloor->World) *
+	XMStoreFloat4x4(&fourthFloor.World,
+		XMLoadFloat4x4(&fourthFloor.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	fourthFloor->Mat = mMaterials["Glass3"].get();
+	fourthFloor.Mat = mMaterials["Glass3"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&fourthFloor->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	fourthFloor->ObjCBIndex = mObjCBIndex++;
-	fourthFloor->Geo = mGeometries["shapeGeo"].get();
-	fourthFloor->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	fourthFloor->Bounds = fourthFloor->Geo->DrawArgs["box"].Bounds;
-	fourthFloor->IndexCount = fourthFloor->Geo->DrawArgs["box"].IndexCount;
-	fourthFloor->StartIndexLocation = fourthFloor->Geo->DrawArgs["box"].StartIndexLocation;
-	fourthFloor->BaseVertexLocation = fourthFloor->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(fourthFloor.get());
-	mAllRitems.push_back(std::move(fourthFloor));
+	XMStoreFloat4x4(&fourthFloor.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	fourthFloor.Geo = mGeometries["shapeGeo"].get();
+	fourthFloor.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	fourthFloor.Bounds = fourthFloor.Geo->DrawArgs["box"].Bounds;
+	fourthFloor.IndexCount = fourthFloor.Geo->DrawArgs["box"].IndexCount;
+	fourthFloor.StartIndexLocation = fourthFloor.Geo->DrawArgs["box"].StartIndexLocation;
+	fourthFloor.BaseVertexLocation = fourthFloor.Geo->DrawArgs["box"].BaseVertexLocation;
+	fourthFloor.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(fourthFloor);
 
 	//long Floor
-	auto longFloor = std::make_unique<RenderItem>();
+	RenderItemDesc longFloor;
 
 	//Local
-	XMStoreFloat4x4(&longFloor->World, XMMatrixScaling(2.5f, 8.0f, 4.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-0.7f, 14.f, 0.0f));
+	XMStoreFloat4x4(&longFloor.World, XMMatrixScaling(2.5f, 8.0f, 4.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-0.7f, 14.f, 0.0f));
 
 	//World
-	XMStoreFloat4x4(&longFloor->World,
-		XMLoadFloat4x4(&longFloor->World) *
+	XMStoreFloat4x4(&longFloor.World,
+		XMLoadFloat4x4(&longFloor.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	longFloor->Mat = mMaterials["Glass3"].get();
+	longFloor.Mat = mMaterials["Glass3"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&longFloor->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	longFloor->ObjCBIndex = mObjCBIndex++;
-	longFloor->Geo = mGeometries["shapeGeo"].get();
-	longFloor->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	longFloor->Bounds = longFloor->Geo->DrawArgs["box"].Bounds;
-	longFloor->IndexCount = longFloor->Geo->DrawArgs["box"].IndexCount;
-	longFloor->StartIndexLocation = longFloor->Geo->DrawArgs["box"].StartIndexLocation;
-	longFloor->BaseVertexLocation = longFloor->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(longFloor.get());
-	mAllRitems.push_back(std::move(longFloor));
+	XMStoreFloat4x4(&longFloor.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	longFloor.Geo = mGeometries["shapeGeo"].get();
+	longFloor.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	longFloor.Bounds = longFloor.Geo->DrawArgs["box"].Bounds;
+	longFloor.IndexCount = longFloor.Geo->DrawArgs["box"].IndexCount;
+	longFloor.StartIndexLocation = longFloor.Geo->DrawArgs["box"].StartIndexLocation;
+	longFloor.BaseVertexLocation = longFloor.Geo->DrawArgs["box"].BaseVertexLocation;
+	longFloor.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(longFloor);
 }
 
 void TreeBillboardsApp::BuildSquareBuilding(FXMVECTOR pos, FXMVECTOR scale, FXMVECTOR rotation)
 {
 	//1st Building
-	auto firstBuilding = std::make_unique<RenderItem>();
+	RenderItemDesc firstBuilding;
 
 	//Local
-	XMStoreFloat4x4(&firstBuilding->World, XMMatrixScaling(5.0f, 5.0f, 5.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-2.0f, 0.5f, 0.0f));
+	XMStoreFloat4x4(&firstBuilding.World, XMMatrixScaling(5.0f, 5.0f, 5.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-2.0f, 0.5f, 0.0f));
 
 	//World
-	XMStoreFloat4x4(&firstBuilding->World,
-		XMLoadFloat4x4(&firstBuilding->World) *
+	XMStoreFloat4x4(&firstBuilding.World,
+		XMLoadFloat4x4(&firstBuilding.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	firstBuilding->Mat = mMaterials["Glass1"].get();
+	firstBuilding.Mat = mMaterials["Glass1"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&firstBuilding->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	firstBuilding->ObjCBIndex = mObjCBIndex++;
-	firstBuilding->Geo = mGeometries["shapeGeo"].get();
-	firstBuilding->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	firstBuilding->Bounds = firstBuilding->Geo->DrawArgs["box"].Bounds;
-	firstBuilding->IndexCount = firstBuilding->Geo->DrawArgs["box"].IndexCount;
-	firstBuilding->StartIndexLocation = firstBuilding->Geo->DrawArgs["box"].StartIndexLocation;
-	firstBuilding->BaseVertexLocation = firstBuilding->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(firstBuilding.get());
-	mAllRitems.push_back(std::move(firstBuilding));
+	XMStoreFloat4x4(&firstBuilding.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	firstBuilding.Geo = mGeometries["shapeGeo"].get();
+	firstBuilding.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	firstBuilding.Bounds = firstBuilding.Geo->DrawArgs["box"].Bounds;
+	firstBuilding.IndexCount = firstBuilding.Geo->DrawArgs["box"].IndexCount;
+	firstBuilding.StartIndexLocation = firstBuilding.Geo->DrawArgs["box"].StartIndexLocation;
+	firstBuilding.BaseVertexLocation = firstBuilding.Geo->DrawArgs["box"].BaseVertexLocation;
+	firstBuilding.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(firstBuilding);
 
 	//Deco 1
-	auto deco1 = std::make_unique<RenderItem>();
+	RenderItemDesc deco1;
 
 	//Local
-	XMStoreFloat4x4(&deco1->World, XMMatrixScaling(3.0f, 0.5f, 0.5f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-3.0f, -0.5f, -2.5f));
+	XMStoreFloat4x4(&deco1.World, XMMatrixScaling(3.0f, 0.5f, 0.5f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-3.0f, -0.5f, -2.5f));
 
 	//World
-	XMStoreFloat4x4(&deco1->World,
-		XMLoadFloat4x4(&deco1->World) *
+	XMStoreFloat4x4(&deco1.World,
+		XMLoadFloat4x4(&deco1.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	deco1->Mat = mMaterials["ice"].get();
+	deco1.Mat = mMaterials["ice"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&deco1->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+	XMStoreFloat4x4(&deco1.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
 
-	deco1->ObjCBIndex = mObjCBIndex++;
-	deco1->Geo = mGeometries["shapeGeo"].get();
-	deco1->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	deco1->Bounds = deco1->Geo->DrawArgs["box"].Bounds;
-	deco1->IndexCount = deco1->Geo->DrawArgs["box"].IndexCount;
-	deco1->StartIndexLocation = deco1->Geo->DrawArgs["box"].StartIndexLocation;
-	deco1->BaseVertexLocation = deco1->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(deco1.get());
-	mAllRitems.push_back(std::move(deco1));
+	deco1.Geo = mGeometries["shapeGeo"].get();
+	deco1.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	deco1.Bounds = deco1.Geo->DrawArgs["box"].Bounds;
+	deco1.IndexCount = deco1.Geo->DrawArgs["box"].IndexCount;
+	deco1.StartIndexLocation = deco1.Geo->DrawArgs["box"].StartIndexLocation;
+	deco1.BaseVertexLocation = deco1.Geo->DrawArgs["box"].BaseVertexLocation;
+	deco1.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(deco1);
 
 
 	//Deco 2
-	auto deco2 = std::make_unique<RenderItem>();
+	RenderItemDesc deco2;
 
 	//Local
-	XMStoreFloat4x4(&deco2->World, XMMatrixScaling(0.5f, 1.5f, 0.5f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-1.725f, 0.5f, -2.5f));
+	XMStoreFloat4x4(&deco2.World, XMMatrixScaling(0.5f, 1.5f, 0.5f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-1.725f, 0.5f, -2.5f));
 
 	//World
-	XMStoreFloat4x4(&deco2->World,
-		XMLoadFloat4x4(&deco2->World) *
+	XMStoreFloat4x4(&deco2.World,
+		XMLoadFloat4x4(&deco2.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	deco2->Mat = mMaterials["ice"].get();
+	deco2.Mat = mMaterials["ice"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&deco2->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	deco2->ObjCBIndex = mObjCBIndex++;
-	deco2->Geo = mGeometries["shapeGeo"].get();
-	deco2->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	deco2->Bounds = deco2->Geo->DrawArgs["box"].Bounds;
-	deco2->IndexCount = deco2->Geo->DrawArgs["box"].IndexCount;
-	deco2->StartIndexLocation = deco2->Geo->DrawArgs["box"].StartIndexLocation;
-	deco2->BaseVertexLocation = deco2->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(deco2.get());
-	mAllRitems.push_back(std::move(deco2));
+	XMStoreFloat4x4(&deco2.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	deco2.Geo = mGeometries["shapeGeo"].get();
+	deco2.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	deco2.Bounds = deco2.Geo->DrawArgs["box"].Bounds;
+	deco2.IndexCount = deco2.Geo->DrawArgs["box"].IndexCount;
+	deco2.StartIndexLocation = deco2.Geo->DrawArgs["box"].StartIndexLocation;
+	deco2.BaseVertexLocation = deco2.Geo->DrawArgs["box"].BaseVertexLocation;
+	deco2.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(deco2);
 
 	//Deco 3
-	auto deco3 = std::make_unique<RenderItem>();
+	RenderItemDesc deco3;
 
 	//Local
-	XMStoreFloat4x4(&deco3->World, XMMatrixScaling(2.0f, 0.5f, 0.5f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-2.5f, 1.5f, -2.5f));
+	XMStoreFloat4x4(&deco3.World, XMMatrixScaling(2.0f, 0.5f, 0.5f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-2.5f, 1.5f, -2.5f));
 
 	//World
-	XMStoreFloat4x4(&deco3->World,
-		XMLoadFloat4x4(&deco3->World) *
+	XMStoreFloat4x4(&deco3.World,
+		XMLoadFloat4x4(&deco3.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	deco3->Mat = mMaterials["ice"].get();
+	deco3.Mat = mMaterials["ice"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&deco3->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	deco3->ObjCBIndex = mObjCBIndex++;
-	deco3->Geo = mGeometries["shapeGeo"].get();
-	deco3->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	deco3->Bounds = deco3->Geo->DrawArgs["box"].Bounds;
-	deco3->IndexCount = deco3->Geo->DrawArgs["box"].IndexCount;
-	deco3->StartIndexLocation = deco3->Geo->DrawArgs["box"].StartIndexLocation;
-	deco3->BaseVertexLocation = deco3->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(deco3.get());
-	mAllRitems.push_back(std::move(deco3));
+	XMStoreFloat4x4(&deco3.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	deco3.Geo = mGeometries["shapeGeo"].get();
+	deco3.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	deco3.Bounds = deco3.Geo->DrawArgs["box"].Bounds;
+	deco3.IndexCount = deco3.Geo->DrawArgs["box"].IndexCount;
+	deco3.StartIndexLocation = deco3.Geo->DrawArgs["box"].StartIndexLocation;
+	deco3.BaseVertexLocation = deco3.Geo->DrawArgs["box"].BaseVertexLocation;
+	deco3.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(deco3);
 
 	//Deco 4
-	auto deco4 = std::make_unique<RenderItem>();
+	RenderItemDesc deco4;
 
 	//Local
-	XMStoreFloat4x4(&deco4->World, XMMatrixScaling(0.5f, 0.5f, 3.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-4.5f, -0.5f, -1.f));
+	XMStoreFloat4x4(&deco4.World, XMMatrixScaling(0.5f, 0.5f, 3.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-4.5f, -0.5f, -1.f));
 
 	//World
-	XMStoreFloat4x4(&deco4->World,
-		XMLoadFloat4x4(&deco4->World) *
+	XMStoreFloat4x4(&deco4.World,
+		XMLoadFloat4x4(&deco4.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	deco4->Mat = mMaterials["ice"].get();
+	deco4.Mat = mMaterials["ice"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&deco4->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	deco4->ObjCBIndex = mObjCBIndex++;
-	deco4->Geo = mGeometries["shapeGeo"].get();
-	deco4->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	deco4->Bounds = deco4->Geo->DrawArgs["box"].Bounds;
-	deco4->IndexCount = deco4->Geo->DrawArgs["box"].IndexCount;
-	deco4->StartIndexLocation = deco4->Geo->DrawArgs["box"].StartIndexLocation;
-	deco4->BaseVertexLocation = deco4->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(deco4.get());
-	mAllRitems.push_back(std::move(deco4));
+	XMStoreFloat4x4(&deco4.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	deco4.Geo = mGeometries["shapeGeo"].get();
+	deco4.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	deco4.Bounds = deco4.Geo->DrawArgs["box"].Bounds;
+	deco4.IndexCount = deco4.Geo->DrawArgs["box"].IndexCount;
+	deco4.StartIndexLocation = deco4.Geo->DrawArgs["box"].StartIndexLocation;
+	deco4.BaseVertexLocation = deco4.Geo->DrawArgs["box"].BaseVertexLocation;
+	deco4.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(deco4);
 
 	//Deco 5
-	auto deco5 = std::make_unique<RenderItem>();
+	RenderItemDesc deco5;
 
 	//Local
-	XMStoreFloat4x4(&deco5->World, XMMatrixScaling(0.5f, 1.5f, 0.5f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-4.5f, 0.5f, 0.25f));
+	XMStoreFloat4x4(&deco5.World, XMMatrixScaling(0.5f, 1.5f, 0.5f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-4.5f, 0.5f, 0.25f));
 
 	//World
-	XMStoreFloat4x4(&deco5->World,
-		XMLoadFloat4x4(&deco5->World) *
+	XMStoreFloat4x4(&deco5.World,
+		XMLoadFloat4x4(&deco5.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	deco5->Mat = mMaterials["ice"].get();
+	deco5.Mat = mMaterials["ice"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&deco5->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	deco5->ObjCBIndex = mObjCBIndex++;
-	deco5->Geo = mGeometries["shapeGeo"].get();
-	deco5->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	deco5->Bounds = deco5->Geo->DrawArgs["box"].Bounds;
-	deco5->IndexCount = deco5->Geo->DrawArgs["box"].IndexCount;
-	deco5->StartIndexLocation = deco5->Geo->DrawArgs["box"].StartIndexLocation;
-	deco5->BaseVertexLocation = deco5->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(deco5.get());
-	mAllRitems.push_back(std::move(deco5));
+	XMStoreFloat4x4(&deco5.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	deco5.Geo = mGeometries["shapeGeo"].get();
+	deco5.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	deco5.Bounds = deco5.Geo->DrawArgs["box"].Bounds;
+	deco5.IndexCount = deco5.Geo->DrawArgs["box"].IndexCount;
+	deco5.StartIndexLocation = deco5.Geo->DrawArgs["box"].StartIndexLocation;
+	deco5.BaseVertexLocation = deco5.Geo->DrawArgs["box"].BaseVertexLocation;
+	deco5.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(deco5);
 
 	//Deco 6
-	auto deco6 = std::make_unique<RenderItem>();
+	RenderItemDesc deco6;
 
 	//Local
-	XMStoreFloat4x4(&deco6->World, XMMatrixScaling(0.5f, 0.5f, 2.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-4.5f, 1.5f, -0.5f));
+	XMStoreFloat4x4(&deco6.World, XMMatrixScaling(0.5f, 0.5f, 2.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-4.5f, 1.5f, -0.5f));
 
 	//World
-	XMStoreFloat4x4(&deco6->World,
-		XMLoadFloat4x4(&deco6->World) *
+	XMStoreFloat4x4(&deco6.World,
+		XMLoadFloat4x4(&deco6.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	deco6->Mat = mMaterials["ice"].get();
+	deco6.Mat = mMaterials["ice"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&deco6->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	deco6->ObjCBIndex = mObjCBIndex++;
-	deco6->Geo = mGeometries["shapeGeo"].get();
-	deco6->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	deco6->Bounds = deco6->Geo->DrawArgs["box"].Bounds;
-	deco6->IndexCount = deco6->Geo->DrawArgs["box"].IndexCount;
-	deco6->StartIndexLocation = deco6->Geo->DrawArgs["box"].StartIndexLocation;
-	deco6->BaseVertexLocation = deco6->Geo->DrawArgs["box"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(deco6.get());
-	mAllRitems.push_back(std::move(deco6));
+	XMStoreFloat4x4(&deco6.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	deco6.Geo = mGeometries["shapeGeo"].get();
+	deco6.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	deco6.Bounds = deco6.Geo->DrawArgs["box"].Bounds;
+	deco6.IndexCount = deco6.Geo->DrawArgs["box"].IndexCount;
+	deco6.StartIndexLocation = deco6.Geo->DrawArgs["box"].StartIndexLocation;
+	deco6.BaseVertexLocation = deco6.Geo->DrawArgs["box"].BaseVertexLocation;
+	deco6.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(deco6);
 
 }
 
 void TreeBillboardsApp::Tower(FXMVECTOR pos, FXMVECTOR scale, FXMVECTOR rotation)
 {
 	//1st Building
-	auto firstBuilding = std::make_unique<RenderItem>();
+	RenderItemDesc firstBuilding;
 
 	//Local
-	XMStoreFloat4x4(&firstBuilding->World, XMMatrixScaling(2.0f, 8.0f, 2.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.0f, 12.f, 0.0f));
-	//XMStoreFloat4x4(&firstBuilding->World, XMMatrixScaling(1.0f, 1.0f, 1.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.0f, 0.f, 0.0f));
+	XMStoreFloat4x4(&firstBuilding.World, XMMatrixScaling(2.0f, 8.0f, 2.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.0f, 12.f, 0.0f));
+	//XMStoreFloat4x4(&firstBuilding.World, XMMatrixScaling(1.0f, 1.0f, 1.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.0f, 0.f, 0.0f));
 
 	//World
-	XMStoreFloat4x4(&firstBuilding->World,
-		XMLoadFloat4x4(&firstBuilding->World) *
+	XMStoreFloat4x4(&firstBuilding.World,
+		XMLoadFloat4x4(&firstBuilding.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	firstBuilding->Mat = mMaterials["redBrick"].get();
+	firstBuilding.Mat = mMaterials["redBrick"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&firstBuilding->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	firstBuilding->ObjCBIndex = mObjCBIndex++;
-	firstBuilding->Geo = mGeometries["shapeGeo"].get();
-	firstBuilding->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	firstBuilding->Bounds = firstBuilding->Geo->DrawArgs["cylinder"].Bounds;
-	firstBuilding->IndexCount = firstBuilding->Geo->DrawArgs["cylinder"].IndexCount;
-	firstBuilding->StartIndexLocation = firstBuilding->Geo->DrawArgs["cylinder"].StartIndexLocation;
-	firstBuilding->BaseVertexLocation = firstBuilding->Geo->DrawArgs["cylinder"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(firstBuilding.get());
-	mAllRitems.push_back(std::move(firstBuilding));
+	XMStoreFloat4x4(&firstBuilding.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	firstBuilding.Geo = mGeometries["shapeGeo"].get();
+	firstBuilding.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	firstBuilding.Bounds = firstBuilding.Geo->DrawArgs["cylinder"].Bounds;
+	firstBuilding.IndexCount = firstBuilding.Geo->DrawArgs["cylinder"].IndexCount;
+	firstBuilding.StartIndexLocation = firstBuilding.Geo->DrawArgs["cylinder"].StartIndexLocation;
+	firstBuilding.BaseVertexLocation = firstBuilding.Geo->DrawArgs["cylinder"].BaseVertexLocation;
+	firstBuilding.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(firstBuilding);
 
 	//2ND
-	auto SecondBuilding = std::make_unique<RenderItem>();
+	RenderItemDesc SecondBuilding;
 
 	//Local
-	XMStoreFloat4x4(&SecondBuilding->World, XMMatrixScaling(9.0f, 1.0f, 9.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.0f, 18.f, 0.0f));
+	XMStoreFloat4x4(&SecondBuilding.World, XMMatrixScaling(9.0f, 1.0f, 9.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(0.0f, 18.f, 0.0f));
 
 	//World
-	XMStoreFloat4x4(&SecondBuilding->World,
-		XMLoadFloat4x4(&SecondBuilding->World) *
+	XMStoreFloat4x4(&SecondBuilding.World,
+		XMLoadFloat4x4(&SecondBuilding.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	SecondBuilding->Mat = mMaterials["Glass4"].get();
+	SecondBuilding.Mat = mMaterials["Glass4"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&SecondBuilding->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	SecondBuilding->ObjCBIndex = mObjCBIndex++;
-	SecondBuilding->Geo = mGeometries["shapeGeo"].get();
-	SecondBuilding->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	SecondBuilding->Bounds = SecondBuilding->Geo->DrawArgs["cylinder"].Bounds;
-	SecondBuilding->IndexCount = SecondBuilding->Geo->DrawArgs["cylinder"].IndexCount;
-	SecondBuilding->StartIndexLocation = SecondBuilding->Geo->DrawArgs["cylinder"].StartIndexLocation;
-	SecondBuilding->BaseVertexLocation = SecondBuilding->Geo->DrawArgs["cylinder"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(SecondBuilding.get());
-	mAllRitems.push_back(std::move(SecondBuilding));
+	XMStoreFloat4x4(&SecondBuilding.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	SecondBuilding.Geo = mGeometries["shapeGeo"].get();
+	SecondBuilding.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	SecondBuilding.Bounds = SecondBuilding.Geo->DrawArgs["cylinder"].Bounds;
+	SecondBuilding.IndexCount = SecondBuilding.Geo->DrawArgs["cylinder"].IndexCount;
+	SecondBuilding.StartIndexLocation = SecondBuilding.Geo->DrawArgs["cylinder"].StartIndexLocation;
+	SecondBuilding.BaseVertexLocation = SecondBuilding.Geo->DrawArgs["cylinder"].BaseVertexLocation;
+	SecondBuilding.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(SecondBuilding);
 }
 
 void TreeBillboardsApp::Park(FXMVECTOR pos, FXMVECTOR scale, FXMVECTOR rotation)
 {
 	//1st Building
-	auto firstBuilding = std::make_unique<RenderItem>();
+	RenderItemDesc firstBuilding;
 
 	//Local
-	XMStoreFloat4x4(&firstBuilding->World, XMMatrixScaling(8.0f, 0.1f, 8.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(3.0f, 0.f, -5.0f));
+	XMStoreFloat4x4(&firstBuilding.World, XMMatrixScaling(8.0f, 0.1f, 8.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(3.0f, 0.f, -5.0f));
 
 	//World
-	XMStoreFloat4x4(&firstBuilding->World,
-		XMLoadFloat4x4(&firstBuilding->World) *
+	XMStoreFloat4x4(&firstBuilding.World,
+		XMLoadFloat4x4(&firstBuilding.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	firstBuilding->Mat = mMaterials["grass"].get();
+	firstBuilding.Mat = mMaterials["grass"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&firstBuilding->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	firstBuilding->ObjCBIndex = mObjCBIndex++;
-	firstBuilding->Geo = mGeometries["shapeGeo"].get();
-	firstBuilding->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	firstBuilding->Bounds = firstBuilding->Geo->DrawArgs["cylinder"].Bounds;
-	firstBuilding->IndexCount = firstBuilding->Geo->DrawArgs["cylinder"].IndexCount;
-	firstBuilding->StartIndexLocation = firstBuilding->Geo->DrawArgs["cylinder"].StartIndexLocation;
-	firstBuilding->BaseVertexLocation = firstBuilding->Geo->DrawArgs["cylinder"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(firstBuilding.get());
-	mAllRitems.push_back(std::move(firstBuilding));
+	XMStoreFloat4x4(&firstBuilding.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	firstBuilding.Geo = mGeometries["shapeGeo"].get();
+	firstBuilding.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	firstBuilding.Bounds = firstBuilding.Geo->DrawArgs["cylinder"].Bounds;
+	firstBuilding.IndexCount = firstBuilding.Geo->DrawArgs["cylinder"].IndexCount;
+	firstBuilding.StartIndexLocation = firstBuilding.Geo->DrawArgs["cylinder"].StartIndexLocation;
+	firstBuilding.BaseVertexLocation = firstBuilding.Geo->DrawArgs["cylinder"].BaseVertexLocation;
+	firstBuilding.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(firstBuilding);
 
 	//2nd
-	auto SecondBuilding = std::make_unique<RenderItem>();
+	RenderItemDesc SecondBuilding;
 
 	//Local
-	XMStoreFloat4x4(&SecondBuilding->World, XMMatrixScaling(8.0f, 0.1f, 8.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-3.0f, 0.f, 7.0f));
+	XMStoreFloat4x4(&SecondBuilding.World, XMMatrixScaling(8.0f, 0.1f, 8.0f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-3.0f, 0.f, 7.0f));
 
 	//World
-	XMStoreFloat4x4(&SecondBuilding->World,
-		XMLoadFloat4x4(&SecondBuilding->World) *
+	XMStoreFloat4x4(&SecondBuilding.World,
+		XMLoadFloat4x4(&SecondBuilding.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	SecondBuilding->Mat = mMaterials["grass"].get();
+	SecondBuilding.Mat = mMaterials["grass"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&SecondBuilding->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+	XMStoreFloat4x4(&SecondBuilding.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
 
-	SecondBuilding->ObjCBIndex = mObjCBIndex++;
-	SecondBuilding->Geo = mGeometries["shapeGeo"].get();
-	SecondBuilding->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	SecondBuilding->Bounds = SecondBuilding->Geo->DrawArgs["cylinder"].Bounds;
-	SecondBuilding->IndexCount = SecondBuilding->Geo->DrawArgs["cylinder"].IndexCount;
-	SecondBuilding->StartIndexLocation = SecondBuilding->Geo->DrawArgs["cylinder"].StartIndexLocation;
-	SecondBuilding->BaseVertexLocation = SecondBuilding->Geo->DrawArgs["cylinder"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(SecondBuilding.get());
-	mAllRitems.push_back(std::move(SecondBuilding));
+	SecondBuilding.Geo = mGeometries["shapeGeo"].get();
+	SecondBuilding.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	SecondBuilding.Bounds = SecondBuilding.Geo->DrawArgs["cylinder"].Bounds;
+	SecondBuilding.IndexCount = SecondBuilding.Geo->DrawArgs["cylinder"].IndexCount;
+	SecondBuilding.StartIndexLocation = SecondBuilding.Geo->DrawArgs["cylinder"].StartIndexLocation;
+	SecondBuilding.BaseVertexLocation = SecondBuilding.Geo->DrawArgs["cylinder"].BaseVertexLocation;
+	SecondBuilding.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(SecondBuilding);
 
 
 
@@ -2763,409 +2820,538 @@ void TreeBillboardsApp::Park(FXMVECTOR pos, FXMVECTOR scale, FXMVECTOR rotation)
 void TreeBillboardsApp::Barrigates(FXMVECTOR pos, FXMVECTOR scale, FXMVECTOR rotation)
 {
 	//1st Building
-	auto firstBuilding = std::make_unique<RenderItem>();
+	RenderItemDesc firstBuilding;
 
 	//Local
-	XMStoreFloat4x4(&firstBuilding->World, XMMatrixScaling(0.3f, 0.5f, 0.3f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(3.0f, 0.f, -14.5f));
+	XMStoreFloat4x4(&firstBuilding.World, XMMatrixScaling(0.3f, 0.5f, 0.3f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(3.0f, 0.f, -14.5f));
 
 	//World
-	XMStoreFloat4x4(&firstBuilding->World,
-		XMLoadFloat4x4(&firstBuilding->World) *
+	XMStoreFloat4x4(&firstBuilding.World,
+		XMLoadFloat4x4(&firstBuilding.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	firstBuilding->Mat = mMaterials["whiteBrick"].get();
+	firstBuilding.Mat = mMaterials["whiteBrick"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&firstBuilding->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	firstBuilding->ObjCBIndex = mObjCBIndex++;
-	firstBuilding->Geo = mGeometries["shapeGeo"].get();
-	firstBuilding->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	firstBuilding->Bounds = firstBuilding->Geo->DrawArgs["cylinder"].Bounds;
-	firstBuilding->IndexCount = firstBuilding->Geo->DrawArgs["cylinder"].IndexCount;
-	firstBuilding->StartIndexLocation = firstBuilding->Geo->DrawArgs["cylinder"].StartIndexLocation;
-	firstBuilding->BaseVertexLocation = firstBuilding->Geo->DrawArgs["cylinder"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(firstBuilding.get());
-	mAllRitems.push_back(std::move(firstBuilding));
+	XMStoreFloat4x4(&firstBuilding.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	firstBuilding.Geo = mGeometries["shapeGeo"].get();
+	firstBuilding.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	firstBuilding.Bounds = firstBuilding.Geo->DrawArgs["cylinder"].Bounds;
+	firstBuilding.IndexCount = firstBuilding.Geo->DrawArgs["cylinder"].IndexCount;
+	firstBuilding.StartIndexLocation = firstBuilding.Geo->DrawArgs["cylinder"].StartIndexLocation;
+	firstBuilding.BaseVertexLocation = firstBuilding.Geo->DrawArgs["cylinder"].BaseVertexLocation;
+	firstBuilding.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(firstBuilding);
 
 	//2nd
-	auto SecondBuilding = std::make_unique<RenderItem>();
+	RenderItemDesc SecondBuilding;
 
 	//Local
-	XMStoreFloat4x4(&SecondBuilding->World, XMMatrixScaling(0.3f, 0.5f, 0.3f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(1.0f, 0.f, -14.5f));
+	XMStoreFloat4x4(&SecondBuilding.World, XMMatrixScaling(0.3f, 0.5f, 0.3f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(1.0f, 0.f, -14.5f));
 
 	//World
-	XMStoreFloat4x4(&SecondBuilding->World,
-		XMLoadFloat4x4(&SecondBuilding->World) *
+	XMStoreFloat4x4(&SecondBuilding.World,
+		XMLoadFloat4x4(&SecondBuilding.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	SecondBuilding->Mat = mMaterials["whiteBrick"].get();
+	SecondBuilding.Mat = mMaterials["whiteBrick"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&SecondBuilding->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	SecondBuilding->ObjCBIndex = mObjCBIndex++;
-	SecondBuilding->Geo = mGeometries["shapeGeo"].get();
-	SecondBuilding->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	SecondBuilding->Bounds = SecondBuilding->Geo->DrawArgs["cylinder"].Bounds;
-	SecondBuilding->IndexCount = SecondBuilding->Geo->DrawArgs["cylinder"].IndexCount;
-	SecondBuilding->StartIndexLocation = SecondBuilding->Geo->DrawArgs["cylinder"].StartIndexLocation;
-	SecondBuilding->BaseVertexLocation = SecondBuilding->Geo->DrawArgs["cylinder"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(SecondBuilding.get());
-	mAllRitems.push_back(std::move(SecondBuilding));
+	XMStoreFloat4x4(&SecondBuilding.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	SecondBuilding.Geo = mGeometries["shapeGeo"].get();
+	SecondBuilding.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	SecondBuilding.Bounds = SecondBuilding.Geo->DrawArgs["cylinder"].Bounds;
+	SecondBuilding.IndexCount = SecondBuilding.Geo->DrawArgs["cylinder"].IndexCount;
+	SecondBuilding.StartIndexLocation = SecondBuilding.Geo->DrawArgs["cylinder"].StartIndexLocation;
+	SecondBuilding.BaseVertexLocation = SecondBuilding.Geo->DrawArgs["cylinder"].BaseVertexLocation;
+	SecondBuilding.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(SecondBuilding);
 
 	//3rd
-	auto Third = std::make_unique<RenderItem>();
+	RenderItemDesc Third;
 
 	//Local
-	XMStoreFloat4x4(&Third->World, XMMatrixScaling(0.3f, 0.5f, 0.3f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-1.0f, 0.f, -14.5f));
+	XMStoreFloat4x4(&Third.World, XMMatrixScaling(0.3f, 0.5f, 0.3f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-1.0f, 0.f, -14.5f));
 
 	//World
-	XMStoreFloat4x4(&Third->World,
-		XMLoadFloat4x4(&Third->World) *
+	XMStoreFloat4x4(&Third.World,
+		XMLoadFloat4x4(&Third.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	Third->Mat = mMaterials["whiteBrick"].get();
+	Third.Mat = mMaterials["whiteBrick"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&Third->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	Third->ObjCBIndex = mObjCBIndex++;
-	Third->Geo = mGeometries["shapeGeo"].get();
-	Third->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	Third->Bounds = Third->Geo->DrawArgs["cylinder"].Bounds;
-	Third->IndexCount = Third->Geo->DrawArgs["cylinder"].IndexCount;
-	Third->StartIndexLocation = Third->Geo->DrawArgs["cylinder"].StartIndexLocation;
-	Third->BaseVertexLocation = Third->Geo->DrawArgs["cylinder"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(Third.get());
-	mAllRitems.push_back(std::move(Third));
+	XMStoreFloat4x4(&Third.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	Third.Geo = mGeometries["shapeGeo"].get();
+	Third.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	Third.Bounds = Third.Geo->DrawArgs["cylinder"].Bounds;
+	Third.IndexCount = Third.Geo->DrawArgs["cylinder"].IndexCount;
+	Third.StartIndexLocation = Third.Geo->DrawArgs["cylinder"].StartIndexLocation;
+	Third.BaseVertexLocation = Third.Geo->DrawArgs["cylinder"].BaseVertexLocation;
+	Third.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(Third);
 
 	//4th
-	auto Fourth = std::make_unique<RenderItem>();
+	RenderItemDesc Fourth;
 
 	//Local
-	XMStoreFloat4x4(&Fourth->World, XMMatrixScaling(0.3f, 0.5f, 0.3f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-3.0f, 0.f, -14.5f));
+	XMStoreFloat4x4(&Fourth.World, XMMatrixScaling(0.3f, 0.5f, 0.3f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-3.0f, 0.f, -14.5f));
 
 	//World
-	XMStoreFloat4x4(&Fourth->World,
-		XMLoadFloat4x4(&Fourth->World) *
+	XMStoreFloat4x4(&Fourth.World,
+		XMLoadFloat4x4(&Fourth.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	Fourth->Mat = mMaterials["whiteBrick"].get();
+	Fourth.Mat = mMaterials["whiteBrick"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&Fourth->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	Fourth->ObjCBIndex = mObjCBIndex++;
-	Fourth->Geo = mGeometries["shapeGeo"].get();
-	Fourth->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	Fourth->Bounds = Fourth->Geo->DrawArgs["cylinder"].Bounds;
-	Fourth->IndexCount = Fourth->Geo->DrawArgs["cylinder"].IndexCount;
-	Fourth->StartIndexLocation = Fourth->Geo->DrawArgs["cylinder"].StartIndexLocation;
-	Fourth->BaseVertexLocation = Fourth->Geo->DrawArgs["cylinder"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(Fourth.get());
-	mAllRitems.push_back(std::move(Fourth));
+	XMStoreFloat4x4(&Fourth.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	Fourth.Geo = mGeometries["shapeGeo"].get();
+	Fourth.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	Fourth.Bounds = Fourth.Geo->DrawArgs["cylinder"].Bounds;
+	Fourth.IndexCount = Fourth.Geo->DrawArgs["cylinder"].IndexCount;
+	Fourth.StartIndexLocation = Fourth.Geo->DrawArgs["cylinder"].StartIndexLocation;
+	Fourth.BaseVertexLocation = Fourth.Geo->DrawArgs["cylinder"].BaseVertexLocation;
+	Fourth.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(Fourth);
 
 	//5th
-	auto Fifth = std::make_unique<RenderItem>();
+	RenderItemDesc Fifth;
 
 	//Local
-	XMStoreFloat4x4(&Fifth->World, XMMatrixScaling(0.3f, 0.5f, 0.3f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-5.0f, 0.f, -14.5f));
+	XMStoreFloat4x4(&Fifth.World, XMMatrixScaling(0.3f, 0.5f, 0.3f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-5.0f, 0.f, -14.5f));
 
 	//World
-	XMStoreFloat4x4(&Fifth->World,
-		XMLoadFloat4x4(&Fifth->World) *
+	XMStoreFloat4x4(&Fifth.World,
+		XMLoadFloat4x4(&Fifth.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	Fifth->Mat = mMaterials["whiteBrick"].get();
+	Fifth.Mat = mMaterials["whiteBrick"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&Fifth->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	Fifth->ObjCBIndex = mObjCBIndex++;
-	Fifth->Geo = mGeometries["shapeGeo"].get();
-	Fifth->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	Fifth->Bounds = Fifth->Geo->DrawArgs["cylinder"].Bounds;
-	Fifth->IndexCount = Fifth->Geo->DrawArgs["cylinder"].IndexCount;
-	Fifth->StartIndexLocation = Fifth->Geo->DrawArgs["cylinder"].StartIndexLocation;
-	Fifth->BaseVertexLocation = Fifth->Geo->DrawArgs["cylinder"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(Fifth.get());
-	mAllRitems.push_back(std::move(Fifth));
+	XMStoreFloat4x4(&Fifth.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	Fifth.Geo = mGeometries["shapeGeo"].get();
+	Fifth.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	Fifth.Bounds = Fifth.Geo->DrawArgs["cylinder"].Bounds;
+	Fifth.IndexCount = Fifth.Geo->DrawArgs["cylinder"].IndexCount;
+	Fifth.StartIndexLocation = Fifth.Geo->DrawArgs["cylinder"].StartIndexLocation;
+	Fifth.BaseVertexLocation = Fifth.Geo->DrawArgs["cylinder"].BaseVertexLocation;
+	Fifth.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(Fifth);
 
 	//6th
-	auto Sisth = std::make_unique<RenderItem>();
+	RenderItemDesc Sisth;
 
 	//Local
-	XMStoreFloat4x4(&Sisth->World, XMMatrixScaling(0.3f, 0.5f, 0.3f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-7.0f, 0.f, -14.5f));
+	XMStoreFloat4x4(&Sisth.World, XMMatrixScaling(0.3f, 0.5f, 0.3f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-7.0f, 0.f, -14.5f));
 
 	//World
-	XMStoreFloat4x4(&Sisth->World,
-		XMLoadFloat4x4(&Sisth->World) *
+	XMStoreFloat4x4(&Sisth.World,
+		XMLoadFloat4x4(&Sisth.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	Sisth->Mat = mMaterials["whiteBrick"].get();
+	Sisth.Mat = mMaterials["whiteBrick"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&Sisth->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	Sisth->ObjCBIndex = mObjCBIndex++;
-	Sisth->Geo = mGeometries["shapeGeo"].get();
-	Sisth->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	Sisth->Bounds = Sisth->Geo->DrawArgs["cylinder"].Bounds;
-	Sisth->IndexCount = Sisth->Geo->DrawArgs["cylinder"].IndexCount;
-	Sisth->StartIndexLocation = Sisth->Geo->DrawArgs["cylinder"].StartIndexLocation;
-	Sisth->BaseVertexLocation = Sisth->Geo->DrawArgs["cylinder"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(Sisth.get());
-	mAllRitems.push_back(std::move(Sisth));
+	XMStoreFloat4x4(&Sisth.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	Sisth.Geo = mGeometries["shapeGeo"].get();
+	Sisth.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	Sisth.Bounds = Sisth.Geo->DrawArgs["cylinder"].Bounds;
+	Sisth.IndexCount = Sisth.Geo->DrawArgs["cylinder"].IndexCount;
+	Sisth.StartIndexLocation = Sisth.Geo->DrawArgs["cylinder"].StartIndexLocation;
+	Sisth.BaseVertexLocation = Sisth.Geo->DrawArgs["cylinder"].BaseVertexLocation;
+	Sisth.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(Sisth);
 
 	//7th
-	auto Seventh = std::make_unique<RenderItem>();
+	RenderItemDesc Seventh;
 
 	//Local
-	XMStoreFloat4x4(&Seventh->World, XMMatrixScaling(0.3f, 0.5f, 0.3f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(5.0f, 0.f, -14.5f));
+	XMStoreFloat4x4(&Seventh.World, XMMatrixScaling(0.3f, 0.5f, 0.3f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(5.0f, 0.f, -14.5f));
 
 	//World
-	XMStoreFloat4x4(&Seventh->World,
-		XMLoadFloat4x4(&Seventh->World) *
+	XMStoreFloat4x4(&Seventh.World,
+		XMLoadFloat4x4(&Seventh.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	Seventh->Mat = mMaterials["whiteBrick"].get();
+	Seventh.Mat = mMaterials["whiteBrick"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&Seventh->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	Seventh->ObjCBIndex = mObjCBIndex++;
-	Seventh->Geo = mGeometries["shapeGeo"].get();
-	Seventh->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	Seventh->Bounds = Seventh->Geo->DrawArgs["cylinder"].Bounds;
-	Seventh->IndexCount = Seventh->Geo->DrawArgs["cylinder"].IndexCount;
-	Seventh->StartIndexLocation = Seventh->Geo->DrawArgs["cylinder"].StartIndexLocation;
-	Seventh->BaseVertexLocation = Seventh->Geo->DrawArgs["cylinder"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(Seventh.get());
-	mAllRitems.push_back(std::move(Seventh));
+	XMStoreFloat4x4(&Seventh.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	Seventh.Geo = mGeometries["shapeGeo"].get();
+	Seventh.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	Seventh.Bounds = Seventh.Geo->DrawArgs["cylinder"].Bounds;
+	Seventh.IndexCount = Seventh.Geo->DrawArgs["cylinder"].IndexCount;
+	Seventh.StartIndexLocation = Seventh.Geo->DrawArgs["cylinder"].StartIndexLocation;
+	Seventh.BaseVertexLocation = Seventh.Geo->DrawArgs["cylinder"].BaseVertexLocation;
+	Seventh.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(Seventh);
 
 	//8th
-	auto Eighth = std::make_unique<RenderItem>();
+	RenderItemDesc Eighth;
 
 	//Local
-	XMStoreFloat4x4(&Eighth->World, XMMatrixScaling(0.3f, 0.5f, 0.3f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(7.0f, 0.f, -14.5f));
+	XMStoreFloat4x4(&Eighth.World, XMMatrixScaling(0.3f, 0.5f, 0.3f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(7.0f, 0.f, -14.5f));
 
 	//World
-	XMStoreFloat4x4(&Eighth->World,
-		XMLoadFloat4x4(&Eighth->World) *
+	XMStoreFloat4x4(&Eighth.World,
+		XMLoadFloat4x4(&Eighth.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	Eighth->Mat = mMaterials["whiteBrick"].get();
+	Eighth.Mat = mMaterials["whiteBrick"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&Eighth->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	Eighth->ObjCBIndex = mObjCBIndex++;
-	Eighth->Geo = mGeometries["shapeGeo"].get();
-	Eighth->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	Eighth->Bounds = Eighth->Geo->DrawArgs["cylinder"].Bounds;
-	Eighth->IndexCount = Eighth->Geo->DrawArgs["cylinder"].IndexCount;
-	Eighth->StartIndexLocation = Eighth->Geo->DrawArgs["cylinder"].StartIndexLocation;
-	Eighth->BaseVertexLocation = Eighth->Geo->DrawArgs["cylinder"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(Eighth.get());
-	mAllRitems.push_back(std::move(Eighth));
+	XMStoreFloat4x4(&Eighth.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	Eighth.Geo = mGeometries["shapeGeo"].get();
+	Eighth.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	Eighth.Bounds = Eighth.Geo->DrawArgs["cylinder"].Bounds;
+	Eighth.IndexCount = Eighth.Geo->DrawArgs["cylinder"].IndexCount;
+	Eighth.StartIndexLocation = Eighth.Geo->DrawArgs["cylinder"].StartIndexLocation;
+	Eighth.BaseVertexLocation = Eighth.Geo->DrawArgs["cylinder"].BaseVertexLocation;
+	Eighth.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(Eighth);
 
 	//9th
-	auto Nineth = std::make_unique<RenderItem>();
+	RenderItemDesc Nineth;
 
 	//Local
-	XMStoreFloat4x4(&Nineth->World, XMMatrixScaling(0.3f, 0.5f, 0.3f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(9.0f, 0.f, -14.5f));
+	XMStoreFloat4x4(&Nineth.World, XMMatrixScaling(0.3f, 0.5f, 0.3f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(9.0f, 0.f, -14.5f));
 
 	//World
-	XMStoreFloat4x4(&Nineth->World,
-		XMLoadFloat4x4(&Nineth->World) *
+	XMStoreFloat4x4(&Nineth.World,
+		XMLoadFloat4x4(&Nineth.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	Nineth->Mat = mMaterials["whiteBrick"].get();
+	Nineth.Mat = mMaterials["whiteBrick"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&Nineth->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	Nineth->ObjCBIndex = mObjCBIndex++;
-	Nineth->Geo = mGeometries["shapeGeo"].get();
-	Nineth->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	Nineth->Bounds = Nineth->Geo->DrawArgs["cylinder"].Bounds;
-	Nineth->IndexCount = Nineth->Geo->DrawArgs["cylinder"].IndexCount;
-	Nineth->StartIndexLocation = Nineth->Geo->DrawArgs["cylinder"].StartIndexLocation;
-	Nineth->BaseVertexLocation = Nineth->Geo->DrawArgs["cylinder"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(Nineth.get());
-	mAllRitems.push_back(std::move(Nineth));
+	XMStoreFloat4x4(&Nineth.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	Nineth.Geo = mGeometries["shapeGeo"].get();
+	Nineth.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	Nineth.Bounds = Nineth.Geo->DrawArgs["cylinder"].Bounds;
+	Nineth.IndexCount = Nineth.Geo->DrawArgs["cylinder"].IndexCount;
+	Nineth.StartIndexLocation = Nineth.Geo->DrawArgs["cylinder"].StartIndexLocation;
+	Nineth.BaseVertexLocation = Nineth.Geo->DrawArgs["cylinder"].BaseVertexLocation;
+	Nineth.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(Nineth);
 
 	//10th
-	auto Tenth = std::make_unique<RenderItem>();
+	RenderItemDesc Tenth;
 
 	//Local
-	XMStoreFloat4x4(&Tenth->World, XMMatrixScaling(0.3f, 0.5f, 0.3f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(11.0f, 0.f, -14.5f));
+	XMStoreFloat4x4(&Tenth.World, XMMatrixScaling(0.3f, 0.5f, 0.3f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(11.0f, 0.f, -14.5f));
 
 	//World
-	XMStoreFloat4x4(&Tenth->World,
-		XMLoadFloat4x4(&Tenth->World) *
+	XMStoreFloat4x4(&Tenth.World,
+		XMLoadFloat4x4(&Tenth.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	Tenth->Mat = mMaterials["whiteBrick"].get();
+	Tenth.Mat = mMaterials["whiteBrick"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&Tenth->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	Tenth->ObjCBIndex = mObjCBIndex++;
-	Tenth->Geo = mGeometries["shapeGeo"].get();
-	Tenth->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	Tenth->Bounds = Tenth->Geo->DrawArgs["cylinder"].Bounds;
-	Tenth->IndexCount = Tenth->Geo->DrawArgs["cylinder"].IndexCount;
-	Tenth->StartIndexLocation = Tenth->Geo->DrawArgs["cylinder"].StartIndexLocation;
-	Tenth->BaseVertexLocation = Tenth->Geo->DrawArgs["cylinder"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(Tenth.get());
-	mAllRitems.push_back(std::move(Tenth));
+	XMStoreFloat4x4(&Tenth.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	Tenth.Geo = mGeometries["shapeGeo"].get();
+	Tenth.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	Tenth.Bounds = Tenth.Geo->DrawArgs["cylinder"].Bounds;
+	Tenth.IndexCount = Tenth.Geo->DrawArgs["cylinder"].IndexCount;
+	Tenth.StartIndexLocation = Tenth.Geo->DrawArgs["cylinder"].StartIndexLocation;
+	Tenth.BaseVertexLocation = Tenth.Geo->DrawArgs["cylinder"].BaseVertexLocation;
+	Tenth.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(Tenth);
 
 	//11th
-	auto Eleventh = std::make_unique<RenderItem>();
+	RenderItemDesc Eleventh;
 
 	//Local
-	XMStoreFloat4x4(&Eleventh->World, XMMatrixScaling(0.3f, 0.5f, 0.3f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(13.0f, 0.f, -14.5f));
+	XMStoreFloat4x4(&Eleventh.World, XMMatrixScaling(0.3f, 0.5f, 0.3f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(13.0f, 0.f, -14.5f));
 
 	//World
-	XMStoreFloat4x4(&Eleventh->World,
-		XMLoadFloat4x4(&Eleventh->World) *
+	XMStoreFloat4x4(&Eleventh.World,
+		XMLoadFloat4x4(&Eleventh.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	Eleventh->Mat = mMaterials["whiteBrick"].get();
+	Eleventh.Mat = mMaterials["whiteBrick"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&Eleventh->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	Eleventh->ObjCBIndex = mObjCBIndex++;
-	Eleventh->Geo = mGeometries["shapeGeo"].get();
-	Eleventh->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	Eleventh->Bounds = Eleventh->Geo->DrawArgs["cylinder"].Bounds;
-	Eleventh->IndexCount = Eleventh->Geo->DrawArgs["cylinder"].IndexCount;
-	Eleventh->StartIndexLocation = Eleventh->Geo->DrawArgs["cylinder"].StartIndexLocation;
-	Eleventh->BaseVertexLocation = Eleventh->Geo->DrawArgs["cylinder"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(Eleventh.get());
-	mAllRitems.push_back(std::move(Eleventh));
+	XMStoreFloat4x4(&Eleventh.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	Eleventh.Geo = mGeometries["shapeGeo"].get();
+	Eleventh.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	Eleventh.Bounds = Eleventh.Geo->DrawArgs["cylinder"].Bounds;
+	Eleventh.IndexCount = Eleventh.Geo->DrawArgs["cylinder"].IndexCount;
+	Eleventh.StartIndexLocation = Eleventh.Geo->DrawArgs["cylinder"].StartIndexLocation;
+	Eleventh.BaseVertexLocation = Eleventh.Geo->DrawArgs["cylinder"].BaseVertexLocation;
+	Eleventh.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(Eleventh);
 
 	//12th
-	auto Twelveth = std::make_unique<RenderItem>();
+	RenderItemDesc Twelveth;
 
 	//Local
-	XMStoreFloat4x4(&Twelveth->World, XMMatrixScaling(0.3f, 0.5f, 0.3f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-13.0f, 0.f, -14.5f));
+	XMStoreFloat4x4(&Twelveth.World, XMMatrixScaling(0.3f, 0.5f, 0.3f) * XMMatrixRotationRollPitchYaw(0.f, 0.f, 0.f) * XMMatrixTranslation(-13.0f, 0.f, -14.5f));
 
 	//World
-	XMStoreFloat4x4(&Twelveth->World,
-		XMLoadFloat4x4(&Twelveth->World) *
+	XMStoreFloat4x4(&Twelveth.World,
+		XMLoadFloat4x4(&Twelveth.World) *
 		XMMatrixScalingFromVector(scale) *
 		XMMatrixRotationRollPitchYawFromVector(rotation) *
 		XMMatrixTranslationFromVector(pos));
 
 	//Material
-	Twelveth->Mat = mMaterials["whiteBrick"].get();
+	Twelveth.Mat = mMaterials["whiteBrick"].get();
 
 	//Texture Scaling
-	XMStoreFloat4x4(&Twelveth->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-
-	Twelveth->ObjCBIndex = mObjCBIndex++;
-	Twelveth->Geo = mGeometries["shapeGeo"].get();
-	Twelveth->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	Twelveth->Bounds = Twelveth->Geo->DrawArgs["cylinder"].Bounds;
-	Twelveth->IndexCount = Twelveth->Geo->DrawArgs["cylinder"].IndexCount;
-	Twelveth->StartIndexLocation = Twelveth->Geo->DrawArgs["cylinder"].StartIndexLocation;
-	Twelveth->BaseVertexLocation = Twelveth->Geo->DrawArgs["cylinder"].BaseVertexLocation;
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(Twelveth.get());
-	mAllRitems.push_back(std::move(Twelveth));
+	XMStoreFloat4x4(&Twelveth.TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+
+	Twelveth.Geo = mGeometries["shapeGeo"].get();
+	Twelveth.PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	Twelveth.Bounds = Twelveth.Geo->DrawArgs["cylinder"].Bounds;
+	Twelveth.IndexCount = Twelveth.Geo->DrawArgs["cylinder"].IndexCount;
+	Twelveth.StartIndexLocation = Twelveth.Geo->DrawArgs["cylinder"].StartIndexLocation;
+	Twelveth.BaseVertexLocation = Twelveth.Geo->DrawArgs["cylinder"].BaseVertexLocation;
+	Twelveth.Layer = (UINT)RenderLayer::Opaque;
+	mRitems.Add(Twelveth);
 }
 
-bool TreeBillboardsApp::CheckCameraCollision(FXMVECTOR predictPos)
+void TreeBillboardsApp::BuildOcclusion()
 {
-	for (auto ri : mRitemLayer[(int)RenderLayer::Opaque])
+	const SubmeshGeometry& box = mGeometries["shapeGeo"]->DrawArgs["box"];
+
+	const UINT8* layers = mRitems.Layers();
+	const RenderItemDrawArgs* drawArgs = mRitems.DrawArgs();
+	const BoundingBox* localBounds = mRitems.LocalBounds();
+	const XMFLOAT4X4* worlds = mRitems.World();
+
+	// Boxes at least 2 units thick along every axis, i.e. the building blocks,
+	// are worth rasterizing.  Their box is exactly what they draw.
+	for (UINT slot = 0; slot < mRitems.Size(); ++slot)
 	{
-		BoundingBox tempCameraBound;
-		XMStoreFloat3(&tempCameraBound.Center, predictPos);
-		tempCameraBound.Extents = mCameraBoundbox.Extents;
+		if (layers[slot] != (UINT8)RenderLayer::Opaque ||
+			drawArgs[slot].StartIndexLocation != box.StartIndexLocation || drawArgs[slot].IndexCount != box.IndexCount)
+			continue;
 
+		XMMATRIX world = XMLoadFloat4x4(&worlds[slot]);
 
-		BoundingBox localCameraBound;
+		BoundingBox worldBounds;
+		localBounds[slot].Transform(worldBounds, world);
+		if (worldBounds.Extents.x < 1.0f || worldBounds.Extents.y < 1.0f || worldBounds.Extents.z < 1.0f)
+			continue;
 
-		XMMATRIX W = XMLoadFloat4x4(&ri->World);
-		XMMATRIX invWorld = XMMatrixInverse(&XMMatrixDeterminant(W), W);
+		mOcclusionCuller.AddOccluderBox(localBounds[slot], world);
+	}
+
+	// The scene is static, so the occludee bounds are only computed once.
+	for (UINT slot = 0; slot < mRitems.Size(); ++slot)
+	{
+		if (layers[slot] != (UINT8)RenderLayer::Opaque && layers[slot] != (UINT8)RenderLayer::AlphaTested)
+			continue;
+
+		BoundingBox worldBounds;
+		localBounds[slot].Transform(worldBounds, XMLoadFloat4x4(&worlds[slot]));
+
+		mOccludees.push_back(mRitems.Handles()[slot]);
+		mOccludeeBounds.push_back(worldBounds);
+	}
+
+	mOccludeeVisible = std::make_unique<bool[]>(mOccludees.size());
+}
 
-		tempCameraBound.Transform(localCameraBound, invWorld);
+void TreeBillboardsApp::BuildCollision()
+{
+	// Items drawing the same submesh share its hierarchy.  The submesh is found
+	// by where the item's draw starts in the geometry buffers.
+	for (UINT slot = 0; slot < mRitems.Size(); ++slot)
+	{
+		const RenderItemDrawArgs& ri = mRitems.DrawArgs()[slot];
+		if (mRitems.Layers()[slot] != (UINT8)RenderLayer::Opaque ||
+			ri.Geo->VertexBufferCPU == nullptr || ri.Geo->IndexBufferCPU == nullptr)
+			continue;
 
-		if (ri->Bounds.Intersects(localCameraBound))
+		for (auto& drawArg : ri.Geo->DrawArgs)
 		{
-			return true;
+			const SubmeshGeometry& submesh = drawArg.second;
+			if (submesh.StartIndexLocation != ri.StartIndexLocation ||
+				submesh.BaseVertexLocation != ri.BaseVertexLocation ||
+				submesh.IndexCount != ri.IndexCount)
+				continue;
+
+			auto& bvh = mMeshBvhs[ri.Geo->Name + "/" + drawArg.first];
+			if (bvh == nullptr)
+			{
+				bvh = std::make_unique<TriangleBvh>();
+				bvh->Build(*ri.Geo, submesh);
+			}
+
+			mCollisionScene.AddInstance(bvh.get(), XMLoadFloat4x4(&mRitems.World()[slot]));
+			break;
 		}
 	}
-	
-	return false;
+
+	mCollisionScene.Build();
+	mCollision.SetScene(&mCollisionScene);
+
+	// As wide as the box the camera used to be tested with.
+	mCameraController.Radius = 1.1f;
 }
 
-void TreeBillboardsApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems)
+void TreeBillboardsApp::BuildDrawList()
+{
+	// Number the submeshes so that those of one MeshGeometry are neighbors in
+	// the sorted draws: geometries in the order their first item comes, and
+	// each geometry's submeshes by where they start.
+	std::unordered_map<const MeshGeometry*, UINT> geometryIds;
+	std::map<std::tuple<UINT, UINT, int, UINT>, UINT> submeshIds;
+
+	for (UINT slot = 0; slot < mRitems.Size(); ++slot)
+	{
+		const RenderItemDrawArgs& ri = mRitems.DrawArgs()[slot];
+		UINT geometry = geometryIds.emplace(ri.Geo, (UINT)geometryIds.size()).first->second;
+		submeshIds[std::make_tuple(geometry, ri.StartIndexLocation, ri.BaseVertexLocation, ri.IndexCount)] = 0;
+	}
+
+	UINT submeshCount = 0;
+	for (auto& e : submeshIds)
+		e.second = submeshCount++;
+
+	mSubmeshIds.resize(mRitems.Capacity(), 0);
+	for (UINT slot = 0; slot < mRitems.Size(); ++slot)
+	{
+		const RenderItemDrawArgs& ri = mRitems.DrawArgs()[slot];
+		UINT geometry = geometryIds[ri.Geo];
+		mSubmeshIds[mRitems.Handles()[slot]] =
+			submeshIds[std::make_tuple(geometry, ri.StartIndexLocation, ri.BaseVertexLocation, ri.IndexCount)];
+	}
+
+	mDrawList.Reserve(mRitems.Size());
+	mDrawBatches.reserve(mRitems.Size());
+}
+
+void TreeBillboardsApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList)
 {
-    UINT objCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
     UINT matCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(MaterialConstants));
 
-	auto objectCB = mCurrFrameResource->ObjectCB->Resource();
+	auto instanceBuffer = mCurrFrameResource->InstanceBuffer->Resource();
 	auto matCB = mCurrFrameResource->MaterialCB->Resource();
 
-    // For each render item...
-    for(size_t i = 0; i < ritems.size(); ++i)
+	const UINT8* layers = mRitems.Layers();
+	const RenderItemMaterial* materials = mRitems.Materials();
+	const RenderItemDrawArgs* drawArgs = mRitems.DrawArgs();
+
+	// What the previous draw left bound.  Draw reset the command list with the
+	// opaque PSO.
+	ID3D12PipelineState* pso = mLayerPSOs[(int)RenderLayer::Opaque];
+	const MeshGeometry* geo = nullptr;
+	D3D12_PRIMITIVE_TOPOLOGY primitiveType = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+	UINT matCBIndex = (UINT)-1;
+
+	DrawListStats stats;
+	stats.Draws = (UINT)mDrawBatches.size();
+	stats.Instances = mDrawList.Size();
+
+    // For each batch in key order, binding only what changed...
+    for(const DrawBatch& batch : mDrawBatches)
     {
-        auto ri = ritems[i];
+		UINT slot = batch.Slot;
+        const RenderItemDrawArgs& ri = drawArgs[slot];
+		const RenderItemMaterial& mat = materials[slot];
+
+		ID3D12PipelineState* layerPso = mLayerPSOs[layers[slot]];
+		if (layerPso != pso)
+		{
+			cmdList->SetPipelineState(layerPso);
+			pso = layerPso;
+			stats.StateChanges++;
+		}
+		else
+			stats.StateChangesSkipped++;
+
+		if (ri.Geo != geo)
+		{
+			cmdList->IASetVertexBuffers(0, 1, &ri.Geo->VertexBufferView());
+			cmdList->IASetIndexBuffer(&ri.Geo->IndexBufferView());
+			geo = ri.Geo;
+			stats.StateChanges += 2;
+		}
+		else
+			stats.StateChangesSkipped += 2;
 
-        cmdList->IASetVertexBuffers(0, 1, &ri->Geo->VertexBufferView());
-        cmdList->IASetIndexBuffer(&ri->Geo->IndexBufferView());
 		//step3
-        cmdList->IASetPrimitiveTopology(ri->PrimitiveType);
+		if (ri.PrimitiveType != primitiveType)
+		{
+			cmdList->IASetPrimitiveTopology(ri.PrimitiveType);
+			primitiveType = ri.PrimitiveType;
+			stats.StateChanges++;
+		}
+		else
+			stats.StateChangesSkipped++;
 
-		CD3DX12_GPU_DESCRIPTOR_HANDLE tex(mSrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
-		tex.Offset(ri->Mat->DiffuseSrvHeapIndex, mCbvSrvDescriptorSize);
+		if (mat.MatCBIndex != matCBIndex)
+		{
+			CD3DX12_GPU_DESCRIPTOR_HANDLE tex(mSrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
+			tex.Offset(mat.DiffuseSrvHeapIndex, mCbvSrvDescriptorSize);
+
+			D3D12_GPU_VIRTUAL_ADDRESS matCBAddress = matCB->GetGPUVirtualAddress() + mat.MatCBIndex*matCBByteSize;
 
-        D3D12_GPU_VIRTUAL_ADDRESS objCBAddress = objectCB->GetGPUVirtualAddress() + ri->ObjCBIndex*objCBByteSize;
-		D3D12_GPU_VIRTUAL_ADDRESS matCBAddress = matCB->GetGPUVirtualAddress() + ri->Mat->MatCBIndex*matCBByteSize;
+			cmdList->SetGraphicsRootDescriptorTable(0, tex);
+			cmdList->SetGraphicsRootConstantBufferView(3, matCBAddress);
+			matCBIndex = mat.MatCBIndex;
+			stats.StateChanges += 2;
+		}
+		else
+			stats.StateChangesSkipped += 2;
 
-		cmdList->SetGraphicsRootDescriptorTable(0, tex);
-        cmdList->SetGraphicsRootConstantBufferView(1, objCBAddress);
-        cmdList->SetGraphicsRootConstantBufferView(3, matCBAddress);
+		// SV_InstanceID restarts at 0 in every draw, so the view starts at the
+		// batch's first handle.
+		cmdList->SetGraphicsRootShaderResourceView(4, instanceBuffer->GetGPUVirtualAddress() +
+			batch.InstanceStart * sizeof(UINT));
 
-        cmdList->DrawIndexedInstanced(ri->IndexCount, 1, ri->StartIndexLocation, ri->BaseVertexLocation, 0);
+        cmdList->DrawIndexedInstanced(ri.IndexCount, batch.InstanceCount, ri.StartIndexLocation, ri.BaseVertexLocation, 0);
     }
+
+	mDrawStats = stats;
 }
 
 std::array<const CD3DX12_STATIC_SAMPLER_DESC, 6> TreeBillboardsApp::GetStaticSamplers()
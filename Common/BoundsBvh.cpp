@@ -0,0 +1,256 @@
+//***************************************************************************************
+// BoundsBvh.cpp
+//***************************************************************************************
+
+#include "BoundsBvh.h"
+#include "BvhBuild.h"
+
+using namespace DirectX;
+
+namespace
+{
+	XMFLOAT3 BoxMin(const CullingBounds& bounds, UINT i)
+	{
+		return XMFLOAT3(bounds.CenterX()[i] - bounds.ExtentX()[i],
+			bounds.CenterY()[i] - bounds.ExtentY()[i],
+			bounds.CenterZ()[i] - bounds.ExtentZ()[i]);
+	}
+
+	XMFLOAT3 BoxMax(const CullingBounds& bounds, UINT i)
+	{
+		return XMFLOAT3(bounds.CenterX()[i] + bounds.ExtentX()[i],
+			bounds.CenterY()[i] + bounds.ExtentY()[i],
+			bounds.CenterZ()[i] + bounds.ExtentZ()[i]);
+	}
+
+	XMFLOAT3 BoxCenter(const CullingBounds& bounds, UINT i)
+	{
+		return XMFLOAT3(bounds.CenterX()[i], bounds.CenterY()[i], bounds.CenterZ()[i]);
+	}
+
+	enum class PlaneSide
+	{
+		Outside,
+		Intersects,
+		Inside
+	};
+
+	PlaneSide ClassifyBox(const XMFLOAT4& plane, const XMFLOAT3& center, const XMFLOAT3& extents)
+	{
+		float d = plane.x*center.x + plane.y*center.y + plane.z*center.z + plane.w;
+		float r = fabsf(plane.x)*extents.x + fabsf(plane.y)*extents.y + fabsf(plane.z)*extents.z;
+
+		if(d + r < 0.0f)
+			return PlaneSide::Outside;
+
+		return d - r >= 0.0f ? PlaneSide::Inside : PlaneSide::Intersects;
+	}
+}
+
+void BoundsBvh::Build(const CullingBounds& bounds)
+{
+	UINT count = bounds.Size();
+
+	mIndices.resize(count);
+	for(UINT i = 0; i < count; ++i)
+		mIndices[i] = i;
+
+	mNodes.clear();
+	mNodes.reserve(2*count);
+	mDepth = 0;
+
+	if(count == 0)
+		return;
+
+	Node root;
+	root.First = 0;
+	root.Count = count;
+	mNodes.push_back(root);
+
+	BuildNode(bounds, 0, 1);
+}
+
+void BoundsBvh::BuildNode(const CullingBounds& bounds, UINT nodeIndex, UINT depth)
+{
+	ComputeNodeBounds(bounds, mNodes[nodeIndex]);
+	mDepth = MathHelper::Max(mDepth, depth);
+
+	UINT first = mNodes[nodeIndex].First;
+	UINT count = mNodes[nodeIndex].Count;
+	if(count <= MaxLeafSize)
+		return;
+
+	// Split along the longest axis of the box centers.
+	BvhBuild::Aabb centroidBounds;
+	for(UINT i = first; i < first + count; ++i)
+	{
+		XMFLOAT3 c = BoxCenter(bounds, mIndices[i]);
+		centroidBounds.Grow(c, c);
+	}
+
+	UINT leftCount = BvhBuild::Split(mIndices.begin() + first, count, centroidBounds, depth,
+		[&](UINT index) { return BoxCenter(bounds, index); },
+		[&](BvhBuild::Aabb& box, UINT index) { box.Grow(BoxMin(bounds, index), BoxMax(bounds, index)); });
+
+	// Both children are added together so the right child follows the left.
+	UINT leftIndex = (UINT)mNodes.size();
+	mNodes[nodeIndex].Left = leftIndex;
+
+	Node leftNode;
+	leftNode.First = first;
+	leftNode.Count = leftCount;
+
+	Node rightNode;
+	rightNode.First = first + leftCount;
+	rightNode.Count = count - leftCount;
+
+	mNodes.push_back(leftNode);
+	mNodes.push_back(rightNode);
+
+	BuildNode(bounds, leftIndex, depth + 1);
+	BuildNode(bounds, leftIndex + 1, depth + 1);
+}
+
+void BoundsBvh::ComputeNodeBounds(const CullingBounds& bounds, Node& node)const
+{
+	BvhBuild::Aabb box;
+	for(UINT i = node.First; i < node.First + node.Count; ++i)
+		box.Grow(BoxMin(bounds, mIndices[i]), BoxMax(bounds, mIndices[i]));
+
+	node.Min = box.Min;
+	node.Max = box.Max;
+}
+
+void BoundsBvh::Refit(const CullingBounds& bounds)
+{
+	assert(bounds.Size() == (UINT)mIndices.size());
+
+	// Children always come after their parent, so a backwards pass sees
+	// both children before the parent.
+	for(UINT i = (UINT)mNodes.size(); i-- > 0; )
+	{
+		Node& node = mNodes[i];
+		if(node.Left == 0)
+		{
+			ComputeNodeBounds(bounds, node);
+			continue;
+		}
+
+		BvhBuild::Aabb box;
+		box.Grow(mNodes[node.Left].Min, mNodes[node.Left].Max);
+		box.Grow(mNodes[node.Left + 1].Min, mNodes[node.Left + 1].Max);
+
+		node.Min = box.Min;
+		node.Max = box.Max;
+	}
+}
+
+UINT BoundsBvh::Cull(const CullingBounds& bounds, const FrustumPlanes& frustum,
+	UINT* visibleIndices, BvhCullStats* stats)const
+{
+	BvhCullStats localStats;
+	UINT visibleCount = 0;
+
+	if(mNodes.empty())
+	{
+		if(stats != nullptr)
+			*stats = localStats;
+		return 0;
+	}
+
+	// Each entry carries the planes its box still has to be tested against;
+	// a plane a node is fully inside of is dropped for the whole subtree.
+	struct StackEntry
+	{
+		UINT Node;
+		UINT PlaneMask;
+	};
+
+	const UINT allPlanes = (1u << FrustumPlanes::Count) - 1;
+
+	StackEntry stack[BvhBuild::MaxStackSize];
+	UINT stackSize = 0;
+	stack[stackSize++] = { 0, allPlanes };
+
+	while(stackSize > 0)
+	{
+		StackEntry entry = stack[--stackSize];
+		const Node& node = mNodes[entry.Node];
+		localStats.NodesVisited++;
+
+		XMFLOAT3 center(0.5f*(node.Min.x + node.Max.x), 0.5f*(node.Min.y + node.Max.y), 0.5f*(node.Min.z + node.Max.z));
+		XMFLOAT3 extents(0.5f*(node.Max.x - node.Min.x), 0.5f*(node.Max.y - node.Min.y), 0.5f*(node.Max.z - node.Min.z));
+
+		UINT planeMask = entry.PlaneMask;
+		bool outside = false;
+		for(UINT p = 0; p < FrustumPlanes::Count && !outside; ++p)
+		{
+			if((planeMask & (1u << p)) == 0)
+				continue;
+
+			PlaneSide side = ClassifyBox(frustum.Planes[p], center, extents);
+			outside = side == PlaneSide::Outside;
+			if(side == PlaneSide::Inside)
+				planeMask &= ~(1u << p);
+		}
+
+		if(outside)
+		{
+			localStats.RejectedSubtrees++;
+			continue;
+		}
+
+		if(planeMask == 0)
+		{
+			// Fully inside: everything below is visible.
+			localStats.AcceptedSubtrees++;
+			for(UINT i = node.First; i < node.First + node.Count; ++i)
+				visibleIndices[visibleCount++] = mIndices[i];
+			continue;
+		}
+
+		if(node.Left != 0)
+		{
+			assert(stackSize + 2 <= BvhBuild::MaxStackSize);
+			stack[stackSize++] = { node.Left + 1, planeMask };
+			stack[stackSize++] = { node.Left, planeMask };
+			continue;
+		}
+
+		// A leaf the frustum cuts through: test its boxes against the
+		// planes that are left.
+		for(UINT i = node.First; i < node.First + node.Count; ++i)
+		{
+			UINT index = mIndices[i];
+			XMFLOAT3 boxCenter = BoxCenter(bounds, index);
+			XMFLOAT3 boxExtents(bounds.ExtentX()[index], bounds.ExtentY()[index], bounds.ExtentZ()[index]);
+
+			bool boxOutside = false;
+			for(UINT p = 0; p < FrustumPlanes::Count && !boxOutside; ++p)
+			{
+				if(planeMask & (1u << p))
+					boxOutside = ClassifyBox(frustum.Planes[p], boxCenter, boxExtents) == PlaneSide::Outside;
+			}
+
+			if(!boxOutside)
+				visibleIndices[visibleCount++] = index;
+		}
+
+		localStats.BoxesTested += node.Count;
+	}
+
+	if(stats != nullptr)
+		*stats = localStats;
+
+	return visibleCount;
+}
+
+UINT BoundsBvh::NodeCount()const
+{
+	return (UINT)mNodes.size();
+}
+
+UINT BoundsBvh::Depth()const
+{
+	return mDepth;
+}
@@ -0,0 +1,78 @@
+//***************************************************************************************
+// BoundsBvh.h
+//
+// Bounding volume hierarchy over the world-space boxes of a CullingBounds, for
+// hierarchical frustum culling of large static scenes.
+//   -Build sorts the boxes into a binary tree with a binned surface area heuristic.
+//    The boxes under any node form one contiguous range of the index array.
+//   -Cull walks the tree and classifies each node against the planes the parent
+//    still intersects.  Subtrees fully outside are skipped and subtrees fully inside
+//    are accepted as a whole, without testing their boxes.
+//   -Refit recomputes the node boxes after instances moved, keeping the tree.
+//***************************************************************************************
+
+#ifndef BOUNDSBVH_H
+#define BOUNDSBVH_H
+
+#include "Culling.h"
+
+struct BvhCullStats
+{
+	UINT NodesVisited = 0;
+
+	// Subtrees accepted or skipped without visiting their children.
+	UINT AcceptedSubtrees = 0;
+	UINT RejectedSubtrees = 0;
+
+	// Individual boxes tested in leaves the frustum intersects.
+	UINT BoxesTested = 0;
+};
+
+class BoundsBvh
+{
+public:
+	// Leaves hold at most this many boxes.
+	static const UINT MaxLeafSize = 4;
+
+	BoundsBvh() = default;
+
+	void Build(const CullingBounds& bounds);
+
+	// Recomputes every node box from the current bounds.  The bounds must
+	// still have the size the tree was built with.
+	void Refit(const CullingBounds& bounds);
+
+	// Writes the indices of the visible boxes, in tree order, and returns
+	// how many there are.  visibleIndices needs room for bounds.Size().
+	UINT Cull(const CullingBounds& bounds, const FrustumPlanes& frustum,
+		UINT* visibleIndices, BvhCullStats* stats = nullptr)const;
+
+	UINT NodeCount()const;
+	UINT Depth()const;
+
+private:
+	struct Node
+	{
+		DirectX::XMFLOAT3 Min;
+		DirectX::XMFLOAT3 Max;
+
+		// Range of mIndices under this node.
+		UINT First = 0;
+		UINT Count = 0;
+
+		// Index of the left child; the right child follows it.  0 for
+		// leaves, since the root is never a child.
+		UINT Left = 0;
+	};
+
+	void BuildNode(const CullingBounds& bounds, UINT nodeIndex, UINT depth);
+	void ComputeNodeBounds(const CullingBounds& bounds, Node& node)const;
+
+private:
+	std::vector<Node> mNodes;
+	std::vector<UINT> mIndices;
+
+	UINT mDepth = 0;
+};
+
+#endif // BOUNDSBVH_H
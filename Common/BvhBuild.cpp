@@ -0,0 +1,28 @@
+//***************************************************************************************
+// BvhBuild.cpp
+//***************************************************************************************
+
+#include "BvhBuild.h"
+
+using namespace DirectX;
+
+float BvhBuild::Component(const XMFLOAT3& v, UINT axis)
+{
+	return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+float XM_CALLCONV BvhBuild::EnterBox(FXMVECTOR origin, FXMVECTOR invDir, const XMFLOAT3& boxMin,
+	const XMFLOAT3& boxMax, float maxT)
+{
+	XMVECTOR t0 = XMVectorMultiply(XMVectorSubtract(XMLoadFloat3(&boxMin), origin), invDir);
+	XMVECTOR t1 = XMVectorMultiply(XMVectorSubtract(XMLoadFloat3(&boxMax), origin), invDir);
+
+	XMFLOAT3 tNear, tFar;
+	XMStoreFloat3(&tNear, XMVectorMin(t0, t1));
+	XMStoreFloat3(&tFar, XMVectorMax(t0, t1));
+
+	float enter = MathHelper::Max(MathHelper::Max(tNear.x, tNear.y), MathHelper::Max(tNear.z, 0.0f));
+	float exit = MathHelper::Min(MathHelper::Min(tFar.x, tFar.y), MathHelper::Min(tFar.z, maxT));
+
+	return enter <= exit && enter < maxT ? enter : FLT_MAX;
+}
@@ -0,0 +1,155 @@
+//***************************************************************************************
+// BvhBuild.h
+//
+// Building blocks shared by TriangleBvh, SceneBvh and BoundsBvh.
+//   -Aabb grows a box over points and boxes and gives its surface area heuristic cost.
+//   -Split divides the primitives of a node in two with a binned surface area
+//    heuristic along the longest axis of their centroids, and falls back to halving
+//    the node by centroid when no bin boundary separates them or the node is deep.
+//   -EnterBox is the slab test the ray traversals use to order and prune nodes.
+//***************************************************************************************
+
+#ifndef BVHBUILD_H
+#define BVHBUILD_H
+
+#include "d3dUtil.h"
+
+class BvhBuild
+{
+public:
+	static const UINT SahBinCount = 12;
+
+	// Below this depth splits always halve the node, which bounds the depth
+	// of the tree and so the traversal stack.
+	static const UINT MaxSahDepth = 32;
+	static const UINT MaxStackSize = 64;
+
+	struct Aabb
+	{
+		DirectX::XMFLOAT3 Min = { FLT_MAX, FLT_MAX, FLT_MAX };
+		DirectX::XMFLOAT3 Max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		void Grow(const DirectX::XMFLOAT3& pMin, const DirectX::XMFLOAT3& pMax)
+		{
+			Min.x = MathHelper::Min(Min.x, pMin.x);
+			Min.y = MathHelper::Min(Min.y, pMin.y);
+			Min.z = MathHelper::Min(Min.z, pMin.z);
+			Max.x = MathHelper::Max(Max.x, pMax.x);
+			Max.y = MathHelper::Max(Max.y, pMax.y);
+			Max.z = MathHelper::Max(Max.z, pMax.z);
+		}
+
+		float HalfArea()const
+		{
+			if(Max.x < Min.x)
+				return 0.0f;
+
+			float dx = Max.x - Min.x;
+			float dy = Max.y - Min.y;
+			float dz = Max.z - Min.z;
+			return dx*dy + dy*dz + dz*dx;
+		}
+	};
+
+	static float Component(const DirectX::XMFLOAT3& v, UINT axis);
+
+	// Distance at which the ray enters the box, or FLT_MAX when it misses it
+	// or enters at maxT or beyond.
+	static float XM_CALLCONV EnterBox(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR invDir,
+		const DirectX::XMFLOAT3& boxMin, const DirectX::XMFLOAT3& boxMax, float maxT);
+
+	// Reorders the count primitives from first on so that the left child's come
+	// first, and returns how many that is, between 1 and count - 1.  centroids
+	// bounds their centroids, depth is the node's.  centerOf(primitive) returns
+	// a primitive's centroid and growBy(box, primitive) grows box by its bounds.
+	template<typename Iterator, typename CenterOf, typename GrowBy>
+	static UINT Split(Iterator first, UINT count, const Aabb& centroids, UINT depth,
+		CenterOf centerOf, GrowBy growBy);
+};
+
+template<typename Iterator, typename CenterOf, typename GrowBy>
+UINT BvhBuild::Split(Iterator first, UINT count, const Aabb& centroids, UINT depth,
+	CenterOf centerOf, GrowBy growBy)
+{
+	typedef const typename std::iterator_traits<Iterator>::value_type& Primitive;
+
+	// Split along the longest axis of the centroids.
+	DirectX::XMFLOAT3 size(centroids.Max.x - centroids.Min.x,
+		centroids.Max.y - centroids.Min.y,
+		centroids.Max.z - centroids.Min.z);
+
+	UINT axis = 0;
+	if(size.y > Component(size, axis)) axis = 1;
+	if(size.z > Component(size, axis)) axis = 2;
+
+	float axisMin = Component(centroids.Min, axis);
+	float axisSize = Component(size, axis);
+
+	UINT leftCount = 0;
+	if(axisSize > 0.0f && depth < MaxSahDepth)
+	{
+		// Binned SAH: sort the centroids into bins, then pick the bin boundary
+		// with the lowest count*area cost on both sides.
+		Aabb binBounds[SahBinCount];
+		UINT binCounts[SahBinCount] = { 0 };
+
+		float binScale = SahBinCount / axisSize;
+		auto binOf = [&](Primitive primitive)
+		{
+			float c = Component(centerOf(primitive), axis);
+			return MathHelper::Min((UINT)((c - axisMin)*binScale), SahBinCount - 1);
+		};
+
+		for(Iterator it = first; it != first + count; ++it)
+		{
+			UINT bin = binOf(*it);
+			binCounts[bin]++;
+			growBy(binBounds[bin], *it);
+		}
+
+		float rightCosts[SahBinCount];
+		Aabb right;
+		UINT rightCount = 0;
+		for(UINT bin = SahBinCount - 1; bin > 0; --bin)
+		{
+			right.Grow(binBounds[bin].Min, binBounds[bin].Max);
+			rightCount += binCounts[bin];
+			rightCosts[bin] = rightCount*right.HalfArea();
+		}
+
+		float bestCost = FLT_MAX;
+		UINT bestSplit = 0;
+		Aabb left;
+		UINT leftBinCount = 0;
+		for(UINT bin = 0; bin < SahBinCount - 1; ++bin)
+		{
+			left.Grow(binBounds[bin].Min, binBounds[bin].Max);
+			leftBinCount += binCounts[bin];
+
+			float cost = leftBinCount*left.HalfArea() + rightCosts[bin + 1];
+			if(leftBinCount > 0 && leftBinCount < count && cost < bestCost)
+			{
+				bestCost = cost;
+				bestSplit = bin;
+			}
+		}
+
+		Iterator middle = std::partition(first, first + count,
+			[&](Primitive primitive) { return binOf(primitive) <= bestSplit; });
+		leftCount = (UINT)(middle - first);
+	}
+
+	// All centroids in one place, or too deep: halve the node by centroid.
+	if(leftCount == 0 || leftCount == count)
+	{
+		leftCount = count / 2;
+		std::nth_element(first, first + leftCount, first + count, [&](Primitive a, Primitive b)
+		{
+			return Component(centerOf(a), axis) < Component(centerOf(b), axis);
+		});
+	}
+
+	return leftCount;
+}
+
+#endif // BVHBUILD_H
@@ -0,0 +1,78 @@
+//***************************************************************************************
+// CameraController.cpp
+//***************************************************************************************
+
+#include "CameraController.h"
+
+using namespace DirectX;
+
+void XM_CALLCONV CameraController::Move(Camera& camera, FXMVECTOR motion, CollisionQuery& query,
+	CameraMoveStats* stats)
+{
+	CameraMoveStats moveStats;
+
+	XMVECTOR position = camera.GetPosition();
+	XMVECTOR remaining = motion;
+	XMVECTOR lastNormal = XMVectorZero();
+
+	for(UINT slide = 0; slide <= MaxSlides; ++slide)
+	{
+		float length = XMVectorGetX(XMVector3Length(remaining));
+		if(length < 1e-6f)
+			break;
+
+		SweepHit hit;
+		CollisionStats sweepStats;
+		bool blocked = query.SweepSphere(position, Radius, remaining, hit, &sweepStats);
+
+		moveStats.Sweeps++;
+		moveStats.Triangles += sweepStats.Triangles;
+
+		if(!blocked)
+		{
+			position += remaining;
+			break;
+		}
+
+		// Stop SkinWidth short of the contact along the motion.
+		float t = MathHelper::Max(hit.T - SkinWidth / length, 0.0f);
+		position += t*remaining;
+		remaining *= 1.0f - t;
+
+		// Motion grazing a surface barely gets away from it that way, so also
+		// lift the sphere off to SkinWidth along the normal.  Otherwise the
+		// slide would touch the same surface again straight away.
+		XMVECTOR normal = XMLoadFloat3(&hit.Normal);
+		XMVECTOR contact = XMLoadFloat3(&hit.Point);
+		float gap = XMVectorGetX(XMVector3Dot(position - contact, normal)) - Radius;
+		if(gap < SkinWidth)
+			position += (SkinWidth - gap)*normal;
+
+		// Keep only the part of what is left that slides along the surface.
+		// When that heads back into the previous surface the sphere is in a
+		// crease, so it may only slide along the line where the two meet.
+		float into = XMVectorGetX(XMVector3Dot(remaining, normal));
+		if(into < 0.0f)
+			remaining -= into*normal;
+
+		if(moveStats.Contacts > 0 && XMVectorGetX(XMVector3Dot(remaining, lastNormal)) < 0.0f)
+		{
+			XMVECTOR crease = XMVector3Cross(lastNormal, normal);
+			float creaseLengthSq = XMVectorGetX(XMVector3LengthSq(crease));
+			if(creaseLengthSq > 1e-8f)
+				remaining = (XMVectorGetX(XMVector3Dot(remaining, crease)) / creaseLengthSq)*crease;
+			else
+				remaining = XMVectorZero();
+		}
+
+		lastNormal = normal;
+		moveStats.Contacts++;
+	}
+
+	XMFLOAT3 p;
+	XMStoreFloat3(&p, position);
+	camera.SetPosition(p);
+
+	if(stats != nullptr)
+		*stats = moveStats;
+}
@@ -0,0 +1,53 @@
+//***************************************************************************************
+// CameraController.h
+//
+// Moves a Camera as a sphere that slides along the triangles of a scene instead of
+// passing through them.
+//   -Each step sweeps the sphere along the remaining motion with a CollisionQuery.
+//    On contact the camera advances to SkinWidth short of the surface, and the part
+//    of the motion going into the surface is removed so the rest slides along it.
+//   -When the slide runs into a second surface it continues along the crease where
+//    the two meet, so the camera does not jitter between them in a corner.
+//   -The motion is redirected at most MaxSlides times per move; what is left after
+//    that is dropped so the camera never ends inside a wall.
+//***************************************************************************************
+
+#ifndef CAMERACONTROLLER_H
+#define CAMERACONTROLLER_H
+
+#include "Camera.h"
+#include "CollisionQuery.h"
+
+struct CameraMoveStats
+{
+	// Sphere sweeps made and contacts resolved by the last Move.
+	UINT Sweeps = 0;
+	UINT Contacts = 0;
+
+	// Triangles the sweeps gathered in total.
+	UINT Triangles = 0;
+};
+
+class CameraController
+{
+public:
+	CameraController() = default;
+	CameraController(const CameraController& rhs) = delete;
+	CameraController& operator=(const CameraController& rhs) = delete;
+	~CameraController() = default;
+
+	// Moves the camera by the world-space motion, sliding along what it hits.
+	void XM_CALLCONV Move(Camera& camera, DirectX::FXMVECTOR motion, CollisionQuery& query,
+		CameraMoveStats* stats = nullptr);
+
+public:
+	// Radius of the sphere around the camera position.
+	float Radius = 1.0f;
+
+	// Gap kept between the sphere and a surface it stops at.
+	float SkinWidth = 0.01f;
+
+	UINT MaxSlides = 3;
+};
+
+#endif // CAMERACONTROLLER_H
@@ -0,0 +1,439 @@
+//***************************************************************************************
+// ClusteredLights.cpp
+//***************************************************************************************
+
+#include "ClusteredLights.h"
+#include <intrin.h>
+
+using namespace DirectX;
+
+namespace
+{
+	// Padding spheres sit this far away with no radius, so they overlap no
+	// box.
+	const float PaddingCenter = 1.0e30f;
+
+	UINT RoundUp(UINT x, UINT multiple)
+	{
+		return (x + multiple - 1) / multiple * multiple;
+	}
+
+	// Appends base + lane for every set bit of hits without branching: every
+	// lane is written, but count only moves past the hits.
+	UINT Compact(int hits, UINT base, UINT lanes, UINT* found, UINT count)
+	{
+		for(UINT lane = 0; lane < lanes; ++lane)
+		{
+			found[count] = base + lane;
+			count += (hits >> lane) & 1;
+		}
+
+		return count;
+	}
+
+	// Box as min and max corners for the loops.
+	struct BoxRange
+	{
+		float MinX, MinY, MinZ;
+		float MaxX, MaxY, MaxZ;
+	};
+
+	BoxRange MakeBoxRange(const BoundingBox& box)
+	{
+		BoxRange range;
+		range.MinX = box.Center.x - box.Extents.x;
+		range.MinY = box.Center.y - box.Extents.y;
+		range.MinZ = box.Center.z - box.Extents.z;
+		range.MaxX = box.Center.x + box.Extents.x;
+		range.MaxY = box.Center.y + box.Extents.y;
+		range.MaxZ = box.Center.z + box.Extents.z;
+
+		return range;
+	}
+
+	BoundingBox MakeBox(float minX, float minY, float minZ, float maxX, float maxY, float maxZ)
+	{
+		return BoundingBox(
+			XMFLOAT3(0.5f*(minX + maxX), 0.5f*(minY + maxY), 0.5f*(minZ + maxZ)),
+			XMFLOAT3(0.5f*(maxX - minX), 0.5f*(maxY - minY), 0.5f*(maxZ - minZ)));
+	}
+
+	// The distance from a center to the box along each axis is how far it is
+	// below min or above max, clamped at zero.
+	UINT OverlapSse(const float* x, const float* y, const float* z, const float* radius,
+		UINT count, const BoxRange& box, UINT* found)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 minX = _mm_set1_ps(box.MinX);
+		const __m128 minY = _mm_set1_ps(box.MinY);
+		const __m128 minZ = _mm_set1_ps(box.MinZ);
+		const __m128 maxX = _mm_set1_ps(box.MaxX);
+		const __m128 maxY = _mm_set1_ps(box.MaxY);
+		const __m128 maxZ = _mm_set1_ps(box.MaxZ);
+
+		UINT hitCount = 0;
+		for(UINT base = 0; base < count; base += 4)
+		{
+			__m128 cx = _mm_loadu_ps(x + base);
+			__m128 cy = _mm_loadu_ps(y + base);
+			__m128 cz = _mm_loadu_ps(z + base);
+			__m128 r = _mm_loadu_ps(radius + base);
+
+			__m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minX, cx), _mm_sub_ps(cx, maxX)), zero);
+			__m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minY, cy), _mm_sub_ps(cy, maxY)), zero);
+			__m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minZ, cz), _mm_sub_ps(cz, maxZ)), zero);
+
+			__m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			int hits = _mm_movemask_ps(_mm_cmple_ps(distSq, _mm_mul_ps(r, r)));
+
+			hitCount = Compact(hits, base, 4, found, hitCount);
+		}
+
+		return hitCount;
+	}
+
+	UINT OverlapAvx(const float* x, const float* y, const float* z, const float* radius,
+		UINT count, const BoxRange& box, UINT* found)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 minX = _mm256_set1_ps(box.MinX);
+		const __m256 minY = _mm256_set1_ps(box.MinY);
+		const __m256 minZ = _mm256_set1_ps(box.MinZ);
+		const __m256 maxX = _mm256_set1_ps(box.MaxX);
+		const __m256 maxY = _mm256_set1_ps(box.MaxY);
+		const __m256 maxZ = _mm256_set1_ps(box.MaxZ);
+
+		UINT hitCount = 0;
+		for(UINT base = 0; base < count; base += 8)
+		{
+			__m256 cx = _mm256_loadu_ps(x + base);
+			__m256 cy = _mm256_loadu_ps(y + base);
+			__m256 cz = _mm256_loadu_ps(z + base);
+			__m256 r = _mm256_loadu_ps(radius + base);
+
+			__m256 dx = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(minX, cx), _mm256_sub_ps(cx, maxX)), zero);
+			__m256 dy = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(minY, cy), _mm256_sub_ps(cy, maxY)), zero);
+			__m256 dz = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(minZ, cz), _mm256_sub_ps(cz, maxZ)), zero);
+
+			__m256 distSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+			int hits = _mm256_movemask_ps(_mm256_cmp_ps(distSq, _mm256_mul_ps(r, r), _CMP_LE_OQ));
+
+			hitCount = Compact(hits, base, 8, found, hitCount);
+		}
+
+		return hitCount;
+	}
+}
+
+void ClusteredLights::SphereSet::Resize(UINT count)
+{
+	UINT paddedCount = RoundUp(count, Lanes);
+
+	// Shrinking first makes the padding get rewritten, whatever was there.
+	X.resize(count);
+	Y.resize(count);
+	Z.resize(count);
+	Radius.resize(count);
+	Index.resize(count);
+
+	X.resize(paddedCount, PaddingCenter);
+	Y.resize(paddedCount, PaddingCenter);
+	Z.resize(paddedCount, PaddingCenter);
+	Radius.resize(paddedCount, 0.0f);
+	Index.resize(paddedCount, 0);
+}
+
+void ClusteredLights::SetGrid(UINT tilesX, UINT tilesY, UINT slices)
+{
+	assert(tilesX > 0 && tilesY > 0 && slices > 0);
+
+	mTilesX = tilesX;
+	mTilesY = tilesY;
+	mSlices = slices;
+	mBoundsDirty = true;
+}
+
+void ClusteredLights::SetLens(float fovY, float aspect, float nearZ, float farZ)
+{
+	assert(nearZ > 0.0f && farZ > nearZ);
+
+	if(fovY != mFovY || aspect != mAspect || nearZ != mNearZ || farZ != mFarZ)
+	{
+		mFovY = fovY;
+		mAspect = aspect;
+		mNearZ = nearZ;
+		mFarZ = farZ;
+		mBoundsDirty = true;
+	}
+}
+
+void ClusteredLights::BuildClusterBounds()
+{
+	float tanY = tanf(0.5f*mFovY);
+	float tanX = tanY*mAspect;
+
+	mClusterBounds.resize(ClusterCount());
+	mRowBounds.resize(mSlices*mTilesY);
+	mSliceBounds.resize(mSlices);
+	mSliceWork.resize(mSlices);
+
+	for(UINT slice = 0; slice < mSlices; ++slice)
+	{
+		float z0 = mNearZ*powf(mFarZ / mNearZ, (float)slice / mSlices);
+		float z1 = mNearZ*powf(mFarZ / mNearZ, (float)(slice + 1) / mSlices);
+
+		mSliceBounds[slice] = MakeBox(-z1*tanX, -z1*tanY, z0, z1*tanX, z1*tanY, z1);
+
+		for(UINT tileY = 0; tileY < mTilesY; ++tileY)
+		{
+			// NDC y runs from +1 at the top row down to -1.
+			float top = 1.0f - 2.0f*tileY / mTilesY;
+			float bottom = 1.0f - 2.0f*(tileY + 1) / mTilesY;
+			float minY = MathHelper::Min(bottom*z0, bottom*z1)*tanY;
+			float maxY = MathHelper::Max(top*z0, top*z1)*tanY;
+
+			mRowBounds[slice*mTilesY + tileY] = MakeBox(-z1*tanX, minY, z0, z1*tanX, maxY, z1);
+
+			for(UINT tileX = 0; tileX < mTilesX; ++tileX)
+			{
+				float left = -1.0f + 2.0f*tileX / mTilesX;
+				float right = -1.0f + 2.0f*(tileX + 1) / mTilesX;
+				float minX = MathHelper::Min(left*z0, left*z1)*tanX;
+				float maxX = MathHelper::Max(right*z0, right*z1)*tanX;
+
+				mClusterBounds[ClusterIndex(tileX, tileY, slice)] = MakeBox(minX, minY, z0, maxX, maxY, z1);
+			}
+		}
+	}
+
+	mFrustumBounds = MakeBox(-mFarZ*tanX, -mFarZ*tanY, mNearZ, mFarZ*tanX, mFarZ*tanY, mFarZ);
+
+	mBoundsDirty = false;
+}
+
+UINT ClusteredLights::OverlapBox(const SphereSet& spheres, UINT count, const BoundingBox& box,
+	std::vector<UINT>& found)
+{
+	UINT paddedCount = RoundUp(count, Lanes);
+	if(found.size() < paddedCount + Lanes)
+		found.resize(paddedCount + Lanes);
+
+	BoxRange range = MakeBoxRange(box);
+
+	return Culling::HasAvx() ?
+		OverlapAvx(spheres.X.data(), spheres.Y.data(), spheres.Z.data(), spheres.Radius.data(),
+			paddedCount, range, found.data()) :
+		OverlapSse(spheres.X.data(), spheres.Y.data(), spheres.Z.data(), spheres.Radius.data(),
+			paddedCount, range, found.data());
+}
+
+void ClusteredLights::Gather(const SphereSet& src, const std::vector<UINT>& found, UINT count, SphereSet& dst)
+{
+	dst.Resize(count);
+
+	for(UINT i = 0; i < count; ++i)
+	{
+		UINT j = found[i];
+		dst.X[i] = src.X[j];
+		dst.Y[i] = src.Y[j];
+		dst.Z[i] = src.Z[j];
+		dst.Radius[i] = src.Radius[j];
+		dst.Index[i] = src.Index[j];
+	}
+}
+
+void XM_CALLCONV ClusteredLights::Build(const Light* lights, UINT pointCount, UINT spotCount,
+	FXMMATRIX view, ClusterStats* stats)
+{
+	if(mBoundsDirty)
+		BuildClusterBounds();
+
+	//
+	// Bounding spheres of the lights in view space.
+	//
+
+	mLightCount = pointCount + spotCount;
+	mLights.Resize(mLightCount);
+
+	for(UINT i = 0; i < mLightCount; ++i)
+	{
+		const Light& light = lights[i];
+
+		XMVECTOR center = XMVector3TransformCoord(XMLoadFloat3(&light.Position), view);
+		float radius = light.FalloffEnd;
+
+		// Past the cutoff angle the cone is bounded by the sphere through its
+		// apex and rim, which is smaller than the range once the cone is
+		// narrower than 60 degrees.
+		if(i >= pointCount && light.SpotPower > 0.0f)
+		{
+			float cosCutoff = powf(SpotCutoff, 1.0f / light.SpotPower);
+			if(cosCutoff > 0.5f)
+			{
+				radius = light.FalloffEnd / (2.0f*cosCutoff);
+
+				XMVECTOR dir = XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&light.Direction), view));
+				center += radius*dir;
+			}
+		}
+
+		XMFLOAT3 c;
+		XMStoreFloat3(&c, center);
+
+		mLights.X[i] = c.x;
+		mLights.Y[i] = c.y;
+		mLights.Z[i] = c.z;
+		mLights.Radius[i] = radius;
+		mLights.Index[i] = i;
+	}
+
+	// Only the lights that reach the frustum's box go on to the slices.
+	mViewLightCount = OverlapBox(mLights, mLightCount, mFrustumBounds, mFound);
+	Gather(mLights, mFound, mViewLightCount, mViewLights);
+
+	//
+	// Bin each slice, then lay the slices' lists out back to back.
+	//
+
+	if(Parallel)
+	{
+		concurrency::parallel_for(0u, mSlices, [this](UINT slice)
+		{
+			BinSlice(slice);
+		});
+	}
+	else
+	{
+		for(UINT slice = 0; slice < mSlices; ++slice)
+			BinSlice(slice);
+	}
+
+	UINT clustersPerSlice = mTilesX*mTilesY;
+
+	mRanges.resize(ClusterCount());
+
+	ClusterStats buildStats;
+	buildStats.Lights = mLightCount;
+	buildStats.LightsInView = mViewLightCount;
+
+	UINT offset = 0;
+	for(UINT slice = 0; slice < mSlices; ++slice)
+	{
+		const SliceWork& work = mSliceWork[slice];
+
+		for(UINT i = 0; i < clustersPerSlice; ++i)
+		{
+			ClusterRange& range = mRanges[slice*clustersPerSlice + i];
+			range.Offset = offset;
+			range.Count = work.Counts[i];
+			offset += range.Count;
+
+			buildStats.NonEmptyClusters += range.Count > 0 ? 1 : 0;
+			buildStats.MaxLightsPerCluster = MathHelper::Max(buildStats.MaxLightsPerCluster, range.Count);
+		}
+	}
+
+	mLightIndices.resize(offset);
+	buildStats.IndexCount = offset;
+
+	for(UINT slice = 0; slice < mSlices; ++slice)
+	{
+		const SliceWork& work = mSliceWork[slice];
+		if(!work.Indices.empty())
+		{
+			memcpy(&mLightIndices[mRanges[slice*clustersPerSlice].Offset], work.Indices.data(),
+				work.Indices.size()*sizeof(UINT));
+		}
+	}
+
+	if(stats != nullptr)
+		*stats = buildStats;
+}
+
+void ClusteredLights::BinSlice(UINT slice)
+{
+	SliceWork& work = mSliceWork[slice];
+	work.Indices.clear();
+	work.Counts.assign(mTilesX*mTilesY, 0);
+
+	UINT sliceCount = OverlapBox(mViewLights, mViewLightCount, mSliceBounds[slice], work.Found);
+	if(sliceCount == 0)
+		return;
+
+	Gather(mViewLights, work.Found, sliceCount, work.SliceLights);
+
+	for(UINT tileY = 0; tileY < mTilesY; ++tileY)
+	{
+		UINT rowCount = OverlapBox(work.SliceLights, sliceCount, mRowBounds[slice*mTilesY + tileY], work.Found);
+		if(rowCount == 0)
+			continue;
+
+		Gather(work.SliceLights, work.Found, rowCount, work.RowLights);
+
+		for(UINT tileX = 0; tileX < mTilesX; ++tileX)
+		{
+			UINT cluster = ClusterIndex(tileX, tileY, slice);
+			UINT count = OverlapBox(work.RowLights, rowCount, mClusterBounds[cluster], work.Found);
+
+			for(UINT i = 0; i < count; ++i)
+				work.Indices.push_back(work.RowLights.Index[work.Found[i]]);
+
+			work.Counts[tileY*mTilesX + tileX] = count;
+		}
+	}
+}
+
+UINT ClusteredLights::TilesX()const
+{
+	return mTilesX;
+}
+
+UINT ClusteredLights::TilesY()const
+{
+	return mTilesY;
+}
+
+UINT ClusteredLights::SliceCount()const
+{
+	return mSlices;
+}
+
+UINT ClusteredLights::ClusterCount()const
+{
+	return mTilesX*mTilesY*mSlices;
+}
+
+UINT ClusteredLights::ClusterIndex(UINT tileX, UINT tileY, UINT slice)const
+{
+	return (slice*mTilesY + tileY)*mTilesX + tileX;
+}
+
+float ClusteredLights::SliceScale()const
+{
+	return mSlices / logf(mFarZ / mNearZ);
+}
+
+float ClusteredLights::SliceBias()const
+{
+	return -logf(mNearZ)*SliceScale();
+}
+
+BoundingBox ClusteredLights::GetClusterBounds(UINT cluster)const
+{
+	return mClusterBounds[cluster];
+}
+
+BoundingSphere ClusteredLights::GetLightBounds(UINT index)const
+{
+	return BoundingSphere(XMFLOAT3(mLights.X[index], mLights.Y[index], mLights.Z[index]), mLights.Radius[index]);
+}
+
+const std::vector<ClusterRange>& ClusteredLights::GetRanges()const
+{
+	return mRanges;
+}
+
+const std::vector<UINT>& ClusteredLights::GetLightIndices()const
+{
+	return mLightIndices;
+}
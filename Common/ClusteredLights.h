@@ -0,0 +1,160 @@
+//***************************************************************************************
+// ClusteredLights.h
+//
+// Clustered light assignment on the CPU, so a pixel shader only loops over the lights
+// that can reach its cluster instead of a fixed Lights[MaxLights] array.
+//   -The view frustum is cut into a grid of clusters: screen tiles across, and slices
+//    in depth whose thickness grows with distance, so clusters stay roughly cubic.
+//    Each cluster's view space AABB is computed once per lens.
+//   -Point lights are spheres of radius FalloffEnd.  A spot light's cone is cut off
+//    where its SpotPower falloff drops below SpotCutoff and is bounded by the
+//    smallest sphere around that cone.
+//   -Slices are binned in parallel on the PPL worker threads.  Each slice keeps the
+//    lights overlapping its AABB, then each row of tiles the lights overlapping the
+//    row, then each cluster its own, testing 8 spheres per iteration with AVX (4
+//    with SSE when the CPU has no AVX).
+//   -The result is ready to copy into two structured buffers: a ClusterRange per
+//    cluster, and the light indices of all the clusters back to back.  The lights
+//    keep the Light layout the shaders already use.
+//***************************************************************************************
+
+#ifndef CLUSTEREDLIGHTS_H
+#define CLUSTEREDLIGHTS_H
+
+#include "Culling.h"
+
+// Where a cluster's light indices are, as a uint2 in HLSL.
+struct ClusterRange
+{
+	UINT Offset = 0;
+	UINT Count = 0;
+};
+
+struct ClusterStats
+{
+	UINT Lights = 0;
+
+	// Lights whose bounds overlap the box around the view frustum.
+	UINT LightsInView = 0;
+
+	UINT NonEmptyClusters = 0;
+	UINT IndexCount = 0;
+	UINT MaxLightsPerCluster = 0;
+};
+
+class ClusteredLights
+{
+public:
+	ClusteredLights() = default;
+	ClusteredLights(const ClusteredLights& rhs) = delete;
+	ClusteredLights& operator=(const ClusteredLights& rhs) = delete;
+	~ClusteredLights() = default;
+
+	// Spot lights are cut off where pow(cos, SpotPower) falls below this.
+	float SpotCutoff = 1.0f / 256.0f;
+
+	// Bins the slices on the PPL worker threads rather than the calling one.
+	bool Parallel = true;
+
+	// Sets the number of tiles across and down the screen and of depth slices.
+	void SetGrid(UINT tilesX, UINT tilesY, UINT slices);
+
+	// Sets the camera lens the clusters are cut from.
+	void SetLens(float fovY, float aspect, float nearZ, float farZ);
+
+	// Bins pointCount point lights followed by spotCount spot lights, as in
+	// the pass constants, seen through a camera with the given view matrix.
+	// The light indices written are positions in that array.
+	void XM_CALLCONV Build(const Light* lights, UINT pointCount, UINT spotCount,
+		DirectX::FXMMATRIX view, ClusterStats* stats = nullptr);
+
+	UINT TilesX()const;
+	UINT TilesY()const;
+	UINT SliceCount()const;
+	UINT ClusterCount()const;
+
+	// Clusters are stored slice by slice, each row by row, top row first.
+	UINT ClusterIndex(UINT tileX, UINT tileY, UINT slice)const;
+
+	// A shader finds the slice of view space depth z as
+	// floor(log(z)*SliceScale() + SliceBias()).
+	float SliceScale()const;
+	float SliceBias()const;
+
+	// View space bounds of a cluster.
+	DirectX::BoundingBox GetClusterBounds(UINT cluster)const;
+
+	// Bounding sphere in view space of the light Build saw at index.
+	DirectX::BoundingSphere GetLightBounds(UINT index)const;
+
+	const std::vector<ClusterRange>& GetRanges()const;
+	const std::vector<UINT>& GetLightIndices()const;
+
+private:
+	// Spheres tested per iteration; the light arrays are padded to a multiple
+	// of this with spheres that overlap nothing.
+	static const UINT Lanes = 8;
+
+	// Spheres in structure-of-arrays form, with the index of each.
+	struct SphereSet
+	{
+		std::vector<float> X;
+		std::vector<float> Y;
+		std::vector<float> Z;
+		std::vector<float> Radius;
+		std::vector<UINT> Index;
+
+		void Resize(UINT count);
+	};
+
+	// Scratch space of the task binning one slice.
+	struct SliceWork
+	{
+		SphereSet SliceLights;
+		SphereSet RowLights;
+		std::vector<UINT> Found;
+		std::vector<UINT> Indices;
+		std::vector<UINT> Counts;
+	};
+
+	void BuildClusterBounds();
+	void BinSlice(UINT slice);
+
+	// Appends to found the index of every sphere in [0, count) of spheres
+	// that overlaps the box, and returns how many there are.
+	static UINT OverlapBox(const SphereSet& spheres, UINT count, const DirectX::BoundingBox& box,
+		std::vector<UINT>& found);
+
+	// Copies the spheres listed in found to dst, padded for OverlapBox.
+	static void Gather(const SphereSet& src, const std::vector<UINT>& found, UINT count, SphereSet& dst);
+
+private:
+	UINT mTilesX = 16;
+	UINT mTilesY = 9;
+	UINT mSlices = 24;
+
+	float mFovY = 0.25f*MathHelper::Pi;
+	float mAspect = 16.0f / 9.0f;
+	float mNearZ = 1.0f;
+	float mFarZ = 1000.0f;
+
+	bool mBoundsDirty = true;
+	std::vector<DirectX::BoundingBox> mClusterBounds;
+	std::vector<DirectX::BoundingBox> mRowBounds;
+	std::vector<DirectX::BoundingBox> mSliceBounds;
+	DirectX::BoundingBox mFrustumBounds;
+
+	// Every light, and the ones that overlap the whole frustum's AABB.
+	SphereSet mLights;
+	SphereSet mViewLights;
+	UINT mLightCount = 0;
+	UINT mViewLightCount = 0;
+	std::vector<UINT> mFound;
+
+	std::vector<SliceWork> mSliceWork;
+
+	std::vector<ClusterRange> mRanges;
+	std::vector<UINT> mLightIndices;
+};
+
+#endif // CLUSTEREDLIGHTS_H
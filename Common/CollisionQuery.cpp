@@ -0,0 +1,415 @@
+//***************************************************************************************
+// CollisionQuery.cpp
+//***************************************************************************************
+
+#include "CollisionQuery.h"
+
+using namespace DirectX;
+
+namespace
+{
+	float XM_CALLCONV Dot(FXMVECTOR a, FXMVECTOR b)
+	{
+		return XMVectorGetX(XMVector3Dot(a, b));
+	}
+
+	// Smaller root of a*t^2 + b*t + c = 0 when it lies in [0, maxT).
+	bool LowestRoot(float a, float b, float c, float maxT, float& root)
+	{
+		if(fabsf(a) < 1e-12f)
+			return false;
+
+		float discriminant = b*b - 4.0f*a*c;
+		if(discriminant < 0.0f)
+			return false;
+
+		float sqrtD = sqrtf(discriminant);
+		float r1 = (-b - sqrtD) / (2.0f*a);
+		float r2 = (-b + sqrtD) / (2.0f*a);
+		if(r1 > r2)
+			std::swap(r1, r2);
+
+		if(r1 < 0.0f || r1 >= maxT)
+			return false;
+
+		root = r1;
+		return true;
+	}
+
+	// p must lie in the plane of the triangle.
+	bool XM_CALLCONV PointInTriangle(FXMVECTOR p, FXMVECTOR a, FXMVECTOR b, GXMVECTOR c)
+	{
+		XMVECTOR v0 = c - a;
+		XMVECTOR v1 = b - a;
+		XMVECTOR v2 = p - a;
+
+		float dot00 = Dot(v0, v0);
+		float dot01 = Dot(v0, v1);
+		float dot02 = Dot(v0, v2);
+		float dot11 = Dot(v1, v1);
+		float dot12 = Dot(v1, v2);
+
+		float denom = dot00*dot11 - dot01*dot01;
+		if(denom == 0.0f)
+			return false;
+
+		float u = (dot11*dot02 - dot01*dot12) / denom;
+		float v = (dot00*dot12 - dot01*dot02) / denom;
+
+		return u >= 0.0f && v >= 0.0f && u + v <= 1.0f;
+	}
+
+	// Point of the triangle closest to p, by the Voronoi regions of its
+	// vertices, edges and face.
+	XMVECTOR XM_CALLCONV ClosestPointOnTriangle(FXMVECTOR p, FXMVECTOR a, FXMVECTOR b, GXMVECTOR c)
+	{
+		XMVECTOR ab = b - a;
+		XMVECTOR ac = c - a;
+
+		XMVECTOR ap = p - a;
+		float d1 = Dot(ab, ap);
+		float d2 = Dot(ac, ap);
+		if(d1 <= 0.0f && d2 <= 0.0f)
+			return a;
+
+		XMVECTOR bp = p - b;
+		float d3 = Dot(ab, bp);
+		float d4 = Dot(ac, bp);
+		if(d3 >= 0.0f && d4 <= d3)
+			return b;
+
+		float vc = d1*d4 - d3*d2;
+		if(vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+			return a + (d1 / (d1 - d3))*ab;
+
+		XMVECTOR cp = p - c;
+		float d5 = Dot(ab, cp);
+		float d6 = Dot(ac, cp);
+		if(d6 >= 0.0f && d5 <= d6)
+			return c;
+
+		float vb = d5*d2 - d1*d6;
+		if(vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+			return a + (d2 / (d2 - d6))*ac;
+
+		float va = d3*d6 - d5*d4;
+		if(va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+			return b + ((d4 - d3) / ((d4 - d3) + (d5 - d6)))*(c - b);
+
+		float denom = 1.0f / (va + vb + vc);
+		return a + (vb*denom)*ab + (vc*denom)*ac;
+	}
+
+	// Squared distance between the segments [p1, q1] and [p2, q2].
+	float XM_CALLCONV SegmentDistanceSq(FXMVECTOR p1, FXMVECTOR q1, FXMVECTOR p2, GXMVECTOR q2)
+	{
+		const float epsilon = 1e-12f;
+
+		XMVECTOR d1 = q1 - p1;
+		XMVECTOR d2 = q2 - p2;
+		XMVECTOR r = p1 - p2;
+		float a = Dot(d1, d1);
+		float e = Dot(d2, d2);
+		float f = Dot(d2, r);
+
+		float s = 0.0f;
+		float t = 0.0f;
+		if(a <= epsilon && e <= epsilon)
+		{
+			// Both segments are points.
+		}
+		else if(a <= epsilon)
+		{
+			t = MathHelper::Clamp(f / e, 0.0f, 1.0f);
+		}
+		else
+		{
+			float c = Dot(d1, r);
+			if(e <= epsilon)
+			{
+				s = MathHelper::Clamp(-c / a, 0.0f, 1.0f);
+			}
+			else
+			{
+				float b = Dot(d1, d2);
+				float denom = a*e - b*b;
+
+				// Parallel segments: any s will do, so start from p1.
+				s = denom != 0.0f ? MathHelper::Clamp((b*f - c*e) / denom, 0.0f, 1.0f) : 0.0f;
+				t = (b*s + f) / e;
+
+				if(t < 0.0f)
+				{
+					t = 0.0f;
+					s = MathHelper::Clamp(-c / a, 0.0f, 1.0f);
+				}
+				else if(t > 1.0f)
+				{
+					t = 1.0f;
+					s = MathHelper::Clamp((b - c) / a, 0.0f, 1.0f);
+				}
+			}
+		}
+
+		XMVECTOR delta = (p1 + s*d1) - (p2 + t*d2);
+		return Dot(delta, delta);
+	}
+
+	// Sweeps a sphere against one triangle.  When it touches the triangle
+	// before tBest, sets tBest and the contact point and returns true.
+	bool XM_CALLCONV SweepTriangle(FXMVECTOR center, float radius, FXMVECTOR motion,
+		FXMVECTOR a, GXMVECTOR b, HXMVECTOR c, float& tBest, XMVECTOR& contact)
+	{
+		XMVECTOR ab = b - a;
+		XMVECTOR ac = c - a;
+		XMVECTOR n = XMVector3Cross(ab, ac);
+		float length = XMVectorGetX(XMVector3Length(n));
+
+		// The plane of a sliver is too noisy to test against; its edges and
+		// vertices still are.
+		if(length > 1e-4f*(Dot(ab, ab) + Dot(ac, ac)))
+		{
+			n = n / length;
+
+			// Work on the side of the plane the sphere's center is on.
+			float dist = Dot(n, center - a);
+			float speed = Dot(n, motion);
+			if(dist < 0.0f)
+			{
+				n = -n;
+				dist = -dist;
+				speed = -speed;
+			}
+
+			// Clear of the plane and not closing in, so nothing in it blocks.
+			if(dist > radius && speed >= 0.0f)
+				return false;
+
+			// Already reaching into the plane but moving along it or away, the
+			// face does not block; an edge or vertex ahead of the sphere still can.
+			if(speed < 0.0f)
+			{
+				// The sphere touches the plane at t0; every contact with the
+				// triangle comes at t0 or later.
+				float t0 = dist <= radius ? 0.0f : (dist - radius) / -speed;
+				if(t0 >= tBest)
+					return false;
+
+				XMVECTOR planePoint = center + t0*motion - MathHelper::Min(dist, radius)*n;
+				if(PointInTriangle(planePoint, a, b, c))
+				{
+					tBest = t0;
+					contact = planePoint;
+					return true;
+				}
+			}
+		}
+
+		// Otherwise the sphere can only touch an edge or a vertex.
+		bool found = false;
+		float speedSq = Dot(motion, motion);
+		float radiusSq = radius*radius;
+
+		XMVECTOR vertices[3] = { a, b, c };
+		for(UINT i = 0; i < 3; ++i)
+		{
+			XMVECTOR p = vertices[i];
+			XMVECTOR toCenter = center - p;
+
+			float qb = 2.0f*Dot(motion, toCenter);
+			float qc = Dot(toCenter, toCenter) - radiusSq;
+
+			float t = 0.0f;
+			bool touches = qc <= 0.0f ? qb < 0.0f : LowestRoot(speedSq, qb, qc, tBest, t);
+			if(touches && t < tBest)
+			{
+				tBest = t;
+				contact = p;
+				found = true;
+			}
+		}
+
+		for(UINT i = 0; i < 3; ++i)
+		{
+			XMVECTOR pa = vertices[i];
+			XMVECTOR edge = vertices[(i + 1) % 3] - pa;
+			XMVECTOR base = pa - center;
+
+			// Edges far shorter than the radius are covered by their vertices,
+			// and would only add round-off here.
+			float edgeLength = XMVectorGetX(XMVector3Length(edge));
+			if(edgeLength < 1e-4f*radius)
+				continue;
+			XMVECTOR dir = edge / edgeLength;
+
+			float dirDotMotion = Dot(dir, motion);
+			float dirDotBase = Dot(dir, base);
+
+			// radius^2 - squared distance to the edge's line at t.
+			float qa = dirDotMotion*dirDotMotion - speedSq;
+			float qb = 2.0f*Dot(motion, base) - 2.0f*dirDotMotion*dirDotBase;
+			float qc = radiusSq - Dot(base, base) + dirDotBase*dirDotBase;
+
+			float t = 0.0f;
+			bool touches = qc >= 0.0f ? qb > 0.0f : LowestRoot(qa, qb, qc, tBest, t);
+			if(!touches || t >= tBest)
+				continue;
+
+			// The line is touched; keep it only within the segment.
+			float f = dirDotMotion*t - dirDotBase;
+			if(f >= 0.0f && f <= edgeLength)
+			{
+				tBest = t;
+				contact = pa + f*dir;
+				found = true;
+			}
+		}
+
+		return found;
+	}
+
+	bool XM_CALLCONV CapsuleTouchesTriangle(FXMVECTOR p0, FXMVECTOR p1, float radius,
+		FXMVECTOR a, GXMVECTOR b, HXMVECTOR c)
+	{
+		// The segment passes through the triangle.  Slivers are left to the
+		// edge tests, as in SweepTriangle.
+		XMVECTOR ab = b - a;
+		XMVECTOR ac = c - a;
+		XMVECTOR n = XMVector3Cross(ab, ac);
+		float d0 = Dot(n, p0 - a);
+		float d1 = Dot(n, p1 - a);
+		if(d0*d1 <= 0.0f && d0 != d1 &&
+			XMVectorGetX(XMVector3Length(n)) > 1e-4f*(Dot(ab, ab) + Dot(ac, ac)))
+		{
+			XMVECTOR crossing = p0 + (d0 / (d0 - d1))*(p1 - p0);
+			if(PointInTriangle(crossing, a, b, c))
+				return true;
+		}
+
+		// Otherwise the closest points are a segment end and the triangle, or
+		// the segment and an edge.
+		float radiusSq = radius*radius;
+
+		XMVECTOR q0 = p0 - ClosestPointOnTriangle(p0, a, b, c);
+		XMVECTOR q1 = p1 - ClosestPointOnTriangle(p1, a, b, c);
+
+		return Dot(q0, q0) <= radiusSq || Dot(q1, q1) <= radiusSq ||
+			SegmentDistanceSq(p0, p1, a, b) <= radiusSq ||
+			SegmentDistanceSq(p0, p1, b, c) <= radiusSq ||
+			SegmentDistanceSq(p0, p1, c, a) <= radiusSq;
+	}
+}
+
+void CollisionQuery::SetScene(const SceneBvh* scene)
+{
+	mScene = scene;
+}
+
+bool XM_CALLCONV CollisionQuery::RayCast(FXMVECTOR origin, FXMVECTOR dir, SceneHit& hit, float maxT)const
+{
+	hit = SceneHit();
+	return mScene != nullptr && mScene->Intersect(origin, dir, hit, maxT);
+}
+
+bool XM_CALLCONV CollisionQuery::SweepSphere(FXMVECTOR center, float radius, FXMVECTOR motion,
+	SweepHit& hit, CollisionStats* stats)
+{
+	hit = SweepHit();
+
+	XMVECTOR end = center + motion;
+	XMVECTOR r = XMVectorReplicate(radius);
+
+	XMFLOAT3 boxMin, boxMax;
+	XMStoreFloat3(&boxMin, XMVectorMin(center, end) - r);
+	XMStoreFloat3(&boxMax, XMVectorMax(center, end) + r);
+
+	UINT triangleCount = GatherTriangles(boxMin, boxMax, stats);
+
+	float tBest = 1.0f;
+	XMVECTOR contact = XMVectorZero();
+	for(UINT i = 0; i < triangleCount; ++i)
+	{
+		if(SweepTriangle(center, radius, motion, XMLoadFloat3(&mVertices[3*i + 0]),
+			XMLoadFloat3(&mVertices[3*i + 1]), XMLoadFloat3(&mVertices[3*i + 2]), tBest, contact))
+		{
+			hit.Instance = mTriangleInstances[i];
+		}
+	}
+
+	if(hit.Instance == (UINT)-1)
+		return false;
+
+	hit.T = tBest;
+	XMStoreFloat3(&hit.Point, contact);
+
+	XMVECTOR normal = center + tBest*motion - contact;
+	if(XMVectorGetX(XMVector3LengthSq(normal)) > 1e-12f)
+		XMStoreFloat3(&hit.Normal, XMVector3Normalize(normal));
+	else
+		XMStoreFloat3(&hit.Normal, XMVector3Normalize(-motion));
+
+	return true;
+}
+
+bool XM_CALLCONV CollisionQuery::OverlapCapsule(FXMVECTOR p0, FXMVECTOR p1, float radius, CollisionStats* stats)
+{
+	XMVECTOR r = XMVectorReplicate(radius);
+
+	XMFLOAT3 boxMin, boxMax;
+	XMStoreFloat3(&boxMin, XMVectorMin(p0, p1) - r);
+	XMStoreFloat3(&boxMax, XMVectorMax(p0, p1) + r);
+
+	UINT triangleCount = GatherTriangles(boxMin, boxMax, stats);
+
+	for(UINT i = 0; i < triangleCount; ++i)
+	{
+		if(CapsuleTouchesTriangle(p0, p1, radius, XMLoadFloat3(&mVertices[3*i + 0]),
+			XMLoadFloat3(&mVertices[3*i + 1]), XMLoadFloat3(&mVertices[3*i + 2])))
+			return true;
+	}
+
+	return false;
+}
+
+UINT CollisionQuery::GatherTriangles(const XMFLOAT3& boxMin, const XMFLOAT3& boxMax, CollisionStats* stats)
+{
+	mInstances.clear();
+	mVertices.clear();
+	mTriangleInstances.clear();
+
+	if(mScene == nullptr)
+		return 0;
+
+	mScene->OverlapBox(boxMin, boxMax, mInstances);
+
+	BoundingBox worldBox;
+	BoundingBox::CreateFromPoints(worldBox, XMLoadFloat3(&boxMin), XMLoadFloat3(&boxMax));
+
+	for(UINT instance : mInstances)
+	{
+		// The world box in local space, grown to stay axis aligned.
+		BoundingBox localBox;
+		worldBox.Transform(localBox, mScene->GetInvWorld(instance));
+
+		XMFLOAT3 localMin, localMax;
+		XMStoreFloat3(&localMin, XMLoadFloat3(&localBox.Center) - XMLoadFloat3(&localBox.Extents));
+		XMStoreFloat3(&localMax, XMLoadFloat3(&localBox.Center) + XMLoadFloat3(&localBox.Extents));
+
+		size_t first = mVertices.size();
+		UINT count = mScene->GetMesh(instance)->OverlapBox(localMin, localMax, mVertices);
+
+		XMMATRIX world = mScene->GetWorld(instance);
+		for(size_t i = first; i < mVertices.size(); ++i)
+			XMStoreFloat3(&mVertices[i], XMVector3TransformCoord(XMLoadFloat3(&mVertices[i]), world));
+
+		mTriangleInstances.insert(mTriangleInstances.end(), count, instance);
+	}
+
+	if(stats != nullptr)
+	{
+		stats->Instances = (UINT)mInstances.size();
+		stats->Triangles = (UINT)mTriangleInstances.size();
+	}
+
+	return (UINT)mTriangleInstances.size();
+}
@@ -0,0 +1,82 @@
+//***************************************************************************************
+// CollisionQuery.h
+//
+// Sphere sweeps, capsule overlaps and ray casts against the triangles of the mesh
+// instances in a SceneBvh, e.g. for keeping a camera out of walls.
+//   -The top level of the SceneBvh finds the instances whose world box overlaps the
+//    volume a query covers.  The world box is taken to each instance's local space
+//    to gather nearby triangles from its TriangleBvh, and those are tested in world
+//    space, so instances may be scaled non-uniformly.
+//   -SweepSphere moves a sphere along a motion vector and reports the first contact:
+//    against the triangle's face, then its edges, then its vertices.  Triangles are
+//    solid from both sides.  A face the sphere already reaches into while moving
+//    along or away from it does not block, but its edges and vertices still do.
+//   -OverlapCapsule tests whether any triangle comes within the radius of a segment.
+//***************************************************************************************
+
+#ifndef COLLISIONQUERY_H
+#define COLLISIONQUERY_H
+
+#include "SceneBvh.h"
+
+struct SweepHit
+{
+	// Instance index in the scene, -1 when nothing was hit.
+	UINT Instance = -1;
+
+	// Fraction of the motion covered before the contact, 1 when nothing was hit.
+	float T = 1.0f;
+
+	// Contact point on the surface, and the unit normal there pointing towards
+	// the sphere's center at the time of contact.
+	DirectX::XMFLOAT3 Point = { 0.0f, 0.0f, 0.0f };
+	DirectX::XMFLOAT3 Normal = { 0.0f, 1.0f, 0.0f };
+};
+
+struct CollisionStats
+{
+	UINT Instances = 0;
+	UINT Triangles = 0;
+};
+
+class CollisionQuery
+{
+public:
+	CollisionQuery() = default;
+	CollisionQuery(const CollisionQuery& rhs) = delete;
+	CollisionQuery& operator=(const CollisionQuery& rhs) = delete;
+	~CollisionQuery() = default;
+
+	// The scene must outlive the queries made on it.
+	void SetScene(const SceneBvh* scene);
+
+	// Closest hit of a world-space ray, as SceneBvh::Intersect.
+	bool XM_CALLCONV RayCast(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR dir, SceneHit& hit,
+		float maxT = FLT_MAX)const;
+
+	// First contact of a sphere moving from center to center + motion.
+	bool XM_CALLCONV SweepSphere(DirectX::FXMVECTOR center, float radius, DirectX::FXMVECTOR motion,
+		SweepHit& hit, CollisionStats* stats = nullptr);
+
+	// True when a triangle comes within radius of the segment [p0, p1].  A
+	// sphere is a capsule with p0 = p1.
+	bool XM_CALLCONV OverlapCapsule(DirectX::FXMVECTOR p0, DirectX::FXMVECTOR p1, float radius,
+		CollisionStats* stats = nullptr);
+
+private:
+	// Fills mVertices with the world-space triangles, three vertices each, of
+	// every instance near the world box, and mTriangleInstances with their
+	// instances.  Returns the number of triangles.
+	UINT GatherTriangles(const DirectX::XMFLOAT3& boxMin, const DirectX::XMFLOAT3& boxMax,
+		CollisionStats* stats);
+
+private:
+	const SceneBvh* mScene = nullptr;
+
+	// Scratch space kept between queries so they do not allocate.
+	std::vector<UINT> mInstances;
+	std::vector<DirectX::XMFLOAT3> mVertices;
+	std::vector<UINT> mTriangleInstances;
+};
+
+#endif // COLLISIONQUERY_H
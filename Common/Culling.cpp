@@ -0,0 +1,610 @@
+//***************************************************************************************
+// Culling.cpp
+//***************************************************************************************
+
+#include "Culling.h"
+#include <intrin.h>
+
+using namespace DirectX;
+
+namespace
+{
+	// Padding boxes have a hugely negative extent, so every plane sees them
+	// as outside and they never show up in the visible list.
+	const float PaddingExtent = -1.0e30f;
+
+	// The frustum planes split into components, plus |n| for the box
+	// projection, so the loops only broadcast.
+	struct PlaneSet
+	{
+		float Nx[FrustumPlanes::Count];
+		float Ny[FrustumPlanes::Count];
+		float Nz[FrustumPlanes::Count];
+		float D[FrustumPlanes::Count];
+		float Ax[FrustumPlanes::Count];
+		float Ay[FrustumPlanes::Count];
+		float Az[FrustumPlanes::Count];
+	};
+
+	PlaneSet MakePlaneSet(const FrustumPlanes& frustum)
+	{
+		PlaneSet set;
+		for(UINT p = 0; p < FrustumPlanes::Count; ++p)
+		{
+			const XMFLOAT4& plane = frustum.Planes[p];
+			set.Nx[p] = plane.x;
+			set.Ny[p] = plane.y;
+			set.Nz[p] = plane.z;
+			set.D[p] = plane.w;
+			set.Ax[p] = fabsf(plane.x);
+			set.Ay[p] = fabsf(plane.y);
+			set.Az[p] = fabsf(plane.z);
+		}
+
+		return set;
+	}
+
+	// CoherentCuller starts over once its accumulators reach these, so the
+	// floats stay precise enough for the drift bound to remain conservative.
+	const float MaxTurn = 2.0f;
+	const float MaxDistance = 256.0f;
+
+	UINT RoundUp(UINT x, UINT multiple)
+	{
+		return (x + multiple - 1) / multiple * multiple;
+	}
+
+	// Appends base + lane for every set bit of visible without branching:
+	// every lane is written, but count only moves past the visible ones.
+	UINT Compact(int visible, UINT base, UINT lanes, UINT* visibleIndices, UINT count)
+	{
+		for(UINT lane = 0; lane < lanes; ++lane)
+		{
+			visibleIndices[count] = base + lane;
+			count += (visible >> lane) & 1;
+		}
+
+		return count;
+	}
+
+	// Bits of the lanes in [base, last).
+	int LaneMask(UINT base, UINT last, UINT lanes)
+	{
+		UINT valid = MathHelper::Min(last - base, lanes);
+		return (int)((1u << valid) - 1);
+	}
+
+	UINT CullSse(const CullingBounds& bounds, const PlaneSet& planes,
+		UINT first, UINT last, UINT* visibleIndices)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		UINT count = 0;
+
+		for(UINT base = first; base < last; base += 4)
+		{
+			__m128 cx = _mm_loadu_ps(bounds.CenterX() + base);
+			__m128 cy = _mm_loadu_ps(bounds.CenterY() + base);
+			__m128 cz = _mm_loadu_ps(bounds.CenterZ() + base);
+			__m128 ex = _mm_loadu_ps(bounds.ExtentX() + base);
+			__m128 ey = _mm_loadu_ps(bounds.ExtentY() + base);
+			__m128 ez = _mm_loadu_ps(bounds.ExtentZ() + base);
+
+			__m128 outside = zero;
+			for(UINT p = 0; p < FrustumPlanes::Count; ++p)
+			{
+				// Signed distance of the center, and the box's extent along n.
+				__m128 d = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.Nx[p]), cx), _mm_mul_ps(_mm_set1_ps(planes.Ny[p]), cy)),
+					_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.Nz[p]), cz), _mm_set1_ps(planes.D[p])));
+				__m128 r = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.Ax[p]), ex), _mm_mul_ps(_mm_set1_ps(planes.Ay[p]), ey)),
+					_mm_mul_ps(_mm_set1_ps(planes.Az[p]), ez));
+
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(d, r), zero));
+
+				if(_mm_movemask_ps(outside) == 0xF)
+					break;
+			}
+
+			int visible = ~_mm_movemask_ps(outside) & LaneMask(base, last, 4);
+			count = Compact(visible, base, 4, visibleIndices, count);
+		}
+
+		return count;
+	}
+
+	UINT CullAvx(const CullingBounds& bounds, const PlaneSet& planes,
+		UINT first, UINT last, UINT* visibleIndices)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		UINT count = 0;
+
+		for(UINT base = first; base < last; base += 8)
+		{
+			__m256 cx = _mm256_loadu_ps(bounds.CenterX() + base);
+			__m256 cy = _mm256_loadu_ps(bounds.CenterY() + base);
+			__m256 cz = _mm256_loadu_ps(bounds.CenterZ() + base);
+			__m256 ex = _mm256_loadu_ps(bounds.ExtentX() + base);
+			__m256 ey = _mm256_loadu_ps(bounds.ExtentY() + base);
+			__m256 ez = _mm256_loadu_ps(bounds.ExtentZ() + base);
+
+			__m256 outside = zero;
+			for(UINT p = 0; p < FrustumPlanes::Count; ++p)
+			{
+				__m256 d = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.Nx[p]), cx), _mm256_mul_ps(_mm256_set1_ps(planes.Ny[p]), cy)),
+					_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.Nz[p]), cz), _mm256_set1_ps(planes.D[p])));
+				__m256 r = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.Ax[p]), ex), _mm256_mul_ps(_mm256_set1_ps(planes.Ay[p]), ey)),
+					_mm256_mul_ps(_mm256_set1_ps(planes.Az[p]), ez));
+
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(d, r), zero, _CMP_LT_OQ));
+
+				if(_mm256_movemask_ps(outside) == 0xFF)
+					break;
+			}
+
+			int visible = ~_mm256_movemask_ps(outside) & LaneMask(base, last, 8);
+			count = Compact(visible, base, 8, visibleIndices, count);
+		}
+
+		return count;
+	}
+
+	// Adds bit view to the masks of the visible lanes.
+	void ScatterViewBit(int visible, UINT view, UINT base, UINT lanes, UINT* visibleMasks)
+	{
+		for(UINT lane = 0; lane < lanes; ++lane)
+			visibleMasks[base + lane] |= (UINT)((visible >> lane) & 1) << view;
+	}
+
+	void CullViewsSse(const CullingBounds& bounds, const PlaneSet* views, UINT viewCount, UINT* visibleMasks)
+	{
+		const __m128 zero = _mm_setzero_ps();
+
+		for(UINT base = 0; base < bounds.PaddedSize(); base += 4)
+		{
+			__m128 cx = _mm_loadu_ps(bounds.CenterX() + base);
+			__m128 cy = _mm_loadu_ps(bounds.CenterY() + base);
+			__m128 cz = _mm_loadu_ps(bounds.CenterZ() + base);
+			__m128 ex = _mm_loadu_ps(bounds.ExtentX() + base);
+			__m128 ey = _mm_loadu_ps(bounds.ExtentY() + base);
+			__m128 ez = _mm_loadu_ps(bounds.ExtentZ() + base);
+
+			for(UINT lane = 0; lane < 4; ++lane)
+				visibleMasks[base + lane] = 0;
+
+			for(UINT v = 0; v < viewCount; ++v)
+			{
+				const PlaneSet& planes = views[v];
+
+				__m128 outside = zero;
+				for(UINT p = 0; p < FrustumPlanes::Count; ++p)
+				{
+					__m128 d = _mm_add_ps(
+						_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.Nx[p]), cx), _mm_mul_ps(_mm_set1_ps(planes.Ny[p]), cy)),
+						_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.Nz[p]), cz), _mm_set1_ps(planes.D[p])));
+					__m128 r = _mm_add_ps(
+						_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.Ax[p]), ex), _mm_mul_ps(_mm_set1_ps(planes.Ay[p]), ey)),
+						_mm_mul_ps(_mm_set1_ps(planes.Az[p]), ez));
+
+					outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(d, r), zero));
+
+					if(_mm_movemask_ps(outside) == 0xF)
+						break;
+				}
+
+				ScatterViewBit(~_mm_movemask_ps(outside) & 0xF, v, base, 4, visibleMasks);
+			}
+		}
+	}
+
+	void CullViewsAvx(const CullingBounds& bounds, const PlaneSet* views, UINT viewCount, UINT* visibleMasks)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+
+		for(UINT base = 0; base < bounds.PaddedSize(); base += 8)
+		{
+			__m256 cx = _mm256_loadu_ps(bounds.CenterX() + base);
+			__m256 cy = _mm256_loadu_ps(bounds.CenterY() + base);
+			__m256 cz = _mm256_loadu_ps(bounds.CenterZ() + base);
+			__m256 ex = _mm256_loadu_ps(bounds.ExtentX() + base);
+			__m256 ey = _mm256_loadu_ps(bounds.ExtentY() + base);
+			__m256 ez = _mm256_loadu_ps(bounds.ExtentZ() + base);
+
+			for(UINT lane = 0; lane < 8; ++lane)
+				visibleMasks[base + lane] = 0;
+
+			for(UINT v = 0; v < viewCount; ++v)
+			{
+				const PlaneSet& planes = views[v];
+
+				__m256 outside = zero;
+				for(UINT p = 0; p < FrustumPlanes::Count; ++p)
+				{
+					__m256 d = _mm256_add_ps(
+						_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.Nx[p]), cx), _mm256_mul_ps(_mm256_set1_ps(planes.Ny[p]), cy)),
+						_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.Nz[p]), cz), _mm256_set1_ps(planes.D[p])));
+					__m256 r = _mm256_add_ps(
+						_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.Ax[p]), ex), _mm256_mul_ps(_mm256_set1_ps(planes.Ay[p]), ey)),
+						_mm256_mul_ps(_mm256_set1_ps(planes.Az[p]), ez));
+
+					outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(d, r), zero, _CMP_LT_OQ));
+
+					if(_mm256_movemask_ps(outside) == 0xFF)
+						break;
+				}
+
+				ScatterViewBit(~_mm256_movemask_ps(outside) & 0xFF, v, base, 8, visibleMasks);
+			}
+		}
+	}
+
+	bool DetectAvx()
+	{
+		int info[4];
+		__cpuid(info, 1);
+
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		if(!osxsave || !avx)
+			return false;
+
+		// The OS must save the upper halves of the ymm registers.
+		return (_xgetbv(0) & 6) == 6;
+	}
+}
+
+FrustumPlanes XM_CALLCONV FrustumPlanes::FromViewProj(FXMMATRIX viewProj)
+{
+	// With row vectors, clip = p*M, so each clip coordinate is p dotted with
+	// a column of M.  Inside means -w <= x <= w, -w <= y <= w, 0 <= z <= w.
+	XMMATRIX T = XMMatrixTranspose(viewProj);
+
+	XMVECTOR planes[Count] =
+	{
+		XMVectorAdd(T.r[3], T.r[0]),
+		XMVectorSubtract(T.r[3], T.r[0]),
+		XMVectorAdd(T.r[3], T.r[1]),
+		XMVectorSubtract(T.r[3], T.r[1]),
+		T.r[2],
+		XMVectorSubtract(T.r[3], T.r[2])
+	};
+
+	FrustumPlanes frustum;
+	for(UINT p = 0; p < Count; ++p)
+	{
+		XMStoreFloat4(&frustum.Planes[p], XMPlaneNormalize(planes[p]));
+	}
+
+	return frustum;
+}
+
+UINT XM_CALLCONV CullingBounds::Add(const BoundingBox& localBounds, FXMMATRIX world)
+{
+	UINT index = mCount++;
+	if(PaddedSize() < RoundUp(mCount, Lanes))
+		Reserve(mCount);
+
+	Set(index, localBounds, world);
+	return index;
+}
+
+UINT CullingBounds::Add(const BoundingBox& worldBounds)
+{
+	return Add(worldBounds, XMMatrixIdentity());
+}
+
+void XM_CALLCONV CullingBounds::Set(UINT index, const BoundingBox& localBounds, FXMMATRIX world)
+{
+	assert(index < mCount);
+
+	// The world AABB of a transformed box: the center is transformed, and
+	// each world axis gathers |row| of the 3x3 part times the extents.
+	XMVECTOR center = XMVector3TransformCoord(XMLoadFloat3(&localBounds.Center), world);
+	XMVECTOR extents = XMLoadFloat3(&localBounds.Extents);
+
+	XMVECTOR worldExtents = XMVectorMultiply(XMVectorAbs(world.r[0]), XMVectorSplatX(extents));
+	worldExtents = XMVectorMultiplyAdd(XMVectorAbs(world.r[1]), XMVectorSplatY(extents), worldExtents);
+	worldExtents = XMVectorMultiplyAdd(XMVectorAbs(world.r[2]), XMVectorSplatZ(extents), worldExtents);
+
+	XMFLOAT3 c, e;
+	XMStoreFloat3(&c, center);
+	XMStoreFloat3(&e, worldExtents);
+
+	mCenterX[index] = c.x;
+	mCenterY[index] = c.y;
+	mCenterZ[index] = c.z;
+	mExtentX[index] = e.x;
+	mExtentY[index] = e.y;
+	mExtentZ[index] = e.z;
+	mRadius[index] = XMVectorGetX(XMVector3Length(worldExtents));
+}
+
+void CullingBounds::Set(UINT index, const BoundingBox& worldBounds)
+{
+	Set(index, worldBounds, XMMatrixIdentity());
+}
+
+void CullingBounds::Clear()
+{
+	mCenterX.clear();
+	mCenterY.clear();
+	mCenterZ.clear();
+	mExtentX.clear();
+	mExtentY.clear();
+	mExtentZ.clear();
+	mRadius.clear();
+
+	mCount = 0;
+}
+
+void CullingBounds::Reserve(UINT count)
+{
+	UINT paddedSize = RoundUp(count, Lanes);
+	if(paddedSize <= PaddedSize())
+		return;
+
+	mCenterX.resize(paddedSize, 0.0f);
+	mCenterY.resize(paddedSize, 0.0f);
+	mCenterZ.resize(paddedSize, 0.0f);
+	mExtentX.resize(paddedSize, PaddingExtent);
+	mExtentY.resize(paddedSize, PaddingExtent);
+	mExtentZ.resize(paddedSize, PaddingExtent);
+	mRadius.resize(paddedSize, 0.0f);
+}
+
+UINT CullingBounds::Size()const
+{
+	return mCount;
+}
+
+UINT CullingBounds::PaddedSize()const
+{
+	return (UINT)mCenterX.size();
+}
+
+BoundingBox CullingBounds::GetBox(UINT index)const
+{
+	return BoundingBox(
+		XMFLOAT3(mCenterX[index], mCenterY[index], mCenterZ[index]),
+		XMFLOAT3(mExtentX[index], mExtentY[index], mExtentZ[index]));
+}
+
+float CullingBounds::GetRadius(UINT index)const
+{
+	return mRadius[index];
+}
+
+UINT Culling::Cull(const CullingBounds& bounds, const FrustumPlanes& frustum, UINT* visibleIndices)
+{
+	return Cull(bounds, frustum, 0, bounds.Size(), visibleIndices);
+}
+
+UINT Culling::Cull(const CullingBounds& bounds, const FrustumPlanes& frustum,
+	UINT first, UINT last, UINT* visibleIndices)
+{
+	assert(first % CullingBounds::Lanes == 0);
+	assert(last <= bounds.Size());
+
+	PlaneSet planes = MakePlaneSet(frustum);
+
+	return HasAvx() ?
+		CullAvx(bounds, planes, first, last, visibleIndices) :
+		CullSse(bounds, planes, first, last, visibleIndices);
+}
+
+void Culling::CullViews(const CullingBounds& bounds, const FrustumPlanes* views, UINT viewCount,
+	UINT* visibleMasks)
+{
+	assert(viewCount <= MaxViews);
+
+	PlaneSet planes[MaxViews];
+	for(UINT v = 0; v < viewCount; ++v)
+		planes[v] = MakePlaneSet(views[v]);
+
+	if(HasAvx())
+		CullViewsAvx(bounds, planes, viewCount, visibleMasks);
+	else
+		CullViewsSse(bounds, planes, viewCount, visibleMasks);
+}
+
+bool Culling::HasAvx()
+{
+	static const bool hasAvx = DetectAvx();
+	return hasAvx;
+}
+
+UINT ParallelCuller::GetChunkSize()const
+{
+	return mChunkSize;
+}
+
+void ParallelCuller::SetChunkSize(UINT chunkSize)
+{
+	mChunkSize = RoundUp(MathHelper::Max(chunkSize, 1u), CullingBounds::Lanes);
+}
+
+const UINT* ParallelCuller::VisibleIndices()const
+{
+	return mVisibleIndices.data();
+}
+
+UINT ParallelCuller::CullChunks(const CullingBounds& bounds, const FrustumPlanes& frustum)
+{
+	UINT boundsCount = bounds.Size();
+	UINT chunkCount = (boundsCount + mChunkSize - 1) / mChunkSize;
+
+	mChunkIndices.resize(chunkCount*mChunkSize);
+	mVisibleIndices.resize(boundsCount);
+	mChunkCounts.resize(chunkCount);
+	mChunkOffsets.resize(chunkCount);
+
+	// Count the survivors of every chunk.
+	concurrency::parallel_for(0u, chunkCount, [&](UINT chunk)
+	{
+		UINT first = chunk*mChunkSize;
+		UINT last = MathHelper::Min(first + mChunkSize, boundsCount);
+
+		mChunkCounts[chunk] = Culling::Cull(bounds, frustum, first, last, &mChunkIndices[first]);
+	});
+
+	// Exclusive prefix sum of the counts gives every chunk its first slot.
+	// There are few chunks, so this stays serial.
+	UINT visibleCount = 0;
+	for(UINT chunk = 0; chunk < chunkCount; ++chunk)
+	{
+		mChunkOffsets[chunk] = visibleCount;
+		visibleCount += mChunkCounts[chunk];
+	}
+
+	return visibleCount;
+}
+
+UINT XM_CALLCONV CoherentCuller::Cull(const CullingBounds& bounds, const FrustumPlanes& frustum,
+	FXMVECTOR eyePosW, UINT* visibleIndices, CoherentCullStats* stats)
+{
+	UINT boundsCount = bounds.Size();
+	mEntries.resize(boundsCount);
+
+	XMFLOAT3 eye;
+	XMStoreFloat3(&eye, eyePosW);
+	AccumulateMotion(frustum, eye);
+
+	PlaneSet planes = MakePlaneSet(frustum);
+	CoherentCullStats localStats;
+	localStats.Objects = boundsCount;
+
+	UINT count = 0;
+	for(UINT i = 0; i < boundsCount; ++i)
+	{
+		Entry& entry = mEntries[i];
+
+		// For a point c, n.c + d = n.(c - eye) + (n.eye + d), so between two
+		// frames the signed distance changes by at most |dn|*|c - eye| plus
+		// the change of n.eye + d plus the eye's own motion; the box's extent
+		// along n changes by at most |dn|*radius.  |c - eye| itself grew by
+		// no more than the path of the eye since the test.
+		if(entry.Plane != Untested)
+		{
+			float path = mPath - entry.Path;
+			float drift = (mTurn - entry.Turn)*(entry.Reach + path) + (mShift - entry.Shift) + path;
+
+			if(drift < entry.Slack)
+			{
+				++localStats.Skipped;
+				if(entry.Plane == Visible)
+					visibleIndices[count++] = i;
+				continue;
+			}
+		}
+
+		float cx = bounds.CenterX()[i];
+		float cy = bounds.CenterY()[i];
+		float cz = bounds.CenterZ()[i];
+		float ex = bounds.ExtentX()[i];
+		float ey = bounds.ExtentY()[i];
+		float ez = bounds.ExtentZ()[i];
+
+		// Start with the plane that rejected the bound last time.
+		UINT firstPlane = entry.Plane < FrustumPlanes::Count ? entry.Plane : 0;
+		UINT rejectingPlane = Visible;
+		float slack = FLT_MAX;
+
+		for(UINT j = 0; j < FrustumPlanes::Count; ++j)
+		{
+			UINT p = (firstPlane + j) % FrustumPlanes::Count;
+			float d = planes.Nx[p]*cx + planes.Ny[p]*cy + planes.Nz[p]*cz + planes.D[p];
+			float r = planes.Ax[p]*ex + planes.Ay[p]*ey + planes.Az[p]*ez;
+			++localStats.PlaneTests;
+
+			if(d + r < 0.0f)
+			{
+				if(j == 0 && entry.Plane == p)
+					++localStats.CachedPlaneHits;
+
+				rejectingPlane = p;
+				slack = -(d + r);
+				break;
+			}
+
+			slack = MathHelper::Min(slack, d + r);
+		}
+
+		float dx = cx - eye.x;
+		float dy = cy - eye.y;
+		float dz = cz - eye.z;
+
+		entry.Plane = rejectingPlane;
+		entry.Slack = slack;
+		entry.Reach = sqrtf(dx*dx + dy*dy + dz*dz) + bounds.GetRadius(i);
+		entry.Turn = mTurn;
+		entry.Shift = mShift;
+		entry.Path = mPath;
+
+		if(rejectingPlane == Visible)
+			visibleIndices[count++] = i;
+	}
+
+	if(stats != nullptr)
+		*stats = localStats;
+
+	return count;
+}
+
+void CoherentCuller::Invalidate(UINT index)
+{
+	if(index < mEntries.size())
+		mEntries[index].Plane = Untested;
+}
+
+void CoherentCuller::InvalidateAll()
+{
+	for(auto& entry : mEntries)
+		entry.Plane = Untested;
+
+	mTurn = 0.0f;
+	mShift = 0.0f;
+	mPath = 0.0f;
+}
+
+void CoherentCuller::AccumulateMotion(const FrustumPlanes& frustum, const XMFLOAT3& eye)
+{
+	XMVECTOR eyePos = XMLoadFloat3(&eye);
+
+	float eyeOffsets[FrustumPlanes::Count];
+	for(UINT p = 0; p < FrustumPlanes::Count; ++p)
+	{
+		XMVECTOR plane = XMLoadFloat4(&frustum.Planes[p]);
+		eyeOffsets[p] = XMVectorGetX(XMPlaneDotCoord(plane, eyePos));
+	}
+
+	if(mHasPrevFrame)
+	{
+		float turn = 0.0f;
+		float shift = 0.0f;
+		for(UINT p = 0; p < FrustumPlanes::Count; ++p)
+		{
+			XMVECTOR normal = XMLoadFloat4(&frustum.Planes[p]);
+			XMVECTOR prevNormal = XMLoadFloat4(&mPrevFrustum.Planes[p]);
+
+			turn = MathHelper::Max(turn, XMVectorGetX(XMVector3Length(XMVectorSubtract(normal, prevNormal))));
+			shift = MathHelper::Max(shift, fabsf(eyeOffsets[p] - mPrevEyeOffsets[p]));
+		}
+
+		XMVECTOR step = XMVectorSubtract(eyePos, XMLoadFloat3(&mPrevEye));
+
+		mTurn += turn;
+		mShift += shift;
+		mPath += XMVectorGetX(XMVector3Length(step));
+
+		if(mTurn > MaxTurn || mShift > MaxDistance || mPath > MaxDistance)
+			InvalidateAll();
+	}
+
+	mHasPrevFrame = true;
+	mPrevFrustum = frustum;
+	mPrevEye = eye;
+	for(UINT p = 0; p < FrustumPlanes::Count; ++p)
+		mPrevEyeOffsets[p] = eyeOffsets[p];
+}
@@ -0,0 +1,255 @@
+//***************************************************************************************
+// Culling.h
+//
+// World-space frustum culling of many instances at once.
+//   -CullingBounds keeps the world-space AABB and bounding sphere radius of every
+//    instance in structure-of-arrays form, so no per-instance matrix has to be
+//    inverted or transformed at cull time.
+//   -FrustumPlanes holds the six world-space planes of a camera, extracted once per
+//    frame from its view-projection matrix.
+//   -Culling::Cull tests 8 boxes per iteration with 256-bit AVX (4 with SSE when the
+//    CPU has no AVX) and writes a compacted list of the visible indices.
+//   -Culling::CullViews tests the bounds against several views at once, e.g. the
+//    main camera, six cube map faces and a light, loading each group of boxes
+//    once, and writes a per-bound bitmask of the views that see it.
+//   -ParallelCuller splits the bounds into chunks culled on the PPL worker threads,
+//    prefix-sums the per-chunk survivor counts and hands every visible instance its
+//    final slot, so each thread can write straight into a mapped instance buffer.
+//   -CoherentCuller remembers, per bound, the plane that rejected it last time and
+//    tests that plane first.  It also bounds how far the planes can have moved past
+//    each bound since it was last tested, and skips the test while that cannot have
+//    changed the outcome.
+//***************************************************************************************
+
+#ifndef CULLING_H
+#define CULLING_H
+
+#include "d3dUtil.h"
+#include <ppl.h>
+
+// The planes of a view frustum in world space as (n, d) with n.p + d >= 0 for
+// points inside.  Normals are unit length and point into the frustum.
+struct FrustumPlanes
+{
+	enum { Left, Right, Bottom, Top, Near, Far, Count };
+
+	DirectX::XMFLOAT4 Planes[Count];
+
+	// Extracts the planes of the clip volume of a world-to-clip matrix, e.g.
+	// view*proj.  The near plane is z = 0, as with XMMatrixPerspectiveFovLH.
+	static FrustumPlanes XM_CALLCONV FromViewProj(DirectX::FXMMATRIX viewProj);
+};
+
+class CullingBounds
+{
+public:
+	// Number of bounds tested per iteration; the arrays are padded to a
+	// multiple of this with boxes that are never visible.
+	static const UINT Lanes = 8;
+
+	CullingBounds() = default;
+
+	// Adds the world-space AABB of localBounds transformed by world and
+	// returns its index.
+	UINT XM_CALLCONV Add(const DirectX::BoundingBox& localBounds, DirectX::FXMMATRIX world);
+	UINT Add(const DirectX::BoundingBox& worldBounds);
+
+	// Replaces the bounds at index, e.g. after the instance moved.
+	void XM_CALLCONV Set(UINT index, const DirectX::BoundingBox& localBounds, DirectX::FXMMATRIX world);
+	void Set(UINT index, const DirectX::BoundingBox& worldBounds);
+
+	void Clear();
+
+	// Makes room for count bounds.
+	void Reserve(UINT count);
+
+	// Number of bounds, and the padded size of the arrays.
+	UINT Size()const;
+	UINT PaddedSize()const;
+
+	DirectX::BoundingBox GetBox(UINT index)const;
+	float GetRadius(UINT index)const;
+
+	const float* CenterX()const { return mCenterX.data(); }
+	const float* CenterY()const { return mCenterY.data(); }
+	const float* CenterZ()const { return mCenterZ.data(); }
+	const float* ExtentX()const { return mExtentX.data(); }
+	const float* ExtentY()const { return mExtentY.data(); }
+	const float* ExtentZ()const { return mExtentZ.data(); }
+	const float* Radius()const { return mRadius.data(); }
+
+private:
+	std::vector<float> mCenterX;
+	std::vector<float> mCenterY;
+	std::vector<float> mCenterZ;
+	std::vector<float> mExtentX;
+	std::vector<float> mExtentY;
+	std::vector<float> mExtentZ;
+	std::vector<float> mRadius;
+
+	UINT mCount = 0;
+};
+
+class Culling
+{
+public:
+	// Writes the indices of the bounds that are inside or intersect the
+	// frustum to visibleIndices, in increasing order, and returns how many
+	// there are.  visibleIndices needs room for bounds.PaddedSize() entries.
+	static UINT Cull(const CullingBounds& bounds, const FrustumPlanes& frustum, UINT* visibleIndices);
+
+	// Same as above for the bounds in [first, last).  first must be a
+	// multiple of CullingBounds::Lanes, and visibleIndices needs room for
+	// last - first rounded up to a multiple of Lanes.
+	static UINT Cull(const CullingBounds& bounds, const FrustumPlanes& frustum,
+		UINT first, UINT last, UINT* visibleIndices);
+
+	// Most views CullViews takes, one bit each.
+	static const UINT MaxViews = 32;
+
+	// Sets bit v of visibleMasks[i] when bound i is inside or intersects
+	// views[v], and clears the other bits.  visibleMasks needs room for
+	// bounds.PaddedSize() entries; the padding gets a mask of 0.
+	static void CullViews(const CullingBounds& bounds, const FrustumPlanes* views, UINT viewCount,
+		UINT* visibleMasks);
+
+	// True when the CPU and OS support AVX.  Checked once.
+	static bool HasAvx();
+};
+
+class ParallelCuller
+{
+public:
+	ParallelCuller() = default;
+	ParallelCuller(const ParallelCuller& rhs) = delete;
+	ParallelCuller& operator=(const ParallelCuller& rhs) = delete;
+	~ParallelCuller() = default;
+
+	// Number of bounds each task culls, rounded up to CullingBounds::Lanes.
+	UINT GetChunkSize()const;
+	void SetChunkSize(UINT chunkSize);
+
+	// Culls the bounds on the worker threads, then calls write(slot, index)
+	// for every visible bound, where slot is its position in the compacted
+	// list.  The slots are the same as Culling::Cull would give, whatever
+	// the number of threads.  write is called concurrently, but never twice
+	// for the same slot.  Returns the number of visible bounds.
+	template<typename WriteVisible>
+	UINT Cull(const CullingBounds& bounds, const FrustumPlanes& frustum, WriteVisible write);
+
+	// The compacted visible indices of the last Cull.
+	const UINT* VisibleIndices()const;
+
+private:
+	UINT CullChunks(const CullingBounds& bounds, const FrustumPlanes& frustum);
+
+private:
+	UINT mChunkSize = 2048;
+
+	// Each chunk's survivors at the chunk's own offset, then compacted.
+	std::vector<UINT> mChunkIndices;
+	std::vector<UINT> mVisibleIndices;
+
+	std::vector<UINT> mChunkCounts;
+	std::vector<UINT> mChunkOffsets;
+};
+
+template<typename WriteVisible>
+UINT ParallelCuller::Cull(const CullingBounds& bounds, const FrustumPlanes& frustum, WriteVisible write)
+{
+	UINT visibleCount = CullChunks(bounds, frustum);
+	UINT chunkCount = (UINT)mChunkCounts.size();
+
+	// Every chunk moves its survivors to their final slots; the slot ranges
+	// of two chunks never overlap, so no locks are needed.
+	concurrency::parallel_for(0u, chunkCount, [&](UINT chunk)
+	{
+		const UINT* chunkIndices = &mChunkIndices[chunk*mChunkSize];
+		UINT offset = mChunkOffsets[chunk];
+
+		for(UINT i = 0; i < mChunkCounts[chunk]; ++i)
+		{
+			UINT index = chunkIndices[i];
+			mVisibleIndices[offset + i] = index;
+			write(offset + i, index);
+		}
+	});
+
+	return visibleCount;
+}
+
+struct CoherentCullStats
+{
+	UINT Objects = 0;
+
+	// Bounds whose last classification provably still held, so no plane was
+	// tested at all.
+	UINT Skipped = 0;
+
+	// Bounds rejected again by the first plane tested, the one that
+	// rejected them last time.
+	UINT CachedPlaneHits = 0;
+
+	UINT PlaneTests = 0;
+};
+
+class CoherentCuller
+{
+public:
+	CoherentCuller() = default;
+	CoherentCuller(const CoherentCuller& rhs) = delete;
+	CoherentCuller& operator=(const CoherentCuller& rhs) = delete;
+	~CoherentCuller() = default;
+
+	// Writes the same visible indices as Culling::Cull, in increasing order,
+	// and returns how many there are.  eyePosW is the camera position the
+	// frustum was built from.  visibleIndices needs room for bounds.Size().
+	UINT XM_CALLCONV Cull(const CullingBounds& bounds, const FrustumPlanes& frustum,
+		DirectX::FXMVECTOR eyePosW, UINT* visibleIndices, CoherentCullStats* stats = nullptr);
+
+	// Forgets what is known about one bound, e.g. after CullingBounds::Set
+	// moved it, or about all of them.
+	void Invalidate(UINT index);
+	void InvalidateAll();
+
+private:
+	static const UINT Visible = FrustumPlanes::Count;
+	static const UINT Untested = FrustumPlanes::Count + 1;
+
+	struct Entry
+	{
+		// The plane that rejected the bound, Visible or Untested.
+		UINT Plane = Untested;
+
+		// How far the bound was outside Plane, or inside the nearest plane
+		// when visible.  The outcome holds while the planes drift less.
+		float Slack = 0.0f;
+
+		// Distance from the eye to the center plus the bounding radius.
+		float Reach = 0.0f;
+
+		// The motion accumulators when the bound was tested.
+		float Turn = 0.0f;
+		float Shift = 0.0f;
+		float Path = 0.0f;
+	};
+
+	void AccumulateMotion(const FrustumPlanes& frustum, const DirectX::XMFLOAT3& eye);
+
+private:
+	std::vector<Entry> mEntries;
+
+	// Summed over the frames since the last reset: the largest change of a
+	// plane normal, the largest change of a plane's offset from the eye, and
+	// the distance the eye travelled.
+	float mTurn = 0.0f;
+	float mShift = 0.0f;
+	float mPath = 0.0f;
+
+	bool mHasPrevFrame = false;
+	FrustumPlanes mPrevFrustum;
+	float mPrevEyeOffsets[FrustumPlanes::Count];
+	DirectX::XMFLOAT3 mPrevEye;
+};
+
+#endif // CULLING_H
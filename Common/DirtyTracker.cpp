@@ -0,0 +1,37 @@
+//***************************************************************************************
+// DirtyTracker.cpp
+//***************************************************************************************
+
+#include "DirtyTracker.h"
+
+DirtyTracker::DirtyTracker()
+	: mLists(gNumFrameResources)
+{
+}
+
+void DirtyTracker::MarkDirty(UINT id)
+{
+	if(id >= mMarkedFrame.size())
+	{
+		mMarkedFrame.resize(id + 1, 0);
+		mWrittenFrame.resize(id + 1, 0);
+	}
+
+	// Once per frame is enough.
+	UINT stamp = mFrame + 1;
+	if(mMarkedFrame[id] == stamp)
+		return;
+
+	mMarkedFrame[id] = stamp;
+	mLists[mFrame % mLists.size()].push_back(id);
+}
+
+void DirtyTracker::Clear()
+{
+	for(std::vector<UINT>& list : mLists)
+		list.clear();
+
+	mMarkedFrame.clear();
+	mWrittenFrame.clear();
+	mFrame = 0;
+}
@@ -0,0 +1,95 @@
+//***************************************************************************************
+// DirtyTracker.h
+//
+// Tracks which constant buffer entries still have to be written, as lists of changes
+// instead of a NumFramesDirty counter that every update has to scan for.
+//   -Each frame resource has its own copy of the buffers, so a change has to reach
+//    gNumFrameResources of them.  MarkDirty queues an id on the list of the frame being
+//    built, once however often it is marked.
+//   -Update writes every id on the last gNumFrameResources lists, once even when it is
+//    on several, then moves to the next frame.  The oldest list has then been written
+//    to every frame resource and is emptied for reuse.
+//   -So a frame costs the number of recent changes, not the number of entries.
+//***************************************************************************************
+
+#ifndef DIRTYTRACKER_H
+#define DIRTYTRACKER_H
+
+#include "d3dUtil.h"
+
+struct DirtyStats
+{
+	// Ids marked since the previous Update.
+	UINT Marked = 0;
+
+	// Entries written by the last Update.
+	UINT Written = 0;
+};
+
+class DirtyTracker
+{
+public:
+	DirtyTracker();
+	DirtyTracker(const DirtyTracker& rhs) = delete;
+	DirtyTracker& operator=(const DirtyTracker& rhs) = delete;
+	~DirtyTracker() = default;
+
+	// Queues id to be written to each of the next gNumFrameResources frame
+	// resources.
+	void MarkDirty(UINT id);
+
+	// Forgets every id, e.g. when the buffers are rebuilt.
+	void Clear();
+
+	// Calls write(id) for every id marked in this or the previous
+	// gNumFrameResources - 1 frames, then starts the next frame.  write
+	// returns false when there was nothing to write after all, e.g. for a
+	// removed item.  Returns the number of entries written.
+	template<typename WriteEntry>
+	UINT Update(WriteEntry write, DirtyStats* stats = nullptr);
+
+private:
+	// The ids marked in each of the last gNumFrameResources frames.
+	std::vector<std::vector<UINT>> mLists;
+
+	// By id, 1 + the frame it was last queued in and last written in, or 0.
+	std::vector<UINT> mMarkedFrame;
+	std::vector<UINT> mWrittenFrame;
+
+	// Frames updated so far.
+	UINT mFrame = 0;
+};
+
+template<typename WriteEntry>
+UINT DirtyTracker::Update(WriteEntry write, DirtyStats* stats)
+{
+	UINT listCount = (UINT)mLists.size();
+	UINT stamp = mFrame + 1;
+
+	DirtyStats updateStats;
+	updateStats.Marked = (UINT)mLists[mFrame % listCount].size();
+
+	for(const std::vector<UINT>& list : mLists)
+	{
+		for(UINT id : list)
+		{
+			if(mWrittenFrame[id] == stamp)
+				continue;
+
+			mWrittenFrame[id] = stamp;
+			if(write(id))
+				updateStats.Written++;
+		}
+	}
+
+	// The oldest list has now reached every frame resource.
+	mFrame++;
+	mLists[mFrame % listCount].clear();
+
+	if(stats != nullptr)
+		*stats = updateStats;
+
+	return updateStats.Written;
+}
+
+#endif // DIRTYTRACKER_H
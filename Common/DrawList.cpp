@@ -0,0 +1,162 @@
+//***************************************************************************************
+// DrawList.cpp
+//***************************************************************************************
+
+#include "DrawList.h"
+
+namespace
+{
+	// DepthBits bits that sort like depth.  The bits of a positive float
+	// already sort like its value, so its top ones serve; anything at or
+	// behind the camera is 0.
+	UINT64 QuantizeDepth(float depth)
+	{
+		if(!(depth > 0.0f))
+			return 0;
+
+		UINT bits;
+		memcpy(&bits, &depth, sizeof(bits));
+
+		// Bit 31, the sign, is 0.
+		return (UINT64)bits >> (31 - DrawList::DepthBits);
+	}
+
+	UINT64 Field(UINT value, UINT bitCount)
+	{
+		assert(value < (1u << bitCount));
+
+		return (UINT64)value;
+	}
+}
+
+UINT64 DrawList::MakeKey(UINT layer, UINT pso, UINT material, UINT geometry, float depth)
+{
+	UINT64 key = Field(layer, LayerBits);
+	key = (key << PsoBits) | Field(pso, PsoBits);
+	key = (key << MaterialBits) | Field(material, MaterialBits);
+	key = (key << GeometryBits) | Field(geometry, GeometryBits);
+	key = (key << DepthBits) | QuantizeDepth(depth);
+
+	return key;
+}
+
+UINT64 DrawList::MakeBlendedKey(UINT layer, UINT pso, UINT material, UINT geometry, float depth)
+{
+	const UINT64 depthMask = (1ull << DepthBits) - 1;
+
+	// Farthest first.
+	UINT64 key = Field(layer, LayerBits);
+	key = (key << DepthBits) | (~QuantizeDepth(depth) & depthMask);
+	key = (key << PsoBits) | Field(pso, PsoBits);
+	key = (key << MaterialBits) | Field(material, MaterialBits);
+	key = (key << GeometryBits) | Field(geometry, GeometryBits);
+
+	return key;
+}
+
+UINT DrawList::KeyLayer(UINT64 key)
+{
+	return (UINT)(key >> (64 - LayerBits));
+}
+
+void DrawList::Clear()
+{
+	mKeys.clear();
+	mItems.clear();
+}
+
+void DrawList::Reserve(UINT count)
+{
+	mKeys.reserve(count);
+	mItems.reserve(count);
+	mScratchKeys.reserve(count);
+	mScratchItems.reserve(count);
+}
+
+void DrawList::Add(UINT64 key, UINT item)
+{
+	mKeys.push_back(key);
+	mItems.push_back(item);
+}
+
+void DrawList::Sort()
+{
+	const UINT digitCount = 8;
+	const UINT bucketCount = 256;
+
+	// Below this many draws, clearing and summing the histograms costs more than
+	// the whole sort.
+	const UINT insertionSortCount = 64;
+
+	UINT count = (UINT)mKeys.size();
+	if(count < 2)
+		return;
+
+	if(count <= insertionSortCount)
+	{
+		for(UINT i = 1; i < count; ++i)
+		{
+			UINT64 key = mKeys[i];
+			UINT item = mItems[i];
+
+			UINT j = i;
+			for(; j > 0 && mKeys[j - 1] > key; --j)
+			{
+				mKeys[j] = mKeys[j - 1];
+				mItems[j] = mItems[j - 1];
+			}
+
+			mKeys[j] = key;
+			mItems[j] = item;
+		}
+
+		return;
+	}
+
+	// Every digit's histogram in one read of the keys.
+	UINT histograms[digitCount][bucketCount] = {};
+	for(UINT i = 0; i < count; ++i)
+	{
+		UINT64 key = mKeys[i];
+		for(UINT d = 0; d < digitCount; ++d)
+			histograms[d][(key >> (8*d)) & 0xff]++;
+	}
+
+	mScratchKeys.resize(count);
+	mScratchItems.resize(count);
+
+	for(UINT d = 0; d < digitCount; ++d)
+	{
+		UINT* histogram = histograms[d];
+		UINT shift = 8*d;
+
+		// The layer, PSO and often more are the same for every draw; a digit
+		// with one bucket would only copy the list.
+		if(histogram[(mKeys[0] >> shift) & 0xff] == count)
+			continue;
+
+		UINT offsets[bucketCount];
+		UINT offset = 0;
+		for(UINT b = 0; b < bucketCount; ++b)
+		{
+			offsets[b] = offset;
+			offset += histogram[b];
+		}
+
+		for(UINT i = 0; i < count; ++i)
+		{
+			UINT64 key = mKeys[i];
+			UINT dst = offsets[(key >> shift) & 0xff]++;
+			mScratchKeys[dst] = key;
+			mScratchItems[dst] = mItems[i];
+		}
+
+		mKeys.swap(mScratchKeys);
+		mItems.swap(mScratchItems);
+	}
+}
+
+UINT DrawList::Size()const
+{
+	return (UINT)mKeys.size();
+}
@@ -0,0 +1,84 @@
+//***************************************************************************************
+// DrawList.h
+//
+// A frame's draws as 64-bit sort keys, radix sorted so that draws sharing state end up
+// next to each other.
+//   -From the top bit down a key holds the layer, the PSO, the material, the geometry
+//    and the view depth.  Sorted, the draws come layer by layer, grouped by PSO, then
+//    by material and geometry, and front to back among equal state, so the submission
+//    loop only has to rebind what differs from the previous draw.
+//   -Blended layers have to be drawn back to front instead.  Their keys put the view
+//    depth, inverted, right under the layer, and the state below it.
+//   -Sort is an LSD radix sort on 8-bit digits that skips any digit every key shares,
+//    or an insertion sort for a few dozen draws.  Either is stable, so draws with
+//    equal keys keep the order they were added in.
+//***************************************************************************************
+
+#ifndef DRAWLIST_H
+#define DRAWLIST_H
+
+#include "d3dUtil.h"
+
+struct DrawListStats
+{
+	// Draw calls, and the items they drew; more items than draws when runs of
+	// equal state are drawn instanced.
+	UINT Draws = 0;
+	UINT Instances = 0;
+
+	// Pipeline state, buffer, topology and material bindings the submission
+	// loop made, and the ones it left out because the previous draw had
+	// already bound the same thing.
+	UINT StateChanges = 0;
+	UINT StateChangesSkipped = 0;
+};
+
+class DrawList
+{
+public:
+	// Key fields, in bits.  The depth takes what is left.
+	static const UINT LayerBits = 4;
+	static const UINT PsoBits = 6;
+	static const UINT MaterialBits = 12;
+	static const UINT GeometryBits = 12;
+	static const UINT DepthBits = 64 - LayerBits - PsoBits - MaterialBits - GeometryBits;
+
+	DrawList() = default;
+	DrawList(const DrawList& rhs) = delete;
+	DrawList& operator=(const DrawList& rhs) = delete;
+	~DrawList() = default;
+
+	// Key of an opaque or alpha tested draw.  depth is the view space depth;
+	// the other fields have to fit their bit counts.
+	static UINT64 MakeKey(UINT layer, UINT pso, UINT material, UINT geometry, float depth);
+
+	// Key of a blended draw, sorted back to front within its layer.
+	static UINT64 MakeBlendedKey(UINT layer, UINT pso, UINT material, UINT geometry, float depth);
+
+	static UINT KeyLayer(UINT64 key);
+
+	void Clear();
+	void Reserve(UINT count);
+
+	// Adds a draw of item, e.g. a render item's slot.
+	void Add(UINT64 key, UINT item);
+
+	// Sorts the draws by key.
+	void Sort();
+
+	UINT Size()const;
+
+	// The keys and items, in order once sorted.
+	const UINT64* Keys()const { return mKeys.data(); }
+	const UINT* Items()const { return mItems.data(); }
+
+private:
+	std::vector<UINT64> mKeys;
+	std::vector<UINT> mItems;
+
+	// The other half of each radix pass.
+	std::vector<UINT64> mScratchKeys;
+	std::vector<UINT> mScratchItems;
+};
+
+#endif // DRAWLIST_H
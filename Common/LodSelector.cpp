@@ -0,0 +1,115 @@
+//***************************************************************************************
+// LodSelector.cpp
+//***************************************************************************************
+
+#include "LodSelector.h"
+
+using namespace DirectX;
+
+void LodSelector::SetSettings(const LodSettings& settings)
+{
+	assert(settings.LodPixels.size() + 1 <= LodSettings::MaxLevels);
+
+	mSettings = settings;
+	Reset();
+}
+
+const LodSettings& LodSelector::GetSettings()const
+{
+	return mSettings;
+}
+
+UINT LodSelector::GetLevelCount()const
+{
+	return (UINT)mSettings.LodPixels.size() + 1;
+}
+
+void XM_CALLCONV LodSelector::SetView(FXMVECTOR eyePosW, float proj11, float viewportHeight)
+{
+	XMStoreFloat3(&mEyePosW, eyePosW);
+	mPixelScale = proj11*viewportHeight;
+}
+
+float LodSelector::ProjectedPixels(const CullingBounds& bounds, UINT index)const
+{
+	float dx = bounds.CenterX()[index] - mEyePosW.x;
+	float dy = bounds.CenterY()[index] - mEyePosW.y;
+	float dz = bounds.CenterZ()[index] - mEyePosW.z;
+	float distance = sqrtf(dx*dx + dy*dy + dz*dz);
+	float radius = bounds.Radius()[index];
+
+	// The camera is inside the sphere, so the instance fills the screen.
+	if(distance <= radius)
+		return FLT_MAX;
+
+	return radius*mPixelScale / distance;
+}
+
+void LodSelector::Reset()
+{
+	std::fill(mPreviousLevels.begin(), mPreviousLevels.end(), Unknown);
+}
+
+UINT LodSelector::Select(const CullingBounds& bounds, const UINT* visibleIndices, UINT visibleCount,
+	std::vector<UINT>* levelInstances, LodStats* stats)
+{
+	UINT levelCount = GetLevelCount();
+
+	if(mPreviousLevels.size() != bounds.Size())
+		mPreviousLevels.assign(bounds.Size(), Unknown);
+
+	for(UINT level = 0; level < levelCount; ++level)
+		levelInstances[level].clear();
+
+	LodStats frameStats;
+	frameStats.Tested = visibleCount;
+
+	UINT keptCount = 0;
+	for(UINT i = 0; i < visibleCount; ++i)
+	{
+		UINT index = visibleIndices[i];
+		UINT previous = mPreviousLevels[index];
+		UINT level = Classify(ProjectedPixels(bounds, index), previous);
+
+		if(previous != Unknown && previous != level)
+			++frameStats.Switched;
+
+		mPreviousLevels[index] = (std::uint8_t)level;
+
+		if(level == levelCount)
+		{
+			++frameStats.TooSmall;
+			continue;
+		}
+
+		levelInstances[level].push_back(index);
+		++frameStats.PerLevel[level];
+		++keptCount;
+	}
+
+	if(stats != nullptr)
+		*stats = frameStats;
+
+	return keptCount;
+}
+
+UINT LodSelector::Classify(float pixels, UINT previous)const
+{
+	UINT levelCount = GetLevelCount();
+
+	// Threshold i separates level i from level i + 1, the last one separating
+	// the coarsest level from being dropped.  Each moves away from the side
+	// the instance was on, so it has to cross it by the hysteresis to switch.
+	for(UINT i = 0; i < levelCount; ++i)
+	{
+		float threshold = i < levelCount - 1 ? mSettings.LodPixels[i] : mSettings.MinPixels;
+
+		if(previous != Unknown)
+			threshold *= previous <= i ? 1.0f - mSettings.Hysteresis : 1.0f + mSettings.Hysteresis;
+
+		if(pixels >= threshold)
+			return i;
+	}
+
+	return levelCount;
+}
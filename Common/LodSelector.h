@@ -0,0 +1,102 @@
+//***************************************************************************************
+// LodSelector.h
+//
+// Screen-size culling and level of detail selection for instances that survived
+// frustum culling.
+//   -The projected size of an instance is estimated from its bounding sphere: the
+//    diameter in pixels is radius * proj(1,1) * viewportHeight / distance, which is
+//    exact at the center of the screen and close enough elsewhere.
+//   -Instances smaller than MinPixels are dropped.  The others get the first level
+//    whose LodPixels threshold they reach; level 0 is the most detailed.
+//   -Each threshold is moved by Hysteresis towards the level an instance had last
+//    frame, so an instance sitting on a threshold does not pop back and forth.
+//   -Select writes one list of instance indices per level, ready to be copied into
+//    the instance buffer as one contiguous range per instanced draw.
+//***************************************************************************************
+
+#ifndef LODSELECTOR_H
+#define LODSELECTOR_H
+
+#include "Culling.h"
+
+struct LodSettings
+{
+	// Most levels a LodSelector handles.
+	static const UINT MaxLevels = 8;
+
+	// Smallest projected diameter in pixels each level is used at, from
+	// level 0 down.  Must be decreasing and end above MinPixels.
+	std::vector<float> LodPixels = { 160.0f, 48.0f };
+
+	// Instances projecting to fewer pixels than this are not drawn.
+	float MinPixels = 3.0f;
+
+	// Fraction a threshold moves towards the previous level of an instance,
+	// e.g. 0.15 makes a level 0 instance switch to level 1 below 136 pixels
+	// but a level 1 instance switch back only above 184.
+	float Hysteresis = 0.15f;
+};
+
+struct LodStats
+{
+	// Instances given to Select.
+	UINT Tested = 0;
+
+	// Dropped for being smaller than MinPixels.
+	UINT TooSmall = 0;
+
+	// Instances that changed level since the last Select.
+	UINT Switched = 0;
+
+	UINT PerLevel[LodSettings::MaxLevels] = {};
+};
+
+class LodSelector
+{
+public:
+	LodSelector() = default;
+	LodSelector(const LodSelector& rhs) = delete;
+	LodSelector& operator=(const LodSelector& rhs) = delete;
+	~LodSelector() = default;
+
+	void SetSettings(const LodSettings& settings);
+	const LodSettings& GetSettings()const;
+
+	// Number of levels, i.e. of lists Select writes.
+	UINT GetLevelCount()const;
+
+	// Takes the camera the sizes are measured from.  proj11 is element (1,1)
+	// of the projection matrix, 1/tan(fovY/2) for a perspective camera.
+	void XM_CALLCONV SetView(DirectX::FXMVECTOR eyePosW, float proj11, float viewportHeight);
+
+	// Sorts the visible instances into per-level lists of indices into bounds,
+	// clearing the lists first.  levelInstances needs GetLevelCount() vectors.
+	// Returns the number of instances kept.
+	UINT Select(const CullingBounds& bounds, const UINT* visibleIndices, UINT visibleCount,
+		std::vector<UINT>* levelInstances, LodStats* stats = nullptr);
+
+	// Projected diameter in pixels of bound index for the current view.
+	float ProjectedPixels(const CullingBounds& bounds, UINT index)const;
+
+	// Forgets the previous levels, e.g. after the camera jumped.
+	void Reset();
+
+private:
+	// Level of an instance from its size, given the level it had before.
+	UINT Classify(float pixels, UINT previous)const;
+
+private:
+	LodSettings mSettings;
+
+	DirectX::XMFLOAT3 mEyePosW = { 0.0f, 0.0f, 0.0f };
+
+	// proj(1,1)*viewportHeight, so pixels = radius*mPixelScale/distance.
+	float mPixelScale = 1.0f;
+
+	// Level of every bound after the last Select; GetLevelCount() stands for
+	// too small, and Unknown for never selected.
+	static const std::uint8_t Unknown = 0xff;
+	std::vector<std::uint8_t> mPreviousLevels;
+};
+
+#endif // LODSELECTOR_H
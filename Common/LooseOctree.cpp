@@ -0,0 +1,524 @@
+//***************************************************************************************
+// LooseOctree.cpp
+//***************************************************************************************
+
+#include "LooseOctree.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// Every node pushes at most 8 children, and a branch is at most
+	// LooseOctree::MaxDepth + 1 nodes deep.
+	const UINT MaxStackSize = 8*(LooseOctree::MaxDepth + 1);
+
+	const UINT AllPlanes = (1u << FrustumPlanes::Count) - 1;
+
+	enum class PlaneSide
+	{
+		Outside,
+		Intersects,
+		Inside
+	};
+
+	PlaneSide ClassifyBox(const XMFLOAT4& plane, const XMFLOAT3& center, const XMFLOAT3& extents)
+	{
+		float d = plane.x*center.x + plane.y*center.y + plane.z*center.z + plane.w;
+		float r = fabsf(plane.x)*extents.x + fabsf(plane.y)*extents.y + fabsf(plane.z)*extents.z;
+
+		if(d + r < 0.0f)
+			return PlaneSide::Outside;
+
+		return d - r >= 0.0f ? PlaneSide::Inside : PlaneSide::Intersects;
+	}
+
+	// Clears the bits of mask for the planes the box is fully inside.  False
+	// when the box is outside one of them.
+	bool ClassifyBox(const FrustumPlanes& frustum, const XMFLOAT3& center, const XMFLOAT3& extents, UINT& mask)
+	{
+		for(UINT p = 0; p < FrustumPlanes::Count; ++p)
+		{
+			if((mask & (1u << p)) == 0)
+				continue;
+
+			PlaneSide side = ClassifyBox(frustum.Planes[p], center, extents);
+			if(side == PlaneSide::Outside)
+				return false;
+
+			if(side == PlaneSide::Inside)
+				mask &= ~(1u << p);
+		}
+
+		return true;
+	}
+
+	bool RayHitsBox(const XMFLOAT3& origin, const XMFLOAT3& invDir, float maxT,
+		const XMFLOAT3& center, const XMFLOAT3& extents)
+	{
+		float tx0 = (center.x - extents.x - origin.x)*invDir.x;
+		float tx1 = (center.x + extents.x - origin.x)*invDir.x;
+		float ty0 = (center.y - extents.y - origin.y)*invDir.y;
+		float ty1 = (center.y + extents.y - origin.y)*invDir.y;
+		float tz0 = (center.z - extents.z - origin.z)*invDir.z;
+		float tz1 = (center.z + extents.z - origin.z)*invDir.z;
+
+		float tEnter = MathHelper::Max(MathHelper::Max(MathHelper::Min(tx0, tx1), MathHelper::Min(ty0, ty1)),
+			MathHelper::Max(MathHelper::Min(tz0, tz1), 0.0f));
+		float tExit = MathHelper::Min(MathHelper::Min(MathHelper::Max(tx0, tx1), MathHelper::Max(ty0, ty1)),
+			MathHelper::Max(tz0, tz1));
+
+		return tEnter <= tExit && tEnter < maxT;
+	}
+
+	bool SphereHitsBox(const XMFLOAT3& sphereCenter, float radiusSq, const XMFLOAT3& center, const XMFLOAT3& extents)
+	{
+		float dx = MathHelper::Max(fabsf(sphereCenter.x - center.x) - extents.x, 0.0f);
+		float dy = MathHelper::Max(fabsf(sphereCenter.y - center.y) - extents.y, 0.0f);
+		float dz = MathHelper::Max(fabsf(sphereCenter.z - center.z) - extents.z, 0.0f);
+
+		return dx*dx + dy*dy + dz*dz <= radiusSq;
+	}
+
+	float SafeInverse(float x)
+	{
+		return 1.0f / (fabsf(x) > 1e-20f ? x : (x < 0.0f ? -1e-20f : 1e-20f));
+	}
+}
+
+void LooseOctree::Reset(const XMFLOAT3& center, float halfSize, UINT depth)
+{
+	mNodes.clear();
+	mObjects.clear();
+	mFreeNodes = Null;
+	mFreeObjects = Null;
+	mMaxDepth = MathHelper::Min(depth, MaxDepth);
+
+	Node root;
+	root.Center = center;
+	root.HalfSize = halfSize;
+	mNodes.push_back(root);
+	mNodeCount = 1;
+}
+
+UINT LooseOctree::Insert(const BoundingBox& worldBounds)
+{
+	UINT handle = mFreeObjects;
+	if(handle != Null)
+	{
+		mFreeObjects = mObjects[handle].Next;
+	}
+	else
+	{
+		handle = (UINT)mObjects.size();
+		mObjects.push_back(Object());
+	}
+
+	mObjects[handle].Bounds = worldBounds;
+	Link(handle);
+
+	return handle;
+}
+
+void LooseOctree::Remove(UINT handle)
+{
+	Unlink(handle);
+
+	mObjects[handle].Next = mFreeObjects;
+	mFreeObjects = handle;
+}
+
+bool LooseOctree::Update(UINT handle, const BoundingBox& worldBounds)
+{
+	Object& object = mObjects[handle];
+	object.Bounds = worldBounds;
+
+	// Still in the right node, as long as the size calls for the same level
+	// and the box has not left the loose cell.
+	const Node& node = mNodes[object.Node];
+	if(TargetDepth(worldBounds) == node.Depth && Fits(node, worldBounds))
+		return false;
+
+	Unlink(handle);
+	Link(handle);
+
+	return true;
+}
+
+void LooseOctree::Update(const UINT* handles, const BoundingBox* worldBounds, UINT count,
+	OctreeUpdateStats* stats)
+{
+	UINT moved = 0;
+	for(UINT i = 0; i < count; ++i)
+	{
+		if(Update(handles[i], worldBounds[i]))
+			moved++;
+	}
+
+	if(stats != nullptr)
+	{
+		stats->Updated = count;
+		stats->Moved = moved;
+	}
+}
+
+const BoundingBox& LooseOctree::GetBounds(UINT handle)const
+{
+	return mObjects[handle].Bounds;
+}
+
+UINT LooseOctree::Cull(const FrustumPlanes& frustum, std::vector<UINT>& handles,
+	OctreeQueryStats* stats)const
+{
+	OctreeQueryStats queryStats;
+	UINT count = 0;
+
+	struct Entry
+	{
+		UINT Node;
+
+		// Planes the parent intersects.
+		UINT Mask;
+	};
+
+	Entry stack[MaxStackSize];
+	UINT stackSize = 0;
+
+	if(ObjectCount() > 0)
+		stack[stackSize++] = { 0, AllPlanes };
+
+	while(stackSize > 0)
+	{
+		Entry entry = stack[--stackSize];
+		const Node& node = mNodes[entry.Node];
+		queryStats.NodesVisited++;
+
+		// The root also holds what is outside it, so it is never rejected.
+		UINT mask = entry.Mask;
+		if(entry.Node != 0)
+		{
+			XMFLOAT3 looseExtents(2.0f*node.HalfSize, 2.0f*node.HalfSize, 2.0f*node.HalfSize);
+			if(!ClassifyBox(frustum, node.Center, looseExtents, mask))
+				continue;
+
+			if(mask == 0)
+			{
+				count += AppendSubtree(entry.Node, handles);
+				queryStats.AcceptedSubtrees++;
+				continue;
+			}
+		}
+
+		for(UINT i = node.FirstObject; i != Null; i = mObjects[i].Next)
+		{
+			const BoundingBox& box = mObjects[i].Bounds;
+			queryStats.ObjectsTested++;
+
+			UINT objectMask = mask;
+			if(ClassifyBox(frustum, box.Center, box.Extents, objectMask))
+			{
+				handles.push_back(i);
+				count++;
+			}
+		}
+
+		for(UINT child : node.Children)
+		{
+			if(child != 0)
+				stack[stackSize++] = { child, mask };
+		}
+	}
+
+	if(stats != nullptr)
+		*stats = queryStats;
+
+	return count;
+}
+
+UINT XM_CALLCONV LooseOctree::RayCast(FXMVECTOR origin, FXMVECTOR dir, float maxT,
+	std::vector<UINT>& handles, OctreeQueryStats* stats)const
+{
+	OctreeQueryStats queryStats;
+	UINT count = 0;
+
+	XMFLOAT3 o, d;
+	XMStoreFloat3(&o, origin);
+	XMStoreFloat3(&d, dir);
+	XMFLOAT3 invDir(SafeInverse(d.x), SafeInverse(d.y), SafeInverse(d.z));
+
+	UINT stack[MaxStackSize];
+	UINT stackSize = 0;
+
+	if(ObjectCount() > 0)
+		stack[stackSize++] = 0;
+
+	while(stackSize > 0)
+	{
+		UINT nodeIndex = stack[--stackSize];
+		const Node& node = mNodes[nodeIndex];
+		queryStats.NodesVisited++;
+
+		if(nodeIndex != 0)
+		{
+			XMFLOAT3 looseExtents(2.0f*node.HalfSize, 2.0f*node.HalfSize, 2.0f*node.HalfSize);
+			if(!RayHitsBox(o, invDir, maxT, node.Center, looseExtents))
+				continue;
+		}
+
+		for(UINT i = node.FirstObject; i != Null; i = mObjects[i].Next)
+		{
+			const BoundingBox& box = mObjects[i].Bounds;
+			queryStats.ObjectsTested++;
+
+			if(RayHitsBox(o, invDir, maxT, box.Center, box.Extents))
+			{
+				handles.push_back(i);
+				count++;
+			}
+		}
+
+		for(UINT child : node.Children)
+		{
+			if(child != 0)
+				stack[stackSize++] = child;
+		}
+	}
+
+	if(stats != nullptr)
+		*stats = queryStats;
+
+	return count;
+}
+
+UINT XM_CALLCONV LooseOctree::OverlapSphere(FXMVECTOR center, float radius,
+	std::vector<UINT>& handles, OctreeQueryStats* stats)const
+{
+	OctreeQueryStats queryStats;
+	UINT count = 0;
+
+	XMFLOAT3 c;
+	XMStoreFloat3(&c, center);
+	float radiusSq = radius*radius;
+
+	UINT stack[MaxStackSize];
+	UINT stackSize = 0;
+
+	if(ObjectCount() > 0)
+		stack[stackSize++] = 0;
+
+	while(stackSize > 0)
+	{
+		UINT nodeIndex = stack[--stackSize];
+		const Node& node = mNodes[nodeIndex];
+		queryStats.NodesVisited++;
+
+		if(nodeIndex != 0)
+		{
+			XMFLOAT3 looseExtents(2.0f*node.HalfSize, 2.0f*node.HalfSize, 2.0f*node.HalfSize);
+			if(!SphereHitsBox(c, radiusSq, node.Center, looseExtents))
+				continue;
+		}
+
+		for(UINT i = node.FirstObject; i != Null; i = mObjects[i].Next)
+		{
+			const BoundingBox& box = mObjects[i].Bounds;
+			queryStats.ObjectsTested++;
+
+			if(SphereHitsBox(c, radiusSq, box.Center, box.Extents))
+			{
+				handles.push_back(i);
+				count++;
+			}
+		}
+
+		for(UINT child : node.Children)
+		{
+			if(child != 0)
+				stack[stackSize++] = child;
+		}
+	}
+
+	if(stats != nullptr)
+		*stats = queryStats;
+
+	return count;
+}
+
+UINT LooseOctree::ObjectCount()const
+{
+	return mNodes.empty() ? 0 : mNodes[0].Count;
+}
+
+UINT LooseOctree::NodeCount()const
+{
+	return mNodeCount;
+}
+
+UINT LooseOctree::TargetDepth(const BoundingBox& bounds)const
+{
+	const Node& root = mNodes[0];
+	const XMFLOAT3& c = bounds.Center;
+
+	// Outside the covered region only the root will do.
+	if(fabsf(c.x - root.Center.x) > root.HalfSize ||
+		fabsf(c.y - root.Center.y) > root.HalfSize ||
+		fabsf(c.z - root.Center.z) > root.HalfSize)
+		return 0;
+
+	float extent = MathHelper::Max(bounds.Extents.x, MathHelper::Max(bounds.Extents.y, bounds.Extents.z));
+
+	UINT depth = 0;
+	float childHalfSize = 0.5f*root.HalfSize;
+	while(depth < mMaxDepth && extent <= childHalfSize)
+	{
+		depth++;
+		childHalfSize *= 0.5f;
+	}
+
+	return depth;
+}
+
+bool LooseOctree::Fits(const Node& node, const BoundingBox& bounds)const
+{
+	if(node.Depth == 0)
+		return true;
+
+	float looseHalfSize = 2.0f*node.HalfSize;
+	return fabsf(bounds.Center.x - node.Center.x) + bounds.Extents.x <= looseHalfSize &&
+		fabsf(bounds.Center.y - node.Center.y) + bounds.Extents.y <= looseHalfSize &&
+		fabsf(bounds.Center.z - node.Center.z) + bounds.Extents.z <= looseHalfSize;
+}
+
+void LooseOctree::Link(UINT handle)
+{
+	const XMFLOAT3 c = mObjects[handle].Bounds.Center;
+	UINT depth = TargetDepth(mObjects[handle].Bounds);
+
+	// Walk down to the cell holding the center, making the missing nodes.
+	UINT nodeIndex = 0;
+	mNodes[0].Count++;
+
+	for(UINT d = 0; d < depth; ++d)
+	{
+		const Node& node = mNodes[nodeIndex];
+		UINT child = (c.x >= node.Center.x ? 1 : 0) |
+			(c.y >= node.Center.y ? 2 : 0) |
+			(c.z >= node.Center.z ? 4 : 0);
+
+		UINT childIndex = node.Children[child];
+		if(childIndex == 0)
+			childIndex = AllocateNode(nodeIndex, child);
+
+		nodeIndex = childIndex;
+		mNodes[nodeIndex].Count++;
+	}
+
+	Node& node = mNodes[nodeIndex];
+	Object& object = mObjects[handle];
+
+	object.Node = nodeIndex;
+	object.Prev = Null;
+	object.Next = node.FirstObject;
+	if(node.FirstObject != Null)
+		mObjects[node.FirstObject].Prev = handle;
+	node.FirstObject = handle;
+}
+
+void LooseOctree::Unlink(UINT handle)
+{
+	Object& object = mObjects[handle];
+
+	if(object.Prev != Null)
+		mObjects[object.Prev].Next = object.Next;
+	else
+		mNodes[object.Node].FirstObject = object.Next;
+
+	if(object.Next != Null)
+		mObjects[object.Next].Prev = object.Prev;
+
+	// Recycle the nodes nothing is left under.  Their descendants went
+	// before them, as they count no more objects.
+	UINT nodeIndex = object.Node;
+	while(nodeIndex != Null)
+	{
+		Node& node = mNodes[nodeIndex];
+		UINT parent = node.Parent;
+
+		if(--node.Count == 0 && nodeIndex != 0)
+		{
+			for(UINT& child : mNodes[parent].Children)
+			{
+				if(child == nodeIndex)
+					child = 0;
+			}
+
+			node.FirstObject = mFreeNodes;
+			mFreeNodes = nodeIndex;
+			mNodeCount--;
+		}
+
+		nodeIndex = parent;
+	}
+
+	object.Node = Null;
+	object.Prev = Null;
+	object.Next = Null;
+}
+
+UINT LooseOctree::AllocateNode(UINT parent, UINT child)
+{
+	UINT nodeIndex = mFreeNodes;
+	if(nodeIndex != Null)
+	{
+		mFreeNodes = mNodes[nodeIndex].FirstObject;
+	}
+	else
+	{
+		nodeIndex = (UINT)mNodes.size();
+		mNodes.push_back(Node());
+	}
+
+	const Node& parentNode = mNodes[parent];
+	float quarter = 0.5f*parentNode.HalfSize;
+
+	Node node;
+	node.Center.x = parentNode.Center.x + ((child & 1) ? quarter : -quarter);
+	node.Center.y = parentNode.Center.y + ((child & 2) ? quarter : -quarter);
+	node.Center.z = parentNode.Center.z + ((child & 4) ? quarter : -quarter);
+	node.HalfSize = quarter;
+	node.Depth = parentNode.Depth + 1;
+	node.Parent = parent;
+
+	mNodes[nodeIndex] = node;
+	mNodes[parent].Children[child] = nodeIndex;
+	mNodeCount++;
+
+	return nodeIndex;
+}
+
+UINT LooseOctree::AppendSubtree(UINT root, std::vector<UINT>& handles)const
+{
+	UINT count = 0;
+
+	UINT stack[MaxStackSize];
+	UINT stackSize = 0;
+	stack[stackSize++] = root;
+
+	while(stackSize > 0)
+	{
+		const Node& node = mNodes[stack[--stackSize]];
+
+		for(UINT i = node.FirstObject; i != Null; i = mObjects[i].Next)
+		{
+			handles.push_back(i);
+			count++;
+		}
+
+		for(UINT child : node.Children)
+		{
+			if(child != 0)
+				stack[stackSize++] = child;
+		}
+	}
+
+	return count;
+}
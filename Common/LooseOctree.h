@@ -0,0 +1,156 @@
+//***************************************************************************************
+// LooseOctree.h
+//
+// Loose octree over the world-space boxes of objects that move, for frustum, ray and
+// sphere queries that stay cheap while the scene animates.
+//   -Every node covers a cubic cell, but holds objects whose box fits in the cell
+//    grown to twice its size.  An object goes to the deepest level whose cell half
+//    size is at least its largest extent, in the cell containing its center, so it
+//    always fits, and finding that node takes at most MaxDepth steps.
+//   -Objects are kept in intrusive lists per node, so moving one between nodes is a
+//    constant number of link updates.  Most moves do not even change node: an object
+//    only leaves it once its box no longer fits in the loose cell.
+//   -Nodes are made on demand and recycled once nothing is left under them.  Each
+//    node counts the objects under it, so empty regions cost nothing to query.
+//   -Objects outside the covered region stay in the root, which is never rejected.
+//   -Cull classifies nodes against the planes their parent still intersects, as
+//    BoundsBvh does, and takes whole subtrees inside the frustum without testing
+//    their objects.
+//***************************************************************************************
+
+#ifndef LOOSEOCTREE_H
+#define LOOSEOCTREE_H
+
+#include "Culling.h"
+
+struct OctreeQueryStats
+{
+	UINT NodesVisited = 0;
+
+	// Subtrees taken as a whole without testing their objects.
+	UINT AcceptedSubtrees = 0;
+
+	UINT ObjectsTested = 0;
+};
+
+struct OctreeUpdateStats
+{
+	// Objects given to Update.
+	UINT Updated = 0;
+
+	// Of those, the ones that changed node.
+	UINT Moved = 0;
+};
+
+class LooseOctree
+{
+public:
+	// Returned by Insert when nothing is there, e.g. to mark an item that
+	// has no handle yet.
+	static const UINT InvalidHandle = 0xffffffff;
+
+	// Most levels below the root.
+	static const UINT MaxDepth = 10;
+
+	LooseOctree() = default;
+	LooseOctree(const LooseOctree& rhs) = delete;
+	LooseOctree& operator=(const LooseOctree& rhs) = delete;
+	~LooseOctree() = default;
+
+	// Removes every object and covers the cube center +- halfSize with up to
+	// depth levels below the root.
+	void Reset(const DirectX::XMFLOAT3& center, float halfSize, UINT depth = 5);
+
+	// Adds an object and returns its handle.  Handles of removed objects are
+	// reused.
+	UINT Insert(const DirectX::BoundingBox& worldBounds);
+
+	void Remove(UINT handle);
+
+	// Gives an object new bounds.  Returns true when it changed node.
+	bool Update(UINT handle, const DirectX::BoundingBox& worldBounds);
+
+	// Gives count objects new bounds, e.g. every render item marked dirty
+	// this frame.
+	void Update(const UINT* handles, const DirectX::BoundingBox* worldBounds, UINT count,
+		OctreeUpdateStats* stats = nullptr);
+
+	const DirectX::BoundingBox& GetBounds(UINT handle)const;
+
+	// Each query appends the handles of the objects it finds to handles, in
+	// no particular order, and returns how many it added.
+
+	// Objects whose box is inside or intersects the frustum.
+	UINT Cull(const FrustumPlanes& frustum, std::vector<UINT>& handles,
+		OctreeQueryStats* stats = nullptr)const;
+
+	// Objects whose box the ray hits with 0 <= t < maxT.  dir need not be
+	// unit length.
+	UINT XM_CALLCONV RayCast(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR dir, float maxT,
+		std::vector<UINT>& handles, OctreeQueryStats* stats = nullptr)const;
+
+	// Objects whose box overlaps the sphere.
+	UINT XM_CALLCONV OverlapSphere(DirectX::FXMVECTOR center, float radius,
+		std::vector<UINT>& handles, OctreeQueryStats* stats = nullptr)const;
+
+	UINT ObjectCount()const;
+	UINT NodeCount()const;
+
+private:
+	static const UINT Null = 0xffffffff;
+
+	struct Node
+	{
+		// The cell; the node holds objects fitting in twice its size.
+		DirectX::XMFLOAT3 Center;
+		float HalfSize = 0.0f;
+
+		UINT Depth = 0;
+		UINT Parent = Null;
+
+		// 0 where there is no child, since the root is never a child.  Bit 0
+		// of the child index is set for +x, bit 1 for +y and bit 2 for +z.
+		UINT Children[8] = {};
+
+		// Head of the list of objects held by the node itself.
+		UINT FirstObject = Null;
+
+		// Objects held by the node and all its descendants.
+		UINT Count = 0;
+	};
+
+	struct Object
+	{
+		DirectX::BoundingBox Bounds;
+
+		// Holding node, Null once removed.
+		UINT Node = Null;
+
+		// Neighbours in the node's list.  Next also links the free handles.
+		UINT Prev = Null;
+		UINT Next = Null;
+	};
+
+	// Deepest level an object fits by size, and whether its box fits in the
+	// loose cell of a node.
+	UINT TargetDepth(const DirectX::BoundingBox& bounds)const;
+	bool Fits(const Node& node, const DirectX::BoundingBox& bounds)const;
+
+	void Link(UINT handle);
+	void Unlink(UINT handle);
+
+	UINT AllocateNode(UINT parent, UINT child);
+	UINT AppendSubtree(UINT node, std::vector<UINT>& handles)const;
+
+private:
+	std::vector<Node> mNodes;
+	std::vector<Object> mObjects;
+
+	UINT mFreeNodes = Null;
+	UINT mFreeObjects = Null;
+	UINT mNodeCount = 0;
+
+	UINT mMaxDepth = 6;
+};
+
+#endif // LOOSEOCTREE_H
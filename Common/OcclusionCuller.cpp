@@ -0,0 +1,501 @@
+//***************************************************************************************
+// OcclusionCuller.cpp
+//***************************************************************************************
+
+#include "OcclusionCuller.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// Rows of the depth buffer each raster task owns.
+	const UINT BandHeight = 8;
+
+	// Vertices transformed and triangles set up per task.
+	const UINT ChunkSize = 256;
+
+	// Corner i of a unit box is at (+-1, +-1, +-1), with bit 0 selecting +x,
+	// bit 1 +y and bit 2 +z.  The triangles are clockwise seen from outside.
+	const XMFLOAT3 BoxCorners[8] =
+	{
+		XMFLOAT3(-1.0f, -1.0f, -1.0f), XMFLOAT3(+1.0f, -1.0f, -1.0f),
+		XMFLOAT3(-1.0f, +1.0f, -1.0f), XMFLOAT3(+1.0f, +1.0f, -1.0f),
+		XMFLOAT3(-1.0f, -1.0f, +1.0f), XMFLOAT3(+1.0f, -1.0f, +1.0f),
+		XMFLOAT3(-1.0f, +1.0f, +1.0f), XMFLOAT3(+1.0f, +1.0f, +1.0f)
+	};
+
+	const UINT BoxIndices[36] =
+	{
+		2, 3, 1,  2, 1, 0, // -z
+		7, 6, 4,  7, 4, 5, // +z
+		3, 7, 5,  3, 5, 1, // +x
+		6, 2, 0,  6, 0, 4, // -x
+		6, 7, 3,  6, 3, 2, // +y
+		5, 4, 0,  5, 0, 1  // -y
+	};
+
+	UINT RoundUp(UINT x, UINT multiple)
+	{
+		return (x + multiple - 1) / multiple * multiple;
+	}
+
+	XMFLOAT4 LerpClip(const XMFLOAT4& a, const XMFLOAT4& b, float t)
+	{
+		XMFLOAT4 result;
+		XMStoreFloat4(&result, XMVectorLerp(XMLoadFloat4(&a), XMLoadFloat4(&b), t));
+		return result;
+	}
+}
+
+OcclusionCuller::OcclusionCuller(UINT width, UINT height)
+{
+	Resize(width, height);
+}
+
+void OcclusionCuller::Resize(UINT width, UINT height)
+{
+	assert(width > 0 && height > 0);
+
+	mLevels.clear();
+
+	// Rows of the full-resolution level are padded to whole SSE registers.
+	Level level;
+	level.Width = width;
+	level.Height = height;
+	level.Pitch = RoundUp(width, 4);
+	level.Depth.assign(level.Pitch*height, 0.0f);
+	mRasterDepth.assign(level.Pitch*height, 0.0f);
+	mRowMinDepth.assign(level.Pitch*height, 0.0f);
+	mLevels.push_back(std::move(level));
+
+	while(width > 1 || height > 1)
+	{
+		width = (width + 1) / 2;
+		height = (height + 1) / 2;
+
+		level.Width = width;
+		level.Height = height;
+		level.Pitch = width;
+		level.Depth.assign(width*height, 0.0f);
+		mLevels.push_back(std::move(level));
+	}
+}
+
+UINT OcclusionCuller::GetWidth()const
+{
+	return mLevels[0].Width;
+}
+
+UINT OcclusionCuller::GetHeight()const
+{
+	return mLevels[0].Height;
+}
+
+void XM_CALLCONV OcclusionCuller::AddOccluder(const XMFLOAT3* positions, UINT vertexCount,
+	const UINT* indices, UINT indexCount, FXMMATRIX world)
+{
+	assert(indexCount % 3 == 0);
+
+	UINT baseVertex = (UINT)mVertices.size();
+
+	for(UINT i = 0; i < vertexCount; ++i)
+	{
+		XMFLOAT3 p;
+		XMStoreFloat3(&p, XMVector3TransformCoord(XMLoadFloat3(&positions[i]), world));
+		mVertices.push_back(p);
+	}
+
+	for(UINT i = 0; i < indexCount; ++i)
+	{
+		assert(indices[i] < vertexCount);
+		mIndices.push_back(baseVertex + indices[i]);
+	}
+
+	++mOccluderCount;
+}
+
+void XM_CALLCONV OcclusionCuller::AddOccluderBox(const BoundingBox& localBox, FXMMATRIX world)
+{
+	XMMATRIX boxToLocal = XMMatrixScaling(localBox.Extents.x, localBox.Extents.y, localBox.Extents.z) *
+		XMMatrixTranslation(localBox.Center.x, localBox.Center.y, localBox.Center.z);
+
+	AddOccluder(BoxCorners, 8, BoxIndices, 36, XMMatrixMultiply(boxToLocal, world));
+}
+
+void OcclusionCuller::ClearOccluders()
+{
+	mVertices.clear();
+	mIndices.clear();
+	mOccluderCount = 0;
+}
+
+void XM_CALLCONV OcclusionCuller::RenderOccluders(FXMMATRIX viewProj)
+{
+	XMMATRIX vp = viewProj;
+	XMStoreFloat4x4(&mViewProj, vp);
+
+	UINT vertexCount = (UINT)mVertices.size();
+	UINT triangleCount = (UINT)mIndices.size() / 3;
+
+	mStats = OcclusionStats();
+	mStats.Occluders = mOccluderCount;
+	mStats.OccluderTriangles = triangleCount;
+
+	Level& level0 = mLevels[0];
+	std::fill(mRasterDepth.begin(), mRasterDepth.end(), 0.0f);
+
+	mClipVertices.resize(vertexCount);
+	mTriangles.resize(2*triangleCount);
+
+	concurrency::parallel_for(0u, (vertexCount + ChunkSize - 1) / ChunkSize, [&](UINT chunk)
+	{
+		UINT last = MathHelper::Min(chunk*ChunkSize + ChunkSize, vertexCount);
+		for(UINT i = chunk*ChunkSize; i < last; ++i)
+			XMStoreFloat4(&mClipVertices[i], XMVector3Transform(XMLoadFloat3(&mVertices[i]), vp));
+	});
+
+	concurrency::parallel_for(0u, (triangleCount + ChunkSize - 1) / ChunkSize, [&](UINT chunk)
+	{
+		UINT last = MathHelper::Min(chunk*ChunkSize + ChunkSize, triangleCount);
+		for(UINT t = chunk*ChunkSize; t < last; ++t)
+			SetupTriangle(t, &mTriangles[2*t]);
+	});
+
+	for(const auto& tri : mTriangles)
+	{
+		if(tri.MaxX >= tri.MinX)
+			++mStats.RasterizedTriangles;
+	}
+
+	UINT bandCount = (level0.Height + BandHeight - 1) / BandHeight;
+	concurrency::parallel_for(0u, bandCount, [&](UINT band)
+	{
+		RasterizeBand(band);
+	});
+
+	BuildHierarchy();
+}
+
+UINT OcclusionCuller::SetupTriangle(UINT triangle, ScreenTriangle* out)const
+{
+	const XMFLOAT4* v[3] =
+	{
+		&mClipVertices[mIndices[3*triangle + 0]],
+		&mClipVertices[mIndices[3*triangle + 1]],
+		&mClipVertices[mIndices[3*triangle + 2]]
+	};
+
+	out[0] = ScreenTriangle();
+	out[1] = ScreenTriangle();
+
+	// Clip against the near plane, z >= 0 in clip space.  A triangle becomes
+	// at most a quad, drawn as a fan of two triangles.
+	XMFLOAT4 polygon[4];
+	UINT count = 0;
+	for(UINT i = 0; i < 3; ++i)
+	{
+		const XMFLOAT4& current = *v[i];
+		const XMFLOAT4& next = *v[(i + 1) % 3];
+
+		if(current.z >= 0.0f)
+			polygon[count++] = current;
+
+		if((current.z >= 0.0f) != (next.z >= 0.0f))
+			polygon[count++] = LerpClip(current, next, current.z / (current.z - next.z));
+	}
+
+	UINT setupCount = 0;
+	if(count >= 3 && SetupScreenTriangle(polygon[0], polygon[1], polygon[2], out[setupCount]))
+		++setupCount;
+	if(count == 4 && SetupScreenTriangle(polygon[0], polygon[2], polygon[3], out[setupCount]))
+		++setupCount;
+
+	return setupCount;
+}
+
+bool OcclusionCuller::SetupScreenTriangle(const XMFLOAT4& v0, const XMFLOAT4& v1,
+	const XMFLOAT4& v2, ScreenTriangle& out)const
+{
+	float width = (float)GetWidth();
+	float height = (float)GetHeight();
+
+	// Pixel coordinates with y down, and 1/w.
+	float x[3], y[3], z[3];
+	const XMFLOAT4* v[3] = { &v0, &v1, &v2 };
+	for(UINT i = 0; i < 3; ++i)
+	{
+		if(v[i]->w <= 0.0f)
+			return false;
+
+		z[i] = 1.0f / v[i]->w;
+		x[i] = (0.5f + 0.5f*v[i]->x*z[i])*width;
+		y[i] = (0.5f - 0.5f*v[i]->y*z[i])*height;
+	}
+
+	// Clockwise triangles have a positive area with y down.
+	float area = (x[1] - x[0])*(y[2] - y[0]) - (x[2] - x[0])*(y[1] - y[0]);
+	if(area <= 0.0f)
+		return false;
+
+	float minX = MathHelper::Clamp(MathHelper::Min(x[0], MathHelper::Min(x[1], x[2])), -1.0f, width);
+	float maxX = MathHelper::Clamp(MathHelper::Max(x[0], MathHelper::Max(x[1], x[2])), -1.0f, width);
+	float minY = MathHelper::Clamp(MathHelper::Min(y[0], MathHelper::Min(y[1], y[2])), -1.0f, height);
+	float maxY = MathHelper::Clamp(MathHelper::Max(y[0], MathHelper::Max(y[1], y[2])), -1.0f, height);
+
+	out.MinX = MathHelper::Max((int)floorf(minX), 0);
+	out.MaxX = MathHelper::Min((int)floorf(maxX), (int)GetWidth() - 1);
+	out.MinY = MathHelper::Max((int)floorf(minY), 0);
+	out.MaxY = MathHelper::Min((int)floorf(maxY), (int)GetHeight() - 1);
+
+	if(out.MinX > out.MaxX || out.MinY > out.MaxY)
+	{
+		out = ScreenTriangle();
+		return false;
+	}
+
+	for(UINT i = 0; i < 3; ++i)
+	{
+		UINT j = (i + 1) % 3;
+		out.A[i] = y[i] - y[j];
+		out.B[i] = x[j] - x[i];
+		out.C[i] = -(out.A[i]*x[i] + out.B[i]*y[i]);
+	}
+
+	out.DzDx = ((z[1] - z[0])*(y[2] - y[0]) - (z[2] - z[0])*(y[1] - y[0])) / area;
+	out.DzDy = ((z[2] - z[0])*(x[1] - x[0]) - (z[1] - z[0])*(x[2] - x[0])) / area;
+	out.Z0 = z[0] - out.DzDx*x[0] - out.DzDy*y[0];
+
+	return true;
+}
+
+void OcclusionCuller::RasterizeBand(UINT band)
+{
+	Level& level0 = mLevels[0];
+
+	int bandMinY = (int)(band*BandHeight);
+	int bandMaxY = MathHelper::Min(bandMinY + (int)BandHeight, (int)level0.Height) - 1;
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+	for(const auto& tri : mTriangles)
+	{
+		int minY = MathHelper::Max(tri.MinY, bandMinY);
+		int maxY = MathHelper::Min(tri.MaxY, bandMaxY);
+		if(tri.MaxX < tri.MinX || minY > maxY)
+			continue;
+
+		// Start on a 4-pixel boundary; the row padding absorbs the last group.
+		int minX = tri.MinX & ~3;
+		__m128 px = _mm_add_ps(_mm_set1_ps((float)minX), laneOffsets);
+
+		__m128 a0 = _mm_set1_ps(tri.A[0]), a1 = _mm_set1_ps(tri.A[1]), a2 = _mm_set1_ps(tri.A[2]);
+		__m128 dz = _mm_set1_ps(tri.DzDx);
+
+		__m128 a0Step = _mm_mul_ps(a0, _mm_set1_ps(4.0f));
+		__m128 a1Step = _mm_mul_ps(a1, _mm_set1_ps(4.0f));
+		__m128 a2Step = _mm_mul_ps(a2, _mm_set1_ps(4.0f));
+		__m128 dzStep = _mm_mul_ps(dz, _mm_set1_ps(4.0f));
+
+		for(int y = minY; y <= maxY; ++y)
+		{
+			float py = (float)y + 0.5f;
+
+			__m128 e0 = _mm_add_ps(_mm_mul_ps(a0, px), _mm_set1_ps(tri.B[0]*py + tri.C[0]));
+			__m128 e1 = _mm_add_ps(_mm_mul_ps(a1, px), _mm_set1_ps(tri.B[1]*py + tri.C[1]));
+			__m128 e2 = _mm_add_ps(_mm_mul_ps(a2, px), _mm_set1_ps(tri.B[2]*py + tri.C[2]));
+			__m128 z = _mm_add_ps(_mm_mul_ps(dz, px), _mm_set1_ps(tri.DzDy*py + tri.Z0));
+
+			float* row = &mRasterDepth[y*level0.Pitch];
+			for(int x = minX; x <= tri.MaxX; x += 4)
+			{
+				__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+					_mm_cmpge_ps(e2, zero));
+
+				// Empty lanes and pixels outside add 0, which never wins the max.
+				__m128 depth = _mm_loadu_ps(row + x);
+				_mm_storeu_ps(row + x, _mm_max_ps(depth, _mm_and_ps(inside, z)));
+
+				e0 = _mm_add_ps(e0, a0Step);
+				e1 = _mm_add_ps(e1, a1Step);
+				e2 = _mm_add_ps(e2, a2Step);
+				z = _mm_add_ps(z, dzStep);
+			}
+		}
+	}
+}
+
+void OcclusionCuller::BuildHierarchy()
+{
+	Level& level0 = mLevels[0];
+	int width = (int)level0.Width;
+	int height = (int)level0.Height;
+
+	// The full-resolution level is the rasterized buffer eroded by one pixel:
+	// every pixel takes the farthest depth of its 3x3 neighbourhood.  Pixel
+	// centers alone would let an occluder claim pixels its silhouette only
+	// partly covers; after the erosion a pixel counts as covered only when the
+	// centers around it are, which for a convex silhouette covers the whole
+	// pixel.
+	concurrency::parallel_for(0, height, [&](int y)
+	{
+		const float* src = &mRasterDepth[y*level0.Pitch];
+		float* dst = &mRowMinDepth[y*level0.Pitch];
+
+		for(int x = 0; x < width; ++x)
+		{
+			float left = src[MathHelper::Max(x - 1, 0)];
+			float right = src[MathHelper::Min(x + 1, width - 1)];
+			dst[x] = MathHelper::Min(src[x], MathHelper::Min(left, right));
+		}
+	});
+
+	concurrency::parallel_for(0, height, [&](int y)
+	{
+		const float* above = &mRowMinDepth[MathHelper::Max(y - 1, 0)*level0.Pitch];
+		const float* center = &mRowMinDepth[y*level0.Pitch];
+		const float* below = &mRowMinDepth[MathHelper::Min(y + 1, height - 1)*level0.Pitch];
+		float* dst = &level0.Depth[y*level0.Pitch];
+
+		for(int x = 0; x < width; ++x)
+			dst[x] = MathHelper::Min(center[x], MathHelper::Min(above[x], below[x]));
+	});
+
+	for(UINT i = 1; i < (UINT)mLevels.size(); ++i)
+	{
+		const Level& src = mLevels[i - 1];
+		Level& dst = mLevels[i];
+
+		concurrency::parallel_for(0u, dst.Height, [&](UINT y)
+		{
+			// An odd source size repeats its last row or column.
+			const float* row0 = &src.Depth[(2*y)*src.Pitch];
+			const float* row1 = &src.Depth[MathHelper::Min(2*y + 1, src.Height - 1)*src.Pitch];
+
+			for(UINT x = 0; x < dst.Width; ++x)
+			{
+				UINT x0 = 2*x;
+				UINT x1 = MathHelper::Min(2*x + 1, src.Width - 1);
+
+				dst.Depth[y*dst.Pitch + x] = MathHelper::Min(
+					MathHelper::Min(row0[x0], row0[x1]),
+					MathHelper::Min(row1[x0], row1[x1]));
+			}
+		});
+	}
+}
+
+OcclusionResult OcclusionCuller::Test(const BoundingBox& worldBox)const
+{
+	XMMATRIX viewProj = XMLoadFloat4x4(&mViewProj);
+
+	XMFLOAT3 corners[BoundingBox::CORNER_COUNT];
+	worldBox.GetCorners(corners);
+
+	float width = (float)GetWidth();
+	float height = (float)GetHeight();
+
+	float minX = FLT_MAX, maxX = -FLT_MAX;
+	float minY = FLT_MAX, maxY = -FLT_MAX;
+	float nearestDepth = 0.0f;
+
+	for(UINT i = 0; i < BoundingBox::CORNER_COUNT; ++i)
+	{
+		XMFLOAT4 clip;
+		XMStoreFloat4(&clip, XMVector3Transform(XMLoadFloat3(&corners[i]), viewProj));
+
+		if(clip.z < 0.0f || clip.w <= 0.0f)
+			return OcclusionResult::Visible;
+
+		float invW = 1.0f / clip.w;
+		float x = (0.5f + 0.5f*clip.x*invW)*width;
+		float y = (0.5f - 0.5f*clip.y*invW)*height;
+
+		minX = MathHelper::Min(minX, x);
+		maxX = MathHelper::Max(maxX, x);
+		minY = MathHelper::Min(minY, y);
+		maxY = MathHelper::Max(maxY, y);
+		nearestDepth = MathHelper::Max(nearestDepth, invW);
+	}
+
+	if(maxX < 0.0f || minX >= width || maxY < 0.0f || minY >= height)
+		return OcclusionResult::OutsideScreen;
+
+	// Every pixel the rectangle touches.
+	UINT x0 = (UINT)MathHelper::Max(minX, 0.0f);
+	UINT x1 = (UINT)MathHelper::Min(maxX, width - 1.0f);
+	UINT y0 = (UINT)MathHelper::Max(minY, 0.0f);
+	UINT y1 = (UINT)MathHelper::Min(maxY, height - 1.0f);
+
+	// The finest level where the rectangle spans at most 4x4 texels.
+	UINT levelIndex = 0;
+	while(levelIndex + 1 < (UINT)mLevels.size() &&
+		((x1 >> levelIndex) - (x0 >> levelIndex) > 3 || (y1 >> levelIndex) - (y0 >> levelIndex) > 3))
+	{
+		++levelIndex;
+	}
+
+	const Level& level = mLevels[levelIndex];
+	for(UINT y = y0 >> levelIndex; y <= y1 >> levelIndex; ++y)
+	{
+		for(UINT x = x0 >> levelIndex; x <= x1 >> levelIndex; ++x)
+		{
+			// Some pixel under this texel is empty or farther than the box.
+			if(level.Depth[y*level.Pitch + x] <= nearestDepth)
+				return OcclusionResult::Visible;
+		}
+	}
+
+	return OcclusionResult::Occluded;
+}
+
+UINT OcclusionCuller::TestOccludees(const BoundingBox* worldBoxes, UINT count, bool* visible)
+{
+	std::vector<OcclusionResult> results(count);
+
+	concurrency::parallel_for(0u, count, [&](UINT i)
+	{
+		results[i] = Test(worldBoxes[i]);
+	});
+
+	UINT visibleCount = 0;
+	for(UINT i = 0; i < count; ++i)
+	{
+		visible[i] = results[i] == OcclusionResult::Visible;
+
+		switch(results[i])
+		{
+		case OcclusionResult::Visible:
+			++visibleCount;
+			++mStats.Visible;
+			break;
+
+		case OcclusionResult::Occluded:
+			++mStats.Occluded;
+			break;
+
+		default:
+			++mStats.OutsideScreen;
+			break;
+		}
+	}
+
+	mStats.Tested += count;
+
+	return visibleCount;
+}
+
+const OcclusionStats& OcclusionCuller::GetStats()const
+{
+	return mStats;
+}
+
+const float* OcclusionCuller::GetDepth()const
+{
+	return mLevels[0].Depth.data();
+}
+
+UINT OcclusionCuller::GetDepthPitch()const
+{
+	return mLevels[0].Pitch;
+}
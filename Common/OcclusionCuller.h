@@ -0,0 +1,144 @@
+//***************************************************************************************
+// OcclusionCuller.h
+//
+// CPU occlusion culling against a small software depth buffer.
+//   -Occluders are triangle meshes, usually a handful of large buildings, given once in
+//    world space.  Each frame RenderOccluders rasterizes them on the PPL worker threads
+//    into a low-resolution buffer, 4 pixels per SSE instruction.  The screen is split
+//    into horizontal bands so no two threads ever write the same pixels.
+//   -The buffer stores 1/w, which interpolates linearly across the screen: nearer is
+//    larger and pixels no occluder covers stay 0.  The buffer is eroded by one pixel so
+//    partly covered silhouette pixels do not count, then each level of the hierarchy
+//    keeps the smallest 1/w, i.e. the farthest occluder, of 2x2 texels of the level below.
+//   -An occludee's world box is projected to a screen rectangle and its nearest 1/w.  It
+//    is occluded when every texel of the level that covers the rectangle with at most
+//    4x4 texels holds an occluder nearer than that.
+//***************************************************************************************
+
+#ifndef OCCLUSIONCULLER_H
+#define OCCLUSIONCULLER_H
+
+#include "d3dUtil.h"
+#include <ppl.h>
+
+enum class OcclusionResult
+{
+	Visible,
+	Occluded,
+
+	// The box projects entirely outside the screen.
+	OutsideScreen
+};
+
+struct OcclusionStats
+{
+	UINT Occluders = 0;
+	UINT OccluderTriangles = 0;
+
+	// Triangles left after near-plane clipping, back-face culling and
+	// rejecting the ones that miss the screen.
+	UINT RasterizedTriangles = 0;
+
+	// Counted by TestOccludees.
+	UINT Tested = 0;
+	UINT Visible = 0;
+	UINT Occluded = 0;
+	UINT OutsideScreen = 0;
+};
+
+class OcclusionCuller
+{
+public:
+	OcclusionCuller(UINT width = 256, UINT height = 128);
+	OcclusionCuller(const OcclusionCuller& rhs) = delete;
+	OcclusionCuller& operator=(const OcclusionCuller& rhs) = delete;
+	~OcclusionCuller() = default;
+
+	// Resolution of the depth buffer.  Keep the aspect ratio of the back buffer.
+	void Resize(UINT width, UINT height);
+	UINT GetWidth()const;
+	UINT GetHeight()const;
+
+	// Adds a mesh with clockwise front faces, transformed to world space once.
+	// Occluders stay until ClearOccluders.
+	void XM_CALLCONV AddOccluder(const DirectX::XMFLOAT3* positions, UINT vertexCount,
+		const UINT* indices, UINT indexCount, DirectX::FXMMATRIX world);
+	void XM_CALLCONV AddOccluderBox(const DirectX::BoundingBox& localBox, DirectX::FXMMATRIX world);
+	void ClearOccluders();
+
+	// Clears the depth buffer, rasterizes every occluder as seen through
+	// viewProj and rebuilds the hierarchy.  Also resets the stats.
+	void XM_CALLCONV RenderOccluders(DirectX::FXMMATRIX viewProj);
+
+	// Tests one box against the hierarchy of the last RenderOccluders.  A box
+	// that crosses the near plane is always visible.
+	OcclusionResult Test(const DirectX::BoundingBox& worldBox)const;
+
+	// Tests every box on the worker threads, writes whether it is visible and
+	// adds to the stats.  Returns the number of visible boxes.
+	UINT TestOccludees(const DirectX::BoundingBox* worldBoxes, UINT count, bool* visible);
+
+	const OcclusionStats& GetStats()const;
+
+	// The full-resolution level of the hierarchy, 1/w after the erosion that
+	// keeps only fully covered pixels, GetDepthPitch() floats per row.
+	const float* GetDepth()const;
+	UINT GetDepthPitch()const;
+
+private:
+	// A triangle in pixel coordinates: three edge functions A*x + B*y + C that
+	// are >= 0 inside, 1/w as a plane over the screen, and its pixel bounds.
+	// MaxX < MinX marks an empty slot.
+	struct ScreenTriangle
+	{
+		float A[3];
+		float B[3];
+		float C[3];
+
+		float Z0;
+		float DzDx;
+		float DzDy;
+
+		int MinX = 0;
+		int MaxX = -1;
+		int MinY = 0;
+		int MaxY = -1;
+	};
+
+	struct Level
+	{
+		UINT Width = 0;
+		UINT Height = 0;
+		UINT Pitch = 0;
+		std::vector<float> Depth;
+	};
+
+	UINT SetupTriangle(UINT triangle, ScreenTriangle* out)const;
+	bool SetupScreenTriangle(const DirectX::XMFLOAT4& v0, const DirectX::XMFLOAT4& v1,
+		const DirectX::XMFLOAT4& v2, ScreenTriangle& out)const;
+	void RasterizeBand(UINT band);
+	void BuildHierarchy();
+
+private:
+	std::vector<Level> mLevels;
+
+	// The occluders as rasterized at pixel centers, before the erosion
+	// that turns them into the first level, and its horizontal pass.
+	std::vector<float> mRasterDepth;
+	std::vector<float> mRowMinDepth;
+
+	std::vector<DirectX::XMFLOAT3> mVertices;
+	std::vector<UINT> mIndices;
+	UINT mOccluderCount = 0;
+
+	// Per-frame work: clip-space vertices and two triangle slots for every
+	// occluder triangle, since clipping at the near plane can split one.
+	std::vector<DirectX::XMFLOAT4> mClipVertices;
+	std::vector<ScreenTriangle> mTriangles;
+
+	DirectX::XMFLOAT4X4 mViewProj = MathHelper::Identity4x4();
+
+	OcclusionStats mStats;
+};
+
+#endif // OCCLUSIONCULLER_H
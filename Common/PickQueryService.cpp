@@ -0,0 +1,172 @@
+//***************************************************************************************
+// PickQueryService.cpp
+//***************************************************************************************
+
+#include "PickQueryService.h"
+
+using namespace DirectX;
+
+PickQueryService::PickQueryService()
+{
+	mWorker = std::thread(&PickQueryService::WorkerLoop, this);
+}
+
+PickQueryService::~PickQueryService()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQueue.clear();
+		mQuit = true;
+	}
+
+	mWorkReady.notify_one();
+	mWorker.join();
+}
+
+void PickQueryService::SetScene(std::shared_ptr<const SceneBvh> scene)
+{
+	mScene = std::move(scene);
+}
+
+void PickQueryService::Submit(const PickRequest& request)
+{
+	if(request.Latest)
+	{
+		for(PickRequest& pending : mPending)
+		{
+			if(pending.Latest && pending.Tag == request.Tag)
+			{
+				pending = request;
+				return;
+			}
+		}
+	}
+
+	mPending.push_back(request);
+}
+
+void PickQueryService::Dispatch(UINT64 frame)
+{
+	if(mPending.empty() || mScene == nullptr)
+		return;
+
+	Batch batch;
+	batch.Frame = frame;
+	batch.Scene = mScene;
+	batch.Requests.swap(mPending);
+
+	auto replaced = [&batch](const PickRequest& queued)
+	{
+		if(!queued.Latest)
+			return false;
+
+		for(const PickRequest& request : batch.Requests)
+		{
+			if(request.Latest && request.Tag == queued.Tag)
+				return true;
+		}
+		return false;
+	};
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		// Batches the worker has not taken yet lose the requests this one
+		// replaces; the batch it is running is left alone.
+		for(Batch& queued : mQueue)
+		{
+			queued.Requests.erase(std::remove_if(queued.Requests.begin(), queued.Requests.end(), replaced),
+				queued.Requests.end());
+		}
+		mQueue.erase(std::remove_if(mQueue.begin(), mQueue.end(),
+			[](const Batch& queued) { return queued.Requests.empty(); }), mQueue.end());
+
+		mQueue.push_back(std::move(batch));
+	}
+
+	mWorkReady.notify_one();
+}
+
+UINT PickQueryService::Collect(std::vector<PickResult>& results)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	UINT count = (UINT)mPublished.size();
+	results.insert(results.end(), mPublished.begin(), mPublished.end());
+	mPublished.clear();
+
+	return count;
+}
+
+void PickQueryService::WaitIdle()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mWorkDone.wait(lock, [this]() { return mQueue.empty() && !mBusy; });
+}
+
+void PickQueryService::WorkerLoop()
+{
+	std::vector<PickResult> results;
+
+	for(;;)
+	{
+		Batch batch;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWorkReady.wait(lock, [this]() { return mQuit || !mQueue.empty(); });
+
+			if(mQuit)
+				break;
+
+			batch = std::move(mQueue.front());
+			mQueue.pop_front();
+			mBusy = true;
+		}
+
+		// The snapshot is immutable, so the queries run without the lock.
+		results.resize(batch.Requests.size());
+		for(size_t i = 0; i < batch.Requests.size(); ++i)
+		{
+			const PickRequest& request = batch.Requests[i];
+
+			results[i].Tag = request.Tag;
+			results[i].Frame = batch.Frame;
+			batch.Scene->Intersect(XMLoadFloat3(&request.Origin), XMLoadFloat3(&request.Dir),
+				results[i].Hit, request.MaxT);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mPublished.insert(mPublished.end(), results.begin(), results.end());
+			mBusy = false;
+		}
+
+		mWorkDone.notify_all();
+	}
+
+	// Nothing waits on a quitting service, but keep WaitIdle from hanging.
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mBusy = false;
+	}
+	mWorkDone.notify_all();
+}
+
+PickRequest XM_CALLCONV PickQueryService::ScreenRay(UINT tag, float sx, float sy, float width, float height,
+	const XMFLOAT4X4& proj, FXMMATRIX invView)
+{
+	// The ray through the pixel on the z = 1 plane of view space, taken to
+	// world space.
+	float vx = (+2.0f*sx / width - 1.0f) / proj(0, 0);
+	float vy = (-2.0f*sy / height + 1.0f) / proj(1, 1);
+
+	XMVECTOR rayOrigin = XMVector3TransformCoord(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), invView);
+	XMVECTOR rayDir = XMVector3TransformNormal(XMVectorSet(vx, vy, 1.0f, 0.0f), invView);
+
+	PickRequest request;
+	request.Tag = tag;
+	XMStoreFloat3(&request.Origin, rayOrigin);
+	XMStoreFloat3(&request.Dir, XMVector3Normalize(rayDir));
+
+	return request;
+}
@@ -0,0 +1,119 @@
+//***************************************************************************************
+// PickQueryService.h
+//
+// Runs ray picking queries on a worker thread so a pick against heavy meshes never
+// stalls the frame.
+//   -Requests are world-space rays, usually made from a screen position with
+//    ScreenRay.  Any number can be submitted per frame, e.g. a hover ray, a click and
+//    the rays of an editing tool, each tagged so its result can be told apart.
+//   -A request marked Latest, e.g. a hover ray sent every frame, replaces the one with
+//    its tag that is still pending or queued, so a worker that falls behind never
+//    builds up a backlog of stale hover rays.
+//   -Dispatch hands the requests of the frame to the worker together with the current
+//    scene snapshot, an immutable SceneBvh copy holding the instance transforms at the
+//    time.  The main thread can move instances and set a new snapshot meanwhile.
+//   -The worker publishes the results of a batch all at once.  Collect takes every
+//    published result without waiting, so a frame sees the results of the batches
+//    dispatched by earlier frames, typically the previous one.
+//***************************************************************************************
+
+#ifndef PICKQUERYSERVICE_H
+#define PICKQUERYSERVICE_H
+
+#include "SceneBvh.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+struct PickRequest
+{
+	// Chosen by the caller and passed back in the result.
+	UINT Tag = 0;
+
+	// World-space ray; Dir need not be unit length.
+	DirectX::XMFLOAT3 Origin = { 0.0f, 0.0f, 0.0f };
+	DirectX::XMFLOAT3 Dir = { 0.0f, 0.0f, 1.0f };
+	float MaxT = FLT_MAX;
+
+	// Only the newest request with this tag matters: it replaces any earlier
+	// Latest one with the same tag that the worker has not started on.
+	bool Latest = false;
+};
+
+struct PickResult
+{
+	UINT Tag = 0;
+
+	// Frame passed to the Dispatch the request went out with.
+	UINT64 Frame = 0;
+
+	// Hit.Instance indexes the scene snapshot, -1 when nothing was hit.
+	SceneHit Hit;
+};
+
+class PickQueryService
+{
+public:
+	// Starts the worker thread.
+	PickQueryService();
+	PickQueryService(const PickQueryService& rhs) = delete;
+	PickQueryService& operator=(const PickQueryService& rhs) = delete;
+
+	// Drops the queued batches and joins the worker.
+	~PickQueryService();
+
+	// Scene used by the batches dispatched from now on.  The snapshot, and the
+	// mesh hierarchies it references, must not change while it is in use.
+	void SetScene(std::shared_ptr<const SceneBvh> scene);
+
+	// Adds a request to the next batch.  A Latest request overwrites a pending
+	// one with its tag instead.
+	void Submit(const PickRequest& request);
+
+	// Sends the requests submitted since the last Dispatch to the worker as one
+	// batch, dropping the queued Latest requests they replace.  Does nothing when
+	// there are none.
+	void Dispatch(UINT64 frame);
+
+	// Appends the results of every batch the worker has finished to results, in
+	// dispatch and submit order, and returns how many were added.  Never waits.
+	UINT Collect(std::vector<PickResult>& results);
+
+	// Waits until every dispatched batch is finished.
+	void WaitIdle();
+
+	// The ray through pixel (sx, sy) of a width by height viewport, from the
+	// camera with projection proj and inverse view matrix invView.
+	static PickRequest XM_CALLCONV ScreenRay(UINT tag, float sx, float sy, float width, float height,
+		const DirectX::XMFLOAT4X4& proj, DirectX::FXMMATRIX invView);
+
+private:
+	struct Batch
+	{
+		UINT64 Frame = 0;
+		std::shared_ptr<const SceneBvh> Scene;
+		std::vector<PickRequest> Requests;
+	};
+
+	void WorkerLoop();
+
+private:
+	// Main thread only.
+	std::shared_ptr<const SceneBvh> mScene;
+	std::vector<PickRequest> mPending;
+
+	// Guards everything below.
+	std::mutex mMutex;
+	std::condition_variable mWorkReady;
+	std::condition_variable mWorkDone;
+
+	std::deque<Batch> mQueue;
+	std::vector<PickResult> mPublished;
+	bool mBusy = false;
+	bool mQuit = false;
+
+	std::thread mWorker;
+};
+
+#endif // PICKQUERYSERVICE_H
@@ -0,0 +1,324 @@
+//***************************************************************************************
+// RayPacket.cpp
+//***************************************************************************************
+
+#include "RayPacket.h"
+#include "Culling.h"
+#include <intrin.h>
+
+using namespace DirectX;
+
+namespace
+{
+	// Determinants smaller than this mean the ray is parallel to the triangle,
+	// as in TriangleBvh::Intersect.
+	const float ParallelEpsilon = 1e-12f;
+
+	bool gAvxEnabled = true;
+
+	// Lanes of mask set to b, the others to a.
+	__m128 Select(__m128 a, __m128 b, __m128 mask)
+	{
+		return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a));
+	}
+
+	__m256 Select(__m256 a, __m256 b, __m256 mask)
+	{
+		return _mm256_blendv_ps(a, b, mask);
+	}
+
+	UINT IntersectBoxSse(const RayPacket& rays, const XMFLOAT3& boxMin, const XMFLOAT3& boxMax, float* tEnter)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 noHit = _mm_set1_ps(FLT_MAX);
+		const __m128 minX = _mm_set1_ps(boxMin.x);
+		const __m128 minY = _mm_set1_ps(boxMin.y);
+		const __m128 minZ = _mm_set1_ps(boxMin.z);
+		const __m128 maxX = _mm_set1_ps(boxMax.x);
+		const __m128 maxY = _mm_set1_ps(boxMax.y);
+		const __m128 maxZ = _mm_set1_ps(boxMax.z);
+
+		UINT mask = 0;
+		for(UINT base = 0; base < RayPacket::Size; base += 4)
+		{
+			__m128 ox = _mm_load_ps(rays.OriginX + base);
+			__m128 oy = _mm_load_ps(rays.OriginY + base);
+			__m128 oz = _mm_load_ps(rays.OriginZ + base);
+			__m128 ix = _mm_load_ps(rays.InvDirX + base);
+			__m128 iy = _mm_load_ps(rays.InvDirY + base);
+			__m128 iz = _mm_load_ps(rays.InvDirZ + base);
+			__m128 tMax = _mm_load_ps(rays.TMax + base);
+
+			__m128 t0x = _mm_mul_ps(_mm_sub_ps(minX, ox), ix);
+			__m128 t1x = _mm_mul_ps(_mm_sub_ps(maxX, ox), ix);
+			__m128 t0y = _mm_mul_ps(_mm_sub_ps(minY, oy), iy);
+			__m128 t1y = _mm_mul_ps(_mm_sub_ps(maxY, oy), iy);
+			__m128 t0z = _mm_mul_ps(_mm_sub_ps(minZ, oz), iz);
+			__m128 t1z = _mm_mul_ps(_mm_sub_ps(maxZ, oz), iz);
+
+			__m128 enter = _mm_max_ps(
+				_mm_max_ps(_mm_min_ps(t0x, t1x), _mm_min_ps(t0y, t1y)),
+				_mm_max_ps(_mm_min_ps(t0z, t1z), zero));
+			__m128 exit = _mm_min_ps(
+				_mm_min_ps(_mm_max_ps(t0x, t1x), _mm_max_ps(t0y, t1y)),
+				_mm_min_ps(_mm_max_ps(t0z, t1z), tMax));
+
+			__m128 hit = _mm_and_ps(_mm_cmple_ps(enter, exit), _mm_cmplt_ps(enter, tMax));
+
+			if(tEnter != nullptr)
+				_mm_storeu_ps(tEnter + base, Select(noHit, enter, hit));
+
+			mask |= (UINT)_mm_movemask_ps(hit) << base;
+		}
+
+		return mask;
+	}
+
+	UINT IntersectBoxAvx(const RayPacket& rays, const XMFLOAT3& boxMin, const XMFLOAT3& boxMax, float* tEnter)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+
+		__m256 ox = _mm256_load_ps(rays.OriginX);
+		__m256 oy = _mm256_load_ps(rays.OriginY);
+		__m256 oz = _mm256_load_ps(rays.OriginZ);
+		__m256 ix = _mm256_load_ps(rays.InvDirX);
+		__m256 iy = _mm256_load_ps(rays.InvDirY);
+		__m256 iz = _mm256_load_ps(rays.InvDirZ);
+		__m256 tMax = _mm256_load_ps(rays.TMax);
+
+		__m256 t0x = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(boxMin.x), ox), ix);
+		__m256 t1x = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(boxMax.x), ox), ix);
+		__m256 t0y = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(boxMin.y), oy), iy);
+		__m256 t1y = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(boxMax.y), oy), iy);
+		__m256 t0z = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(boxMin.z), oz), iz);
+		__m256 t1z = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(boxMax.z), oz), iz);
+
+		__m256 enter = _mm256_max_ps(
+			_mm256_max_ps(_mm256_min_ps(t0x, t1x), _mm256_min_ps(t0y, t1y)),
+			_mm256_max_ps(_mm256_min_ps(t0z, t1z), zero));
+		__m256 exit = _mm256_min_ps(
+			_mm256_min_ps(_mm256_max_ps(t0x, t1x), _mm256_max_ps(t0y, t1y)),
+			_mm256_min_ps(_mm256_max_ps(t0z, t1z), tMax));
+
+		__m256 hit = _mm256_and_ps(_mm256_cmp_ps(enter, exit, _CMP_LE_OQ), _mm256_cmp_ps(enter, tMax, _CMP_LT_OQ));
+
+		if(tEnter != nullptr)
+			_mm256_storeu_ps(tEnter, Select(_mm256_set1_ps(FLT_MAX), enter, hit));
+
+		return (UINT)_mm256_movemask_ps(hit);
+	}
+
+	// Moller-Trumbore with the triangle broadcast to every lane.
+	UINT IntersectTriangleSse(RayPacket& rays, const XMFLOAT3& v0, const XMFLOAT3& e1, const XMFLOAT3& e2,
+		UINT triangle, RayPacketHits& hits)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		const __m128 epsilon = _mm_set1_ps(ParallelEpsilon);
+		const __m128 index = _mm_castsi128_ps(_mm_set1_epi32((int)triangle));
+
+		const __m128 e1x = _mm_set1_ps(e1.x);
+		const __m128 e1y = _mm_set1_ps(e1.y);
+		const __m128 e1z = _mm_set1_ps(e1.z);
+		const __m128 e2x = _mm_set1_ps(e2.x);
+		const __m128 e2y = _mm_set1_ps(e2.y);
+		const __m128 e2z = _mm_set1_ps(e2.z);
+
+		UINT mask = 0;
+		for(UINT base = 0; base < RayPacket::Size; base += 4)
+		{
+			__m128 dx = _mm_load_ps(rays.DirX + base);
+			__m128 dy = _mm_load_ps(rays.DirY + base);
+			__m128 dz = _mm_load_ps(rays.DirZ + base);
+
+			// p = dir x e2
+			__m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+			__m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+			__m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+
+			__m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+			__m128 invDet = _mm_div_ps(one, det);
+
+			// s = origin - v0
+			__m128 sx = _mm_sub_ps(_mm_load_ps(rays.OriginX + base), _mm_set1_ps(v0.x));
+			__m128 sy = _mm_sub_ps(_mm_load_ps(rays.OriginY + base), _mm_set1_ps(v0.y));
+			__m128 sz = _mm_sub_ps(_mm_load_ps(rays.OriginZ + base), _mm_set1_ps(v0.z));
+
+			__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), invDet);
+
+			// q = s x e1
+			__m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+			__m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+			__m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+
+			__m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), invDet);
+			__m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), invDet);
+
+			__m128 tMax = _mm_load_ps(rays.TMax + base);
+
+			__m128 hit = _mm_cmpge_ps(_mm_and_ps(det, absMask), epsilon);
+			hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmple_ps(u, one)));
+			hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmple_ps(_mm_add_ps(u, v), one)));
+			hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(t, zero), _mm_cmplt_ps(t, tMax)));
+
+			int laneMask = _mm_movemask_ps(hit);
+			if(laneMask == 0)
+				continue;
+
+			_mm_store_ps(rays.TMax + base, Select(tMax, t, hit));
+			_mm_store_ps(hits.T + base, Select(_mm_load_ps(hits.T + base), t, hit));
+			_mm_store_ps(hits.U + base, Select(_mm_load_ps(hits.U + base), u, hit));
+			_mm_store_ps(hits.V + base, Select(_mm_load_ps(hits.V + base), v, hit));
+
+			float* triangles = (float*)hits.Triangle + base;
+			_mm_store_ps(triangles, Select(_mm_load_ps(triangles), index, hit));
+
+			mask |= (UINT)laneMask << base;
+		}
+
+		return mask;
+	}
+
+	UINT IntersectTriangleAvx(RayPacket& rays, const XMFLOAT3& v0, const XMFLOAT3& e1, const XMFLOAT3& e2,
+		UINT triangle, RayPacketHits& hits)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+		const __m256 e1x = _mm256_set1_ps(e1.x);
+		const __m256 e1y = _mm256_set1_ps(e1.y);
+		const __m256 e1z = _mm256_set1_ps(e1.z);
+		const __m256 e2x = _mm256_set1_ps(e2.x);
+		const __m256 e2y = _mm256_set1_ps(e2.y);
+		const __m256 e2z = _mm256_set1_ps(e2.z);
+
+		__m256 dx = _mm256_load_ps(rays.DirX);
+		__m256 dy = _mm256_load_ps(rays.DirY);
+		__m256 dz = _mm256_load_ps(rays.DirZ);
+
+		// p = dir x e2
+		__m256 px = _mm256_sub_ps(_mm256_mul_ps(dy, e2z), _mm256_mul_ps(dz, e2y));
+		__m256 py = _mm256_sub_ps(_mm256_mul_ps(dz, e2x), _mm256_mul_ps(dx, e2z));
+		__m256 pz = _mm256_sub_ps(_mm256_mul_ps(dx, e2y), _mm256_mul_ps(dy, e2x));
+
+		__m256 det = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, px), _mm256_mul_ps(e1y, py)), _mm256_mul_ps(e1z, pz));
+		__m256 invDet = _mm256_div_ps(one, det);
+
+		// s = origin - v0
+		__m256 sx = _mm256_sub_ps(_mm256_load_ps(rays.OriginX), _mm256_set1_ps(v0.x));
+		__m256 sy = _mm256_sub_ps(_mm256_load_ps(rays.OriginY), _mm256_set1_ps(v0.y));
+		__m256 sz = _mm256_sub_ps(_mm256_load_ps(rays.OriginZ), _mm256_set1_ps(v0.z));
+
+		__m256 u = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sx, px), _mm256_mul_ps(sy, py)), _mm256_mul_ps(sz, pz)), invDet);
+
+		// q = s x e1
+		__m256 qx = _mm256_sub_ps(_mm256_mul_ps(sy, e1z), _mm256_mul_ps(sz, e1y));
+		__m256 qy = _mm256_sub_ps(_mm256_mul_ps(sz, e1x), _mm256_mul_ps(sx, e1z));
+		__m256 qz = _mm256_sub_ps(_mm256_mul_ps(sx, e1y), _mm256_mul_ps(sy, e1x));
+
+		__m256 v = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, qx), _mm256_mul_ps(dy, qy)), _mm256_mul_ps(dz, qz)), invDet);
+		__m256 t = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2x, qx), _mm256_mul_ps(e2y, qy)), _mm256_mul_ps(e2z, qz)), invDet);
+
+		__m256 tMax = _mm256_load_ps(rays.TMax);
+
+		__m256 hit = _mm256_cmp_ps(_mm256_and_ps(det, absMask), _mm256_set1_ps(ParallelEpsilon), _CMP_GE_OQ);
+		hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(u, zero, _CMP_GE_OQ), _mm256_cmp_ps(u, one, _CMP_LE_OQ)));
+		hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(v, zero, _CMP_GE_OQ), _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_LE_OQ)));
+		hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GE_OQ), _mm256_cmp_ps(t, tMax, _CMP_LT_OQ)));
+
+		UINT mask = (UINT)_mm256_movemask_ps(hit);
+		if(mask == 0)
+			return 0;
+
+		_mm256_store_ps(rays.TMax, Select(tMax, t, hit));
+		_mm256_store_ps(hits.T, Select(_mm256_load_ps(hits.T), t, hit));
+		_mm256_store_ps(hits.U, Select(_mm256_load_ps(hits.U), u, hit));
+		_mm256_store_ps(hits.V, Select(_mm256_load_ps(hits.V), v, hit));
+
+		__m256 index = _mm256_castsi256_ps(_mm256_set1_epi32((int)triangle));
+		_mm256_store_ps((float*)hits.Triangle, Select(_mm256_load_ps((float*)hits.Triangle), index, hit));
+
+		return mask;
+	}
+}
+
+RayPacket::RayPacket()
+{
+	for(UINT i = 0; i < Size; ++i)
+	{
+		OriginX[i] = OriginY[i] = OriginZ[i] = 0.0f;
+		DirX[i] = DirY[i] = DirZ[i] = 1.0f;
+		InvDirX[i] = InvDirY[i] = InvDirZ[i] = 1.0f;
+		TMax[i] = -1.0f;
+	}
+}
+
+void XM_CALLCONV RayPacket::SetRay(UINT lane, FXMVECTOR origin, FXMVECTOR dir, float maxT)
+{
+	assert(lane < Size);
+
+	XMFLOAT3 o, d, inv;
+	XMStoreFloat3(&o, origin);
+	XMStoreFloat3(&d, dir);
+	XMStoreFloat3(&inv, XMVectorReciprocal(dir));
+
+	OriginX[lane] = o.x;
+	OriginY[lane] = o.y;
+	OriginZ[lane] = o.z;
+	DirX[lane] = d.x;
+	DirY[lane] = d.y;
+	DirZ[lane] = d.z;
+	InvDirX[lane] = inv.x;
+	InvDirY[lane] = inv.y;
+	InvDirZ[lane] = inv.z;
+	TMax[lane] = maxT;
+}
+
+UINT RayPacket::ActiveMask()const
+{
+	UINT mask = 0;
+	for(UINT i = 0; i < Size; ++i)
+	{
+		if(TMax[i] >= 0.0f)
+			mask |= 1u << i;
+	}
+
+	return mask;
+}
+
+RayPacketHits::RayPacketHits()
+{
+	for(UINT i = 0; i < RayPacket::Size; ++i)
+	{
+		T[i] = FLT_MAX;
+		U[i] = V[i] = 0.0f;
+		Triangle[i] = (UINT)-1;
+	}
+}
+
+UINT RayPacketTests::IntersectBox(const RayPacket& rays, const XMFLOAT3& boxMin, const XMFLOAT3& boxMax, float* tEnter)
+{
+	return UsesAvx() ?
+		IntersectBoxAvx(rays, boxMin, boxMax, tEnter) :
+		IntersectBoxSse(rays, boxMin, boxMax, tEnter);
+}
+
+UINT RayPacketTests::IntersectTriangle(RayPacket& rays, const XMFLOAT3& v0, const XMFLOAT3& edge1,
+	const XMFLOAT3& edge2, UINT triangle, RayPacketHits& hits)
+{
+	return UsesAvx() ?
+		IntersectTriangleAvx(rays, v0, edge1, edge2, triangle, hits) :
+		IntersectTriangleSse(rays, v0, edge1, edge2, triangle, hits);
+}
+
+void RayPacketTests::SetAvxEnabled(bool enabled)
+{
+	gAvxEnabled = enabled;
+}
+
+bool RayPacketTests::UsesAvx()
+{
+	return gAvxEnabled && Culling::HasAvx();
+}
@@ -0,0 +1,83 @@
+//***************************************************************************************
+// RayPacket.h
+//
+// Ray-triangle and ray-box tests on packets of 8 rays at once, the SIMD counterparts
+// of TriangleTests::Intersects and BoundingBox::Intersects.
+//   -RayPacket keeps the rays in structure-of-arrays form, one float per lane, with the
+//    reciprocal direction precomputed for box tests.
+//   -Every test handles the 8 lanes with 256-bit AVX, or as two halves with SSE when
+//    the CPU has no AVX, and returns a bitmask of the lanes that hit.
+//   -TMax is the closest hit so far: IntersectTriangle shortens it for the lanes it
+//    hits, so a packet can be run over many triangles, or down a TriangleBvh with
+//    TriangleBvh::IntersectPacket, and ends up with the closest hit of every ray.
+//   -For line-of-sight checks set TMax to the distance to the target; any lane that
+//    hits a triangle is blocked.
+//***************************************************************************************
+
+#ifndef RAYPACKET_H
+#define RAYPACKET_H
+
+#include "d3dUtil.h"
+
+struct RayPacket
+{
+	static const UINT Size = 8;
+
+	// Fills every lane with an unused ray, which never hits anything.
+	RayPacket();
+
+	// Sets a lane.  dir need not be unit length; distances are in units of it.
+	void XM_CALLCONV SetRay(UINT lane, DirectX::FXMVECTOR origin, DirectX::FXMVECTOR dir,
+		float maxT = FLT_MAX);
+
+	// Bitmask of the lanes holding a ray that can still be hit.
+	UINT ActiveMask()const;
+
+	alignas(32) float OriginX[Size];
+	alignas(32) float OriginY[Size];
+	alignas(32) float OriginZ[Size];
+	alignas(32) float DirX[Size];
+	alignas(32) float DirY[Size];
+	alignas(32) float DirZ[Size];
+	alignas(32) float InvDirX[Size];
+	alignas(32) float InvDirY[Size];
+	alignas(32) float InvDirZ[Size];
+
+	// Hits are accepted with 0 <= t < TMax.  Unused lanes have TMax = -1.
+	alignas(32) float TMax[Size];
+};
+
+struct RayPacketHits
+{
+	RayPacketHits();
+
+	// Per lane, as in TriangleHit: the triangle index passed to the test,
+	// -1 when nothing was hit, the distance and the barycentrics.
+	alignas(32) float T[RayPacket::Size];
+	alignas(32) float U[RayPacket::Size];
+	alignas(32) float V[RayPacket::Size];
+	alignas(32) UINT Triangle[RayPacket::Size];
+};
+
+class RayPacketTests
+{
+public:
+	// Returns the lanes whose ray enters the box with 0 <= t < TMax.  For those
+	// lanes tEnter, if given, receives the distance at which the ray enters the
+	// box, 0 when it starts inside; the other lanes receive FLT_MAX.
+	static UINT IntersectBox(const RayPacket& rays, const DirectX::XMFLOAT3& boxMin,
+		const DirectX::XMFLOAT3& boxMax, float* tEnter = nullptr);
+
+	// Tests the triangle (v0, v0 + edge1, v0 + edge2) from both sides.  For
+	// the lanes that hit it with 0 <= t < TMax, writes the hit to hits under
+	// the given triangle index and sets TMax to t.  Returns those lanes.
+	static UINT IntersectTriangle(RayPacket& rays, const DirectX::XMFLOAT3& v0,
+		const DirectX::XMFLOAT3& edge1, const DirectX::XMFLOAT3& edge2, UINT triangle, RayPacketHits& hits);
+
+	// The tests use AVX when the CPU has it, unless it is turned off here, e.g.
+	// to compare both paths.
+	static void SetAvxEnabled(bool enabled);
+	static bool UsesAvx();
+};
+
+#endif // RAYPACKET_H
@@ -0,0 +1,167 @@
+//***************************************************************************************
+// RenderItemStore.cpp
+//***************************************************************************************
+
+#include "RenderItemStore.h"
+
+using namespace DirectX;
+
+UINT RenderItemStore::Add(const RenderItemDesc& desc)
+{
+	assert(desc.Mat != nullptr && desc.Geo != nullptr);
+
+	UINT handle;
+	if(!mFreeHandles.empty())
+	{
+		handle = mFreeHandles.back();
+		mFreeHandles.pop_back();
+	}
+	else
+	{
+		handle = (UINT)mSlots.size();
+		mSlots.resize(handle + 1);
+	}
+
+	mSlots[handle] = (UINT)mHandles.size();
+
+	RenderItemMaterial material;
+	material.MatCBIndex = (UINT)desc.Mat->MatCBIndex;
+	material.DiffuseSrvHeapIndex = (UINT)desc.Mat->DiffuseSrvHeapIndex;
+
+	RenderItemDrawArgs drawArgs;
+	drawArgs.Geo = desc.Geo;
+	drawArgs.PrimitiveType = desc.PrimitiveType;
+	drawArgs.IndexCount = desc.IndexCount;
+	drawArgs.StartIndexLocation = desc.StartIndexLocation;
+	drawArgs.BaseVertexLocation = desc.BaseVertexLocation;
+
+	mHandles.push_back(handle);
+	mWorld.push_back(desc.World);
+	mTexTransform.push_back(desc.TexTransform);
+	mMaterials.push_back(material);
+	mDrawArgs.push_back(drawArgs);
+	mLocalBounds.push_back(desc.Bounds);
+	mLayers.push_back((UINT8)desc.Layer);
+	mVisible.push_back(1);
+
+	mDirty.MarkDirty(handle);
+
+	return handle;
+}
+
+void RenderItemStore::Remove(UINT handle)
+{
+	UINT slot = GetSlot(handle);
+	UINT last = (UINT)mHandles.size() - 1;
+
+	// Move the last item into the hole.
+	if(slot != last)
+	{
+		mHandles[slot] = mHandles[last];
+		mWorld[slot] = mWorld[last];
+		mTexTransform[slot] = mTexTransform[last];
+		mMaterials[slot] = mMaterials[last];
+		mDrawArgs[slot] = mDrawArgs[last];
+		mLocalBounds[slot] = mLocalBounds[last];
+		mLayers[slot] = mLayers[last];
+		mVisible[slot] = mVisible[last];
+
+		mSlots[mHandles[slot]] = slot;
+	}
+
+	mHandles.pop_back();
+	mWorld.pop_back();
+	mTexTransform.pop_back();
+	mMaterials.pop_back();
+	mDrawArgs.pop_back();
+	mLocalBounds.pop_back();
+	mLayers.pop_back();
+	mVisible.pop_back();
+
+	mSlots[handle] = InvalidHandle;
+	mFreeHandles.push_back(handle);
+}
+
+void RenderItemStore::Clear()
+{
+	mHandles.clear();
+	mWorld.clear();
+	mTexTransform.clear();
+	mMaterials.clear();
+	mDrawArgs.clear();
+	mLocalBounds.clear();
+	mLayers.clear();
+	mVisible.clear();
+
+	mSlots.clear();
+	mFreeHandles.clear();
+
+	mDirty.Clear();
+}
+
+void RenderItemStore::Reserve(UINT count)
+{
+	mHandles.reserve(count);
+	mWorld.reserve(count);
+	mTexTransform.reserve(count);
+	mMaterials.reserve(count);
+	mDrawArgs.reserve(count);
+	mLocalBounds.reserve(count);
+	mLayers.reserve(count);
+	mVisible.reserve(count);
+
+	mSlots.reserve(count);
+}
+
+UINT RenderItemStore::Size()const
+{
+	return (UINT)mHandles.size();
+}
+
+UINT RenderItemStore::Capacity()const
+{
+	return (UINT)mSlots.size();
+}
+
+UINT RenderItemStore::GetSlot(UINT handle)const
+{
+	assert(handle < mSlots.size() && mSlots[handle] != InvalidHandle);
+
+	return mSlots[handle];
+}
+
+void RenderItemStore::SetWorld(UINT handle, const XMFLOAT4X4& world)
+{
+	UINT slot = GetSlot(handle);
+	mWorld[slot] = world;
+	mDirty.MarkDirty(handle);
+}
+
+void RenderItemStore::SetTexTransform(UINT handle, const XMFLOAT4X4& texTransform)
+{
+	UINT slot = GetSlot(handle);
+	mTexTransform[slot] = texTransform;
+	mDirty.MarkDirty(handle);
+}
+
+void RenderItemStore::SetMaterial(UINT handle, const Material* mat)
+{
+	UINT slot = GetSlot(handle);
+	mMaterials[slot].MatCBIndex = (UINT)mat->MatCBIndex;
+	mMaterials[slot].DiffuseSrvHeapIndex = (UINT)mat->DiffuseSrvHeapIndex;
+}
+
+void RenderItemStore::SetVisible(UINT handle, bool visible)
+{
+	mVisible[GetSlot(handle)] = visible ? 1 : 0;
+}
+
+const XMFLOAT4X4& RenderItemStore::GetWorld(UINT handle)const
+{
+	return mWorld[GetSlot(handle)];
+}
+
+const RenderItemDrawArgs& RenderItemStore::GetDrawArgs(UINT handle)const
+{
+	return mDrawArgs[GetSlot(handle)];
+}
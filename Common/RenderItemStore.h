@@ -0,0 +1,150 @@
+//***************************************************************************************
+// RenderItemStore.h
+//
+// Render items in structure-of-arrays form, addressed by stable handles, in place of a
+// vector of separately allocated RenderItem structs.
+//   -Each property has its own array: world and texture transforms, material indices,
+//    draw arguments, local bounds, layer and visibility.  A loop that only needs the
+//    transforms or only the draw arguments reads nothing else.
+//   -The arrays are dense.  The live items sit in slots [0, Size()), so the update and
+//    draw loops walk memory front to back; removing an item moves the last one into
+//    its slot.
+//   -A handle stays with its item however its slot moves, and is only reused once the
+//    item is removed.  It is also the item's index in the object constant buffer, so
+//    that buffer needs room for Capacity() items.
+//   -Adding an item or changing its transforms queues its handle on a DirtyTracker,
+//    so updating the object constants only visits the items that changed.
+//***************************************************************************************
+
+#ifndef RENDERITEMSTORE_H
+#define RENDERITEMSTORE_H
+
+#include "DirtyTracker.h"
+
+// What DrawRenderItems reads of a material.
+struct RenderItemMaterial
+{
+	UINT MatCBIndex = 0;
+	UINT DiffuseSrvHeapIndex = 0;
+};
+
+// DrawIndexedInstanced parameters and the buffers they index.
+struct RenderItemDrawArgs
+{
+	MeshGeometry* Geo = nullptr;
+	D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	UINT IndexCount = 0;
+	UINT StartIndexLocation = 0;
+	int BaseVertexLocation = 0;
+};
+
+// Everything Add needs to know of a new item, with the fields of the old
+// RenderItem.
+struct RenderItemDesc
+{
+	// Bounds of the drawn submesh in local space.
+	DirectX::BoundingBox Bounds;
+
+	DirectX::XMFLOAT4X4 World = MathHelper::Identity4x4();
+	DirectX::XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
+
+	Material* Mat = nullptr;
+	MeshGeometry* Geo = nullptr;
+
+	D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	UINT IndexCount = 0;
+	UINT StartIndexLocation = 0;
+	int BaseVertexLocation = 0;
+
+	// The app's render layer, e.g. the PSO to draw with.
+	UINT Layer = 0;
+};
+
+class RenderItemStore
+{
+public:
+	// Handle of no item.
+	static const UINT InvalidHandle = 0xffffffff;
+
+	RenderItemStore() = default;
+	RenderItemStore(const RenderItemStore& rhs) = delete;
+	RenderItemStore& operator=(const RenderItemStore& rhs) = delete;
+	~RenderItemStore() = default;
+
+	// Adds an item, dirty for every frame resource, and returns its handle.
+	UINT Add(const RenderItemDesc& desc);
+
+	void Remove(UINT handle);
+	void Clear();
+
+	// Makes room for count items.
+	void Reserve(UINT count);
+
+	// Number of items, and one past the largest handle given out so far.
+	UINT Size()const;
+	UINT Capacity()const;
+
+	// Slot of the item with the given handle.
+	UINT GetSlot(UINT handle)const;
+
+	// Changing a transform marks the item dirty for every frame resource.
+	void SetWorld(UINT handle, const DirectX::XMFLOAT4X4& world);
+	void SetTexTransform(UINT handle, const DirectX::XMFLOAT4X4& texTransform);
+	void SetMaterial(UINT handle, const Material* mat);
+	void SetVisible(UINT handle, bool visible);
+
+	const DirectX::XMFLOAT4X4& GetWorld(UINT handle)const;
+	const RenderItemDrawArgs& GetDrawArgs(UINT handle)const;
+
+	// Calls write(handle, world, texTransform) for every item changed in the
+	// last gNumFrameResources frames, for the current frame resource, and
+	// returns how many items were written.  Call it once per frame.
+	template<typename WriteConstants>
+	UINT UpdateDirty(WriteConstants write, DirtyStats* stats = nullptr);
+
+	// The arrays, indexed by slot.
+	const UINT* Handles()const { return mHandles.data(); }
+	const DirectX::XMFLOAT4X4* World()const { return mWorld.data(); }
+	const DirectX::XMFLOAT4X4* TexTransform()const { return mTexTransform.data(); }
+	const RenderItemMaterial* Materials()const { return mMaterials.data(); }
+	const RenderItemDrawArgs* DrawArgs()const { return mDrawArgs.data(); }
+	const DirectX::BoundingBox* LocalBounds()const { return mLocalBounds.data(); }
+	const UINT8* Layers()const { return mLayers.data(); }
+	const UINT8* Visible()const { return mVisible.data(); }
+	UINT8* Visible() { return mVisible.data(); }
+
+private:
+	// By slot.
+	std::vector<UINT> mHandles;
+	std::vector<DirectX::XMFLOAT4X4> mWorld;
+	std::vector<DirectX::XMFLOAT4X4> mTexTransform;
+	std::vector<RenderItemMaterial> mMaterials;
+	std::vector<RenderItemDrawArgs> mDrawArgs;
+	std::vector<DirectX::BoundingBox> mLocalBounds;
+	std::vector<UINT8> mLayers;
+	std::vector<UINT8> mVisible;
+
+	// By handle; InvalidHandle for handles not in use.
+	std::vector<UINT> mSlots;
+
+	std::vector<UINT> mFreeHandles;
+
+	DirtyTracker mDirty;
+};
+
+template<typename WriteConstants>
+UINT RenderItemStore::UpdateDirty(WriteConstants write, DirtyStats* stats)
+{
+	return mDirty.Update([this, &write](UINT handle)
+	{
+		// Removed since it was marked.
+		if(mSlots[handle] == InvalidHandle)
+			return false;
+
+		UINT slot = mSlots[handle];
+		write(handle, mWorld[slot], mTexTransform[slot]);
+		return true;
+	}, stats);
+}
+
+#endif // RENDERITEMSTORE_H
@@ -0,0 +1,323 @@
+//***************************************************************************************
+// SceneBvh.cpp
+//***************************************************************************************
+
+#include "SceneBvh.h"
+#include "BvhBuild.h"
+
+using namespace DirectX;
+
+UINT XM_CALLCONV SceneBvh::AddInstance(const TriangleBvh* mesh, FXMMATRIX world)
+{
+	assert(mesh != nullptr);
+
+	Instance instance;
+	instance.Mesh = mesh;
+	UpdateInstance(instance, world);
+
+	mInstances.push_back(instance);
+	return (UINT)mInstances.size() - 1;
+}
+
+void XM_CALLCONV SceneBvh::SetWorld(UINT instance, FXMMATRIX world)
+{
+	UpdateInstance(mInstances[instance], world);
+}
+
+void SceneBvh::SetEnabled(UINT instance, bool enabled)
+{
+	mInstances[instance].Enabled = enabled;
+}
+
+void XM_CALLCONV SceneBvh::UpdateInstance(Instance& instance, FXMMATRIX world)
+{
+	XMVECTOR det = XMMatrixDeterminant(world);
+	XMStoreFloat4x4(&instance.World, world);
+	XMStoreFloat4x4(&instance.InvWorld, XMMatrixInverse(&det, world));
+
+	// Box around the eight transformed corners of the mesh box.
+	BoundingBox worldBounds;
+	instance.Mesh->GetBounds().Transform(worldBounds, world);
+
+	XMVECTOR center = XMLoadFloat3(&worldBounds.Center);
+	XMVECTOR extents = XMLoadFloat3(&worldBounds.Extents);
+	XMStoreFloat3(&instance.Min, center - extents);
+	XMStoreFloat3(&instance.Max, center + extents);
+}
+
+void SceneBvh::Build()
+{
+	UINT instanceCount = (UINT)mInstances.size();
+
+	mIndices.resize(instanceCount);
+	for(UINT i = 0; i < instanceCount; ++i)
+		mIndices[i] = i;
+
+	mNodes.clear();
+	mNodes.reserve(2*instanceCount);
+	mDepth = 0;
+
+	if(instanceCount > 0)
+		BuildNode(0, instanceCount, 1);
+}
+
+UINT SceneBvh::BuildNode(UINT first, UINT count, UINT depth)
+{
+	mDepth = MathHelper::Max(mDepth, depth);
+
+	auto center = [&](UINT index)
+	{
+		const Instance& instance = mInstances[index];
+		return XMFLOAT3(0.5f*(instance.Min.x + instance.Max.x),
+			0.5f*(instance.Min.y + instance.Max.y),
+			0.5f*(instance.Min.z + instance.Max.z));
+	};
+
+	BvhBuild::Aabb box;
+	BvhBuild::Aabb centroidBounds;
+	for(UINT i = first; i < first + count; ++i)
+	{
+		const Instance& instance = mInstances[mIndices[i]];
+		XMFLOAT3 c = center(mIndices[i]);
+		box.Grow(instance.Min, instance.Max);
+		centroidBounds.Grow(c, c);
+	}
+
+	UINT nodeIndex = (UINT)mNodes.size();
+	mNodes.push_back(Node());
+	mNodes[nodeIndex].Min = box.Min;
+	mNodes[nodeIndex].Max = box.Max;
+
+	if(count <= MaxLeafSize)
+	{
+		mNodes[nodeIndex].FirstOrRight = first;
+		mNodes[nodeIndex].Count = count;
+		return nodeIndex;
+	}
+
+	UINT leftCount = BvhBuild::Split(mIndices.begin() + first, count, centroidBounds, depth, center,
+		[&](BvhBuild::Aabb& bounds, UINT index) { bounds.Grow(mInstances[index].Min, mInstances[index].Max); });
+
+	// The left subtree is built first so it directly follows this node.
+	BuildNode(first, leftCount, depth + 1);
+	UINT rightIndex = BuildNode(first + leftCount, count - leftCount, depth + 1);
+	mNodes[nodeIndex].FirstOrRight = rightIndex;
+
+	return nodeIndex;
+}
+
+void SceneBvh::Refit()
+{
+	// Children always come after their parent, so walking the nodes backwards
+	// visits both children before the node itself.
+	for(UINT i = (UINT)mNodes.size(); i-- > 0; )
+	{
+		Node& node = mNodes[i];
+
+		BvhBuild::Aabb box;
+		if(node.Count > 0)
+		{
+			for(UINT j = node.FirstOrRight; j < node.FirstOrRight + node.Count; ++j)
+				box.Grow(mInstances[mIndices[j]].Min, mInstances[mIndices[j]].Max);
+		}
+		else
+		{
+			box.Grow(mNodes[i + 1].Min, mNodes[i + 1].Max);
+			box.Grow(mNodes[node.FirstOrRight].Min, mNodes[node.FirstOrRight].Max);
+		}
+
+		node.Min = box.Min;
+		node.Max = box.Max;
+	}
+}
+
+void SceneBvh::Clear()
+{
+	mNodes.clear();
+	mIndices.clear();
+	mInstances.clear();
+	mDepth = 0;
+}
+
+bool XM_CALLCONV SceneBvh::Intersect(FXMVECTOR origin, FXMVECTOR dir, SceneHit& hit,
+	float maxT, SceneRayStats* stats)const
+{
+	SceneRayStats localStats;
+	hit = SceneHit();
+
+	if(mNodes.empty())
+	{
+		if(stats != nullptr)
+			*stats = localStats;
+		return false;
+	}
+
+	XMVECTOR invDir = XMVectorReciprocal(dir);
+	float closest = maxT;
+
+	struct StackEntry
+	{
+		UINT Node;
+		float Enter;
+	};
+
+	StackEntry stack[BvhBuild::MaxStackSize];
+	UINT stackSize = 0;
+
+	float rootEnter = BvhBuild::EnterBox(origin, invDir, mNodes[0].Min, mNodes[0].Max, closest);
+	if(rootEnter != FLT_MAX)
+		stack[stackSize++] = { 0, rootEnter };
+
+	while(stackSize > 0)
+	{
+		StackEntry entry = stack[--stackSize];
+
+		// A closer hit was found after this node was pushed.
+		if(entry.Enter >= closest)
+			continue;
+
+		const Node& node = mNodes[entry.Node];
+		localStats.NodesVisited++;
+
+		if(node.Count > 0)
+		{
+			for(UINT i = node.FirstOrRight; i < node.FirstOrRight + node.Count; ++i)
+			{
+				UINT index = mIndices[i];
+				const Instance& instance = mInstances[index];
+
+				if(!instance.Enabled ||
+					BvhBuild::EnterBox(origin, invDir, instance.Min, instance.Max, closest) == FLT_MAX)
+					continue;
+
+				// The ray in the instance's local space.  Affine transforms keep
+				// t, so closest also bounds the local query.
+				XMMATRIX invWorld = XMLoadFloat4x4(&instance.InvWorld);
+				XMVECTOR localOrigin = XMVector3TransformCoord(origin, invWorld);
+				XMVECTOR localDir = XMVector3TransformNormal(dir, invWorld);
+
+				TriangleHit meshHit;
+				RayQueryStats meshStats;
+				bool meshHitFound = instance.Mesh->Intersect(localOrigin, localDir, meshHit, closest, &meshStats);
+
+				localStats.InstancesTested++;
+				localStats.MeshNodesVisited += meshStats.NodesVisited;
+				localStats.TrianglesTested += meshStats.TrianglesTested;
+
+				if(meshHitFound)
+				{
+					closest = meshHit.T;
+					hit.Instance = index;
+					hit.Triangle = meshHit.Triangle;
+					hit.T = meshHit.T;
+					hit.U = meshHit.U;
+					hit.V = meshHit.V;
+				}
+			}
+
+			continue;
+		}
+
+		// Push the farther child first so the nearer one is visited next.
+		UINT leftIndex = entry.Node + 1;
+		UINT rightIndex = node.FirstOrRight;
+		float leftEnter = BvhBuild::EnterBox(origin, invDir, mNodes[leftIndex].Min, mNodes[leftIndex].Max, closest);
+		float rightEnter = BvhBuild::EnterBox(origin, invDir, mNodes[rightIndex].Min, mNodes[rightIndex].Max, closest);
+
+		if(leftEnter > rightEnter)
+		{
+			std::swap(leftEnter, rightEnter);
+			std::swap(leftIndex, rightIndex);
+		}
+
+		assert(stackSize + 2 <= BvhBuild::MaxStackSize);
+		if(rightEnter != FLT_MAX)
+			stack[stackSize++] = { rightIndex, rightEnter };
+		if(leftEnter != FLT_MAX)
+			stack[stackSize++] = { leftIndex, leftEnter };
+	}
+
+	if(stats != nullptr)
+		*stats = localStats;
+
+	return hit.Instance != (UINT)-1;
+}
+
+UINT SceneBvh::OverlapBox(const XMFLOAT3& boxMin, const XMFLOAT3& boxMax, std::vector<UINT>& instances)const
+{
+	if(mNodes.empty())
+		return 0;
+
+	auto overlaps = [&](const XMFLOAT3& nodeMin, const XMFLOAT3& nodeMax)
+	{
+		return nodeMin.x <= boxMax.x && nodeMax.x >= boxMin.x &&
+			nodeMin.y <= boxMax.y && nodeMax.y >= boxMin.y &&
+			nodeMin.z <= boxMax.z && nodeMax.z >= boxMin.z;
+	};
+
+	UINT stack[BvhBuild::MaxStackSize];
+	UINT stackSize = 0;
+	UINT count = 0;
+
+	if(overlaps(mNodes[0].Min, mNodes[0].Max))
+		stack[stackSize++] = 0;
+
+	while(stackSize > 0)
+	{
+		UINT nodeIndex = stack[--stackSize];
+		const Node& node = mNodes[nodeIndex];
+
+		if(node.Count > 0)
+		{
+			for(UINT i = node.FirstOrRight; i < node.FirstOrRight + node.Count; ++i)
+			{
+				const Instance& instance = mInstances[mIndices[i]];
+				if(instance.Enabled && overlaps(instance.Min, instance.Max))
+				{
+					instances.push_back(mIndices[i]);
+					++count;
+				}
+			}
+
+			continue;
+		}
+
+		assert(stackSize + 2 <= BvhBuild::MaxStackSize);
+		if(overlaps(mNodes[node.FirstOrRight].Min, mNodes[node.FirstOrRight].Max))
+			stack[stackSize++] = node.FirstOrRight;
+		if(overlaps(mNodes[nodeIndex + 1].Min, mNodes[nodeIndex + 1].Max))
+			stack[stackSize++] = nodeIndex + 1;
+	}
+
+	return count;
+}
+
+const TriangleBvh* SceneBvh::GetMesh(UINT instance)const
+{
+	return mInstances[instance].Mesh;
+}
+
+XMMATRIX SceneBvh::GetWorld(UINT instance)const
+{
+	return XMLoadFloat4x4(&mInstances[instance].World);
+}
+
+XMMATRIX SceneBvh::GetInvWorld(UINT instance)const
+{
+	return XMLoadFloat4x4(&mInstances[instance].InvWorld);
+}
+
+UINT SceneBvh::InstanceCount()const
+{
+	return (UINT)mInstances.size();
+}
+
+UINT SceneBvh::NodeCount()const
+{
+	return (UINT)mNodes.size();
+}
+
+UINT SceneBvh::Depth()const
+{
+	return mDepth;
+}
@@ -0,0 +1,140 @@
+//***************************************************************************************
+// SceneBvh.h
+//
+// Two-level hierarchy for ray queries across a scene of mesh instances.
+//   -The top level is a bounding volume hierarchy over the world-space boxes of the
+//    instances.  Each instance references the TriangleBvh of its mesh, which is shared
+//    by every instance drawing that mesh, and keeps the inverse of its world matrix.
+//   -Intersect walks the top level nearest first.  For each instance the ray reaches
+//    it transforms the world ray into the instance's local space and queries the
+//    instance's TriangleBvh.  The local direction is not renormalized, so a distance
+//    t means the same point in both spaces and hits of different instances compare
+//    directly.
+//   -SetWorld moves an instance and Refit recomputes the top-level boxes, keeping the
+//    tree.  Build again when instances were added or moved far.
+//   -OverlapBox finds the instances whose world box overlaps a box, for collision
+//    queries that then look at the triangles of each.
+//***************************************************************************************
+
+#ifndef SCENEBVH_H
+#define SCENEBVH_H
+
+#include "TriangleBvh.h"
+
+struct SceneHit
+{
+	// Instance index returned by AddInstance, and triangle in its mesh.  Both
+	// -1 when nothing was hit.
+	UINT Instance = -1;
+	UINT Triangle = -1;
+
+	// Distance along the world ray in units of its direction, and the
+	// barycentric coordinates of the hit in the triangle.
+	float T = FLT_MAX;
+	float U = 0.0f;
+	float V = 0.0f;
+};
+
+struct SceneRayStats
+{
+	UINT NodesVisited = 0;
+
+	// Instances whose mesh hierarchy was queried.
+	UINT InstancesTested = 0;
+
+	// Summed over the mesh hierarchies of those instances.
+	UINT MeshNodesVisited = 0;
+	UINT TrianglesTested = 0;
+};
+
+class SceneBvh
+{
+public:
+	// Leaves hold at most this many instances.
+	static const UINT MaxLeafSize = 2;
+
+	// Copies share the mesh hierarchies, so a copy is a cheap snapshot of the
+	// instance transforms, e.g. for queries on another thread.
+	SceneBvh() = default;
+	SceneBvh(const SceneBvh& rhs) = default;
+	SceneBvh& operator=(const SceneBvh& rhs) = default;
+	~SceneBvh() = default;
+
+	// Adds an instance of a mesh and returns its index.  The mesh must stay
+	// alive as long as the scene.  Takes effect at the next Build.
+	UINT XM_CALLCONV AddInstance(const TriangleBvh* mesh, DirectX::FXMMATRIX world);
+
+	// Moves an instance.  Takes effect at the next Refit or Build.
+	void XM_CALLCONV SetWorld(UINT instance, DirectX::FXMMATRIX world);
+
+	// Disabled instances are never hit, e.g. while their render item is hidden.
+	void SetEnabled(UINT instance, bool enabled);
+
+	void Build();
+
+	// Recomputes every node box from the current instance boxes.
+	void Refit();
+
+	// Removes every instance.
+	void Clear();
+
+	// Finds the closest hit with 0 <= t < maxT of a world-space ray over every
+	// enabled instance.  dir need not be unit length.
+	bool XM_CALLCONV Intersect(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR dir, SceneHit& hit,
+		float maxT = FLT_MAX, SceneRayStats* stats = nullptr)const;
+
+	// Appends the enabled instances whose world box overlaps the world box
+	// [boxMin, boxMax] to instances, and returns how many there are.
+	UINT OverlapBox(const DirectX::XMFLOAT3& boxMin, const DirectX::XMFLOAT3& boxMax,
+		std::vector<UINT>& instances)const;
+
+	const TriangleBvh* GetMesh(UINT instance)const;
+	DirectX::XMMATRIX GetWorld(UINT instance)const;
+	DirectX::XMMATRIX GetInvWorld(UINT instance)const;
+
+	UINT InstanceCount()const;
+	UINT NodeCount()const;
+	UINT Depth()const;
+
+private:
+	struct Node
+	{
+		DirectX::XMFLOAT3 Min;
+
+		// Leaves: first entry in mIndices.  Others: the right child.
+		UINT FirstOrRight = 0;
+
+		DirectX::XMFLOAT3 Max;
+
+		// Instances in the leaf, 0 for interior nodes.
+		UINT Count = 0;
+	};
+
+	struct Instance
+	{
+		DirectX::XMFLOAT4X4 World;
+		DirectX::XMFLOAT4X4 InvWorld;
+
+		// Mesh bounds transformed to world space.
+		DirectX::XMFLOAT3 Min;
+		DirectX::XMFLOAT3 Max;
+
+		const TriangleBvh* Mesh = nullptr;
+		bool Enabled = true;
+	};
+
+	void XM_CALLCONV UpdateInstance(Instance& instance, DirectX::FXMMATRIX world);
+
+	// Builds the subtree over mIndices [first, first + count) and returns
+	// its root.
+	UINT BuildNode(UINT first, UINT count, UINT depth);
+
+private:
+	std::vector<Node> mNodes;
+	std::vector<UINT> mIndices;
+	std::vector<Instance> mInstances;
+
+	UINT mDepth = 0;
+};
+
+#endif // SCENEBVH_H
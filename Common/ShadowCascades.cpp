@@ -0,0 +1,171 @@
+//***************************************************************************************
+// ShadowCascades.cpp
+//***************************************************************************************
+
+#include "ShadowCascades.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// Tiles in a row of the shadow map.
+	const UINT TilesAcross = 2;
+}
+
+void XM_CALLCONV ShadowCascades::Build(const Camera& camera, FXMVECTOR lightDir,
+	const BoundingSphere& sceneBounds, UINT cascadeCount, UINT tileSize)
+{
+	assert(cascadeCount >= 1 && cascadeCount <= MaxCascades);
+	assert(tileSize > 2*BorderTexels);
+
+	mCascadeCount = cascadeCount;
+
+	XMVECTOR eye = camera.GetPosition();
+	XMVECTOR look = camera.GetLook();
+	XMVECTOR sceneCenter = XMLoadFloat3(&sceneBounds.Center);
+
+	// Past the far side of the scene there is nothing to shadow.  The distance
+	// is rounded up to eighths of an octave, since every change of it resizes
+	// the cascades and makes the shadows crawl for a frame.
+	float nearZ = camera.GetNearZ();
+	float farZ = XMVectorGetX(XMVector3Length(sceneCenter - eye)) + sceneBounds.Radius;
+	farZ = nearZ*exp2f(ceilf(8.0f*log2f(MathHelper::Max(farZ / nearZ, 2.0f))) / 8.0f);
+	farZ = MathHelper::Min(farZ, camera.GetFarZ());
+
+	// Squared distance from the axis of a corner of the frustum at depth 1.
+	float tanY = tanf(0.5f*camera.GetFovY());
+	float tanX = tanY*camera.GetAspect();
+	float cornerSq = tanX*tanX + tanY*tanY;
+
+	// The light space axes only depend on the light, so a point of the world
+	// lands on the same texel whatever the camera does.
+	XMVECTOR up = fabsf(XMVectorGetY(lightDir)) < 0.99f ?
+		XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f) : XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+	XMMATRIX lightView = XMMatrixLookToLH(XMVectorZero(), lightDir, up);
+
+	XMFLOAT3 sceneCenterLS;
+	XMStoreFloat3(&sceneCenterLS, XMVector3TransformCoord(sceneCenter, lightView));
+
+	UINT mapWidth = MapWidth(cascadeCount, tileSize);
+	UINT mapHeight = MapHeight(cascadeCount, tileSize);
+
+	float splitNear = nearZ;
+	for(UINT i = 0; i < cascadeCount; ++i)
+	{
+		ShadowCascade& cascade = mCascades[i];
+
+		float fraction = (float)(i + 1) / cascadeCount;
+		float logSplit = nearZ*powf(farZ / nearZ, fraction);
+		float uniformSplit = nearZ + (farZ - nearZ)*fraction;
+		float splitFar = SplitLambda*logSplit + (1.0f - SplitLambda)*uniformSplit;
+
+		// Smallest sphere through the corners of the slice, centered on the
+		// axis.  It only depends on the depths and the lens.
+		float centerZ = 0.5f*(splitNear + splitFar)*(1.0f + cornerSq);
+		float radius;
+		if(centerZ < splitFar)
+		{
+			float dz = splitFar - centerZ;
+			radius = sqrtf(dz*dz + splitFar*splitFar*cornerSq);
+		}
+		else
+		{
+			centerZ = splitFar;
+			radius = splitFar*sqrtf(cornerSq);
+		}
+
+		// Round the radius up so rounding errors do not change the texel size
+		// from one frame to the next.
+		radius = ceilf(16.0f*radius) / 16.0f;
+
+		XMVECTOR center = eye + centerZ*look;
+
+		// The sphere fills the tile but its border, and the center moves in
+		// whole texels.
+		float halfWidth = radius*tileSize / (float)(tileSize - 2*BorderTexels);
+		float texelSize = 2.0f*halfWidth / tileSize;
+
+		XMFLOAT3 centerLS;
+		XMStoreFloat3(&centerLS, XMVector3TransformCoord(center, lightView));
+		centerLS.x = floorf(centerLS.x / texelSize + 0.5f)*texelSize;
+		centerLS.y = floorf(centerLS.y / texelSize + 0.5f)*texelSize;
+
+		float n = MathHelper::Min(centerLS.z - radius, sceneCenterLS.z - sceneBounds.Radius);
+		float f = centerLS.z + radius;
+
+		XMMATRIX lightProj = XMMatrixOrthographicOffCenterLH(
+			centerLS.x - halfWidth, centerLS.x + halfWidth,
+			centerLS.y - halfWidth, centerLS.y + halfWidth, n, f);
+
+		cascade.TileX = (i % TilesAcross)*tileSize;
+		cascade.TileY = (i / TilesAcross)*tileSize;
+
+		// Transform NDC space [-1,+1]^2 to the cascade's tile of the shadow map.
+		float scaleX = (float)tileSize / mapWidth;
+		float scaleY = (float)tileSize / mapHeight;
+		float offsetX = (float)cascade.TileX / mapWidth;
+		float offsetY = (float)cascade.TileY / mapHeight;
+		XMMATRIX T(
+			0.5f*scaleX, 0.0f, 0.0f, 0.0f,
+			0.0f, -0.5f*scaleY, 0.0f, 0.0f,
+			0.0f, 0.0f, 1.0f, 0.0f,
+			0.5f*scaleX + offsetX, 0.5f*scaleY + offsetY, 0.0f, 1.0f);
+
+		XMStoreFloat4x4(&cascade.View, lightView);
+		XMStoreFloat4x4(&cascade.Proj, lightProj);
+		XMStoreFloat4x4(&cascade.ShadowTransform, lightView*lightProj*T);
+		cascade.SplitNear = splitNear;
+		cascade.SplitFar = splitFar;
+		XMStoreFloat3(&cascade.Center, center);
+		cascade.Radius = radius;
+		cascade.NearZ = n;
+		cascade.FarZ = f;
+
+		splitNear = splitFar;
+	}
+}
+
+void ShadowCascades::SetDepthRange(UINT index, float nearZ, float farZ)
+{
+	assert(index < mCascadeCount);
+	assert(farZ > nearZ);
+
+	ShadowCascade& cascade = mCascades[index];
+
+	// An orthographic projection maps light space z to (z - n)/(f - n), and
+	// T leaves depth alone, so only the z columns change.
+	float depthScale = 1.0f / (farZ - nearZ);
+	float depthOffset = -nearZ*depthScale;
+
+	cascade.Proj(2, 2) = depthScale;
+	cascade.Proj(3, 2) = depthOffset;
+
+	for(int row = 0; row < 4; ++row)
+		cascade.ShadowTransform(row, 2) = cascade.View(row, 2)*depthScale;
+	cascade.ShadowTransform(3, 2) += depthOffset;
+
+	cascade.NearZ = nearZ;
+	cascade.FarZ = farZ;
+}
+
+UINT ShadowCascades::CascadeCount()const
+{
+	return mCascadeCount;
+}
+
+const ShadowCascade& ShadowCascades::GetCascade(UINT index)const
+{
+	assert(index < mCascadeCount);
+
+	return mCascades[index];
+}
+
+UINT ShadowCascades::MapWidth(UINT cascadeCount, UINT tileSize)
+{
+	return MathHelper::Min(cascadeCount, TilesAcross)*tileSize;
+}
+
+UINT ShadowCascades::MapHeight(UINT cascadeCount, UINT tileSize)
+{
+	return ((cascadeCount + TilesAcross - 1) / TilesAcross)*tileSize;
+}
@@ -0,0 +1,92 @@
+//***************************************************************************************
+// ShadowCascades.h
+//
+// Cascaded shadow maps for one directional light, fitted to the camera each frame.
+//   -The camera frustum is cut into slices along its depth.  The split depths blend a
+//    logarithmic and a uniform distribution, so nearby slices are short and get as
+//    many shadow map texels as the far ones.
+//   -Each slice is enclosed in a sphere whose radius depends only on the split depths
+//    and the lens, so it does not change as the camera turns.  The light projection
+//    covers the sphere and its center is snapped to whole texels in light space, so
+//    the shadow map texels stay fixed in the world while the camera moves and the
+//    shadow edges do not shimmer.
+//   -The cascades share one shadow map as tiles of a grid, two tiles across.  Each
+//    ShadowTransform maps world space straight to the cascade's tile.
+//   -Depth ranges reach back to the scene bounds, so casters between the light and a
+//    slice are drawn even when they are outside the slice's sphere.
+//***************************************************************************************
+
+#ifndef SHADOWCASCADES_H
+#define SHADOWCASCADES_H
+
+#include "Camera.h"
+
+struct ShadowCascade
+{
+	// Light view and orthographic projection to draw the cascade with.
+	DirectX::XMFLOAT4X4 View = MathHelper::Identity4x4();
+	DirectX::XMFLOAT4X4 Proj = MathHelper::Identity4x4();
+
+	// World space to shadow map texture coordinates and depth.
+	DirectX::XMFLOAT4X4 ShadowTransform = MathHelper::Identity4x4();
+
+	// Camera view space depths the cascade covers.
+	float SplitNear = 0.0f;
+	float SplitFar = 0.0f;
+
+	// Sphere around the slice in world space.
+	DirectX::XMFLOAT3 Center = { 0.0f, 0.0f, 0.0f };
+	float Radius = 0.0f;
+
+	// Depth range of Proj in light space.
+	float NearZ = 0.0f;
+	float FarZ = 0.0f;
+
+	// Top left corner of the cascade's tile in the shadow map, in texels.
+	UINT TileX = 0;
+	UINT TileY = 0;
+};
+
+class ShadowCascades
+{
+public:
+	// Most cascades, matching the shadow transforms in the pass constants.
+	static const UINT MaxCascades = 4;
+
+	ShadowCascades() = default;
+	ShadowCascades(const ShadowCascades& rhs) = delete;
+	ShadowCascades& operator=(const ShadowCascades& rhs) = delete;
+	~ShadowCascades() = default;
+
+	// 1 places the splits logarithmically, 0 uniformly.
+	float SplitLambda = 0.75f;
+
+	// Texels left around the sphere at the edges of each tile, so filtering
+	// the shadow map does not read the neighbouring tiles.
+	UINT BorderTexels = 2;
+
+	// Splits the camera frustum into cascadeCount slices, each drawn to a
+	// tileSize square tile, for a light shining along lightDir.  The slices
+	// end where the camera no longer sees any of sceneBounds.
+	void XM_CALLCONV Build(const Camera& camera, DirectX::FXMVECTOR lightDir,
+		const DirectX::BoundingSphere& sceneBounds, UINT cascadeCount, UINT tileSize);
+
+	// Moves the near and far planes of a cascade, e.g. to the casters and
+	// receivers that are left after culling.  View, the extent of Proj and
+	// the tile stay as Build made them.
+	void SetDepthRange(UINT index, float nearZ, float farZ);
+
+	UINT CascadeCount()const;
+	const ShadowCascade& GetCascade(UINT index)const;
+
+	// Size of the shadow map that holds cascadeCount tiles.
+	static UINT MapWidth(UINT cascadeCount, UINT tileSize);
+	static UINT MapHeight(UINT cascadeCount, UINT tileSize);
+
+private:
+	ShadowCascade mCascades[MaxCascades];
+
+	UINT mCascadeCount = 0;
+};
+
+#endif // SHADOWCASCADES_H
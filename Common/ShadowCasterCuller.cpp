@@ -0,0 +1,119 @@
+//***************************************************************************************
+// ShadowCasterCuller.cpp
+//***************************************************************************************
+
+#include "ShadowCasterCuller.h"
+
+using namespace DirectX;
+
+ShadowCasterCuller::LightBox XM_CALLCONV ShadowCasterCuller::ToLightSpace(const BoundingBox& box, FXMMATRIX lightView)
+{
+	XMVECTOR center = XMVector3TransformCoord(XMLoadFloat3(&box.Center), lightView);
+
+	XMVECTOR extents = XMLoadFloat3(&box.Extents);
+	XMVECTOR lightExtents = XMVectorMultiply(XMVectorAbs(lightView.r[0]), XMVectorSplatX(extents));
+	lightExtents = XMVectorMultiplyAdd(XMVectorAbs(lightView.r[1]), XMVectorSplatY(extents), lightExtents);
+	lightExtents = XMVectorMultiplyAdd(XMVectorAbs(lightView.r[2]), XMVectorSplatZ(extents), lightExtents);
+
+	LightBox result;
+	XMStoreFloat3(&result.Min, center - lightExtents);
+	XMStoreFloat3(&result.Max, center + lightExtents);
+
+	return result;
+}
+
+bool XM_CALLCONV ShadowCasterCuller::Cull(const CullingBounds& bounds, UINT* viewMasks, UINT receiverBit, UINT casterBit,
+	FXMMATRIX lightView, const BoundingSphere& receiverRegion,
+	float& nearZ, float& farZ, ShadowCasterStats* stats)
+{
+	ShadowCasterStats cullStats;
+
+	// Only the part of a receiver inside the region needs shadows here.
+	XMFLOAT3 regionCenter;
+	XMStoreFloat3(&regionCenter, XMVector3TransformCoord(XMLoadFloat3(&receiverRegion.Center), lightView));
+	float regionRadius = receiverRegion.Radius;
+
+	LightBox all;
+	all.Min = XMFLOAT3(MathHelper::Infinity, MathHelper::Infinity, MathHelper::Infinity);
+	all.Max = XMFLOAT3(-MathHelper::Infinity, -MathHelper::Infinity, -MathHelper::Infinity);
+
+	mReceivers.clear();
+	for(UINT i = 0; i < bounds.Size(); ++i)
+	{
+		if((viewMasks[i] & receiverBit) == 0)
+			continue;
+
+		BoundingBox box = bounds.GetBox(i);
+		if(!box.Intersects(receiverRegion))
+			continue;
+
+		LightBox receiver = ToLightSpace(box, lightView);
+		receiver.Min.x = MathHelper::Max(receiver.Min.x, regionCenter.x - regionRadius);
+		receiver.Min.y = MathHelper::Max(receiver.Min.y, regionCenter.y - regionRadius);
+		receiver.Max.x = MathHelper::Min(receiver.Max.x, regionCenter.x + regionRadius);
+		receiver.Max.y = MathHelper::Min(receiver.Max.y, regionCenter.y + regionRadius);
+		receiver.Max.z = MathHelper::Min(receiver.Max.z, regionCenter.z + regionRadius);
+
+		all.Min.x = MathHelper::Min(all.Min.x, receiver.Min.x);
+		all.Min.y = MathHelper::Min(all.Min.y, receiver.Min.y);
+		all.Max.x = MathHelper::Max(all.Max.x, receiver.Max.x);
+		all.Max.y = MathHelper::Max(all.Max.y, receiver.Max.y);
+		all.Max.z = MathHelper::Max(all.Max.z, receiver.Max.z);
+
+		mReceivers.push_back(receiver);
+	}
+
+	cullStats.Receivers = (UINT)mReceivers.size();
+
+	// The light shines along +z, so a caster shadows a receiver when their
+	// boxes overlap in x and y and the caster starts before the receiver ends.
+	float nearestCaster = MathHelper::Infinity;
+	for(UINT i = 0; i < bounds.Size(); ++i)
+	{
+		if((viewMasks[i] & casterBit) == 0)
+			continue;
+
+		cullStats.CastersBefore++;
+
+		LightBox caster = ToLightSpace(bounds.GetBox(i), lightView);
+
+		bool shadows = false;
+		if(caster.Min.x <= all.Max.x && caster.Max.x >= all.Min.x &&
+		   caster.Min.y <= all.Max.y && caster.Max.y >= all.Min.y &&
+		   caster.Min.z <= all.Max.z)
+		{
+			for(const LightBox& receiver : mReceivers)
+			{
+				if(caster.Min.x <= receiver.Max.x && caster.Max.x >= receiver.Min.x &&
+				   caster.Min.y <= receiver.Max.y && caster.Max.y >= receiver.Min.y &&
+				   caster.Min.z <= receiver.Max.z)
+				{
+					shadows = true;
+					break;
+				}
+			}
+		}
+
+		if(shadows)
+		{
+			nearestCaster = MathHelper::Min(nearestCaster, caster.Min.z);
+			cullStats.CastersAfter++;
+		}
+		else
+		{
+			viewMasks[i] &= ~casterBit;
+		}
+	}
+
+	if(stats != nullptr)
+		*stats = cullStats;
+
+	if(cullStats.CastersAfter == 0)
+		return false;
+
+	// Every kept caster overlaps a receiver, so there is one behind it.
+	nearZ = nearestCaster;
+	farZ = all.Max.z;
+
+	return true;
+}
@@ -0,0 +1,63 @@
+//***************************************************************************************
+// ShadowCasterCuller.h
+//
+// Drops the shadow casters whose shadow cannot fall on anything the camera sees.
+//   -Works on the view masks Culling::CullViews writes: one bit marks the bounds the
+//    camera sees, another the bounds inside a light's view.
+//   -The receivers are the bounds the camera sees within a region, e.g. the sphere
+//    of a shadow cascade.  In the light's view space their boxes are extruded back
+//    towards the light, and a caster is kept only when its box overlaps one of those
+//    volumes.  The others lose their light bit, so the shadow pass skips them.
+//   -It also returns the light space depth range from the nearest kept caster to the
+//    farthest receiver, to tighten the near and far planes of the light.
+//   -Receivers and casters are compared pairwise, after a test against the box
+//    around all the receivers, which suits a few hundred bounds.
+//***************************************************************************************
+
+#ifndef SHADOWCASTERCULLER_H
+#define SHADOWCASTERCULLER_H
+
+#include "Culling.h"
+
+struct ShadowCasterStats
+{
+	UINT Receivers = 0;
+
+	// Bounds inside the light's view, and how many of them were kept.
+	UINT CastersBefore = 0;
+	UINT CastersAfter = 0;
+};
+
+class ShadowCasterCuller
+{
+public:
+	ShadowCasterCuller() = default;
+	ShadowCasterCuller(const ShadowCasterCuller& rhs) = delete;
+	ShadowCasterCuller& operator=(const ShadowCasterCuller& rhs) = delete;
+	~ShadowCasterCuller() = default;
+
+	// Receivers are the bounds with receiverBit set in viewMasks that touch
+	// receiverRegion.  casterBit is cleared for the bounds that cannot shadow
+	// them in the light with view matrix lightView, which must be a rotation
+	// and translation.  When there are casters left, nearZ and farZ are set
+	// to the light space depths of the nearest caster and the farthest
+	// receiver, and true is returned; otherwise they are left alone.
+	bool XM_CALLCONV Cull(const CullingBounds& bounds, UINT* viewMasks, UINT receiverBit, UINT casterBit,
+		DirectX::FXMMATRIX lightView, const DirectX::BoundingSphere& receiverRegion,
+		float& nearZ, float& farZ, ShadowCasterStats* stats = nullptr);
+
+private:
+	// A box in light space.
+	struct LightBox
+	{
+		DirectX::XMFLOAT3 Min;
+		DirectX::XMFLOAT3 Max;
+	};
+
+	static LightBox XM_CALLCONV ToLightSpace(const DirectX::BoundingBox& box, DirectX::FXMMATRIX lightView);
+
+private:
+	std::vector<LightBox> mReceivers;
+};
+
+#endif // SHADOWCASTERCULLER_H
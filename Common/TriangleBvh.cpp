@@ -0,0 +1,420 @@
+//***************************************************************************************
+// TriangleBvh.cpp
+//***************************************************************************************
+
+#include "TriangleBvh.h"
+#include "RayPacket.h"
+#include "BvhBuild.h"
+
+using namespace DirectX;
+
+void TriangleBvh::Build(const MeshGeometry& geo, const SubmeshGeometry& submesh)
+{
+	assert(geo.VertexBufferCPU != nullptr && geo.IndexBufferCPU != nullptr);
+
+	UINT triangleCount = submesh.IndexCount / 3;
+	std::vector<std::uint32_t> indices(3*triangleCount);
+
+	if(geo.IndexFormat == DXGI_FORMAT_R16_UINT)
+	{
+		auto source = (const std::uint16_t*)geo.IndexBufferCPU->GetBufferPointer() + submesh.StartIndexLocation;
+		for(UINT i = 0; i < 3*triangleCount; ++i)
+			indices[i] = source[i] + submesh.BaseVertexLocation;
+	}
+	else
+	{
+		auto source = (const std::uint32_t*)geo.IndexBufferCPU->GetBufferPointer() + submesh.StartIndexLocation;
+		for(UINT i = 0; i < 3*triangleCount; ++i)
+			indices[i] = source[i] + submesh.BaseVertexLocation;
+	}
+
+	Build((const XMFLOAT3*)geo.VertexBufferCPU->GetBufferPointer(), geo.VertexByteStride,
+		indices.data(), triangleCount);
+}
+
+void TriangleBvh::Build(const XMFLOAT3* positions, UINT vertexStride,
+	const std::uint32_t* indices, UINT triangleCount)
+{
+	auto position = [&](std::uint32_t index)
+	{
+		return XMLoadFloat3((const XMFLOAT3*)((const BYTE*)positions + (size_t)index*vertexStride));
+	};
+
+	std::vector<Triangle> source(triangleCount);
+	std::vector<BuildTriangle> buildTriangles(triangleCount);
+	for(UINT i = 0; i < triangleCount; ++i)
+	{
+		XMVECTOR v0 = position(indices[3*i + 0]);
+		XMVECTOR v1 = position(indices[3*i + 1]);
+		XMVECTOR v2 = position(indices[3*i + 2]);
+
+		XMStoreFloat3(&source[i].V0, v0);
+		XMStoreFloat3(&source[i].Edge1, v1 - v0);
+		XMStoreFloat3(&source[i].Edge2, v2 - v0);
+		source[i].Index = i;
+
+		XMVECTOR triMin = XMVectorMin(v0, XMVectorMin(v1, v2));
+		XMVECTOR triMax = XMVectorMax(v0, XMVectorMax(v1, v2));
+		XMStoreFloat3(&buildTriangles[i].Min, triMin);
+		XMStoreFloat3(&buildTriangles[i].Max, triMax);
+		XMStoreFloat3(&buildTriangles[i].Center, 0.5f*(triMin + triMax));
+		buildTriangles[i].Index = i;
+	}
+
+	mNodes.clear();
+	mNodes.reserve(2*triangleCount / MaxLeafSize + 1);
+	mTriangles.clear();
+	mTriangles.reserve(triangleCount);
+	mDepth = 0;
+
+	if(triangleCount > 0)
+		BuildNode(buildTriangles, source, 0, triangleCount, 1);
+}
+
+UINT TriangleBvh::BuildNode(std::vector<BuildTriangle>& triangles, const std::vector<Triangle>& source,
+	UINT first, UINT count, UINT depth)
+{
+	mDepth = MathHelper::Max(mDepth, depth);
+
+	BvhBuild::Aabb box;
+	BvhBuild::Aabb centroidBounds;
+	for(UINT i = first; i < first + count; ++i)
+	{
+		box.Grow(triangles[i].Min, triangles[i].Max);
+		centroidBounds.Grow(triangles[i].Center, triangles[i].Center);
+	}
+
+	UINT nodeIndex = (UINT)mNodes.size();
+	mNodes.push_back(Node());
+	mNodes[nodeIndex].Min = box.Min;
+	mNodes[nodeIndex].Max = box.Max;
+
+	if(count <= MaxLeafSize)
+	{
+		mNodes[nodeIndex].FirstOrRight = (UINT)mTriangles.size();
+		mNodes[nodeIndex].Count = count;
+		for(UINT i = first; i < first + count; ++i)
+			mTriangles.push_back(source[triangles[i].Index]);
+		return nodeIndex;
+	}
+
+	UINT leftCount = BvhBuild::Split(triangles.begin() + first, count, centroidBounds, depth,
+		[](const BuildTriangle& triangle) { return triangle.Center; },
+		[](BvhBuild::Aabb& bounds, const BuildTriangle& triangle) { bounds.Grow(triangle.Min, triangle.Max); });
+
+	// The left subtree is built first so it directly follows this node.
+	BuildNode(triangles, source, first, leftCount, depth + 1);
+	UINT rightIndex = BuildNode(triangles, source, first + leftCount, count - leftCount, depth + 1);
+	mNodes[nodeIndex].FirstOrRight = rightIndex;
+
+	return nodeIndex;
+}
+
+bool XM_CALLCONV TriangleBvh::Intersect(FXMVECTOR origin, FXMVECTOR dir, TriangleHit& hit,
+	float maxT, RayQueryStats* stats)const
+{
+	RayQueryStats localStats;
+	hit = TriangleHit();
+
+	if(mNodes.empty())
+	{
+		if(stats != nullptr)
+			*stats = localStats;
+		return false;
+	}
+
+	XMVECTOR invDir = XMVectorReciprocal(dir);
+	float closest = maxT;
+
+	struct StackEntry
+	{
+		UINT Node;
+		float Enter;
+	};
+
+	StackEntry stack[BvhBuild::MaxStackSize];
+	UINT stackSize = 0;
+
+	float rootEnter = BvhBuild::EnterBox(origin, invDir, mNodes[0].Min, mNodes[0].Max, closest);
+	if(rootEnter != FLT_MAX)
+		stack[stackSize++] = { 0, rootEnter };
+
+	while(stackSize > 0)
+	{
+		StackEntry entry = stack[--stackSize];
+
+		// A closer hit was found after this node was pushed.
+		if(entry.Enter >= closest)
+			continue;
+
+		const Node& node = mNodes[entry.Node];
+		localStats.NodesVisited++;
+
+		if(node.Count > 0)
+		{
+			// Moller-Trumbore against each triangle of the leaf.
+			for(UINT i = node.FirstOrRight; i < node.FirstOrRight + node.Count; ++i)
+			{
+				const Triangle& triangle = mTriangles[i];
+				localStats.TrianglesTested++;
+
+				XMVECTOR e1 = XMLoadFloat3(&triangle.Edge1);
+				XMVECTOR e2 = XMLoadFloat3(&triangle.Edge2);
+
+				XMVECTOR p = XMVector3Cross(dir, e2);
+				float det = XMVectorGetX(XMVector3Dot(e1, p));
+				if(fabsf(det) < 1e-12f)
+					continue;
+
+				float invDet = 1.0f / det;
+				XMVECTOR s = XMVectorSubtract(origin, XMLoadFloat3(&triangle.V0));
+				float u = XMVectorGetX(XMVector3Dot(s, p))*invDet;
+				if(u < 0.0f || u > 1.0f)
+					continue;
+
+				XMVECTOR q = XMVector3Cross(s, e1);
+				float v = XMVectorGetX(XMVector3Dot(dir, q))*invDet;
+				if(v < 0.0f || u + v > 1.0f)
+					continue;
+
+				float t = XMVectorGetX(XMVector3Dot(e2, q))*invDet;
+				if(t < 0.0f || t >= closest)
+					continue;
+
+				closest = t;
+				hit.Triangle = triangle.Index;
+				hit.T = t;
+				hit.U = u;
+				hit.V = v;
+			}
+
+			continue;
+		}
+
+		// Push the farther child first so the nearer one is visited next.
+		UINT leftIndex = entry.Node + 1;
+		UINT rightIndex = node.FirstOrRight;
+		float leftEnter = BvhBuild::EnterBox(origin, invDir, mNodes[leftIndex].Min, mNodes[leftIndex].Max, closest);
+		float rightEnter = BvhBuild::EnterBox(origin, invDir, mNodes[rightIndex].Min, mNodes[rightIndex].Max, closest);
+
+		if(leftEnter > rightEnter)
+		{
+			std::swap(leftEnter, rightEnter);
+			std::swap(leftIndex, rightIndex);
+		}
+
+		assert(stackSize + 2 <= BvhBuild::MaxStackSize);
+		if(rightEnter != FLT_MAX)
+			stack[stackSize++] = { rightIndex, rightEnter };
+		if(leftEnter != FLT_MAX)
+			stack[stackSize++] = { leftIndex, leftEnter };
+	}
+
+	if(stats != nullptr)
+		*stats = localStats;
+
+	return hit.Triangle != (UINT)-1;
+}
+
+UINT TriangleBvh::IntersectPacket(RayPacket& rays, RayPacketHits& hits, RayQueryStats* stats)const
+{
+	RayQueryStats localStats;
+	hits = RayPacketHits();
+
+	if(mNodes.empty())
+	{
+		if(stats != nullptr)
+			*stats = localStats;
+		return 0;
+	}
+
+	// Nodes are ordered and pruned by the nearest entry over the packet, and
+	// skipped once every ray has a closer hit.
+	auto nearestEnter = [](const float* tEnter, UINT mask)
+	{
+		float nearest = FLT_MAX;
+		for(UINT i = 0; i < RayPacket::Size; ++i)
+		{
+			if(mask & (1u << i))
+				nearest = MathHelper::Min(nearest, tEnter[i]);
+		}
+		return nearest;
+	};
+
+	auto farthestTMax = [&]()
+	{
+		float farthest = -1.0f;
+		for(UINT i = 0; i < RayPacket::Size; ++i)
+			farthest = MathHelper::Max(farthest, rays.TMax[i]);
+		return farthest;
+	};
+
+	struct StackEntry
+	{
+		UINT Node;
+		float Enter;
+	};
+
+	StackEntry stack[BvhBuild::MaxStackSize];
+	UINT stackSize = 0;
+
+	float tEnter[RayPacket::Size];
+	UINT rootMask = RayPacketTests::IntersectBox(rays, mNodes[0].Min, mNodes[0].Max, tEnter);
+	if(rootMask != 0)
+		stack[stackSize++] = { 0, nearestEnter(tEnter, rootMask) };
+
+	float farthest = farthestTMax();
+
+	while(stackSize > 0)
+	{
+		StackEntry entry = stack[--stackSize];
+
+		if(entry.Enter >= farthest)
+			continue;
+
+		const Node& node = mNodes[entry.Node];
+		localStats.NodesVisited++;
+
+		if(node.Count > 0)
+		{
+			UINT hitMask = 0;
+			for(UINT i = node.FirstOrRight; i < node.FirstOrRight + node.Count; ++i)
+			{
+				const Triangle& triangle = mTriangles[i];
+				localStats.TrianglesTested++;
+
+				hitMask |= RayPacketTests::IntersectTriangle(rays, triangle.V0, triangle.Edge1, triangle.Edge2,
+					triangle.Index, hits);
+			}
+
+			if(hitMask != 0)
+				farthest = farthestTMax();
+
+			continue;
+		}
+
+		// Push the farther child first so the nearer one is visited next.
+		UINT leftIndex = entry.Node + 1;
+		UINT rightIndex = node.FirstOrRight;
+
+		UINT leftMask = RayPacketTests::IntersectBox(rays, mNodes[leftIndex].Min, mNodes[leftIndex].Max, tEnter);
+		float leftEnter = leftMask != 0 ? nearestEnter(tEnter, leftMask) : FLT_MAX;
+
+		UINT rightMask = RayPacketTests::IntersectBox(rays, mNodes[rightIndex].Min, mNodes[rightIndex].Max, tEnter);
+		float rightEnter = rightMask != 0 ? nearestEnter(tEnter, rightMask) : FLT_MAX;
+
+		if(leftEnter > rightEnter)
+		{
+			std::swap(leftEnter, rightEnter);
+			std::swap(leftIndex, rightIndex);
+		}
+
+		assert(stackSize + 2 <= BvhBuild::MaxStackSize);
+		if(rightEnter != FLT_MAX)
+			stack[stackSize++] = { rightIndex, rightEnter };
+		if(leftEnter != FLT_MAX)
+			stack[stackSize++] = { leftIndex, leftEnter };
+	}
+
+	if(stats != nullptr)
+		*stats = localStats;
+
+	UINT mask = 0;
+	for(UINT i = 0; i < RayPacket::Size; ++i)
+	{
+		if(hits.Triangle[i] != (UINT)-1)
+			mask |= 1u << i;
+	}
+
+	return mask;
+}
+
+UINT TriangleBvh::OverlapBox(const XMFLOAT3& boxMin, const XMFLOAT3& boxMax,
+	std::vector<XMFLOAT3>& vertices)const
+{
+	if(mNodes.empty())
+		return 0;
+
+	auto overlaps = [&](const XMFLOAT3& nodeMin, const XMFLOAT3& nodeMax)
+	{
+		return nodeMin.x <= boxMax.x && nodeMax.x >= boxMin.x &&
+			nodeMin.y <= boxMax.y && nodeMax.y >= boxMin.y &&
+			nodeMin.z <= boxMax.z && nodeMax.z >= boxMin.z;
+	};
+
+	UINT stack[BvhBuild::MaxStackSize];
+	UINT stackSize = 0;
+	UINT count = 0;
+
+	if(overlaps(mNodes[0].Min, mNodes[0].Max))
+		stack[stackSize++] = 0;
+
+	while(stackSize > 0)
+	{
+		UINT nodeIndex = stack[--stackSize];
+		const Node& node = mNodes[nodeIndex];
+
+		if(node.Count > 0)
+		{
+			for(UINT i = node.FirstOrRight; i < node.FirstOrRight + node.Count; ++i)
+			{
+				const Triangle& triangle = mTriangles[i];
+				XMVECTOR v0 = XMLoadFloat3(&triangle.V0);
+
+				XMFLOAT3 v1, v2;
+				XMStoreFloat3(&v1, v0 + XMLoadFloat3(&triangle.Edge1));
+				XMStoreFloat3(&v2, v0 + XMLoadFloat3(&triangle.Edge2));
+
+				// The leaf box only bounds the triangles together.
+				XMFLOAT3 triMin(MathHelper::Min(triangle.V0.x, MathHelper::Min(v1.x, v2.x)),
+					MathHelper::Min(triangle.V0.y, MathHelper::Min(v1.y, v2.y)),
+					MathHelper::Min(triangle.V0.z, MathHelper::Min(v1.z, v2.z)));
+				XMFLOAT3 triMax(MathHelper::Max(triangle.V0.x, MathHelper::Max(v1.x, v2.x)),
+					MathHelper::Max(triangle.V0.y, MathHelper::Max(v1.y, v2.y)),
+					MathHelper::Max(triangle.V0.z, MathHelper::Max(v1.z, v2.z)));
+				if(!overlaps(triMin, triMax))
+					continue;
+
+				vertices.push_back(triangle.V0);
+				vertices.push_back(v1);
+				vertices.push_back(v2);
+				++count;
+			}
+
+			continue;
+		}
+
+		assert(stackSize + 2 <= BvhBuild::MaxStackSize);
+		if(overlaps(mNodes[node.FirstOrRight].Min, mNodes[node.FirstOrRight].Max))
+			stack[stackSize++] = node.FirstOrRight;
+		if(overlaps(mNodes[nodeIndex + 1].Min, mNodes[nodeIndex + 1].Max))
+			stack[stackSize++] = nodeIndex + 1;
+	}
+
+	return count;
+}
+
+BoundingBox TriangleBvh::GetBounds()const
+{
+	if(mNodes.empty())
+		return BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+
+	BoundingBox bounds;
+	BoundingBox::CreateFromPoints(bounds, XMLoadFloat3(&mNodes[0].Min), XMLoadFloat3(&mNodes[0].Max));
+	return bounds;
+}
+
+UINT TriangleBvh::TriangleCount()const
+{
+	return (UINT)mTriangles.size();
+}
+
+UINT TriangleBvh::NodeCount()const
+{
+	return (UINT)mNodes.size();
+}
+
+UINT TriangleBvh::Depth()const
+{
+	return mDepth;
+}
@@ -0,0 +1,136 @@
+//***************************************************************************************
+// TriangleBvh.h
+//
+// Bounding volume hierarchy over the triangles of one mesh, for ray picking and other
+// ray queries in the mesh's local space.
+//   -Build reads the positions and indices of a submesh from the system memory copies
+//    of its MeshGeometry and sorts the triangles into a binary tree with a binned
+//    surface area heuristic.
+//   -The nodes are stored depth first in one array, 32 bytes each: the left child
+//    always follows its parent, so only the right child's index is kept.  Leaf
+//    triangles are copied in tree order as a vertex and two edges, so a leaf's
+//    triangles are contiguous in memory and need no index lookups.
+//   -Intersect finds the closest hit.  It visits the nearer child first and skips
+//    every node whose box is entered beyond the closest hit found so far.
+//   -IntersectPacket traces 8 rays at once with the SIMD tests of RayPacket.h.  A node
+//    is visited while any ray of the packet still enters it, which pays off when the
+//    rays are coherent, e.g. neighbouring pixels or line-of-sight checks from one eye.
+//   -OverlapBox gathers the triangles near a box, for collision queries.
+//***************************************************************************************
+
+#ifndef TRIANGLEBVH_H
+#define TRIANGLEBVH_H
+
+#include "d3dUtil.h"
+
+struct RayPacket;
+struct RayPacketHits;
+
+struct TriangleHit
+{
+	// Index of the triangle in the submesh, so its indices start at
+	// StartIndexLocation + 3*Triangle.  -1 when nothing was hit.
+	UINT Triangle = -1;
+
+	// Distance along the ray in units of its direction, and the barycentric
+	// coordinates of the hit: p = (1-U-V)*v0 + U*v1 + V*v2.
+	float T = FLT_MAX;
+	float U = 0.0f;
+	float V = 0.0f;
+};
+
+struct RayQueryStats
+{
+	UINT NodesVisited = 0;
+	UINT TrianglesTested = 0;
+};
+
+class TriangleBvh
+{
+public:
+	// Leaves hold at most this many triangles.
+	static const UINT MaxLeafSize = 4;
+
+	TriangleBvh() = default;
+	TriangleBvh(const TriangleBvh& rhs) = delete;
+	TriangleBvh& operator=(const TriangleBvh& rhs) = delete;
+	~TriangleBvh() = default;
+
+	// Builds over the triangles of a submesh.  The position must be the first
+	// element of the vertex, and the index format R16_UINT or R32_UINT.
+	void Build(const MeshGeometry& geo, const SubmeshGeometry& submesh);
+
+	// Builds over triangleCount triangles of 32-bit indices into positions,
+	// which are vertexStride bytes apart.
+	void Build(const DirectX::XMFLOAT3* positions, UINT vertexStride,
+		const std::uint32_t* indices, UINT triangleCount);
+
+	// Finds the closest triangle the ray hits with 0 <= t < maxT.  The ray is
+	// in the mesh's local space and dir need not be unit length.  Triangles
+	// are hit from both sides, as with TriangleTests::Intersects.
+	bool XM_CALLCONV Intersect(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR dir, TriangleHit& hit,
+		float maxT = FLT_MAX, RayQueryStats* stats = nullptr)const;
+
+	// Finds the closest hit of every ray of the packet with 0 <= t < TMax,
+	// shortening TMax to it.  hits is reset first.  TrianglesTested counts
+	// packet tests.  Returns the lanes that hit.
+	UINT IntersectPacket(RayPacket& rays, RayPacketHits& hits, RayQueryStats* stats = nullptr)const;
+
+	// Appends v0, v1 and v2 of every triangle whose box overlaps the local
+	// box [boxMin, boxMax] to vertices, and returns how many triangles that is.
+	UINT OverlapBox(const DirectX::XMFLOAT3& boxMin, const DirectX::XMFLOAT3& boxMax,
+		std::vector<DirectX::XMFLOAT3>& vertices)const;
+
+	// Box around every triangle, in local space.
+	DirectX::BoundingBox GetBounds()const;
+
+	UINT TriangleCount()const;
+	UINT NodeCount()const;
+	UINT Depth()const;
+
+private:
+	struct Node
+	{
+		DirectX::XMFLOAT3 Min;
+
+		// Leaves: first triangle in mTriangles.  Others: the right child.
+		UINT FirstOrRight = 0;
+
+		DirectX::XMFLOAT3 Max;
+
+		// Triangles in the leaf, 0 for interior nodes.
+		UINT Count = 0;
+	};
+
+	struct Triangle
+	{
+		DirectX::XMFLOAT3 V0;
+		DirectX::XMFLOAT3 Edge1;
+		DirectX::XMFLOAT3 Edge2;
+
+		// Index in the submesh.
+		UINT Index;
+	};
+
+	// Bounds and centroid of a triangle while building.
+	struct BuildTriangle
+	{
+		DirectX::XMFLOAT3 Min;
+		DirectX::XMFLOAT3 Max;
+		DirectX::XMFLOAT3 Center;
+		UINT Index;
+	};
+
+	// Builds the subtree over triangles [first, first + count) and returns
+	// its root.  source holds every triangle by its submesh index.
+	UINT BuildNode(std::vector<BuildTriangle>& triangles, const std::vector<Triangle>& source,
+		UINT first, UINT count, UINT depth);
+
+private:
+	std::vector<Node> mNodes;
+	std::vector<Triangle> mTriangles;
+
+	UINT mDepth = 0;
+};
+
+#endif // TRIANGLEBVH_H
@@ -55,6 +55,14 @@ public:
         memcpy(&mMappedData[elementIndex*mElementByteSize], &data, sizeof(T));
     }
 
+    // Lets the caller write an element in place instead of building it on the
+    // stack and copying it with CopyData.  The memory is write-combined, so
+    // fill it sequentially and never read it back.
+    T* MappedElement(int elementIndex)
+    {
+        return reinterpret_cast<T*>(&mMappedData[elementIndex*mElementByteSize]);
+    }
+
 private:
     Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer;
     BYTE* mMappedData = nullptr;
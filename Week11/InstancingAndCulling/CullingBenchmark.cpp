@@ -0,0 +1,437 @@
+//***************************************************************************************
+// CullingBenchmark.cpp
+//
+// Headless console benchmark for the instance culling in Common/Culling.h.  Build it as
+// its own console project with Common/Culling.cpp and Common/MathHelper.cpp.
+//
+// For 1k to 1M skull-sized instances scattered around the camera it times
+//   -the old path of InstancingAndCullingApp::UpdateInstanceData: invert every world
+//    matrix, transform the frustum into the instance's local space and call Contains,
+//   -the new path: extract the world-space planes once and run Culling::Cull over the
+//    precomputed world bounds,
+// and prints instances culled per millisecond for both.
+//
+// It then culls 1M instances with ParallelCuller on 1, 2, 4, ... cores, writing the
+// visible InstanceData into a stand-in for the mapped instance buffer, and checks that
+// every core count produces exactly the serial visible list.
+//
+// Finally it builds a BoundsBvh over the same scenes and compares hierarchical culling
+// with the flat SIMD cull, along with the build and refit times.  Add
+// Common/BoundsBvh.cpp and Common/BvhBuild.cpp to the project for this part.
+//
+// The last section flies the camera through 100k instances and compares the flat cull
+// with CoherentCuller, printing how many tests the cached planes and skipped bounds save.
+//
+// After that the same flight runs the frustum survivors through LodSelector with and
+// without hysteresis, printing the time, how many instances were too small to draw and
+// how many changed level per frame.  Add Common/LodSelector.cpp to the project for it.
+//***************************************************************************************
+
+#include <windows.h>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <ppl.h>
+#include "../../Common/Culling.h"
+#include "../../Common/BoundsBvh.h"
+#include "../../Common/LodSelector.h"
+#include "FrameResource.h"
+
+using namespace std;
+using namespace DirectX;
+
+double Milliseconds(const LARGE_INTEGER& start, const LARGE_INTEGER& end)
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+
+	return 1000.0 * (double)(end.QuadPart - start.QuadPart) / (double)frequency.QuadPart;
+}
+
+// Average time of one parallel cull and instance write, in milliseconds, when
+// the PPL scheduler may only use the given number of cores.  Returns false
+// if the visible list differs from the expected one.
+bool TimeParallelCull(ParallelCuller& culler, const CullingBounds& bounds, const FrustumPlanes& frustum,
+	const std::vector<XMFLOAT4X4>& worlds, const std::vector<UINT>& expected, UINT expectedCount,
+	std::vector<InstanceData>& instanceBuffer, UINT cores, UINT repeats, double& ms)
+{
+	concurrency::CurrentScheduler::Create(concurrency::SchedulerPolicy(2,
+		concurrency::MinConcurrency, cores,
+		concurrency::MaxConcurrency, cores));
+
+	auto writeInstance = [&](UINT slot, UINT index)
+	{
+		InstanceData& data = instanceBuffer[slot];
+		XMStoreFloat4x4(&data.World, XMMatrixTranspose(XMLoadFloat4x4(&worlds[index])));
+		data.MaterialIndex = index;
+	};
+
+	UINT visibleCount = 0;
+	LARGE_INTEGER start, end;
+	QueryPerformanceCounter(&start);
+	for(UINT repeat = 0; repeat < repeats; ++repeat)
+	{
+		visibleCount = culler.Cull(bounds, frustum, writeInstance);
+	}
+	QueryPerformanceCounter(&end);
+
+	concurrency::CurrentScheduler::Detach();
+
+	ms = Milliseconds(start, end) / repeats;
+
+	if(visibleCount != expectedCount)
+		return false;
+
+	for(UINT i = 0; i < visibleCount; ++i)
+	{
+		if(culler.VisibleIndices()[i] != expected[i] || instanceBuffer[i].MaterialIndex != expected[i])
+			return false;
+	}
+
+	return true;
+}
+
+// Scatters skull-sized instances with random rotations through a 1000 unit cube.
+void BuildScene(UINT instanceCount, const BoundingBox& localBounds,
+	std::vector<XMFLOAT4X4>& worlds, CullingBounds& bounds)
+{
+	srand(instanceCount);
+
+	worlds.resize(instanceCount);
+	bounds.Clear();
+	bounds.Reserve(instanceCount);
+	for(UINT i = 0; i < instanceCount; ++i)
+	{
+		XMMATRIX world = XMMatrixRotationY(MathHelper::RandF(0.0f, XM_2PI)) *
+			XMMatrixTranslation(MathHelper::RandF(-500.0f, 500.0f),
+				MathHelper::RandF(-500.0f, 500.0f), MathHelper::RandF(-500.0f, 500.0f));
+
+		XMStoreFloat4x4(&worlds[i], world);
+		bounds.Add(localBounds, world);
+	}
+}
+
+int main()
+{
+	// Roughly the bounds of skull.txt.
+	BoundingBox skullBounds(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(3.0f, 4.0f, 4.0f));
+
+	// Same lens as InstancingAndCullingApp, looking down +z from the origin.
+	XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f),
+		XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	XMMATRIX proj = XMMatrixPerspectiveFovLH(0.6f*MathHelper::Pi, 1280.0f / 720.0f, 1.0f, 1000.0f);
+
+	BoundingFrustum camFrustum;
+	BoundingFrustum::CreateFromMatrix(camFrustum, proj);
+
+	XMVECTOR viewDet = XMMatrixDeterminant(view);
+	XMMATRIX invView = XMMatrixInverse(&viewDet, view);
+	FrustumPlanes frustum = FrustumPlanes::FromViewProj(XMMatrixMultiply(view, proj));
+
+	cout << (Culling::HasAvx() ? "AVX" : "SSE") << " plane tests" << endl << endl;
+	cout << "instances   old visible   new visible   old inst/ms    new inst/ms   speedup" << endl;
+
+	for(UINT instanceCount = 1000; instanceCount <= 1000000; instanceCount *= 10)
+	{
+		std::vector<XMFLOAT4X4> worlds;
+		CullingBounds bounds;
+		BuildScene(instanceCount, skullBounds, worlds, bounds);
+
+		std::vector<UINT> visibleIndices(bounds.PaddedSize());
+		LARGE_INTEGER start, end;
+
+		// Repeat the small sizes so every measurement covers enough work.
+		UINT oldRepeats = MathHelper::Max(1u, 200000u / instanceCount);
+		UINT newRepeats = MathHelper::Max(1u, 20000000u / instanceCount);
+
+		UINT oldVisible = 0;
+		QueryPerformanceCounter(&start);
+		for(UINT repeat = 0; repeat < oldRepeats; ++repeat)
+		{
+			oldVisible = 0;
+			for(UINT i = 0; i < instanceCount; ++i)
+			{
+				XMMATRIX world = XMLoadFloat4x4(&worlds[i]);
+				XMVECTOR worldDet = XMMatrixDeterminant(world);
+				XMMATRIX invWorld = XMMatrixInverse(&worldDet, world);
+				XMMATRIX viewToLocal = XMMatrixMultiply(invView, invWorld);
+
+				BoundingFrustum localSpaceFrustum;
+				camFrustum.Transform(localSpaceFrustum, viewToLocal);
+
+				if(localSpaceFrustum.Contains(skullBounds) != DirectX::DISJOINT)
+					visibleIndices[oldVisible++] = i;
+			}
+		}
+		QueryPerformanceCounter(&end);
+		double oldMs = Milliseconds(start, end) / oldRepeats;
+
+		UINT newVisible = 0;
+		QueryPerformanceCounter(&start);
+		for(UINT repeat = 0; repeat < newRepeats; ++repeat)
+		{
+			FrustumPlanes planes = FrustumPlanes::FromViewProj(XMMatrixMultiply(view, proj));
+			newVisible = Culling::Cull(bounds, planes, visibleIndices.data());
+		}
+		QueryPerformanceCounter(&end);
+		double newMs = Milliseconds(start, end) / newRepeats;
+
+		// The world AABBs are a little larger than the rotated boxes, so the
+		// new path may keep a few more instances than the old one.
+		cout << setw(9) << instanceCount << setw(14) << oldVisible << setw(14) << newVisible
+			<< fixed << setprecision(1)
+			<< setw(14) << instanceCount / oldMs << setw(15) << instanceCount / newMs
+			<< setw(9) << oldMs / newMs << "x" << endl;
+
+		if(instanceCount < 1000000)
+			continue;
+
+		//
+		// Parallel cull of the largest set, writing the visible instances.
+		//
+
+		std::vector<InstanceData> instanceBuffer(instanceCount);
+		ParallelCuller culler;
+
+		cout << endl << "parallel cull of " << instanceCount << " instances, chunk size "
+			<< culler.GetChunkSize() << endl;
+		cout << "cores   ms/frame      inst/ms   speedup   deterministic" << endl;
+
+		std::vector<UINT> coreCounts;
+		UINT processorCount = concurrency::GetProcessorCount();
+		for(UINT cores = 1; cores < processorCount; cores *= 2)
+			coreCounts.push_back(cores);
+		coreCounts.push_back(processorCount);
+
+		double oneCoreMs = 0.0;
+		for(UINT cores : coreCounts)
+		{
+			double ms = 0.0;
+			bool same = TimeParallelCull(culler, bounds, frustum, worlds, visibleIndices, newVisible,
+				instanceBuffer, cores, 20, ms);
+
+			if(cores == 1)
+				oneCoreMs = ms;
+
+			cout << setw(5) << cores << setw(11) << ms << setw(13) << instanceCount / ms
+				<< setw(9) << oneCoreMs / ms << "x" << setw(10) << (same ? "yes" : "NO") << endl;
+		}
+	}
+
+	//
+	// Hierarchical culling.
+	//
+
+	cout << endl << "instances   build ms   flat ms/cull   bvh ms/cull   speedup   nodes   visited   accepted   same" << endl;
+
+	for(UINT instanceCount = 1000; instanceCount <= 1000000; instanceCount *= 10)
+	{
+		std::vector<XMFLOAT4X4> worlds;
+		CullingBounds bounds;
+		BuildScene(instanceCount, skullBounds, worlds, bounds);
+
+		LARGE_INTEGER start, end;
+		BoundsBvh bvh;
+
+		QueryPerformanceCounter(&start);
+		bvh.Build(bounds);
+		QueryPerformanceCounter(&end);
+		double buildMs = Milliseconds(start, end);
+
+		std::vector<UINT> flatIndices(bounds.PaddedSize());
+		std::vector<UINT> bvhIndices(bounds.Size());
+		UINT repeats = MathHelper::Max(1u, 20000000u / instanceCount);
+
+		UINT flatVisible = 0;
+		QueryPerformanceCounter(&start);
+		for(UINT repeat = 0; repeat < repeats; ++repeat)
+			flatVisible = Culling::Cull(bounds, frustum, flatIndices.data());
+		QueryPerformanceCounter(&end);
+		double flatMs = Milliseconds(start, end) / repeats;
+
+		UINT bvhVisible = 0;
+		BvhCullStats stats;
+		QueryPerformanceCounter(&start);
+		for(UINT repeat = 0; repeat < repeats; ++repeat)
+			bvhVisible = bvh.Cull(bounds, frustum, bvhIndices.data(), &stats);
+		QueryPerformanceCounter(&end);
+		double bvhMs = Milliseconds(start, end) / repeats;
+
+		// The tree returns the same set in tree order.
+		std::sort(bvhIndices.begin(), bvhIndices.begin() + bvhVisible);
+		bool same = flatVisible == bvhVisible &&
+			std::equal(flatIndices.begin(), flatIndices.begin() + flatVisible, bvhIndices.begin());
+
+		cout << setw(9) << instanceCount << setw(11) << setprecision(2) << buildMs
+			<< setw(15) << setprecision(4) << flatMs << setw(14) << bvhMs
+			<< setw(9) << setprecision(1) << flatMs / bvhMs << "x"
+			<< setw(8) << bvh.NodeCount() << setw(10) << stats.NodesVisited
+			<< setw(11) << stats.AcceptedSubtrees << setw(7) << (same ? "yes" : "NO") << endl;
+
+		if(instanceCount < 1000000)
+			continue;
+
+		// Nudge every instance and refit the tree instead of rebuilding it.
+		for(UINT i = 0; i < instanceCount; ++i)
+		{
+			XMMATRIX world = XMLoadFloat4x4(&worlds[i]) * XMMatrixTranslation(0.0f, 0.1f, 0.0f);
+			bounds.Set(i, skullBounds, world);
+		}
+
+		QueryPerformanceCounter(&start);
+		bvh.Refit(bounds);
+		QueryPerformanceCounter(&end);
+		cout << setprecision(2) << "refit of " << instanceCount << " instances: "
+			<< Milliseconds(start, end) << " ms" << endl;
+	}
+
+	//
+	// Fly-through with plane caching.
+	//
+
+	{
+		const UINT instanceCount = 100000;
+		const UINT frameCount = 1000;
+
+		std::vector<XMFLOAT4X4> worlds;
+		CullingBounds bounds;
+		BuildScene(instanceCount, skullBounds, worlds, bounds);
+
+		std::vector<UINT> flatIndices(bounds.PaddedSize());
+		std::vector<UINT> coherentIndices(bounds.Size());
+		CoherentCuller coherentCuller;
+
+		double flatMs = 0.0;
+		double coherentMs = 0.0;
+		UINT64 objects = 0, skipped = 0, cachedPlaneHits = 0, planeTests = 0;
+		bool same = true;
+
+		XMFLOAT3 eye(0.0f, 0.0f, -400.0f);
+		float yaw = 0.0f;
+
+		for(UINT frame = 0; frame < frameCount; ++frame)
+		{
+			// Walk forward at 30 units per second while slowly turning and
+			// bobbing, as a player would at 60 frames per second.
+			float pitch = 0.2f*sinf(0.002f*frame);
+			yaw += 0.004f + 0.01f*sinf(0.003f*frame);
+
+			XMVECTOR look = XMVectorSet(cosf(pitch)*sinf(yaw), sinf(pitch), cosf(pitch)*cosf(yaw), 0.0f);
+			XMVECTOR eyePos = XMVectorMultiplyAdd(look, XMVectorReplicate(0.5f), XMLoadFloat3(&eye));
+			XMStoreFloat3(&eye, eyePos);
+
+			XMMATRIX frameView = XMMatrixLookToLH(eyePos, look, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+			FrustumPlanes planes = FrustumPlanes::FromViewProj(XMMatrixMultiply(frameView, proj));
+
+			LARGE_INTEGER start, end;
+
+			QueryPerformanceCounter(&start);
+			UINT flatVisible = Culling::Cull(bounds, planes, flatIndices.data());
+			QueryPerformanceCounter(&end);
+			flatMs += Milliseconds(start, end);
+
+			CoherentCullStats stats;
+			QueryPerformanceCounter(&start);
+			UINT coherentVisible = coherentCuller.Cull(bounds, planes, eyePos, coherentIndices.data(), &stats);
+			QueryPerformanceCounter(&end);
+			coherentMs += Milliseconds(start, end);
+
+			same = same && flatVisible == coherentVisible &&
+				std::equal(flatIndices.begin(), flatIndices.begin() + flatVisible, coherentIndices.begin());
+
+			objects += stats.Objects;
+			skipped += stats.Skipped;
+			cachedPlaneHits += stats.CachedPlaneHits;
+			planeTests += stats.PlaneTests;
+		}
+
+		UINT64 tested = objects - skipped;
+
+		cout << endl << "fly-through of " << frameCount << " frames over " << instanceCount << " instances" << endl;
+		cout << setprecision(4) << "flat SIMD cull:   " << flatMs / frameCount << " ms/frame" << endl;
+		cout << "coherent cull:    " << coherentMs / frameCount << " ms/frame" << endl;
+		cout << setprecision(1)
+			<< "skipped:          " << 100.0*skipped / objects << "% of bounds" << endl
+			<< "cached plane hit: " << (tested > 0 ? 100.0*cachedPlaneHits / tested : 0.0) << "% of tested bounds" << endl
+			<< setprecision(2)
+			<< "plane tests:      " << (double)planeTests / objects << " per bound" << endl
+			<< "same visible set: " << (same ? "yes" : "NO") << endl;
+	}
+
+	//
+	// Screen-size culling and level of detail selection.
+	//
+
+	{
+		const UINT instanceCount = 100000;
+		const UINT frameCount = 1000;
+
+		std::vector<XMFLOAT4X4> worlds;
+		CullingBounds bounds;
+		BuildScene(instanceCount, skullBounds, worlds, bounds);
+
+		std::vector<UINT> visibleIndices(bounds.PaddedSize());
+
+		XMFLOAT4X4 proj4x4;
+		XMStoreFloat4x4(&proj4x4, proj);
+
+		cout << endl << "LOD selection of the frustum survivors over " << frameCount << " frames" << endl;
+		cout << "hysteresis   ms/frame   visible   too small   level 0   level 1   level 2   switches/frame" << endl;
+
+		for(float hysteresis : { 0.0f, 0.15f })
+		{
+			LodSettings settings;
+			settings.Hysteresis = hysteresis;
+
+			LodSelector selector;
+			selector.SetSettings(settings);
+
+			std::vector<UINT> levelInstances[LodSettings::MaxLevels];
+
+			double selectMs = 0.0;
+			UINT64 visible = 0, tooSmall = 0, switched = 0;
+			UINT64 perLevel[LodSettings::MaxLevels] = {};
+
+			XMFLOAT3 eye(0.0f, 0.0f, -400.0f);
+			float yaw = 0.0f;
+
+			for(UINT frame = 0; frame < frameCount; ++frame)
+			{
+				float pitch = 0.2f*sinf(0.002f*frame);
+				yaw += 0.004f + 0.01f*sinf(0.003f*frame);
+
+				XMVECTOR look = XMVectorSet(cosf(pitch)*sinf(yaw), sinf(pitch), cosf(pitch)*cosf(yaw), 0.0f);
+				XMVECTOR eyePos = XMVectorMultiplyAdd(look, XMVectorReplicate(0.5f), XMLoadFloat3(&eye));
+				XMStoreFloat3(&eye, eyePos);
+
+				XMMATRIX frameView = XMMatrixLookToLH(eyePos, look, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+				FrustumPlanes planes = FrustumPlanes::FromViewProj(XMMatrixMultiply(frameView, proj));
+
+				UINT visibleCount = Culling::Cull(bounds, planes, visibleIndices.data());
+
+				LodStats stats;
+				LARGE_INTEGER start, end;
+				QueryPerformanceCounter(&start);
+				selector.SetView(eyePos, proj4x4._22, 720.0f);
+				selector.Select(bounds, visibleIndices.data(), visibleCount, levelInstances, &stats);
+				QueryPerformanceCounter(&end);
+				selectMs += Milliseconds(start, end);
+
+				visible += visibleCount;
+				tooSmall += stats.TooSmall;
+				switched += stats.Switched;
+				for(UINT level = 0; level < selector.GetLevelCount(); ++level)
+					perLevel[level] += stats.PerLevel[level];
+			}
+
+			cout << setprecision(2) << setw(10) << hysteresis << setprecision(4) << setw(11) << selectMs / frameCount
+				<< setw(10) << visible / frameCount << setw(12) << tooSmall / frameCount
+				<< setw(10) << perLevel[0] / frameCount << setw(10) << perLevel[1] / frameCount
+				<< setw(10) << perLevel[2] / frameCount
+				<< setprecision(1) << setw(17) << (double)switched / frameCount << endl;
+		}
+	}
+
+	system("pause");
+	return 0;
+}
@@ -1,6 +1,10 @@
 //********************************************************************************************************
 // InstancingAndCullingApp.cpp 
 //Press 1 to see all the 125 skulls and press 2 to remove all invisible objects from drawing (better performance)
+//Press 3 to find the visible objects through the bounding volume hierarchy instead of testing every one
+//Press 4 to reuse last frame's plane tests where the camera has not moved enough to change them
+//Press 5 to also drop the skulls smaller than a few pixels and draw the rest with a coarser mesh
+//the smaller they are on screen, and 6 to draw every visible skull with the full mesh again
 //********************************************************************************************************
 
 #include "../../Common/d3dApp.h"
@@ -8,6 +12,9 @@
 #include "../../Common/UploadBuffer.h"
 #include "../../Common/GeometryGenerator.h"
 #include "../../Common/Camera.h"
+#include "../../Common/Culling.h"
+#include "../../Common/BoundsBvh.h"
+#include "../../Common/LodSelector.h"
 #include "FrameResource.h"
 
 using Microsoft::WRL::ComPtr;
@@ -51,6 +58,27 @@ struct RenderItem
 	BoundingBox Bounds;
 	std::vector<InstanceData> Instances;
 
+	// World-space bounds of every instance, built once since the instances
+	// do not move.
+	CullingBounds InstanceBounds;
+
+	// Hierarchy over InstanceBounds, and the visible indices it found.
+	BoundsBvh InstanceBvh;
+	std::vector<UINT> VisibleInstances;
+
+	// Remembers last frame's plane tests of every instance.
+	std::unique_ptr<CoherentCuller> InstanceCuller;
+
+	// Meshes of each level of detail, level 0 being the full one, and the
+	// selector that sorts the visible instances into per-level lists.
+	std::vector<SubmeshGeometry> Lods;
+	LodSelector InstanceLods;
+	std::vector<UINT> LodInstances[LodSettings::MaxLevels];
+
+	// Range of the instance buffer drawn with each level.
+	UINT LodInstanceStart[LodSettings::MaxLevels] = {};
+	UINT LodInstanceCount[LodSettings::MaxLevels] = {};
+
 	// DrawIndexedInstanced parameters.
 	UINT IndexCount = 0;
 	UINT InstanceCount = 0;
@@ -124,11 +152,12 @@ private:
 
 	UINT mInstanceCount = 0;
 
-	//step1: create a bounding frustum from camera projection matrix
-
 	bool mFrustumCullingEnabled = true;
+	bool mBvhCullingEnabled = false;
+	bool mCoherentCullingEnabled = false;
+	bool mLodEnabled = false;
 
-	BoundingFrustum mCamFrustum;
+	ParallelCuller mCuller;
 
 	PassConstants mMainPassCB;
 
@@ -211,10 +240,6 @@ void InstancingAndCullingApp::OnResize()
 	D3DApp::OnResize();
 
 	mCamera.SetLens(0.6f * MathHelper::Pi, AspectRatio(), 1.0f, 1000.0f);
-
-	//step2:the frustum is positioned at the origin, and axis aligned.The following DirectX collision code
-	//computes the frustum in view space from a projection matrix :
-	BoundingFrustum::CreateFromMatrix(mCamFrustum, mCamera.GetProj());
 }
 
 void InstancingAndCullingApp::Update(const GameTimer& gt)
@@ -356,10 +381,38 @@ void InstancingAndCullingApp::OnKeyboardInput(const GameTimer& gt)
 
 	//step2
 	if (GetAsyncKeyState('1') & 0x8000)
+	{
 		mFrustumCullingEnabled = true;
+		mBvhCullingEnabled = false;
+		mCoherentCullingEnabled = false;
+	}
 
 	if (GetAsyncKeyState('2') & 0x8000)
+	{
 		mFrustumCullingEnabled = false;
+		mBvhCullingEnabled = false;
+		mCoherentCullingEnabled = false;
+	}
+
+	if (GetAsyncKeyState('3') & 0x8000)
+	{
+		mFrustumCullingEnabled = false;
+		mBvhCullingEnabled = true;
+		mCoherentCullingEnabled = false;
+	}
+
+	if (GetAsyncKeyState('4') & 0x8000)
+	{
+		mFrustumCullingEnabled = false;
+		mBvhCullingEnabled = false;
+		mCoherentCullingEnabled = true;
+	}
+
+	if (GetAsyncKeyState('5') & 0x8000)
+		mLodEnabled = true;
+
+	if (GetAsyncKeyState('6') & 0x8000)
+		mLodEnabled = false;
 
 	mCamera.UpdateViewMatrix();
 }
@@ -371,43 +424,102 @@ void InstancingAndCullingApp::AnimateMaterials(const GameTimer& gt)
 
 void InstancingAndCullingApp::UpdateInstanceData(const GameTimer& gt)
 {
-	XMMATRIX view = mCamera.GetView();
-	XMMATRIX invView = XMMatrixInverse(&XMMatrixDeterminant(view), view);
+	// The planes are extracted once per frame in world space and every instance
+	// is tested against its precomputed world bounds, so no per-instance matrix
+	// is inverted and no frustum is transformed.
+	XMMATRIX viewProj = XMMatrixMultiply(mCamera.GetView(), mCamera.GetProj());
+	FrustumPlanes frustum = FrustumPlanes::FromViewProj(viewProj);
 
 	auto currInstanceBuffer = mCurrFrameResource->InstanceBuffer.get();
 	for (auto& e : mAllRitems)
 	{
 		const auto& instanceData = e->Instances;
 
-		int visibleInstanceCount = 0;
-
-		for (UINT i = 0; i < (UINT)instanceData.size(); ++i)
+		// Converts an instance to the shader layout and writes it straight into
+		// its slot of the mapped instance buffer.
+		auto writeInstance = [&](UINT slot, UINT index)
 		{
-			XMMATRIX world = XMLoadFloat4x4(&instanceData[i].World);
-			XMMATRIX texTransform = XMLoadFloat4x4(&instanceData[i].TexTransform);
+			const InstanceData& instance = instanceData[index];
 
-			XMMATRIX invWorld = XMMatrixInverse(&XMMatrixDeterminant(world), world);
+			XMMATRIX world = XMLoadFloat4x4(&instance.World);
+			XMMATRIX texTransform = XMLoadFloat4x4(&instance.TexTransform);
+
+			InstanceData* data = currInstanceBuffer->MappedElement(slot);
+			XMStoreFloat4x4(&data->World, XMMatrixTranspose(world));
+			XMStoreFloat4x4(&data->TexTransform, XMMatrixTranspose(texTransform));
+			data->MaterialIndex = instance.MaterialIndex;
+		};
+
+		UINT visibleInstanceCount = 0;
+
+		// Indices of the visible instances, when they were not written while culling.
+		const UINT* visibleIndices = e->VisibleInstances.data();
+
+		// Press 1 to draw every instance, 2 to draw only the visible ones, 3 to
+		// find them through the hierarchy, 4 to reuse last frame's tests.
+		if (mFrustumCullingEnabled)
+		{
+			for (UINT i = 0; i < (UINT)instanceData.size(); ++i)
+				writeInstance(visibleInstanceCount++, i);
+			visibleIndices = nullptr;
+		}
+		else if (mBvhCullingEnabled)
+		{
+			// Whole subtrees outside or inside the frustum are settled at once.
+			visibleInstanceCount = e->InstanceBvh.Cull(e->InstanceBounds, frustum, e->VisibleInstances.data());
+		}
+		else if (mCoherentCullingEnabled)
+		{
+			visibleInstanceCount = e->InstanceCuller->Cull(e->InstanceBounds, frustum,
+				mCamera.GetPosition(), e->VisibleInstances.data());
+		}
+		else if (mLodEnabled)
+		{
+			// The instances are written per level below, so only the indices are needed.
+			visibleInstanceCount = mCuller.Cull(e->InstanceBounds, frustum, [](UINT, UINT) {});
+			visibleIndices = mCuller.VisibleIndices();
+		}
+		else
+		{
+			// Visible instances are found and written on the worker threads.
+			visibleInstanceCount = mCuller.Cull(e->InstanceBounds, frustum, writeInstance);
+			visibleIndices = nullptr;
+		}
 
-			// View space to the object's local space.
-			XMMATRIX viewToLocal = XMMatrixMultiply(invView, invWorld);
+		for (UINT level = 0; level < LodSettings::MaxLevels; ++level)
+		{
+			e->LodInstanceStart[level] = 0;
+			e->LodInstanceCount[level] = 0;
+		}
 
-			// step3: Transform the camera frustum from view space to the object's local space.
-			BoundingFrustum localSpaceFrustum;
-			mCamFrustum.Transform(localSpaceFrustum, viewToLocal);
+		if (mLodEnabled && visibleIndices != nullptr)
+		{
+			// Drop the instances too small to see and give every level one
+			// contiguous range of the instance buffer, drawn with its own mesh.
+			e->InstanceLods.SetView(mCamera.GetPosition(), mCamera.GetProj4x4f()._22, (float)mClientHeight);
+			e->InstanceLods.Select(e->InstanceBounds, visibleIndices, visibleInstanceCount, e->LodInstances);
 
-			// Perform the box/frustum intersection test in local space.
-			if((localSpaceFrustum.Contains(e->Bounds) != DirectX::DISJOINT) || (mFrustumCullingEnabled==true))
-			//try this to remove skull that intersects as well
-			//if (((localSpaceFrustum.Contains(e->Bounds) != DirectX::DISJOINT) && (localSpaceFrustum.Contains(e->Bounds) != DirectX::INTERSECTS)) || (mFrustumCullingEnabled == true))
+			UINT slot = 0;
+			for (UINT level = 0; level < e->InstanceLods.GetLevelCount(); ++level)
 			{
-				InstanceData data;
-				XMStoreFloat4x4(&data.World, XMMatrixTranspose(world));
-				XMStoreFloat4x4(&data.TexTransform, XMMatrixTranspose(texTransform));
-				data.MaterialIndex = instanceData[i].MaterialIndex;
+				e->LodInstanceStart[level] = slot;
+				e->LodInstanceCount[level] = (UINT)e->LodInstances[level].size();
+
+				for (UINT index : e->LodInstances[level])
+					writeInstance(slot++, index);
+			}
 
-				// Write the instance data to structured buffer for the visible objects.
-				currInstanceBuffer->CopyData(visibleInstanceCount++, data);
+			visibleInstanceCount = slot;
+		}
+		else
+		{
+			if (visibleIndices != nullptr)
+			{
+				for (UINT i = 0; i < visibleInstanceCount; ++i)
+					writeInstance(i, visibleIndices[i]);
 			}
+
+			e->LodInstanceCount[0] = visibleInstanceCount;
 		}
 
 		e->InstanceCount = visibleInstanceCount;
@@ -417,6 +529,12 @@ void InstancingAndCullingApp::UpdateInstanceData(const GameTimer& gt)
 		outs << L"Instancing and Culling Demo" <<
 			L"    " << e->InstanceCount <<
 			L" objects visible out of " << e->Instances.size();
+		if (mLodEnabled && visibleIndices != nullptr)
+		{
+			outs << L"    per level:";
+			for (UINT level = 0; level < e->InstanceLods.GetLevelCount(); ++level)
+				outs << L" " << e->LodInstanceCount[level];
+		}
 		mMainWndCaption = outs.str();
 	}
 }
@@ -678,6 +796,48 @@ void InstancingAndCullingApp::BuildShadersAndInputLayout()
 	};
 }
 
+// Simplifies a mesh by vertex clustering: the bounds are split into cellsPerAxis^3
+// cells, every vertex is replaced by the first vertex of its cell and the triangles
+// that collapse are dropped.  The result indexes the original vertices.
+std::vector<std::int32_t> ClusterIndices(const std::vector<Vertex>& vertices,
+	const std::vector<std::int32_t>& indices, const BoundingBox& bounds, int cellsPerAxis)
+{
+	XMVECTOR boxMin = XMLoadFloat3(&bounds.Center) - XMLoadFloat3(&bounds.Extents);
+	XMVECTOR cellScale = XMVectorReplicate((float)cellsPerAxis) /
+		XMVectorMax(2.0f * XMLoadFloat3(&bounds.Extents), XMVectorReplicate(1e-6f));
+
+	std::unordered_map<int, std::int32_t> cellVertex;
+	std::vector<std::int32_t> remap(vertices.size());
+	for (size_t i = 0; i < vertices.size(); ++i)
+	{
+		XMFLOAT3 cell;
+		XMStoreFloat3(&cell, (XMLoadFloat3(&vertices[i].Pos) - boxMin) * cellScale);
+
+		int x = MathHelper::Clamp((int)cell.x, 0, cellsPerAxis - 1);
+		int y = MathHelper::Clamp((int)cell.y, 0, cellsPerAxis - 1);
+		int z = MathHelper::Clamp((int)cell.z, 0, cellsPerAxis - 1);
+
+		remap[i] = cellVertex.emplace((z * cellsPerAxis + y) * cellsPerAxis + x, (std::int32_t)i).first->second;
+	}
+
+	std::vector<std::int32_t> clustered;
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		std::int32_t i0 = remap[indices[i + 0]];
+		std::int32_t i1 = remap[indices[i + 1]];
+		std::int32_t i2 = remap[indices[i + 2]];
+
+		if (i0 == i1 || i1 == i2 || i0 == i2)
+			continue;
+
+		clustered.push_back(i0);
+		clustered.push_back(i1);
+		clustered.push_back(i2);
+	}
+
+	return clustered;
+}
+
 void InstancingAndCullingApp::BuildSkullGeometry()
 {
 	std::ifstream fin("Models/skull.txt");
@@ -750,6 +910,15 @@ void InstancingAndCullingApp::BuildSkullGeometry()
 
 	fin.close();
 
+	// Coarser levels of detail index the same vertices, so they are appended
+	// to the index buffer and share the vertex buffer.
+	std::vector<std::int32_t> lod1Indices = ClusterIndices(vertices, indices, bounds, 24);
+	std::vector<std::int32_t> lod2Indices = ClusterIndices(vertices, indices, bounds, 10);
+
+	UINT skullIndexCount = (UINT)indices.size();
+	indices.insert(indices.end(), lod1Indices.begin(), lod1Indices.end());
+	indices.insert(indices.end(), lod2Indices.begin(), lod2Indices.end());
+
 	//
 	// Pack the indices of all the meshes into one index buffer.
 	//
@@ -779,7 +948,7 @@ void InstancingAndCullingApp::BuildSkullGeometry()
 	geo->IndexBufferByteSize = ibByteSize;
 
 	SubmeshGeometry submesh;
-	submesh.IndexCount = (UINT)indices.size();
+	submesh.IndexCount = skullIndexCount;
 	submesh.StartIndexLocation = 0;
 	submesh.BaseVertexLocation = 0;
 	//step7
@@ -787,6 +956,16 @@ void InstancingAndCullingApp::BuildSkullGeometry()
 
 	geo->DrawArgs["skull"] = submesh;
 
+	SubmeshGeometry lod1Submesh = submesh;
+	lod1Submesh.IndexCount = (UINT)lod1Indices.size();
+	lod1Submesh.StartIndexLocation = skullIndexCount;
+	geo->DrawArgs["skullLod1"] = lod1Submesh;
+
+	SubmeshGeometry lod2Submesh = submesh;
+	lod2Submesh.IndexCount = (UINT)lod2Indices.size();
+	lod2Submesh.StartIndexLocation = skullIndexCount + lod1Submesh.IndexCount;
+	geo->DrawArgs["skullLod2"] = lod2Submesh;
+
 	mGeometries[geo->Name] = std::move(geo);
 }
 
@@ -951,6 +1130,24 @@ void InstancingAndCullingApp::BuildRenderItems()
 	}
 
 
+	for (auto& instance : skullRitem->Instances)
+		skullRitem->InstanceBounds.Add(skullRitem->Bounds, XMLoadFloat4x4(&instance.World));
+
+	skullRitem->InstanceBvh.Build(skullRitem->InstanceBounds);
+	skullRitem->VisibleInstances.resize(skullRitem->Instances.size());
+	skullRitem->InstanceCuller = std::make_unique<CoherentCuller>();
+
+	// Full mesh above 120 pixels, the coarsest one down to 12 pixels, and
+	// nothing below, which drops the far corner of the grid.
+	skullRitem->Lods.push_back(skullRitem->Geo->DrawArgs["skull"]);
+	skullRitem->Lods.push_back(skullRitem->Geo->DrawArgs["skullLod1"]);
+	skullRitem->Lods.push_back(skullRitem->Geo->DrawArgs["skullLod2"]);
+
+	LodSettings lodSettings;
+	lodSettings.LodPixels = { 120.0f, 40.0f };
+	lodSettings.MinPixels = 12.0f;
+	skullRitem->InstanceLods.SetSettings(lodSettings);
+
 	mAllRitems.push_back(std::move(skullRitem));
 
 	// All the render items are opaque.
@@ -972,9 +1169,21 @@ void InstancingAndCullingApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList
 		// Set the instance buffer to use for this render-item.  For structured buffers, we can bypass 
 		// the heap and set as a root descriptor.
 		auto instanceBuffer = mCurrFrameResource->InstanceBuffer->Resource();
-		mCommandList->SetGraphicsRootShaderResourceView(0, instanceBuffer->GetGPUVirtualAddress());
 
-		cmdList->DrawIndexedInstanced(ri->IndexCount, ri->InstanceCount, ri->StartIndexLocation, ri->BaseVertexLocation, 0);
+		// One draw per level of detail.  SV_InstanceID restarts at 0 in every
+		// draw, so the buffer view starts at the level's first instance.
+		for (UINT level = 0; level < (UINT)ri->Lods.size(); ++level)
+		{
+			if (ri->LodInstanceCount[level] == 0)
+				continue;
+
+			const SubmeshGeometry& lod = ri->Lods[level];
+
+			mCommandList->SetGraphicsRootShaderResourceView(0, instanceBuffer->GetGPUVirtualAddress() +
+				ri->LodInstanceStart[level] * sizeof(InstanceData));
+
+			cmdList->DrawIndexedInstanced(lod.IndexCount, ri->LodInstanceCount[level], lod.StartIndexLocation, lod.BaseVertexLocation, 0);
+		}
 	}
 }
 
@@ -7,6 +7,7 @@
 #include "../../Common/UploadBuffer.h"
 #include "../../Common/GeometryGenerator.h"
 #include "../../Common/Camera.h"
+#include "../../Common/PickQueryService.h"
 #include "FrameResource.h"
 
 using Microsoft::WRL::ComPtr;
@@ -29,6 +30,12 @@ struct RenderItem
 	bool Visible = true;
 
 	BoundingBox Bounds;
+
+	// Triangle hierarchy of the submesh, shared by every render item drawing it.
+	TriangleBvh* Bvh = nullptr;
+
+	// Instance of this render item in the picking scene.
+	UINT SceneIndex = -1;
  
     // World matrix of the shape that describes the object's local space
     // relative to the world space, which defines the position, orientation,
@@ -65,6 +72,13 @@ enum class RenderLayer : int
 	Count
 };
 
+// Tags of the pick queries, telling their results apart.
+enum class PickQuery : UINT
+{
+	Click = 0,
+	Hover
+};
+
 class PickingApp : public D3DApp
 {
 public:
@@ -100,7 +114,9 @@ private:
     void BuildMaterials();
     void BuildRenderItems();
     void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems);
-	void Pick(int sx, int sy);
+	void Pick(int sx, int sy, PickQuery query);
+	void UpdatePicking(const GameTimer& gt);
+	void HighlightHit(RenderItem* highlight, const SceneHit& hit);
 
 	std::array<const CD3DX12_STATIC_SAMPLER_DESC, 6> GetStaticSamplers();
 
@@ -122,6 +138,20 @@ private:
 	std::unordered_map<std::string, ComPtr<ID3DBlob>> mShaders;
 	std::unordered_map<std::string, ComPtr<ID3D12PipelineState>> mPSOs;
 
+	// Built once per submesh for picking, by the same name as its DrawArgs.
+	std::unordered_map<std::string, std::unique_ptr<TriangleBvh>> mMeshBvhs;
+
+	// Two-level hierarchy over the pickable render items, and the render item
+	// of each of its instances.
+	SceneBvh mScene;
+	std::vector<RenderItem*> mSceneItems;
+
+	// Picks run on a worker against a snapshot of mScene; their results are
+	// applied in the Update of a later frame.
+	PickQueryService mPickQueries;
+	std::vector<PickResult> mPickResults;
+	UINT64 mFrameCount = 0;
+
     std::vector<D3D12_INPUT_ELEMENT_DESC> mInputLayout;
  
 	// List of all the render items.
@@ -133,11 +163,17 @@ private:
 	//step2: To render the triangle with a highlight, we need a render-item for it.
 	RenderItem* mPickedRitem = nullptr;
 
+	// Triangle under the mouse.
+	RenderItem* mHoverRitem = nullptr;
+
     PassConstants mMainPassCB;
 
 	Camera mCamera;
 
-    POINT mLastMousePos;
+    POINT mLastMousePos = { 0, 0 };
+
+	// No hover picks until the mouse has moved over the window.
+	bool mMouseSeen = false;
 };
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance,
@@ -238,6 +274,7 @@ void PickingApp::Update(const GameTimer& gt)
         CloseHandle(eventHandle);
     }
 
+	UpdatePicking(gt);
 	AnimateMaterials(gt);
 	UpdateObjectCBs(gt);
 	UpdateMaterialBuffer(gt);
@@ -331,7 +368,7 @@ void PickingApp::OnMouseDown(WPARAM btnState, int x, int y)
 	else if((btnState & MK_RBUTTON) != 0)
 	{
 		//step4
-		Pick(x, y);
+		Pick(x, y, PickQuery::Click);
 	}
 }
 
@@ -354,6 +391,7 @@ void PickingApp::OnMouseMove(WPARAM btnState, int x, int y)
 
     mLastMousePos.x = x;
     mLastMousePos.y = y;
+    mMouseSeen = true;
 }
  
 void PickingApp::OnKeyboardInput(const GameTimer& gt)
@@ -657,6 +695,10 @@ void PickingApp::BuildCarGeometry()
 
 	geo->DrawArgs["car"] = submesh;
 
+	auto carBvh = std::make_unique<TriangleBvh>();
+	carBvh->Build(*geo, submesh);
+	mMeshBvhs["car"] = std::move(carBvh);
+
 	mGeometries[geo->Name] = std::move(geo);
 }
 
@@ -749,8 +791,17 @@ void PickingApp::BuildMaterials()
 	highlight0->Roughness = 0.0f;
 
 	
+	auto hover0 = std::make_unique<Material>();
+	hover0->Name = "hover0";
+	hover0->MatCBIndex = 2;
+	hover0->DiffuseSrvHeapIndex = 0;
+	hover0->DiffuseAlbedo = XMFLOAT4(0.0f, 0.8f, 1.0f, 0.4f);
+	hover0->FresnelR0 = XMFLOAT3(0.06f, 0.06f, 0.06f);
+	hover0->Roughness = 0.0f;
+
 	mMaterials["gray0"] = std::move(gray0);
 	mMaterials["highlight0"] = std::move(highlight0);
+	mMaterials["hover0"] = std::move(hover0);
 }
 
 void PickingApp::BuildRenderItems()
@@ -763,6 +814,7 @@ void PickingApp::BuildRenderItems()
 	carRitem->Geo = mGeometries["carGeo"].get();
 	carRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 	carRitem->Bounds = carRitem->Geo->DrawArgs["car"].Bounds;
+	carRitem->Bvh = mMeshBvhs["car"].get();
 	carRitem->IndexCount = carRitem->Geo->DrawArgs["car"].IndexCount;
 	carRitem->StartIndexLocation = carRitem->Geo->DrawArgs["car"].StartIndexLocation;
 	carRitem->BaseVertexLocation = carRitem->Geo->DrawArgs["car"].BaseVertexLocation;
@@ -788,9 +840,31 @@ void PickingApp::BuildRenderItems()
 	mPickedRitem = pickedRitem.get();
 	mRitemLayer[(int)RenderLayer::Highlight].push_back(pickedRitem.get());
 
+	auto hoverRitem = std::make_unique<RenderItem>();
+	hoverRitem->ObjCBIndex = 2;
+	hoverRitem->Mat = mMaterials["hover0"].get();
+	hoverRitem->Geo = mGeometries["carGeo"].get();
+	hoverRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	hoverRitem->Visible = false;
+	mHoverRitem = hoverRitem.get();
+	mRitemLayer[(int)RenderLayer::Highlight].push_back(hoverRitem.get());
 
 	mAllRitems.push_back(std::move(carRitem));
 	mAllRitems.push_back(std::move(pickedRitem));
+	mAllRitems.push_back(std::move(hoverRitem));
+
+	// Every opaque render item can be picked.  Items that move must call
+	// mScene.SetWorld and mScene.Refit, and hidden ones mScene.SetEnabled.
+	for(auto ri : mRitemLayer[(int)RenderLayer::Opaque])
+	{
+		ri->SceneIndex = mScene.AddInstance(ri->Bvh, XMLoadFloat4x4(&ri->World));
+		mScene.SetEnabled(ri->SceneIndex, ri->Visible);
+		mSceneItems.push_back(ri);
+	}
+	mScene.Build();
+
+	// The items never move, so one snapshot serves every pick.
+	mPickQueries.SetScene(std::make_shared<const SceneBvh>(mScene));
 }
 
 void PickingApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems)
@@ -882,107 +956,68 @@ std::array<const CD3DX12_STATIC_SAMPLER_DESC, 6> PickingApp::GetStaticSamplers()
 //int mClientHeight = 600;
 
 
-void PickingApp::Pick(int sx, int sy)
+void PickingApp::Pick(int sx, int sy, PickQuery query)
 {
 	XMFLOAT4X4 P = mCamera.GetProj4x4f();   ////XMMatrixPerspectiveFovLH(mFovY, mAspect, mNearZ, mFarZ);
 
-
-	// Compute picking ray in view space.
-	//we can shoot our picking ray through the point (v'x, v'y, 1) instead. Note that this yields the same picking ray as the one shot through the point (xv, yv, d) on the projection window.
-
-	float vx = (+2.0f*sx / mClientWidth - 1.0f) / P(0, 0);
-	float vy = (-2.0f*sy / mClientHeight + 1.0f) / P(1, 1);
-
-	// Ray definition in view space.
-	XMVECTOR rayOrigin = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
-	XMVECTOR rayDir = XMVectorSet(vx, vy, 1.0f, 0.0f);
-	
+	//Because the view matrix transforms geometry from world space to view space, the inverse of the view matrix transforms geometry from view space to world space. 
 	XMMATRIX V = mCamera.GetView();
-	XMMATRIX invView = XMMatrixInverse(&XMMatrixDeterminant(V), V);
-
-	//Generally, each object in the scene has its own local space. Therefore, the ray must be transformed to the local space of each scene object to do the intersection test.
-	//The following code shows how the picking ray is transformed from view space to the local space of an object :
-
+	XMVECTOR detView = XMMatrixDeterminant(V);
+	XMMATRIX invView = XMMatrixInverse(&detView, V);
+
+	// The ray through the pixel in world space.  The query runs on the picking worker, which
+	// transforms it to the local space of each object whose bounds it reaches; the result is
+	// applied by UpdatePicking in a later frame.
+	PickRequest request = PickQueryService::ScreenRay((UINT)query, (float)sx, (float)sy,
+		(float)mClientWidth, (float)mClientHeight, P, invView);
+
+	// A hover ray goes out every frame; only the newest is worth running, while
+	// clicks all run in order.
+	request.Latest = query == PickQuery::Hover;
+	mPickQueries.Submit(request);
+}
 
-	// Assume nothing is picked to start, so the picked render-item is invisible.
-	mPickedRitem->Visible = false;
+void PickingApp::UpdatePicking(const GameTimer& gt)
+{
+	// Results of the picks dispatched by earlier frames, oldest first, so the
+	// latest result of each kind wins.
+	mPickResults.clear();
+	mPickQueries.Collect(mPickResults);
 
-	// Check if we picked an opaque render item.  A real app might keep a separate "picking list"
-	// of objects that can be selected.   
-	for(auto ri : mRitemLayer[(int)RenderLayer::Opaque])
+	for(const PickResult& result : mPickResults)
 	{
-		auto geo = ri->Geo;
+		if(result.Tag == (UINT)PickQuery::Click)
+			HighlightHit(mPickedRitem, result.Hit);
+		else if(result.Tag == (UINT)PickQuery::Hover)
+			HighlightHit(mHoverRitem, result.Hit);
+	}
 
-		// Skip invisible render-items.
-		if(ri->Visible == false)
-			continue;
+	// Hover the triangle under the mouse while the camera is not being dragged.
+	if(mMouseSeen && (GetAsyncKeyState(VK_LBUTTON) & 0x8000) == 0)
+		Pick(mLastMousePos.x, mLastMousePos.y, PickQuery::Hover);
 
-		XMMATRIX W = XMLoadFloat4x4(&ri->World);
+	mPickQueries.Dispatch(mFrameCount++);
+}
 
-		//If W is the world matrix of an object, the matrix W−1 transforms geometry from world space to the local space of the object.
-		XMMATRIX invWorld = XMMatrixInverse(&XMMatrixDeterminant(W), W);
+void PickingApp::HighlightHit(RenderItem* highlight, const SceneHit& hit)
+{
+	// Assume nothing is picked to start, so the highlight render-item is invisible.
+	highlight->Visible = false;
 
-		//Because the view matrix transforms geometry from world space to view space, the inverse of the view matrix transforms geometry from view space to world space. 
-		XMMATRIX toLocal = XMMatrixMultiply(invView, invWorld);
+	if(hit.Instance == (UINT)-1)
+		return;
 
-		//Generally, each object in the scene has its own local space. Therefore, the ray must be transformed to the local space of each scene object to do the intersection test.
-		rayOrigin = XMVector3TransformCoord(rayOrigin, toLocal);
-		rayDir = XMVector3TransformNormal(rayDir, toLocal);
+	RenderItem* ri = mSceneItems[hit.Instance];
 
-		// Make the ray direction unit length for the intersection tests.
-		rayDir = XMVector3Normalize(rayDir);
+	highlight->Visible = true;
+	highlight->Geo = ri->Geo;
+	highlight->IndexCount = 3;
+	highlight->BaseVertexLocation = ri->BaseVertexLocation;
 
-		// If we hit the bounding box of the Mesh, then we might have picked a Mesh triangle,
-		// so do the ray/triangle tests.
-		//
-		// If we did not hit the bounding box, then it is impossible that we hit 
-		// the Mesh, so do not waste effort doing ray/triangle tests.
-		float tmin = 0.0f;
-		if(ri->Bounds.Intersects(rayOrigin, rayDir, tmin))
-		{
-			// NOTE: For the demo, we know what to cast the vertex/index data to.  If we were mixing
-			// formats, some metadata would be needed to figure out what to cast it to.
-			auto vertices = (Vertex*)geo->VertexBufferCPU->GetBufferPointer();
-			auto indices = (std::uint32_t*)geo->IndexBufferCPU->GetBufferPointer();
-			UINT triCount = ri->IndexCount / 3;
-
-			// Find the nearest ray/triangle intersection.
-			tmin = MathHelper::Infinity;
-			for(UINT i = 0; i < triCount; ++i)
-			{
-				// Indices for this triangle.
-				UINT i0 = indices[i * 3 + 0];
-				UINT i1 = indices[i * 3 + 1];
-				UINT i2 = indices[i * 3 + 2];
-
-				// Vertices for this triangle.
-				XMVECTOR v0 = XMLoadFloat3(&vertices[i0].Pos);
-				XMVECTOR v1 = XMLoadFloat3(&vertices[i1].Pos);
-				XMVECTOR v2 = XMLoadFloat3(&vertices[i2].Pos);
-
-				// We have to iterate over all the triangles in order to find the nearest intersection.
-				float t = 0.0f;
-				if(TriangleTests::Intersects(rayOrigin, rayDir, v0, v1, v2, t))
-				{
-					if(t < tmin)
-					{
-						// This is the new nearest picked triangle.
-						tmin = t;
-						UINT pickedTriangle = i;
-
-						mPickedRitem->Visible = true;
-						mPickedRitem->IndexCount = 3;
-						mPickedRitem->BaseVertexLocation = 0;
-
-						// Picked render item needs same world matrix as object picked.
-						mPickedRitem->World = ri->World;
-						mPickedRitem->NumFramesDirty = gNumFrameResources;
-
-						// Offset to the picked triangle in the mesh index buffer.
-						mPickedRitem->StartIndexLocation = 3 * pickedTriangle;
-					}
-				}
-			}
-		}
-	}
-}
\ No newline at end of file
+	// Highlight render item needs same world matrix as object picked.
+	highlight->World = ri->World;
+	highlight->NumFramesDirty = gNumFrameResources;
+
+	// Offset to the picked triangle in the mesh index buffer.
+	highlight->StartIndexLocation = ri->StartIndexLocation + 3 * hit.Triangle;
+}
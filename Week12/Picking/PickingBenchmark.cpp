@@ -0,0 +1,303 @@
+//***************************************************************************************
+// PickingBenchmark.cpp
+//
+// Headless console benchmark for Common/TriangleBvh.h.  Build it as its own console
+// project with Common/TriangleBvh.cpp, Common/BvhBuild.cpp, Common/GeometryGenerator.cpp
+// and Common/MathHelper.cpp, and run it from this folder so Models/ is found.
+//
+// For the car, the skull and a 180k triangle sphere it times the BVH build, then
+// shoots random rays at the mesh and compares the brute-force loop PickingApp::Pick
+// used to run over every triangle with TriangleTests::Intersects against the closest
+// hit query of the BVH, in microseconds per pick.  Both must find the same triangle.
+//
+// It then scatters instances of the first mesh through a scene and compares the
+// per-object loop, which inverts every world matrix and tests every object's box,
+// with the two-level Common/SceneBvh.h; build that one with Common/SceneBvh.cpp too.
+//***************************************************************************************
+
+#include <windows.h>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include "../../Common/SceneBvh.h"
+#include "../../Common/GeometryGenerator.h"
+
+using namespace std;
+using namespace DirectX;
+
+double Milliseconds(const LARGE_INTEGER& start, const LARGE_INTEGER& end)
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+
+	return 1000.0 * (double)(end.QuadPart - start.QuadPart) / (double)frequency.QuadPart;
+}
+
+struct Mesh
+{
+	std::string Name;
+	std::vector<XMFLOAT3> Positions;
+	std::vector<std::uint32_t> Indices;
+};
+
+// Reads the positions and triangles of a Models/*.txt file.
+bool LoadModel(const std::string& name, const std::string& fileName, Mesh& mesh)
+{
+	std::ifstream fin(fileName);
+	if(!fin)
+		return false;
+
+	UINT vcount = 0;
+	UINT tcount = 0;
+	std::string ignore;
+
+	fin >> ignore >> vcount;
+	fin >> ignore >> tcount;
+	fin >> ignore >> ignore >> ignore >> ignore;
+
+	mesh.Name = name;
+	mesh.Positions.resize(vcount);
+	for(UINT i = 0; i < vcount; ++i)
+	{
+		XMFLOAT3 normal;
+		fin >> mesh.Positions[i].x >> mesh.Positions[i].y >> mesh.Positions[i].z;
+		fin >> normal.x >> normal.y >> normal.z;
+	}
+
+	fin >> ignore;
+	fin >> ignore;
+	fin >> ignore;
+
+	mesh.Indices.resize(3 * tcount);
+	for(UINT i = 0; i < 3 * tcount; ++i)
+		fin >> mesh.Indices[i];
+
+	return true;
+}
+
+// The loop PickingApp::Pick ran before it had a BVH.
+UINT BruteForcePick(const Mesh& mesh, FXMVECTOR origin, FXMVECTOR dir, float& tmin)
+{
+	UINT picked = -1;
+	tmin = MathHelper::Infinity;
+
+	for(UINT i = 0; i < (UINT)mesh.Indices.size() / 3; ++i)
+	{
+		XMVECTOR v0 = XMLoadFloat3(&mesh.Positions[mesh.Indices[i * 3 + 0]]);
+		XMVECTOR v1 = XMLoadFloat3(&mesh.Positions[mesh.Indices[i * 3 + 1]]);
+		XMVECTOR v2 = XMLoadFloat3(&mesh.Positions[mesh.Indices[i * 3 + 2]]);
+
+		float t = 0.0f;
+		if(TriangleTests::Intersects(origin, dir, v0, v1, v2, t) && t < tmin)
+		{
+			tmin = t;
+			picked = i;
+		}
+	}
+
+	return picked;
+}
+
+void RunMesh(const Mesh& mesh, UINT rayCount)
+{
+	TriangleBvh bvh;
+
+	LARGE_INTEGER start, end;
+	QueryPerformanceCounter(&start);
+	bvh.Build(mesh.Positions.data(), sizeof(XMFLOAT3), mesh.Indices.data(), (UINT)mesh.Indices.size() / 3);
+	QueryPerformanceCounter(&end);
+	double buildMs = Milliseconds(start, end);
+
+	// Rays from a sphere around the mesh aimed at random points inside its
+	// box, like picks from a camera orbiting it.
+	BoundingBox bounds = bvh.GetBounds();
+	float radius = 2.0f * XMVectorGetX(XMVector3Length(XMLoadFloat3(&bounds.Extents)));
+
+	srand(rayCount);
+
+	double bruteMs = 0.0;
+	double bvhMs = 0.0;
+	UINT hits = 0;
+	UINT mismatches = 0;
+	UINT64 nodesVisited = 0;
+	UINT64 trianglesTested = 0;
+
+	for(UINT i = 0; i < rayCount; ++i)
+	{
+		XMVECTOR target = XMLoadFloat3(&bounds.Center) + XMVectorSet(
+			MathHelper::RandF(-1.0f, 1.0f) * bounds.Extents.x,
+			MathHelper::RandF(-1.0f, 1.0f) * bounds.Extents.y,
+			MathHelper::RandF(-1.0f, 1.0f) * bounds.Extents.z, 0.0f);
+		XMVECTOR origin = XMLoadFloat3(&bounds.Center) + radius * MathHelper::RandUnitVec3();
+		XMVECTOR dir = XMVector3Normalize(target - origin);
+
+		float bruteT = 0.0f;
+		QueryPerformanceCounter(&start);
+		UINT bruteTriangle = BruteForcePick(mesh, origin, dir, bruteT);
+		QueryPerformanceCounter(&end);
+		bruteMs += Milliseconds(start, end);
+
+		TriangleHit hit;
+		RayQueryStats stats;
+		QueryPerformanceCounter(&start);
+		bvh.Intersect(origin, dir, hit, FLT_MAX, &stats);
+		QueryPerformanceCounter(&end);
+		bvhMs += Milliseconds(start, end);
+
+		nodesVisited += stats.NodesVisited;
+		trianglesTested += stats.TrianglesTested;
+
+		if(hit.Triangle != (UINT)-1)
+			++hits;
+
+		// Two triangles sharing the hit edge may both report it; only a
+		// different distance is a real mismatch.
+		if(hit.Triangle != bruteTriangle &&
+			(hit.Triangle == (UINT)-1 || bruteTriangle == (UINT)-1 || fabsf(hit.T - bruteT) > 1e-4f * bruteT))
+			++mismatches;
+	}
+
+	cout << setw(8) << mesh.Name << setw(11) << mesh.Indices.size() / 3
+		<< setprecision(2) << setw(11) << buildMs << setw(7) << bvh.Depth()
+		<< setprecision(1) << setw(14) << 1000.0 * bruteMs / rayCount
+		<< setprecision(2) << setw(12) << 1000.0 * bvhMs / rayCount
+		<< setprecision(0) << setw(10) << bruteMs / bvhMs << "x"
+		<< setprecision(1) << setw(9) << (double)nodesVisited / rayCount
+		<< setw(8) << (double)trianglesTested / rayCount
+		<< setw(7) << hits << setw(12) << mismatches << endl;
+}
+
+// Picks over instanceCount randomly placed, rotated and scaled instances of mesh.
+void RunScene(const Mesh& mesh, UINT instanceCount, UINT rayCount)
+{
+	TriangleBvh meshBvh;
+	meshBvh.Build(mesh.Positions.data(), sizeof(XMFLOAT3), mesh.Indices.data(), (UINT)mesh.Indices.size() / 3);
+	BoundingBox meshBounds = meshBvh.GetBounds();
+
+	// Spread the instances so about a tenth of the scene volume is filled.
+	float meshSize = 2.0f * XMVectorGetX(XMVector3Length(XMLoadFloat3(&meshBounds.Extents)));
+	float sceneSize = meshSize * powf(10.0f * instanceCount, 1.0f / 3.0f);
+
+	srand(instanceCount);
+
+	SceneBvh scene;
+	std::vector<XMFLOAT4X4> worlds(instanceCount);
+	for(UINT i = 0; i < instanceCount; ++i)
+	{
+		float scale = MathHelper::RandF(0.5f, 1.5f);
+		XMMATRIX world = XMMatrixScaling(scale, scale, scale) *
+			XMMatrixRotationRollPitchYaw(MathHelper::RandF(0.0f, XM_2PI), MathHelper::RandF(0.0f, XM_2PI), 0.0f) *
+			XMMatrixTranslation(MathHelper::RandF(-0.5f, 0.5f) * sceneSize,
+				MathHelper::RandF(-0.5f, 0.5f) * sceneSize, MathHelper::RandF(-0.5f, 0.5f) * sceneSize);
+
+		XMStoreFloat4x4(&worlds[i], world);
+		scene.AddInstance(&meshBvh, world);
+	}
+
+	LARGE_INTEGER start, end;
+	QueryPerformanceCounter(&start);
+	scene.Build();
+	QueryPerformanceCounter(&end);
+	double buildMs = Milliseconds(start, end);
+
+	double loopMs = 0.0;
+	double sceneMs = 0.0;
+	UINT hits = 0;
+	UINT mismatches = 0;
+	UINT64 instancesTested = 0;
+
+	for(UINT i = 0; i < rayCount; ++i)
+	{
+		XMVECTOR origin = 0.75f * sceneSize * MathHelper::RandUnitVec3();
+		XMVECTOR target = XMVectorSet(MathHelper::RandF(-0.5f, 0.5f) * sceneSize,
+			MathHelper::RandF(-0.5f, 0.5f) * sceneSize, MathHelper::RandF(-0.5f, 0.5f) * sceneSize, 0.0f);
+		origin = XMVectorSetW(origin, 1.0f);
+		XMVECTOR dir = XMVector3Normalize(target - origin);
+
+		// The per-object loop, with the ray taken to each object's space from
+		// the world ray.
+		QueryPerformanceCounter(&start);
+		UINT loopInstance = -1;
+		float loopT = FLT_MAX;
+		for(UINT j = 0; j < instanceCount; ++j)
+		{
+			XMMATRIX W = XMLoadFloat4x4(&worlds[j]);
+			XMVECTOR det = XMMatrixDeterminant(W);
+			XMMATRIX invWorld = XMMatrixInverse(&det, W);
+
+			XMVECTOR localOrigin = XMVector3TransformCoord(origin, invWorld);
+			XMVECTOR localDir = XMVector3TransformNormal(dir, invWorld);
+
+			float tmin = 0.0f;
+			TriangleHit hit;
+			if(meshBounds.Intersects(localOrigin, XMVector3Normalize(localDir), tmin) &&
+				meshBvh.Intersect(localOrigin, localDir, hit, loopT))
+			{
+				loopT = hit.T;
+				loopInstance = j;
+			}
+		}
+		QueryPerformanceCounter(&end);
+		loopMs += Milliseconds(start, end);
+
+		SceneHit hit;
+		SceneRayStats stats;
+		QueryPerformanceCounter(&start);
+		scene.Intersect(origin, dir, hit, FLT_MAX, &stats);
+		QueryPerformanceCounter(&end);
+		sceneMs += Milliseconds(start, end);
+
+		instancesTested += stats.InstancesTested;
+
+		if(hit.Instance != (UINT)-1)
+			++hits;
+
+		if(hit.Instance != loopInstance &&
+			(hit.Instance == (UINT)-1 || loopInstance == (UINT)-1 || fabsf(hit.T - loopT) > 1e-4f * loopT))
+			++mismatches;
+	}
+
+	cout << setw(10) << instanceCount << setprecision(2) << setw(11) << buildMs << setw(7) << scene.Depth()
+		<< setprecision(1) << setw(13) << 1000.0 * loopMs / rayCount
+		<< setprecision(2) << setw(14) << 1000.0 * sceneMs / rayCount
+		<< setprecision(0) << setw(10) << loopMs / sceneMs << "x"
+		<< setprecision(1) << setw(12) << (double)instancesTested / rayCount
+		<< setw(7) << hits << setw(12) << mismatches << endl;
+}
+
+int main()
+{
+	const UINT rayCount = 1000;
+
+	std::vector<Mesh> meshes;
+
+	Mesh mesh;
+	if(LoadModel("car", "Models/car.txt", mesh))
+		meshes.push_back(mesh);
+	if(LoadModel("skull", "Models/skull.txt", mesh))
+		meshes.push_back(mesh);
+
+	GeometryGenerator geoGen;
+	GeometryGenerator::MeshData sphere = geoGen.CreateSphere(5.0f, 300, 300);
+	mesh.Name = "sphere";
+	mesh.Positions.clear();
+	for(auto& v : sphere.Vertices)
+		mesh.Positions.push_back(v.Position);
+	mesh.Indices = sphere.Indices32;
+	meshes.push_back(mesh);
+
+	cout << fixed << rayCount << " random picks per mesh" << endl << endl;
+	cout << "    mesh  triangles   build ms  depth   brute us/pick  bvh us/pick   speedup   nodes    tris   hits  mismatches" << endl;
+
+	for(const Mesh& m : meshes)
+		RunMesh(m, rayCount);
+
+	cout << endl << "Scenes of " << meshes[0].Name << " instances" << endl << endl;
+	cout << " instances   build ms  depth  loop us/pick  scene us/pick   speedup   instances   hits  mismatches" << endl;
+
+	for(UINT instanceCount : { 10, 100, 1000, 10000 })
+		RunScene(meshes[0], instanceCount, rayCount);
+
+	system("pause");
+	return 0;
+}
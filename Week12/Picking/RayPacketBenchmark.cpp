@@ -0,0 +1,406 @@
+//***************************************************************************************
+// RayPacketBenchmark.cpp
+//
+// Headless console benchmark for Common/RayPacket.h.  Build it as its own console
+// project with Common/RayPacket.cpp, Common/TriangleBvh.cpp, Common/BvhBuild.cpp,
+// Common/Culling.cpp, Common/GeometryGenerator.cpp and Common/MathHelper.cpp.
+//
+// It first checks the packet tests against TriangleTests::Intersects and
+// BoundingBox::Intersects on random rays, with both the SSE and the AVX path, then
+// measures rays per second for:
+//   -every ray against every one of a set of triangles and of boxes, one ray at a
+//    time with DirectXCollision and 8 at a time with the packet tests;
+//   -closest-hit queries on a TriangleBvh, with TriangleBvh::Intersect per ray and
+//    with TriangleBvh::IntersectPacket, for coherent rays from one eye through a
+//    grid of pixels and for incoherent rays.
+//***************************************************************************************
+
+#include <windows.h>
+#include <iostream>
+#include <iomanip>
+#include "../../Common/TriangleBvh.h"
+#include "../../Common/RayPacket.h"
+#include "../../Common/GeometryGenerator.h"
+
+using namespace std;
+using namespace DirectX;
+
+double Milliseconds(const LARGE_INTEGER& start, const LARGE_INTEGER& end)
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+
+	return 1000.0 * (double)(end.QuadPart - start.QuadPart) / (double)frequency.QuadPart;
+}
+
+struct Ray
+{
+	XMFLOAT3 Origin;
+	XMFLOAT3 Dir;
+};
+
+struct Triangle
+{
+	XMFLOAT3 V0;
+	XMFLOAT3 V1;
+	XMFLOAT3 V2;
+	XMFLOAT3 Edge1;
+	XMFLOAT3 Edge2;
+};
+
+XMFLOAT3 RandomPoint(float size)
+{
+	return XMFLOAT3(MathHelper::RandF(-size, size), MathHelper::RandF(-size, size), MathHelper::RandF(-size, size));
+}
+
+// Unit length rays from a box of half size 4 towards the middle, since
+// DirectXCollision wants unit directions.
+std::vector<Ray> RandomRays(UINT count)
+{
+	std::vector<Ray> rays(count);
+	for(Ray& ray : rays)
+	{
+		ray.Origin = RandomPoint(4.0f);
+		XMFLOAT3 target = RandomPoint(1.0f);
+		XMStoreFloat3(&ray.Dir, XMVector3Normalize(XMLoadFloat3(&target) - XMLoadFloat3(&ray.Origin)));
+	}
+
+	return rays;
+}
+
+std::vector<Triangle> RandomTriangles(UINT count)
+{
+	std::vector<Triangle> triangles(count);
+	for(Triangle& triangle : triangles)
+	{
+		XMFLOAT3 center = RandomPoint(1.0f);
+		XMFLOAT3 p0 = RandomPoint(0.5f);
+		XMFLOAT3 p1 = RandomPoint(0.5f);
+		XMFLOAT3 p2 = RandomPoint(0.5f);
+
+		XMVECTOR c = XMLoadFloat3(&center);
+		XMStoreFloat3(&triangle.V0, c + XMLoadFloat3(&p0));
+		XMStoreFloat3(&triangle.V1, c + XMLoadFloat3(&p1));
+		XMStoreFloat3(&triangle.V2, c + XMLoadFloat3(&p2));
+		XMStoreFloat3(&triangle.Edge1, XMLoadFloat3(&triangle.V1) - XMLoadFloat3(&triangle.V0));
+		XMStoreFloat3(&triangle.Edge2, XMLoadFloat3(&triangle.V2) - XMLoadFloat3(&triangle.V0));
+	}
+
+	return triangles;
+}
+
+std::vector<BoundingBox> RandomBoxes(UINT count)
+{
+	std::vector<BoundingBox> boxes(count);
+	for(BoundingBox& box : boxes)
+	{
+		box.Center = RandomPoint(1.5f);
+		box.Extents = XMFLOAT3(MathHelper::RandF(0.05f, 0.5f), MathHelper::RandF(0.05f, 0.5f), MathHelper::RandF(0.05f, 0.5f));
+	}
+
+	return boxes;
+}
+
+UINT CountBits(UINT mask)
+{
+	UINT count = 0;
+	for(; mask != 0; mask &= mask - 1)
+		++count;
+	return count;
+}
+
+RayPacket MakePacket(const std::vector<Ray>& rays, UINT first)
+{
+	RayPacket packet;
+	for(UINT lane = 0; lane < RayPacket::Size && first + lane < rays.size(); ++lane)
+	{
+		const Ray& ray = rays[first + lane];
+		packet.SetRay(lane, XMLoadFloat3(&ray.Origin), XMLoadFloat3(&ray.Dir));
+	}
+
+	return packet;
+}
+
+// Hits and distances of every ray against every triangle and box, one at a
+// time with DirectXCollision and through the packet tests.  A ray grazing an
+// edge may rarely go either way.
+void Validate(const std::vector<Ray>& rays, const std::vector<Triangle>& triangles,
+	const std::vector<BoundingBox>& boxes)
+{
+	UINT triangleHits = 0;
+	UINT triangleMismatches = 0;
+	UINT boxHits = 0;
+	UINT boxMismatches = 0;
+
+	for(UINT first = 0; first < rays.size(); first += RayPacket::Size)
+	{
+		for(UINT t = 0; t < triangles.size(); ++t)
+		{
+			const Triangle& triangle = triangles[t];
+
+			// A fresh packet per triangle, so TMax does not hide hits.
+			RayPacket packet = MakePacket(rays, first);
+			RayPacketHits hits;
+			UINT mask = RayPacketTests::IntersectTriangle(packet, triangle.V0, triangle.Edge1, triangle.Edge2, t, hits);
+
+			for(UINT lane = 0; lane < RayPacket::Size && first + lane < rays.size(); ++lane)
+			{
+				const Ray& ray = rays[first + lane];
+
+				float dist = 0.0f;
+				bool hit = TriangleTests::Intersects(XMLoadFloat3(&ray.Origin), XMLoadFloat3(&ray.Dir),
+					XMLoadFloat3(&triangle.V0), XMLoadFloat3(&triangle.V1), XMLoadFloat3(&triangle.V2), dist);
+				bool packetHit = (mask & (1u << lane)) != 0;
+
+				if(hit)
+					++triangleHits;
+
+				if(hit != packetHit || (hit && fabsf(dist - hits.T[lane]) > 1e-4f*(1.0f + dist)))
+					++triangleMismatches;
+			}
+		}
+
+		RayPacket packet = MakePacket(rays, first);
+		for(const BoundingBox& box : boxes)
+		{
+			XMFLOAT3 boxMin(box.Center.x - box.Extents.x, box.Center.y - box.Extents.y, box.Center.z - box.Extents.z);
+			XMFLOAT3 boxMax(box.Center.x + box.Extents.x, box.Center.y + box.Extents.y, box.Center.z + box.Extents.z);
+
+			float tEnter[RayPacket::Size];
+			UINT mask = RayPacketTests::IntersectBox(packet, boxMin, boxMax, tEnter);
+
+			for(UINT lane = 0; lane < RayPacket::Size && first + lane < rays.size(); ++lane)
+			{
+				const Ray& ray = rays[first + lane];
+
+				float dist = 0.0f;
+				bool hit = box.Intersects(XMLoadFloat3(&ray.Origin), XMLoadFloat3(&ray.Dir), dist);
+				bool packetHit = (mask & (1u << lane)) != 0;
+
+				if(hit)
+					++boxHits;
+
+				if(hit != packetHit || (hit && fabsf(dist - tEnter[lane]) > 1e-4f*(1.0f + dist)))
+					++boxMismatches;
+			}
+		}
+	}
+
+	cout << setw(5) << (RayPacketTests::UsesAvx() ? "AVX" : "SSE")
+		<< setw(16) << triangleHits << setw(12) << triangleMismatches
+		<< setw(12) << boxHits << setw(12) << boxMismatches << endl;
+}
+
+// Every ray against every triangle and every box, in millions of ray tests
+// per second.
+void RunBruteForce(const std::vector<Ray>& rays, const std::vector<Triangle>& triangles,
+	const std::vector<BoundingBox>& boxes)
+{
+	double triangleTests = (double)rays.size() * triangles.size();
+	double boxTests = (double)rays.size() * boxes.size();
+	UINT found = 0;
+	LARGE_INTEGER start, end;
+
+	QueryPerformanceCounter(&start);
+	for(const Ray& ray : rays)
+	{
+		XMVECTOR origin = XMLoadFloat3(&ray.Origin);
+		XMVECTOR dir = XMLoadFloat3(&ray.Dir);
+		for(const Triangle& triangle : triangles)
+		{
+			float dist = 0.0f;
+			found += TriangleTests::Intersects(origin, dir, XMLoadFloat3(&triangle.V0),
+				XMLoadFloat3(&triangle.V1), XMLoadFloat3(&triangle.V2), dist) ? 1 : 0;
+		}
+	}
+	QueryPerformanceCounter(&end);
+	double scalarTriangleMs = Milliseconds(start, end);
+
+	QueryPerformanceCounter(&start);
+	for(const Ray& ray : rays)
+	{
+		XMVECTOR origin = XMLoadFloat3(&ray.Origin);
+		XMVECTOR dir = XMLoadFloat3(&ray.Dir);
+		for(const BoundingBox& box : boxes)
+		{
+			float dist = 0.0f;
+			found += box.Intersects(origin, dir, dist) ? 1 : 0;
+		}
+	}
+	QueryPerformanceCounter(&end);
+	double scalarBoxMs = Milliseconds(start, end);
+
+	cout << "     DirectXCollision" << setprecision(1)
+		<< setw(14) << triangleTests / scalarTriangleMs / 1000.0
+		<< setw(14) << boxTests / scalarBoxMs / 1000.0 << endl;
+
+	for(bool avx : { false, true })
+	{
+		RayPacketTests::SetAvxEnabled(avx);
+		if(avx && !RayPacketTests::UsesAvx())
+			break;
+
+		QueryPerformanceCounter(&start);
+		for(UINT first = 0; first < rays.size(); first += RayPacket::Size)
+		{
+			RayPacket packet = MakePacket(rays, first);
+			RayPacketHits hits;
+			for(UINT t = 0; t < triangles.size(); ++t)
+			{
+				// Keep every hit, like the scalar loop.
+				float tMax[RayPacket::Size];
+				memcpy(tMax, packet.TMax, sizeof(tMax));
+				found += CountBits(RayPacketTests::IntersectTriangle(packet, triangles[t].V0,
+					triangles[t].Edge1, triangles[t].Edge2, t, hits));
+				memcpy(packet.TMax, tMax, sizeof(tMax));
+			}
+		}
+		QueryPerformanceCounter(&end);
+		double packetTriangleMs = Milliseconds(start, end);
+
+		QueryPerformanceCounter(&start);
+		for(UINT first = 0; first < rays.size(); first += RayPacket::Size)
+		{
+			RayPacket packet = MakePacket(rays, first);
+			for(const BoundingBox& box : boxes)
+			{
+				XMFLOAT3 boxMin(box.Center.x - box.Extents.x, box.Center.y - box.Extents.y, box.Center.z - box.Extents.z);
+				XMFLOAT3 boxMax(box.Center.x + box.Extents.x, box.Center.y + box.Extents.y, box.Center.z + box.Extents.z);
+				found += CountBits(RayPacketTests::IntersectBox(packet, boxMin, boxMax));
+			}
+		}
+		QueryPerformanceCounter(&end);
+		double packetBoxMs = Milliseconds(start, end);
+
+		cout << setw(21) << (avx ? "AVX packets" : "SSE packets")
+			<< setw(14) << triangleTests / packetTriangleMs / 1000.0
+			<< setw(14) << boxTests / packetBoxMs / 1000.0 << endl;
+	}
+
+	// Keeps the loops from being optimized away.
+	if(found == 0)
+		cout << "no hits" << endl;
+}
+
+// Closest-hit queries on a mesh hierarchy, one ray at a time and in packets,
+// in millions of rays per second.
+void RunBvh(const char* name, const TriangleBvh& bvh, const std::vector<Ray>& rays)
+{
+	UINT scalarHits = 0;
+	UINT packetHits = 0;
+	UINT mismatches = 0;
+	UINT64 scalarNodes = 0;
+	UINT64 packetNodes = 0;
+	std::vector<TriangleHit> scalarResults(rays.size());
+
+	LARGE_INTEGER start, end;
+	QueryPerformanceCounter(&start);
+	for(UINT i = 0; i < rays.size(); ++i)
+	{
+		RayQueryStats stats;
+		if(bvh.Intersect(XMLoadFloat3(&rays[i].Origin), XMLoadFloat3(&rays[i].Dir), scalarResults[i], FLT_MAX, &stats))
+			++scalarHits;
+		scalarNodes += stats.NodesVisited;
+	}
+	QueryPerformanceCounter(&end);
+	double scalarMs = Milliseconds(start, end);
+
+	QueryPerformanceCounter(&start);
+	for(UINT first = 0; first < rays.size(); first += RayPacket::Size)
+	{
+		RayPacket packet = MakePacket(rays, first);
+		RayPacketHits hits;
+		RayQueryStats stats;
+		UINT mask = bvh.IntersectPacket(packet, hits, &stats);
+		packetHits += CountBits(mask);
+		packetNodes += stats.NodesVisited;
+
+		for(UINT lane = 0; lane < RayPacket::Size && first + lane < rays.size(); ++lane)
+		{
+			const TriangleHit& hit = scalarResults[first + lane];
+			bool packetHit = (mask & (1u << lane)) != 0;
+			if(packetHit != (hit.Triangle != (UINT)-1) ||
+				(packetHit && fabsf(hit.T - hits.T[lane]) > 1e-5f*hit.T))
+				++mismatches;
+		}
+	}
+	QueryPerformanceCounter(&end);
+	double packetMs = Milliseconds(start, end);
+
+	cout << setw(12) << name << setprecision(2)
+		<< setw(14) << rays.size() / scalarMs / 1000.0
+		<< setw(14) << rays.size() / packetMs / 1000.0
+		<< setprecision(1) << setw(14) << (double)scalarNodes / rays.size()
+		<< setw(14) << (double)packetNodes * RayPacket::Size / rays.size()
+		<< setw(8) << scalarHits << setw(8) << packetHits << setw(12) << mismatches << endl;
+}
+
+int main()
+{
+	srand(2024);
+
+	cout << fixed;
+
+	// Check both paths against DirectXCollision.
+	std::vector<Ray> rays = RandomRays(4096);
+	std::vector<Triangle> triangles = RandomTriangles(256);
+	std::vector<BoundingBox> boxes = RandomBoxes(256);
+
+	cout << rays.size() << " rays against " << triangles.size() << " triangles and "
+		<< boxes.size() << " boxes" << endl << endl;
+	cout << "path  triangle hits  mismatches   box hits  mismatches" << endl;
+
+	for(bool avx : { false, true })
+	{
+		RayPacketTests::SetAvxEnabled(avx);
+		if(avx && !RayPacketTests::UsesAvx())
+		{
+			cout << "  AVX not supported" << endl;
+			break;
+		}
+		Validate(rays, triangles, boxes);
+	}
+
+	cout << endl << "Every ray against every primitive, millions of tests per second" << endl << endl;
+	cout << "                       triangles         boxes" << endl;
+	RunBruteForce(rays, triangles, boxes);
+
+	RayPacketTests::SetAvxEnabled(true);
+
+	// Closest hits on a sphere of 80k triangles.
+	GeometryGenerator geoGen;
+	GeometryGenerator::MeshData sphere = geoGen.CreateSphere(1.0f, 200, 200);
+
+	TriangleBvh bvh;
+	bvh.Build(&sphere.Vertices[0].Position, sizeof(GeometryGenerator::Vertex),
+		sphere.Indices32.data(), (UINT)sphere.Indices32.size() / 3);
+
+	// A 256x256 image of the sphere from one eye, row by row, so each packet
+	// holds 8 neighbouring pixels.
+	const UINT imageSize = 256;
+	std::vector<Ray> coherentRays;
+	XMFLOAT3 eye(0.0f, 0.5f, -3.0f);
+	for(UINT y = 0; y < imageSize; ++y)
+	{
+		for(UINT x = 0; x < imageSize; ++x)
+		{
+			XMVECTOR pixel = XMVectorSet(1.5f*(2.0f*x / imageSize - 1.0f), 1.5f*(1.0f - 2.0f*y / imageSize), 0.0f, 0.0f);
+
+			Ray ray;
+			ray.Origin = eye;
+			XMStoreFloat3(&ray.Dir, XMVector3Normalize(pixel - XMLoadFloat3(&eye)));
+			coherentRays.push_back(ray);
+		}
+	}
+
+	std::vector<Ray> incoherentRays = RandomRays(imageSize*imageSize);
+
+	cout << endl << "Closest hits on " << bvh.TriangleCount() << " triangles, millions of rays per second, "
+		<< (RayPacketTests::UsesAvx() ? "AVX" : "SSE") << endl << endl;
+	cout << "        rays    one by one       packets    nodes/ray  nodes/packet    hits  packet  mismatches" << endl;
+	RunBvh("coherent", bvh, coherentRays);
+	RunBvh("incoherent", bvh, incoherentRays);
+
+	system("pause");
+	return 0;
+}
@@ -9,6 +9,7 @@
 #include "../../Common/UploadBuffer.h"
 #include "../../Common/GeometryGenerator.h"
 #include "../../Common/Camera.h"
+#include "../../Common/Culling.h"
 #include "FrameResource.h"
 #include "CubeRenderTarget.h"
 
@@ -56,6 +57,15 @@ struct RenderItem
     UINT IndexCount = 0;
     UINT StartIndexLocation = 0;
     int BaseVertexLocation = 0;
+
+	// Bounds of the submesh in local space and the index of the world bounds
+	// in mCullingBounds; the sky has none and is drawn in every view.
+	BoundingBox Bounds;
+	UINT CullingIndex = -1;
+
+	// Bit v is set when pass v sees the item: 0 is the main camera and 1-6
+	// are the cube map faces, matching the pass constant buffers.
+	UINT ViewMask = 0xffffffff;
 };
 
 //step10: We have three render layers. 
@@ -95,6 +105,7 @@ private:
 	void UpdateMaterialBuffer(const GameTimer& gt);
 	void UpdateMainPassCB(const GameTimer& gt);
 	void UpdateCubeMapFacePassCBs();
+	void UpdateViewMasks();
 
 	void LoadTextures();
     void BuildRootSignature();
@@ -107,7 +118,7 @@ private:
     void BuildFrameResources();
     void BuildMaterials();
     void BuildRenderItems();
-    void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems);
+    void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems, UINT view);
 	void DrawSceneToCubeMap();
 
 	std::array<const CD3DX12_STATIC_SAMPLER_DESC, 6> GetStaticSamplers();
@@ -144,6 +155,11 @@ private:
 
 	RenderItem* mSkullRitem = nullptr;
 
+	// World bounds of every render item but the sky, and the masks of the
+	// views that see them, recomputed each frame.
+	CullingBounds mCullingBounds;
+	std::vector<UINT> mViewMasks;
+
 	std::unique_ptr<CubeRenderTarget> mDynamicCubeMap = nullptr;
 	CD3DX12_CPU_DESCRIPTOR_HANDLE mCubeDSV;
 
@@ -293,6 +309,7 @@ void DynamicCubeMapApp::Update(const GameTimer& gt)
 	UpdateObjectCBs(gt);
 	UpdateMaterialBuffer(gt);
 	UpdateMainPassCB(gt);
+	UpdateViewMasks();
 }
 
 void DynamicCubeMapApp::Draw(const GameTimer& gt)
@@ -360,15 +377,15 @@ void DynamicCubeMapApp::Draw(const GameTimer& gt)
 	//but with the dynamic cube map applied to the center sphere:
 
 
-	DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::OpaqueDynamicReflectors]);
+	DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::OpaqueDynamicReflectors], 0);
 
 	// Use the static "background" cube map for the other objects (including the sky)
 	mCommandList->SetGraphicsRootDescriptorTable(3, skyTexDescriptor);
 
-	DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Opaque]);
+	DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Opaque], 0);
 
 	mCommandList->SetPipelineState(mPSOs["sky"].Get());
-	DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Sky]);
+	DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Sky], 0);
 
     // Indicate a state transition on the resource usage.
 	mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
@@ -568,6 +585,29 @@ void DynamicCubeMapApp::UpdateCubeMapFacePassCBs()
 	}
 }
 
+//
+// Tests every render item against the main camera and the six cube map face
+// cameras in one pass over the bounds, so each pass only draws what it sees.
+//
+void DynamicCubeMapApp::UpdateViewMasks()
+{
+	// The skull circles the center sphere, so its world bounds change each frame.
+	mCullingBounds.Set(mSkullRitem->CullingIndex, mSkullRitem->Bounds, XMLoadFloat4x4(&mSkullRitem->World));
+
+	FrustumPlanes views[7];
+	views[0] = FrustumPlanes::FromViewProj(XMMatrixMultiply(mCamera.GetView(), mCamera.GetProj()));
+	for(int i = 0; i < 6; ++i)
+		views[1 + i] = FrustumPlanes::FromViewProj(XMMatrixMultiply(mCubeMapCamera[i].GetView(), mCubeMapCamera[i].GetProj()));
+
+	Culling::CullViews(mCullingBounds, views, 7, mViewMasks.data());
+
+	for(auto& ri : mAllRitems)
+	{
+		if(ri->CullingIndex != -1)
+			ri->ViewMask = mViewMasks[ri->CullingIndex];
+	}
+}
+
 void DynamicCubeMapApp::LoadTextures()
 {
     std::vector<std::string> texNames =
@@ -991,6 +1031,13 @@ void DynamicCubeMapApp::BuildShapeGeometry()
 	geo->IndexFormat = DXGI_FORMAT_R16_UINT;
 	geo->IndexBufferByteSize = ibByteSize;
 
+	// Local bounds for culling.
+	UINT vertexStride = sizeof(GeometryGenerator::Vertex);
+	BoundingBox::CreateFromPoints(boxSubmesh.Bounds, box.Vertices.size(), &box.Vertices[0].Position, vertexStride);
+	BoundingBox::CreateFromPoints(gridSubmesh.Bounds, grid.Vertices.size(), &grid.Vertices[0].Position, vertexStride);
+	BoundingBox::CreateFromPoints(sphereSubmesh.Bounds, sphere.Vertices.size(), &sphere.Vertices[0].Position, vertexStride);
+	BoundingBox::CreateFromPoints(cylinderSubmesh.Bounds, cylinder.Vertices.size(), &cylinder.Vertices[0].Position, vertexStride);
+
 	geo->DrawArgs["box"] = boxSubmesh;
 	geo->DrawArgs["grid"] = gridSubmesh;
 	geo->DrawArgs["sphere"] = sphereSubmesh;
@@ -1146,6 +1193,7 @@ void DynamicCubeMapApp::BuildRenderItems()
 	skullRitem->IndexCount = skullRitem->Geo->DrawArgs["skull"].IndexCount;
 	skullRitem->StartIndexLocation = skullRitem->Geo->DrawArgs["skull"].StartIndexLocation;
 	skullRitem->BaseVertexLocation = skullRitem->Geo->DrawArgs["skull"].BaseVertexLocation;
+	skullRitem->Bounds = skullRitem->Geo->DrawArgs["skull"].Bounds;
 
 	mSkullRitem = skullRitem.get();
 
@@ -1162,6 +1210,7 @@ void DynamicCubeMapApp::BuildRenderItems()
 	boxRitem->IndexCount = boxRitem->Geo->DrawArgs["box"].IndexCount;
 	boxRitem->StartIndexLocation = boxRitem->Geo->DrawArgs["box"].StartIndexLocation;
 	boxRitem->BaseVertexLocation = boxRitem->Geo->DrawArgs["box"].BaseVertexLocation;
+	boxRitem->Bounds = boxRitem->Geo->DrawArgs["box"].Bounds;
 
 	mRitemLayer[(int)RenderLayer::Opaque].push_back(boxRitem.get());
 	mAllRitems.push_back(std::move(boxRitem));
@@ -1176,6 +1225,7 @@ void DynamicCubeMapApp::BuildRenderItems()
 	globeRitem->IndexCount = globeRitem->Geo->DrawArgs["sphere"].IndexCount;
 	globeRitem->StartIndexLocation = globeRitem->Geo->DrawArgs["sphere"].StartIndexLocation;
 	globeRitem->BaseVertexLocation = globeRitem->Geo->DrawArgs["sphere"].BaseVertexLocation;
+	globeRitem->Bounds = globeRitem->Geo->DrawArgs["sphere"].Bounds;
 
 	mRitemLayer[(int)RenderLayer::OpaqueDynamicReflectors].push_back(globeRitem.get());
 	mAllRitems.push_back(std::move(globeRitem));
@@ -1190,6 +1240,7 @@ void DynamicCubeMapApp::BuildRenderItems()
     gridRitem->IndexCount = gridRitem->Geo->DrawArgs["grid"].IndexCount;
     gridRitem->StartIndexLocation = gridRitem->Geo->DrawArgs["grid"].StartIndexLocation;
     gridRitem->BaseVertexLocation = gridRitem->Geo->DrawArgs["grid"].BaseVertexLocation;
+	gridRitem->Bounds = gridRitem->Geo->DrawArgs["grid"].Bounds;
 
 	mRitemLayer[(int)RenderLayer::Opaque].push_back(gridRitem.get());
 	mAllRitems.push_back(std::move(gridRitem));
@@ -1218,6 +1269,7 @@ void DynamicCubeMapApp::BuildRenderItems()
 		leftCylRitem->IndexCount = leftCylRitem->Geo->DrawArgs["cylinder"].IndexCount;
 		leftCylRitem->StartIndexLocation = leftCylRitem->Geo->DrawArgs["cylinder"].StartIndexLocation;
 		leftCylRitem->BaseVertexLocation = leftCylRitem->Geo->DrawArgs["cylinder"].BaseVertexLocation;
+		leftCylRitem->Bounds = leftCylRitem->Geo->DrawArgs["cylinder"].Bounds;
 
 		XMStoreFloat4x4(&rightCylRitem->World, leftCylWorld);
 		XMStoreFloat4x4(&rightCylRitem->TexTransform, brickTexTransform);
@@ -1228,6 +1280,7 @@ void DynamicCubeMapApp::BuildRenderItems()
 		rightCylRitem->IndexCount = rightCylRitem->Geo->DrawArgs["cylinder"].IndexCount;
 		rightCylRitem->StartIndexLocation = rightCylRitem->Geo->DrawArgs["cylinder"].StartIndexLocation;
 		rightCylRitem->BaseVertexLocation = rightCylRitem->Geo->DrawArgs["cylinder"].BaseVertexLocation;
+		rightCylRitem->Bounds = rightCylRitem->Geo->DrawArgs["cylinder"].Bounds;
 
 		XMStoreFloat4x4(&leftSphereRitem->World, leftSphereWorld);
 		leftSphereRitem->TexTransform = MathHelper::Identity4x4();
@@ -1238,6 +1291,7 @@ void DynamicCubeMapApp::BuildRenderItems()
 		leftSphereRitem->IndexCount = leftSphereRitem->Geo->DrawArgs["sphere"].IndexCount;
 		leftSphereRitem->StartIndexLocation = leftSphereRitem->Geo->DrawArgs["sphere"].StartIndexLocation;
 		leftSphereRitem->BaseVertexLocation = leftSphereRitem->Geo->DrawArgs["sphere"].BaseVertexLocation;
+		leftSphereRitem->Bounds = leftSphereRitem->Geo->DrawArgs["sphere"].Bounds;
 
 		XMStoreFloat4x4(&rightSphereRitem->World, rightSphereWorld);
 		rightSphereRitem->TexTransform = MathHelper::Identity4x4();
@@ -1248,6 +1302,7 @@ void DynamicCubeMapApp::BuildRenderItems()
 		rightSphereRitem->IndexCount = rightSphereRitem->Geo->DrawArgs["sphere"].IndexCount;
 		rightSphereRitem->StartIndexLocation = rightSphereRitem->Geo->DrawArgs["sphere"].StartIndexLocation;
 		rightSphereRitem->BaseVertexLocation = rightSphereRitem->Geo->DrawArgs["sphere"].BaseVertexLocation;
+		rightSphereRitem->Bounds = rightSphereRitem->Geo->DrawArgs["sphere"].Bounds;
 
 		mRitemLayer[(int)RenderLayer::Opaque].push_back(leftCylRitem.get());
 		mRitemLayer[(int)RenderLayer::Opaque].push_back(rightCylRitem.get());
@@ -1259,9 +1314,16 @@ void DynamicCubeMapApp::BuildRenderItems()
 		mAllRitems.push_back(std::move(leftSphereRitem));
 		mAllRitems.push_back(std::move(rightSphereRitem));
 	}
+
+	for(int layer : { (int)RenderLayer::Opaque, (int)RenderLayer::OpaqueDynamicReflectors })
+	{
+		for(auto ri : mRitemLayer[layer])
+			ri->CullingIndex = mCullingBounds.Add(ri->Bounds, XMLoadFloat4x4(&ri->World));
+	}
+	mViewMasks.resize(mCullingBounds.PaddedSize());
 }
 
-void DynamicCubeMapApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems)
+void DynamicCubeMapApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems, UINT view)
 {
     UINT objCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
  
@@ -1272,6 +1334,9 @@ void DynamicCubeMapApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, cons
     {
         auto ri = ritems[i];
 
+		if((ri->ViewMask & (1u << view)) == 0)
+			continue;
+
         cmdList->IASetVertexBuffers(0, 1, &ri->Geo->VertexBufferView());
         cmdList->IASetIndexBuffer(&ri->Geo->IndexBufferView());
         cmdList->IASetPrimitiveTopology(ri->PrimitiveType);
@@ -1312,10 +1377,10 @@ void DynamicCubeMapApp::DrawSceneToCubeMap()
 		D3D12_GPU_VIRTUAL_ADDRESS passCBAddress = passCB->GetGPUVirtualAddress() + (1+i)*passCBByteSize;
 		mCommandList->SetGraphicsRootConstantBufferView(1, passCBAddress);
 
-		DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Opaque]);
+		DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Opaque], 1 + i);
 
 		mCommandList->SetPipelineState(mPSOs["sky"].Get());
-		DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Sky]);
+		DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Sky], 1 + i);
 
 		mCommandList->SetPipelineState(mPSOs["opaque"].Get());
 	}
@@ -0,0 +1,151 @@
+//***************************************************************************************
+// CascadeBenchmark.cpp
+//
+// Headless console benchmark for Common/ShadowCascades.h.  Build it as its own console
+// project with Common/ShadowCascades.cpp, Common/Camera.cpp and Common/MathHelper.cpp.
+//
+// For the ShadowMapApp scene and lens it prints how much world space one shadow map
+// texel covers at a few distances from the camera, for the old single 2048x2048 map
+// around the scene bounds and for four cascades in maps of 2048, 1024 and 512 texels.
+//
+// It then walks and turns the camera through the scene for a few thousand frames and
+// prints the time of a Build, and how far a fixed point of the world drifted across
+// the texel grid between frames in which its cascade kept its size.  That drift is
+// what makes shadow edges shimmer; with the snapping it stays at rounding error.
+//***************************************************************************************
+
+#include <windows.h>
+#include <iostream>
+#include <iomanip>
+#include "../../Common/ShadowCascades.h"
+
+using namespace std;
+using namespace DirectX;
+
+double Milliseconds(const LARGE_INTEGER& start, const LARGE_INTEGER& end)
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+
+	return 1000.0 * (double)(end.QuadPart - start.QuadPart) / (double)frequency.QuadPart;
+}
+
+// World space width of one texel of the cascade covering depth, or 0 when no
+// cascade does.
+float TexelSizeAt(const ShadowCascades& cascades, float depth, UINT tileSize, UINT borderTexels)
+{
+	for(UINT i = 0; i < cascades.CascadeCount(); ++i)
+	{
+		const ShadowCascade& cascade = cascades.GetCascade(i);
+		if(depth <= cascade.SplitFar)
+			return 2.0f*cascade.Radius / (tileSize - 2*borderTexels);
+	}
+
+	return 0.0f;
+}
+
+int main()
+{
+	const UINT cascadeCount = 4;
+	const UINT frameCount = 5000;
+
+	// Same as ShadowMapApp.
+	BoundingSphere sceneBounds;
+	sceneBounds.Center = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	sceneBounds.Radius = sqrtf(10.0f*10.0f + 15.0f*15.0f);
+
+	XMVECTOR lightDir = XMVector3Normalize(XMVectorSet(0.57735f, -0.57735f, 0.57735f, 0.0f));
+
+	Camera camera;
+	camera.SetLens(0.25f*MathHelper::Pi, 16.0f / 9.0f, 1.0f, 1000.0f);
+	camera.SetPosition(0.0f, 2.0f, -15.0f);
+	camera.UpdateViewMatrix();
+
+	//
+	// Texel sizes.
+	//
+
+	const float depths[] = { 2.0f, 5.0f, 10.0f, 20.0f, 35.0f };
+
+	cout << "world units per shadow map texel, camera at (0, 2, -15)" << endl << endl;
+	cout << "depth   single 2048";
+	for(UINT mapSize : { 2048u, 1024u, 512u })
+		cout << "   cascades " << setw(4) << mapSize;
+	cout << endl;
+
+	ShadowCascades cascades;
+	for(float depth : depths)
+	{
+		cout << setw(5) << depth << fixed << setprecision(4)
+			<< setw(14) << 2.0f*sceneBounds.Radius / 2048.0f;
+
+		for(UINT mapSize : { 2048u, 1024u, 512u })
+		{
+			UINT tileSize = mapSize / 2;
+			cascades.Build(camera, lightDir, sceneBounds, cascadeCount, tileSize);
+			cout << setw(17) << TexelSizeAt(cascades, depth, tileSize, cascades.BorderTexels);
+		}
+		cout << endl;
+	}
+
+	//
+	// Stability and cost.
+	//
+
+	const UINT tileSize = 1024;
+	const UINT mapSize = ShadowCascades::MapWidth(cascadeCount, tileSize);
+
+	XMVECTOR probe = XMVectorSet(3.3f, 0.7f, -2.1f, 1.0f);
+	float lastTexel[ShadowCascades::MaxCascades] = {};
+	float lastRadius[ShadowCascades::MaxCascades] = {};
+
+	double totalMs = 0.0;
+	float worstDrift = 0.0f;
+	UINT resizes = 0;
+
+	srand(44);
+	for(UINT frame = 0; frame < frameCount; ++frame)
+	{
+		// Walk and look around like the app's keys and mouse do.
+		camera.Walk(MathHelper::RandF(0.0f, 0.15f));
+		camera.Strafe(MathHelper::RandF(-0.05f, 0.05f));
+		camera.RotateY(MathHelper::RandF(-0.02f, 0.03f));
+		camera.UpdateViewMatrix();
+
+		LARGE_INTEGER start, end;
+		QueryPerformanceCounter(&start);
+		cascades.Build(camera, lightDir, sceneBounds, cascadeCount, tileSize);
+		QueryPerformanceCounter(&end);
+		totalMs += Milliseconds(start, end);
+
+		for(UINT i = 0; i < cascadeCount; ++i)
+		{
+			const ShadowCascade& cascade = cascades.GetCascade(i);
+
+			XMVECTOR texC = XMVector3TransformCoord(probe, XMLoadFloat4x4(&cascade.ShadowTransform));
+			float texel = XMVectorGetX(texC)*mapSize;
+			float fraction = texel - floorf(texel);
+
+			if(frame > 0 && cascade.Radius == lastRadius[i])
+			{
+				float drift = fabsf(fraction - lastTexel[i]);
+				worstDrift = MathHelper::Max(worstDrift, MathHelper::Min(drift, 1.0f - drift));
+			}
+			else if(frame > 0)
+			{
+				resizes++;
+			}
+
+			lastTexel[i] = fraction;
+			lastRadius[i] = cascade.Radius;
+		}
+	}
+
+	cout << endl << fixed << setprecision(4)
+		<< "build:   " << 1000.0*totalMs / frameCount << " us average" << endl
+		<< "drift:   " << worstDrift << " texels worst between frames" << endl
+		<< "resizes: " << resizes << " cascade resizes in " << frameCount << " frames" << endl;
+
+	system("pause");
+	return 0;
+}
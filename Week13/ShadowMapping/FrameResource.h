@@ -3,6 +3,7 @@
 #include "../../Common/d3dUtil.h"
 #include "../../Common/MathHelper.h"
 #include "../../Common/UploadBuffer.h"
+#include "../../Common/ShadowCascades.h"
 
 struct ObjectConstants
 {
@@ -22,7 +23,10 @@ struct PassConstants
     DirectX::XMFLOAT4X4 InvProj = MathHelper::Identity4x4();
     DirectX::XMFLOAT4X4 ViewProj = MathHelper::Identity4x4();
     DirectX::XMFLOAT4X4 InvViewProj = MathHelper::Identity4x4();
-    DirectX::XMFLOAT4X4 ShadowTransform = MathHelper::Identity4x4();
+    DirectX::XMFLOAT4X4 ShadowTransforms[ShadowCascades::MaxCascades];
+
+    // Camera view space depth where each cascade ends.
+    DirectX::XMFLOAT4 CascadeSplits = { 0.0f, 0.0f, 0.0f, 0.0f };
     DirectX::XMFLOAT3 EyePosW = { 0.0f, 0.0f, 0.0f };
     float cbPerObjectPad1 = 0.0f;
     DirectX::XMFLOAT2 RenderTargetSize = { 0.0f, 0.0f };
@@ -69,7 +69,8 @@ cbuffer cbPass : register(b1)
     float4x4 gInvProj;
     float4x4 gViewProj;
     float4x4 gInvViewProj;
-    float4x4 gShadowTransform;
+    float4x4 gShadowTransforms[4];
+    float4 gCascadeSplits;
     float3 gEyePosW;
     float cbPerObjectPad1;
     float2 gRenderTargetSize;
@@ -147,5 +148,23 @@ float CalcShadowFactor(float4 shadowPosH)
     return percentLit / 9.0f;
 }
 
+//---------------------------------------------------------------------------------------
+// Shadow factor of a point from the cascade that covers its depth in the camera view.
+// Points past the last split are lit.
+//---------------------------------------------------------------------------------------
 
+float CalcCascadedShadowFactor(float3 posW)
+{
+    float depthV = mul(float4(posW, 1.0f), gView).z;
 
+    // Unused cascades repeat the last split, so they are never picked.
+    uint cascade = 0;
+    [unroll]
+    for(uint i = 0; i < 3; ++i)
+        cascade += depthV > gCascadeSplits[i] ? 1 : 0;
+
+    if(depthV > gCascadeSplits[cascade])
+        return 1.0f;
+
+    return CalcShadowFactor(mul(float4(posW, 1.0f), gShadowTransforms[cascade]));
+}
@@ -29,8 +29,7 @@ struct VertexIn
 struct VertexOut
 {
 	float4 PosH    : SV_POSITION;
-    float4 ShadowPosH : POSITION0;
-    float3 PosW    : POSITION1;
+    float3 PosW    : POSITION;
     float3 NormalW : NORMAL;
 	float3 TangentW : TANGENT;
 	float2 TexC    : TEXCOORD;
@@ -58,9 +57,6 @@ VertexOut VS(VertexIn vin)
 	// Output vertex attributes for interpolation across triangle.
 	float4 texC = mul(float4(vin.TexC, 0.0f, 1.0f), gTexTransform);
 	vout.TexC = mul(texC, matData.MatTransform).xy;
-
-    // Generate projective tex-coords to project shadow map onto scene.
-    vout.ShadowPosH = mul(posW, gShadowTransform);
 	
     return vout;
 }
@@ -103,7 +99,7 @@ float4 PS(VertexOut pin) : SV_Target
 	//step10:The shadow factor does not affect ambient light since that is indirect light, and it also does not affect reflective light coming from the environment map.
     // Only the first light casts a shadow.
     float3 shadowFactor = float3(1.0f, 1.0f, 1.0f);
-    shadowFactor[0] = CalcShadowFactor(pin.ShadowPosH);
+    shadowFactor[0] = CalcCascadedShadowFactor(pin.PosW);
 
     const float shininess = (1.0f - roughness) * normalMapSample.a;
     Material mat = { diffuseAlbedo, fresnelR0, shininess };
@@ -7,6 +7,9 @@
 #include "../../Common/UploadBuffer.h"
 #include "../../Common/GeometryGenerator.h"
 #include "../../Common/Camera.h"
+#include "../../Common/Culling.h"
+#include "../../Common/ShadowCascades.h"
+#include "../../Common/ShadowCasterCuller.h"
 #include "FrameResource.h"
 #include "ShadowMap.h"
 
@@ -16,6 +19,11 @@ using namespace DirectX::PackedVector;
 
 const int gNumFrameResources = 3;
 
+// The first light's shadow is split into cascades, each drawn to a tile of
+// the shadow map.
+const UINT gNumCascades = 4;
+const UINT gCascadeTileSize = 1024;
+
 // Lightweight structure stores parameters to draw a shape.  This will
 // vary from app-to-app.
 struct RenderItem
@@ -49,6 +57,16 @@ struct RenderItem
     UINT IndexCount = 0;
     UINT StartIndexLocation = 0;
     int BaseVertexLocation = 0;
+
+	// Bounds of the submesh in local space and the index of the world bounds
+	// in mCullingBounds; the sky and the debug quad have none and are drawn
+	// in every view.
+	BoundingBox Bounds;
+	UINT CullingIndex = -1;
+
+	// Bit v is set when view v sees the item: 0 is the camera and 1 + c
+	// shadow cascade c, matching the pass constant buffers.
+	UINT ViewMask = 0xffffffff;
 };
 
 enum class RenderLayer : int
@@ -86,6 +104,9 @@ private:
     void UpdateShadowTransform(const GameTimer& gt);
 	void UpdateMainPassCB(const GameTimer& gt);
     void UpdateShadowPassCB(const GameTimer& gt);
+	void UpdateCullingBounds();
+	void UpdateViewMasks();
+	void UpdateCascadeRedraws();
 
 	void LoadTextures();
     void BuildRootSignature();
@@ -97,7 +118,7 @@ private:
     void BuildFrameResources();
     void BuildMaterials();
     void BuildRenderItems();
-    void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems);
+    void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems, UINT view);
     void DrawSceneToShadowMap();
 
 	std::array<const CD3DX12_STATIC_SAMPLER_DESC, 7> GetStaticSamplers();
@@ -135,7 +156,7 @@ private:
     CD3DX12_GPU_DESCRIPTOR_HANDLE mNullSrv;
 
     PassConstants mMainPassCB;  // index 0 of pass cbuffer.
-    PassConstants mShadowPassCB;// index 1 of pass cbuffer.
+    PassConstants mShadowPassCB;// index 1 + c of pass cbuffer for cascade c.
 
 	Camera mCamera;
 
@@ -143,12 +164,32 @@ private:
 
     DirectX::BoundingSphere mSceneBounds;
 
-    float mLightNearZ = 0.0f;
-    float mLightFarZ = 0.0f;
-    XMFLOAT3 mLightPosW;
-    XMFLOAT4X4 mLightView = MathHelper::Identity4x4();
-    XMFLOAT4X4 mLightProj = MathHelper::Identity4x4();
-    XMFLOAT4X4 mShadowTransform = MathHelper::Identity4x4();
+	// World bounds of the opaque render items, and the masks of the views
+	// that see them, recomputed each frame.
+	CullingBounds mCullingBounds;
+	std::vector<UINT> mViewMasks;
+
+	// Nonzero for the bounds whose item moved this frame.
+	std::vector<UINT> mMoved;
+
+    ShadowCascades mCascades;
+    ShadowCasterCuller mCasterCuller;
+
+	// The shadow map outlives the frame resources, so a cascade's tile is
+	// only redrawn when its light matrices changed, it gained a caster or
+	// one of its casters moved.  The masks and matrices it was last drawn
+	// with are kept to tell.
+	bool mCascadeRedraw[gNumCascades] = {};
+	bool mCascadeDrawn[gNumCascades] = {};
+	XMFLOAT4X4 mDrawnLightView[gNumCascades];
+	XMFLOAT4X4 mDrawnLightProj[gNumCascades];
+	std::vector<UINT> mDrawnMasks;
+
+	ShadowCasterStats mCasterStats[gNumCascades];
+
+	// Keys 1 and 2 stop and restart the light, so the shadow pass can be
+	// skipped.
+	bool mLightPaused = false;
 
     float mLightRotationAngle = 0.0f;
     XMFLOAT3 mBaseLightDirections[3] = {
@@ -218,8 +259,9 @@ bool ShadowMapApp::Initialize()
  
 	//step6: The first step in shadow mapping is to build the shadow map. To do this, we create a ShadowMap instance:
 
-    mShadowMap = std::make_unique<ShadowMap>(
-        md3dDevice.Get(), 2048, 2048);
+    mShadowMap = std::make_unique<ShadowMap>(md3dDevice.Get(),
+        ShadowCascades::MapWidth(gNumCascades, gCascadeTileSize),
+        ShadowCascades::MapHeight(gNumCascades, gCascadeTileSize));
 
 	LoadTextures();
     BuildRootSignature();
@@ -293,7 +335,8 @@ void ShadowMapApp::Update(const GameTimer& gt)
     // Animate the lights (and hence shadows).
     //
 
-    mLightRotationAngle += 0.1f*gt.DeltaTime();
+    if(!mLightPaused)
+        mLightRotationAngle += 0.1f*gt.DeltaTime();
 
     XMMATRIX R = XMMatrixRotationY(mLightRotationAngle);
     for(int i = 0; i < 3; ++i)
@@ -304,9 +347,12 @@ void ShadowMapApp::Update(const GameTimer& gt)
     }
 
 	AnimateMaterials(gt);
+	UpdateCullingBounds();
 	UpdateObjectCBs(gt);
 	UpdateMaterialBuffer(gt);
     UpdateShadowTransform(gt);
+	UpdateViewMasks();
+	UpdateCascadeRedraws();
 	UpdateMainPassCB(gt);
     UpdateShadowPassCB(gt);
 }
@@ -370,13 +416,13 @@ void ShadowMapApp::Draw(const GameTimer& gt)
     mCommandList->SetGraphicsRootDescriptorTable(3, skyTexDescriptor);
 
     mCommandList->SetPipelineState(mPSOs["opaque"].Get());
-    DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Opaque]);
+    DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Opaque], 0);
 
     mCommandList->SetPipelineState(mPSOs["debug"].Get());
-    DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Debug]);
+    DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Debug], 0);
 
 	mCommandList->SetPipelineState(mPSOs["sky"].Get());
-	DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Sky]);
+	DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Sky], 0);
 
     // Indicate a state transition on the resource usage.
 	mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
@@ -447,6 +493,12 @@ void ShadowMapApp::OnKeyboardInput(const GameTimer& gt)
 	if(GetAsyncKeyState('D') & 0x8000)
 		mCamera.Strafe(10.0f*dt);
 
+	if(GetAsyncKeyState('1') & 0x8000)
+		mLightPaused = true;
+
+	if(GetAsyncKeyState('2') & 0x8000)
+		mLightPaused = false;
+
 	mCamera.UpdateViewMatrix();
 }
  
@@ -455,6 +507,24 @@ void ShadowMapApp::AnimateMaterials(const GameTimer& gt)
 	
 }
 
+//
+// Refreshes the world bounds of the opaque items whose world matrix changed.
+// Runs before UpdateObjectCBs, which counts the dirty frames down.
+//
+void ShadowMapApp::UpdateCullingBounds()
+{
+	std::fill(mMoved.begin(), mMoved.end(), 0);
+
+	for(auto ri : mRitemLayer[(int)RenderLayer::Opaque])
+	{
+		if(ri->NumFramesDirty > 0)
+		{
+			mCullingBounds.Set(ri->CullingIndex, ri->Bounds, XMLoadFloat4x4(&ri->World));
+			mMoved[ri->CullingIndex] = 1;
+		}
+	}
+}
+
 void ShadowMapApp::UpdateObjectCBs(const GameTimer& gt)
 {
 	auto currObjectCB = mCurrFrameResource->ObjectCB.get();
@@ -510,42 +580,13 @@ void ShadowMapApp::UpdateMaterialBuffer(const GameTimer& gt)
 
 void ShadowMapApp::UpdateShadowTransform(const GameTimer& gt)
 {
-    // Only the first "main" light casts a shadow.
+    // Only the first "main" light casts a shadow.  Rather than one projection
+    // around the whole scene, the camera frustum is split into cascades that
+    // each get a tile of the shadow map, so the texels go where the camera
+    // looks.
     XMVECTOR lightDir = XMLoadFloat3(&mRotatedLightDirections[0]);
-    XMVECTOR lightPos = -2.0f*mSceneBounds.Radius*lightDir;
-    XMVECTOR targetPos = XMLoadFloat3(&mSceneBounds.Center);
-    XMVECTOR lightUp = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
-    XMMATRIX lightView = XMMatrixLookAtLH(lightPos, targetPos, lightUp);
-
-    XMStoreFloat3(&mLightPosW, lightPos);
-
-    // Transform bounding sphere to light space.
-    XMFLOAT3 sphereCenterLS;
-    XMStoreFloat3(&sphereCenterLS, XMVector3TransformCoord(targetPos, lightView));
-
-    // Ortho frustum in light space encloses scene.
-    float l = sphereCenterLS.x - mSceneBounds.Radius;
-    float b = sphereCenterLS.y - mSceneBounds.Radius;
-    float n = sphereCenterLS.z - mSceneBounds.Radius;
-    float r = sphereCenterLS.x + mSceneBounds.Radius;
-    float t = sphereCenterLS.y + mSceneBounds.Radius;
-    float f = sphereCenterLS.z + mSceneBounds.Radius;
-
-    mLightNearZ = n;
-    mLightFarZ = f;
-    XMMATRIX lightProj = XMMatrixOrthographicOffCenterLH(l, r, b, t, n, f);
-
-    // Transform NDC space [-1,+1]^2 to texture space [0,1]^2
-    XMMATRIX T(
-        0.5f, 0.0f, 0.0f, 0.0f,
-        0.0f, -0.5f, 0.0f, 0.0f,
-        0.0f, 0.0f, 1.0f, 0.0f,
-        0.5f, 0.5f, 0.0f, 1.0f);
-
-    XMMATRIX S = lightView*lightProj*T;
-    XMStoreFloat4x4(&mLightView, lightView);
-    XMStoreFloat4x4(&mLightProj, lightProj);
-    XMStoreFloat4x4(&mShadowTransform, S);
+
+    mCascades.Build(mCamera, lightDir, mSceneBounds, gNumCascades, gCascadeTileSize);
 }
 
 void ShadowMapApp::UpdateMainPassCB(const GameTimer& gt)
@@ -558,15 +599,25 @@ void ShadowMapApp::UpdateMainPassCB(const GameTimer& gt)
 	XMMATRIX invProj = XMMatrixInverse(&XMMatrixDeterminant(proj), proj);
 	XMMATRIX invViewProj = XMMatrixInverse(&XMMatrixDeterminant(viewProj), viewProj);
 
-    XMMATRIX shadowTransform = XMLoadFloat4x4(&mShadowTransform);
-
 	XMStoreFloat4x4(&mMainPassCB.View, XMMatrixTranspose(view));
 	XMStoreFloat4x4(&mMainPassCB.InvView, XMMatrixTranspose(invView));
 	XMStoreFloat4x4(&mMainPassCB.Proj, XMMatrixTranspose(proj));
 	XMStoreFloat4x4(&mMainPassCB.InvProj, XMMatrixTranspose(invProj));
 	XMStoreFloat4x4(&mMainPassCB.ViewProj, XMMatrixTranspose(viewProj));
 	XMStoreFloat4x4(&mMainPassCB.InvViewProj, XMMatrixTranspose(invViewProj));
-    XMStoreFloat4x4(&mMainPassCB.ShadowTransform, XMMatrixTranspose(shadowTransform));
+
+    // Unused cascades repeat the last one, which the shader never picks.
+    float splits[ShadowCascades::MaxCascades];
+    for(UINT i = 0; i < ShadowCascades::MaxCascades; ++i)
+    {
+        const ShadowCascade& cascade = mCascades.GetCascade(MathHelper::Min(i, gNumCascades - 1));
+
+        XMMATRIX shadowTransform = XMLoadFloat4x4(&cascade.ShadowTransform);
+        XMStoreFloat4x4(&mMainPassCB.ShadowTransforms[i], XMMatrixTranspose(shadowTransform));
+        splits[i] = cascade.SplitFar;
+    }
+    mMainPassCB.CascadeSplits = XMFLOAT4(splits[0], splits[1], splits[2], splits[3]);
+
 	mMainPassCB.EyePosW = mCamera.GetPosition3f();
 	mMainPassCB.RenderTargetSize = XMFLOAT2((float)mClientWidth, (float)mClientHeight);
 	mMainPassCB.InvRenderTargetSize = XMFLOAT2(1.0f / mClientWidth, 1.0f / mClientHeight);
@@ -586,33 +637,128 @@ void ShadowMapApp::UpdateMainPassCB(const GameTimer& gt)
 	currPassCB->CopyData(0, mMainPassCB);
 }
 
-void ShadowMapApp::UpdateShadowPassCB(const GameTimer& gt)
+//
+// Tests the opaque render items against the camera and every shadow cascade
+// in one pass over the bounds, so the main pass and each cascade only draw
+// what they see.  Each cascade then drops the casters whose shadow cannot
+// land on an item the camera sees within the cascade, and its near and far
+// planes close in on the rest.
+//
+void ShadowMapApp::UpdateViewMasks()
+{
+	FrustumPlanes views[1 + gNumCascades];
+	views[0] = FrustumPlanes::FromViewProj(XMMatrixMultiply(mCamera.GetView(), mCamera.GetProj()));
+	for(UINT i = 0; i < gNumCascades; ++i)
+	{
+		const ShadowCascade& cascade = mCascades.GetCascade(i);
+		views[1 + i] = FrustumPlanes::FromViewProj(XMMatrixMultiply(
+			XMLoadFloat4x4(&cascade.View), XMLoadFloat4x4(&cascade.Proj)));
+	}
+
+	Culling::CullViews(mCullingBounds, views, 1 + gNumCascades, mViewMasks.data());
+
+	for(UINT i = 0; i < gNumCascades; ++i)
+	{
+		const ShadowCascade& cascade = mCascades.GetCascade(i);
+		BoundingSphere region(cascade.Center, cascade.Radius);
+
+		float nearZ, farZ;
+		if(mCasterCuller.Cull(mCullingBounds, mViewMasks.data(), 1u, 1u << (1 + i),
+			XMLoadFloat4x4(&cascade.View), region, nearZ, farZ, &mCasterStats[i]))
+		{
+			// Round outwards to sixteenths of the radius, so small camera moves
+			// keep the same projection and the tile can be kept.
+			float step = cascade.Radius / 16.0f;
+			nearZ = floorf(nearZ / step)*step;
+			farZ = (floorf(farZ / step) + 1.0f)*step;
+
+			mCascades.SetDepthRange(i, nearZ, farZ);
+		}
+	}
+
+	for(auto& ri : mAllRitems)
+	{
+		if(ri->CullingIndex != -1)
+			ri->ViewMask = mViewMasks[ri->CullingIndex];
+	}
+}
+
+void ShadowMapApp::UpdateCascadeRedraws()
 {
-    XMMATRIX view = XMLoadFloat4x4(&mLightView);
-    XMMATRIX proj = XMLoadFloat4x4(&mLightProj);
-
-    XMMATRIX viewProj = XMMatrixMultiply(view, proj);
-    XMMATRIX invView = XMMatrixInverse(&XMMatrixDeterminant(view), view);
-    XMMATRIX invProj = XMMatrixInverse(&XMMatrixDeterminant(proj), proj);
-    XMMATRIX invViewProj = XMMatrixInverse(&XMMatrixDeterminant(viewProj), viewProj);
-
-    UINT w = mShadowMap->Width();
-    UINT h = mShadowMap->Height();
-
-    XMStoreFloat4x4(&mShadowPassCB.View, XMMatrixTranspose(view));
-    XMStoreFloat4x4(&mShadowPassCB.InvView, XMMatrixTranspose(invView));
-    XMStoreFloat4x4(&mShadowPassCB.Proj, XMMatrixTranspose(proj));
-    XMStoreFloat4x4(&mShadowPassCB.InvProj, XMMatrixTranspose(invProj));
-    XMStoreFloat4x4(&mShadowPassCB.ViewProj, XMMatrixTranspose(viewProj));
-    XMStoreFloat4x4(&mShadowPassCB.InvViewProj, XMMatrixTranspose(invViewProj));
-    mShadowPassCB.EyePosW = mLightPosW;
-    mShadowPassCB.RenderTargetSize = XMFLOAT2((float)w, (float)h);
-    mShadowPassCB.InvRenderTargetSize = XMFLOAT2(1.0f / w, 1.0f / h);
-    mShadowPassCB.NearZ = mLightNearZ;
-    mShadowPassCB.FarZ = mLightFarZ;
+	UINT castersBefore = 0;
+	UINT castersAfter = 0;
+	UINT redraws = 0;
+
+	for(UINT i = 0; i < gNumCascades; ++i)
+	{
+		const ShadowCascade& cascade = mCascades.GetCascade(i);
+		UINT bit = 1u << (1 + i);
+
+		bool redraw = !mCascadeDrawn[i] ||
+			memcmp(&cascade.View, &mDrawnLightView[i], sizeof(XMFLOAT4X4)) != 0 ||
+			memcmp(&cascade.Proj, &mDrawnLightProj[i], sizeof(XMFLOAT4X4)) != 0;
+
+		// Casters drawn last time that are no longer needed do no harm, but
+		// new ones and moving ones must be drawn.
+		for(UINT j = 0; j < mCullingBounds.Size() && !redraw; ++j)
+		{
+			bool caster = (mViewMasks[j] & bit) != 0;
+			bool drawn = (mDrawnMasks[j] & bit) != 0;
+			redraw = (caster && !drawn) || (mMoved[j] && (caster || drawn));
+		}
+
+		if(redraw)
+		{
+			for(UINT j = 0; j < mCullingBounds.Size(); ++j)
+				mDrawnMasks[j] = (mDrawnMasks[j] & ~bit) | (mViewMasks[j] & bit);
+
+			mDrawnLightView[i] = cascade.View;
+			mDrawnLightProj[i] = cascade.Proj;
+			mCascadeDrawn[i] = true;
+			redraws++;
+		}
+
+		mCascadeRedraw[i] = redraw;
+		castersBefore += mCasterStats[i].CastersBefore;
+		castersAfter += mCasterStats[i].CastersAfter;
+	}
+
+	std::wostringstream outs;
+	outs << L"Shadow Map Demo    casters " << castersAfter << L" of " << castersBefore <<
+		L", cascades redrawn " << redraws << L" of " << gNumCascades;
+	mMainWndCaption = outs.str();
+}
 
+void ShadowMapApp::UpdateShadowPassCB(const GameTimer& gt)
+{
     auto currPassCB = mCurrFrameResource->PassCB.get();
-    currPassCB->CopyData(1, mShadowPassCB);
+
+    for(UINT i = 0; i < gNumCascades; ++i)
+    {
+        const ShadowCascade& cascade = mCascades.GetCascade(i);
+
+        XMMATRIX view = XMLoadFloat4x4(&cascade.View);
+        XMMATRIX proj = XMLoadFloat4x4(&cascade.Proj);
+
+        XMMATRIX viewProj = XMMatrixMultiply(view, proj);
+        XMMATRIX invView = XMMatrixInverse(&XMMatrixDeterminant(view), view);
+        XMMATRIX invProj = XMMatrixInverse(&XMMatrixDeterminant(proj), proj);
+        XMMATRIX invViewProj = XMMatrixInverse(&XMMatrixDeterminant(viewProj), viewProj);
+
+        XMStoreFloat4x4(&mShadowPassCB.View, XMMatrixTranspose(view));
+        XMStoreFloat4x4(&mShadowPassCB.InvView, XMMatrixTranspose(invView));
+        XMStoreFloat4x4(&mShadowPassCB.Proj, XMMatrixTranspose(proj));
+        XMStoreFloat4x4(&mShadowPassCB.InvProj, XMMatrixTranspose(invProj));
+        XMStoreFloat4x4(&mShadowPassCB.ViewProj, XMMatrixTranspose(viewProj));
+        XMStoreFloat4x4(&mShadowPassCB.InvViewProj, XMMatrixTranspose(invViewProj));
+        XMStoreFloat3(&mShadowPassCB.EyePosW, invView.r[3]);
+        mShadowPassCB.RenderTargetSize = XMFLOAT2((float)gCascadeTileSize, (float)gCascadeTileSize);
+        mShadowPassCB.InvRenderTargetSize = XMFLOAT2(1.0f / gCascadeTileSize, 1.0f / gCascadeTileSize);
+        mShadowPassCB.NearZ = cascade.NearZ;
+        mShadowPassCB.FarZ = cascade.FarZ;
+
+        currPassCB->CopyData(1 + i, mShadowPassCB);
+    }
 }
 
 void ShadowMapApp::LoadTextures()
@@ -946,6 +1092,13 @@ void ShadowMapApp::BuildShapeGeometry()
 	geo->IndexFormat = DXGI_FORMAT_R16_UINT;
 	geo->IndexBufferByteSize = ibByteSize;
 
+	// Local bounds for culling.
+	UINT vertexStride = sizeof(GeometryGenerator::Vertex);
+	BoundingBox::CreateFromPoints(boxSubmesh.Bounds, box.Vertices.size(), &box.Vertices[0].Position, vertexStride);
+	BoundingBox::CreateFromPoints(gridSubmesh.Bounds, grid.Vertices.size(), &grid.Vertices[0].Position, vertexStride);
+	BoundingBox::CreateFromPoints(sphereSubmesh.Bounds, sphere.Vertices.size(), &sphere.Vertices[0].Position, vertexStride);
+	BoundingBox::CreateFromPoints(cylinderSubmesh.Bounds, cylinder.Vertices.size(), &cylinder.Vertices[0].Position, vertexStride);
+
 	geo->DrawArgs["box"] = boxSubmesh;
 	geo->DrawArgs["grid"] = gridSubmesh;
 	geo->DrawArgs["sphere"] = sphereSubmesh;
@@ -1194,7 +1347,7 @@ void ShadowMapApp::BuildFrameResources()
     for(int i = 0; i < gNumFrameResources; ++i)
     {
         mFrameResources.push_back(std::make_unique<FrameResource>(md3dDevice.Get(),
-            2, (UINT)mAllRitems.size(), (UINT)mMaterials.size()));
+            1 + gNumCascades, (UINT)mAllRitems.size(), (UINT)mMaterials.size()));
     }
 }
 
@@ -1292,6 +1445,7 @@ void ShadowMapApp::BuildRenderItems()
 	boxRitem->IndexCount = boxRitem->Geo->DrawArgs["box"].IndexCount;
 	boxRitem->StartIndexLocation = boxRitem->Geo->DrawArgs["box"].StartIndexLocation;
 	boxRitem->BaseVertexLocation = boxRitem->Geo->DrawArgs["box"].BaseVertexLocation;
+	boxRitem->Bounds = boxRitem->Geo->DrawArgs["box"].Bounds;
 
 	mRitemLayer[(int)RenderLayer::Opaque].push_back(boxRitem.get());
 	mAllRitems.push_back(std::move(boxRitem));
@@ -1306,6 +1460,7 @@ void ShadowMapApp::BuildRenderItems()
     skullRitem->IndexCount = skullRitem->Geo->DrawArgs["skull"].IndexCount;
     skullRitem->StartIndexLocation = skullRitem->Geo->DrawArgs["skull"].StartIndexLocation;
     skullRitem->BaseVertexLocation = skullRitem->Geo->DrawArgs["skull"].BaseVertexLocation;
+    skullRitem->Bounds = skullRitem->Geo->DrawArgs["skull"].Bounds;
 
     mRitemLayer[(int)RenderLayer::Opaque].push_back(skullRitem.get());
     mAllRitems.push_back(std::move(skullRitem));
@@ -1320,6 +1475,7 @@ void ShadowMapApp::BuildRenderItems()
     gridRitem->IndexCount = gridRitem->Geo->DrawArgs["grid"].IndexCount;
     gridRitem->StartIndexLocation = gridRitem->Geo->DrawArgs["grid"].StartIndexLocation;
     gridRitem->BaseVertexLocation = gridRitem->Geo->DrawArgs["grid"].BaseVertexLocation;
+    gridRitem->Bounds = gridRitem->Geo->DrawArgs["grid"].Bounds;
 
 	mRitemLayer[(int)RenderLayer::Opaque].push_back(gridRitem.get());
 	mAllRitems.push_back(std::move(gridRitem));
@@ -1348,6 +1504,7 @@ void ShadowMapApp::BuildRenderItems()
 		leftCylRitem->IndexCount = leftCylRitem->Geo->DrawArgs["cylinder"].IndexCount;
 		leftCylRitem->StartIndexLocation = leftCylRitem->Geo->DrawArgs["cylinder"].StartIndexLocation;
 		leftCylRitem->BaseVertexLocation = leftCylRitem->Geo->DrawArgs["cylinder"].BaseVertexLocation;
+		leftCylRitem->Bounds = leftCylRitem->Geo->DrawArgs["cylinder"].Bounds;
 
 		XMStoreFloat4x4(&rightCylRitem->World, leftCylWorld);
 		XMStoreFloat4x4(&rightCylRitem->TexTransform, brickTexTransform);
@@ -1358,6 +1515,7 @@ void ShadowMapApp::BuildRenderItems()
 		rightCylRitem->IndexCount = rightCylRitem->Geo->DrawArgs["cylinder"].IndexCount;
 		rightCylRitem->StartIndexLocation = rightCylRitem->Geo->DrawArgs["cylinder"].StartIndexLocation;
 		rightCylRitem->BaseVertexLocation = rightCylRitem->Geo->DrawArgs["cylinder"].BaseVertexLocation;
+		rightCylRitem->Bounds = rightCylRitem->Geo->DrawArgs["cylinder"].Bounds;
 
 		XMStoreFloat4x4(&leftSphereRitem->World, leftSphereWorld);
 		leftSphereRitem->TexTransform = MathHelper::Identity4x4();
@@ -1368,6 +1526,7 @@ void ShadowMapApp::BuildRenderItems()
 		leftSphereRitem->IndexCount = leftSphereRitem->Geo->DrawArgs["sphere"].IndexCount;
 		leftSphereRitem->StartIndexLocation = leftSphereRitem->Geo->DrawArgs["sphere"].StartIndexLocation;
 		leftSphereRitem->BaseVertexLocation = leftSphereRitem->Geo->DrawArgs["sphere"].BaseVertexLocation;
+		leftSphereRitem->Bounds = leftSphereRitem->Geo->DrawArgs["sphere"].Bounds;
 
 		XMStoreFloat4x4(&rightSphereRitem->World, rightSphereWorld);
 		rightSphereRitem->TexTransform = MathHelper::Identity4x4();
@@ -1378,6 +1537,7 @@ void ShadowMapApp::BuildRenderItems()
 		rightSphereRitem->IndexCount = rightSphereRitem->Geo->DrawArgs["sphere"].IndexCount;
 		rightSphereRitem->StartIndexLocation = rightSphereRitem->Geo->DrawArgs["sphere"].StartIndexLocation;
 		rightSphereRitem->BaseVertexLocation = rightSphereRitem->Geo->DrawArgs["sphere"].BaseVertexLocation;
+		rightSphereRitem->Bounds = rightSphereRitem->Geo->DrawArgs["sphere"].Bounds;
 
 		mRitemLayer[(int)RenderLayer::Opaque].push_back(leftCylRitem.get());
 		mRitemLayer[(int)RenderLayer::Opaque].push_back(rightCylRitem.get());
@@ -1389,9 +1549,15 @@ void ShadowMapApp::BuildRenderItems()
 		mAllRitems.push_back(std::move(leftSphereRitem));
 		mAllRitems.push_back(std::move(rightSphereRitem));
 	}
+
+	for(auto ri : mRitemLayer[(int)RenderLayer::Opaque])
+		ri->CullingIndex = mCullingBounds.Add(ri->Bounds, XMLoadFloat4x4(&ri->World));
+	mViewMasks.resize(mCullingBounds.PaddedSize());
+	mDrawnMasks.resize(mCullingBounds.PaddedSize());
+	mMoved.resize(mCullingBounds.PaddedSize());
 }
 
-void ShadowMapApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems)
+void ShadowMapApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems, UINT view)
 {
     UINT objCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
  
@@ -1402,6 +1568,9 @@ void ShadowMapApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std
     {
         auto ri = ritems[i];
 
+		if((ri->ViewMask & (1u << view)) == 0)
+			continue;
+
         cmdList->IASetVertexBuffers(0, 1, &ri->Geo->VertexBufferView());
         cmdList->IASetIndexBuffer(&ri->Geo->IndexBufferView());
         cmdList->IASetPrimitiveTopology(ri->PrimitiveType);
@@ -1416,8 +1585,14 @@ void ShadowMapApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std
 
 void ShadowMapApp::DrawSceneToShadowMap()
 {
-    mCommandList->RSSetViewports(1, &mShadowMap->Viewport());
-    mCommandList->RSSetScissorRects(1, &mShadowMap->ScissorRect());
+    // Tiles that are still valid keep last frame's contents, and when none
+    // needs drawing the shadow pass is skipped entirely.
+    bool anyRedraw = false;
+    for(UINT i = 0; i < gNumCascades; ++i)
+        anyRedraw |= mCascadeRedraw[i];
+
+    if(!anyRedraw)
+        return;
 
     // Change to DEPTH_WRITE.
     mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mShadowMap->Resource(),
@@ -1425,23 +1600,38 @@ void ShadowMapApp::DrawSceneToShadowMap()
 
     UINT passCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(PassConstants));
 
-    // Clear the back buffer and depth buffer.
-    mCommandList->ClearDepthStencilView(mShadowMap->Dsv(), 
-        D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
-
     // Set null render target because we are only going to draw to
     // depth buffer.  Setting a null render target will disable color writes.
     // Note the active PSO also must specify a render target count of 0.
     mCommandList->OMSetRenderTargets(0, nullptr, false, &mShadowMap->Dsv());
 
-    // Bind the pass constant buffer for the shadow map pass.
+    mCommandList->SetPipelineState(mPSOs["shadow_opaque"].Get());
+
+    // Clear and draw each cascade that needs it in its tile, with its own
+    // pass constant buffer.
     auto passCB = mCurrFrameResource->PassCB->Resource();
-    D3D12_GPU_VIRTUAL_ADDRESS passCBAddress = passCB->GetGPUVirtualAddress() + 1*passCBByteSize;
-    mCommandList->SetGraphicsRootConstantBufferView(1, passCBAddress);
+    for(UINT i = 0; i < gNumCascades; ++i)
+    {
+        if(!mCascadeRedraw[i])
+            continue;
 
-    mCommandList->SetPipelineState(mPSOs["shadow_opaque"].Get());
+        const ShadowCascade& cascade = mCascades.GetCascade(i);
+
+        D3D12_VIEWPORT viewport = { (float)cascade.TileX, (float)cascade.TileY,
+            (float)gCascadeTileSize, (float)gCascadeTileSize, 0.0f, 1.0f };
+        D3D12_RECT scissorRect = { (LONG)cascade.TileX, (LONG)cascade.TileY,
+            (LONG)(cascade.TileX + gCascadeTileSize), (LONG)(cascade.TileY + gCascadeTileSize) };
+        mCommandList->RSSetViewports(1, &viewport);
+        mCommandList->RSSetScissorRects(1, &scissorRect);
+
+        mCommandList->ClearDepthStencilView(mShadowMap->Dsv(),
+            D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 1, &scissorRect);
 
-    DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Opaque]);
+        D3D12_GPU_VIRTUAL_ADDRESS passCBAddress = passCB->GetGPUVirtualAddress() + (1 + i)*passCBByteSize;
+        mCommandList->SetGraphicsRootConstantBufferView(1, passCBAddress);
+
+        DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Opaque], 1 + i);
+    }
 
     // Change back to GENERIC_READ so we can read the texture in a shader.
     mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mShadowMap->Resource(),
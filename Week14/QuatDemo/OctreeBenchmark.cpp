@@ -0,0 +1,215 @@
+//***************************************************************************************
+// OctreeBenchmark.cpp
+//
+// Headless console benchmark for Common/LooseOctree.h.  Build it as its own console
+// project with Common/LooseOctree.cpp, Common/Culling.cpp and Common/MathHelper.cpp.
+//
+// For 10k, 30k and 100k objects of mixed sizes flying about a 400 unit cube it runs
+// 120 frames.  Each frame every object moves, then it times
+//   -the octree: one batched Update of all the objects, then Cull,
+//   -the flat path: CullingBounds::Set for every object, then Culling::Cull,
+// and a sphere and a ray query against the octree and against a loop over every box.
+// It prints the averages, the node count and how many objects changed node per frame,
+// and checks that both paths find exactly the same objects.
+//***************************************************************************************
+
+#include <windows.h>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include "../../Common/LooseOctree.h"
+
+using namespace std;
+using namespace DirectX;
+
+double Milliseconds(const LARGE_INTEGER& start, const LARGE_INTEGER& end)
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+
+	return 1000.0 * (double)(end.QuadPart - start.QuadPart) / (double)frequency.QuadPart;
+}
+
+// Sorts both lists and compares them.
+bool SameObjects(std::vector<UINT>& a, std::vector<UINT>& b)
+{
+	std::sort(a.begin(), a.end());
+	std::sort(b.begin(), b.end());
+
+	return a == b;
+}
+
+int main()
+{
+	const float worldSize = 200.0f;
+	const UINT frameCount = 120;
+
+	XMMATRIX proj = XMMatrixPerspectiveFovLH(0.25f*MathHelper::Pi, 16.0f / 9.0f, 1.0f, 300.0f);
+
+	cout << "objects   nodes   moved   octree update+cull   flat set+cull   sphere (octree/loop)"
+		"   ray (octree/loop)   ms" << endl;
+
+	for(UINT objectCount : { 10000u, 30000u, 100000u })
+	{
+		srand(1234);
+
+		// Mostly small objects, a few large ones.  Some start and stray outside
+		// the octree, which then keeps them in the root.
+		std::vector<BoundingBox> bounds(objectCount);
+		std::vector<XMFLOAT3> velocities(objectCount);
+		for(UINT i = 0; i < objectCount; ++i)
+		{
+			float r = MathHelper::RandF();
+			float extent = 0.2f + 20.0f*r*r*r;
+
+			bounds[i].Center = XMFLOAT3(
+				MathHelper::RandF(-1.05f, 1.05f)*worldSize,
+				MathHelper::RandF(-1.05f, 1.05f)*worldSize,
+				MathHelper::RandF(-1.05f, 1.05f)*worldSize);
+			bounds[i].Extents = XMFLOAT3(extent, 0.5f*extent, extent);
+
+			velocities[i] = XMFLOAT3(MathHelper::RandF(-1.0f, 1.0f),
+				MathHelper::RandF(-1.0f, 1.0f), MathHelper::RandF(-1.0f, 1.0f));
+		}
+
+		LooseOctree octree;
+		octree.Reset(XMFLOAT3(0.0f, 0.0f, 0.0f), worldSize, 5);
+
+		CullingBounds flatBounds;
+		flatBounds.Reserve(objectCount);
+
+		std::vector<UINT> handles(objectCount);
+		for(UINT i = 0; i < objectCount; ++i)
+		{
+			handles[i] = octree.Insert(bounds[i]);
+			flatBounds.Add(bounds[i]);
+		}
+
+		std::vector<UINT> octreeVisible;
+		std::vector<UINT> flatIndices(flatBounds.PaddedSize());
+		std::vector<UINT> flatVisible;
+		std::vector<UINT> octreeFound;
+		std::vector<UINT> loopFound;
+
+		double octreeMs = 0.0;
+		double flatMs = 0.0;
+		double octreeSphereMs = 0.0;
+		double loopSphereMs = 0.0;
+		double octreeRayMs = 0.0;
+		double loopRayMs = 0.0;
+		UINT64 moved = 0;
+		UINT mismatches = 0;
+
+		for(UINT frame = 0; frame < frameCount; ++frame)
+		{
+			for(UINT i = 0; i < objectCount; ++i)
+			{
+				bounds[i].Center.x += velocities[i].x;
+				bounds[i].Center.y += velocities[i].y;
+				bounds[i].Center.z += velocities[i].z;
+			}
+
+			// A camera circling the middle and looking across it.
+			float angle = 0.05f*frame;
+			XMVECTOR eye = XMVectorSet(150.0f*cosf(angle), 20.0f, 150.0f*sinf(angle), 1.0f);
+			XMMATRIX view = XMMatrixLookAtLH(eye, XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f),
+				XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+			FrustumPlanes frustum = FrustumPlanes::FromViewProj(XMMatrixMultiply(view, proj));
+
+			LARGE_INTEGER start, end;
+
+			// Octree.
+			OctreeUpdateStats updateStats;
+			octreeVisible.clear();
+
+			QueryPerformanceCounter(&start);
+			octree.Update(handles.data(), bounds.data(), objectCount, &updateStats);
+			octree.Cull(frustum, octreeVisible);
+			QueryPerformanceCounter(&end);
+
+			octreeMs += Milliseconds(start, end);
+			moved += updateStats.Moved;
+
+			// Flat.
+			QueryPerformanceCounter(&start);
+			for(UINT i = 0; i < objectCount; ++i)
+				flatBounds.Set(i, bounds[i]);
+			UINT flatCount = Culling::Cull(flatBounds, frustum, flatIndices.data());
+			QueryPerformanceCounter(&end);
+
+			flatMs += Milliseconds(start, end);
+
+			// Handles were given out in order, so they equal the flat indices.
+			flatVisible.assign(flatIndices.begin(), flatIndices.begin() + flatCount);
+			if(!SameObjects(octreeVisible, flatVisible))
+				mismatches++;
+
+			// A blast somewhere in the world.
+			XMVECTOR center = XMVectorSet(MathHelper::RandF(-1.0f, 1.0f)*worldSize,
+				MathHelper::RandF(-1.0f, 1.0f)*worldSize, MathHelper::RandF(-1.0f, 1.0f)*worldSize, 1.0f);
+			float radius = MathHelper::RandF(5.0f, 40.0f);
+			BoundingSphere sphere;
+			XMStoreFloat3(&sphere.Center, center);
+			sphere.Radius = radius;
+
+			octreeFound.clear();
+			QueryPerformanceCounter(&start);
+			octree.OverlapSphere(center, radius, octreeFound);
+			QueryPerformanceCounter(&end);
+			octreeSphereMs += Milliseconds(start, end);
+
+			loopFound.clear();
+			QueryPerformanceCounter(&start);
+			for(UINT i = 0; i < objectCount; ++i)
+			{
+				if(sphere.Intersects(bounds[i]))
+					loopFound.push_back(handles[i]);
+			}
+			QueryPerformanceCounter(&end);
+			loopSphereMs += Milliseconds(start, end);
+
+			if(!SameObjects(octreeFound, loopFound))
+				mismatches++;
+
+			// A shot from the camera through the middle of the world.
+			XMVECTOR dir = XMVector3Normalize(XMVectorSet(MathHelper::RandF(-0.2f, 0.2f),
+				MathHelper::RandF(-0.2f, 0.2f), MathHelper::RandF(-0.2f, 0.2f), 0.0f) - eye);
+			float maxT = 600.0f;
+
+			octreeFound.clear();
+			QueryPerformanceCounter(&start);
+			octree.RayCast(eye, dir, maxT, octreeFound);
+			QueryPerformanceCounter(&end);
+			octreeRayMs += Milliseconds(start, end);
+
+			loopFound.clear();
+			QueryPerformanceCounter(&start);
+			for(UINT i = 0; i < objectCount; ++i)
+			{
+				float t = 0.0f;
+				if(bounds[i].Intersects(eye, dir, t) && t < maxT)
+					loopFound.push_back(handles[i]);
+			}
+			QueryPerformanceCounter(&end);
+			loopRayMs += Milliseconds(start, end);
+
+			if(!SameObjects(octreeFound, loopFound))
+				mismatches++;
+		}
+
+		cout << setw(7) << objectCount << setw(8) << octree.NodeCount()
+			<< setw(8) << moved / frameCount
+			<< fixed << setprecision(3)
+			<< setw(21) << octreeMs / frameCount
+			<< setw(16) << flatMs / frameCount
+			<< setw(13) << octreeSphereMs / frameCount << " /" << setw(7) << loopSphereMs / frameCount
+			<< setw(12) << octreeRayMs / frameCount << " /" << setw(7) << loopRayMs / frameCount;
+
+		if(mismatches > 0)
+			cout << "   " << mismatches << " MISMATCHES";
+		cout << endl;
+	}
+
+	system("pause");
+	return 0;
+}
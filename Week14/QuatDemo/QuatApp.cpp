@@ -7,6 +7,7 @@
 #include "../../Common/UploadBuffer.h"
 #include "../../Common/GeometryGenerator.h"
 #include "../../Common/Camera.h"
+#include "../../Common/LooseOctree.h"
 #include "FrameResource.h"
 #include "AnimationHelper.h"
 
@@ -49,6 +50,10 @@ struct RenderItem
     UINT IndexCount = 0;
     UINT StartIndexLocation = 0;
     int BaseVertexLocation = 0;
+
+	// Local bounds of the submesh, and the item's handle in the octree.
+	BoundingBox Bounds;
+	UINT OctreeHandle = LooseOctree::InvalidHandle;
 };
 
 class QuatApp : public D3DApp
@@ -75,6 +80,7 @@ private:
 	void UpdateObjectCBs(const GameTimer& gt);
 	void UpdateMaterialBuffer(const GameTimer& gt);
 	void UpdateMainPassCB(const GameTimer& gt);
+	void UpdateOctree(const GameTimer& gt);
 
     void DefineSkullAnimation();
 	void LoadTextures();
@@ -120,6 +126,15 @@ private:
     RenderItem* mSkullRitem = nullptr;
     XMFLOAT4X4 mSkullWorld = MathHelper::Identity4x4();
 
+	// Every render item is indexed by its world bounds.  The items marked
+	// dirty are updated in one batch each frame, then the octree culls them.
+	LooseOctree mOctree;
+	std::vector<RenderItem*> mOctreeItems;
+	std::vector<UINT> mDirtyHandles;
+	std::vector<BoundingBox> mDirtyBounds;
+	std::vector<UINT> mVisibleHandles;
+	std::vector<RenderItem*> mVisibleRitems;
+
     PassConstants mMainPassCB;
 
 	Camera mCamera;
@@ -238,6 +253,7 @@ void QuatApp::Update(const GameTimer& gt)
     }
 
 	AnimateMaterials(gt);
+	UpdateOctree(gt);
 	UpdateObjectCBs(gt);
 	UpdateMaterialBuffer(gt);
 	UpdateMainPassCB(gt);
@@ -287,7 +303,7 @@ void QuatApp::Draw(const GameTimer& gt)
     // The root signature knows how many descriptors are expected in the table.
 	mCommandList->SetGraphicsRootDescriptorTable(3, mSrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
 
-    DrawRenderItems(mCommandList.Get(), mOpaqueRitems);
+    DrawRenderItems(mCommandList.Get(), mVisibleRitems);
 
     // Indicate a state transition on the resource usage.
 	mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
@@ -453,6 +469,36 @@ void QuatApp::UpdateMainPassCB(const GameTimer& gt)
 	currPassCB->CopyData(0, mMainPassCB);
 }
 
+void QuatApp::UpdateOctree(const GameTimer& gt)
+{
+	// The items whose world matrix changed are the ones still to be copied to
+	// a frame resource, so this has to run before UpdateObjectCBs.
+	mDirtyHandles.clear();
+	mDirtyBounds.clear();
+	for(auto& e : mAllRitems)
+	{
+		if(e->NumFramesDirty > 0)
+		{
+			BoundingBox worldBounds;
+			e->Bounds.Transform(worldBounds, XMLoadFloat4x4(&e->World));
+
+			mDirtyHandles.push_back(e->OctreeHandle);
+			mDirtyBounds.push_back(worldBounds);
+		}
+	}
+
+	mOctree.Update(mDirtyHandles.data(), mDirtyBounds.data(), (UINT)mDirtyHandles.size());
+
+	FrustumPlanes frustum = FrustumPlanes::FromViewProj(XMMatrixMultiply(mCamera.GetView(), mCamera.GetProj()));
+
+	mVisibleHandles.clear();
+	mOctree.Cull(frustum, mVisibleHandles);
+
+	mVisibleRitems.clear();
+	for(UINT handle : mVisibleHandles)
+		mVisibleRitems.push_back(mOctreeItems[handle]);
+}
+
 void QuatApp::DefineSkullAnimation()
 {
     //
@@ -700,6 +746,16 @@ void QuatApp::BuildShapeGeometry()
 	cylinderSubmesh.StartIndexLocation = cylinderIndexOffset;
 	cylinderSubmesh.BaseVertexLocation = cylinderVertexOffset;
 
+	// Local bounds of each shape, for the octree.
+	BoundingBox::CreateFromPoints(boxSubmesh.Bounds, box.Vertices.size(),
+		&box.Vertices[0].Position, sizeof(GeometryGenerator::Vertex));
+	BoundingBox::CreateFromPoints(gridSubmesh.Bounds, grid.Vertices.size(),
+		&grid.Vertices[0].Position, sizeof(GeometryGenerator::Vertex));
+	BoundingBox::CreateFromPoints(sphereSubmesh.Bounds, sphere.Vertices.size(),
+		&sphere.Vertices[0].Position, sizeof(GeometryGenerator::Vertex));
+	BoundingBox::CreateFromPoints(cylinderSubmesh.Bounds, cylinder.Vertices.size(),
+		&cylinder.Vertices[0].Position, sizeof(GeometryGenerator::Vertex));
+
 	//
 	// Extract the vertex elements we are interested in and pack the
 	// vertices of all the meshes into one vertex buffer.
@@ -991,6 +1047,7 @@ void QuatApp::BuildRenderItems()
     skullRitem->IndexCount = skullRitem->Geo->DrawArgs["skull"].IndexCount;
     skullRitem->StartIndexLocation = skullRitem->Geo->DrawArgs["skull"].StartIndexLocation;
     skullRitem->BaseVertexLocation = skullRitem->Geo->DrawArgs["skull"].BaseVertexLocation;
+    skullRitem->Bounds = skullRitem->Geo->DrawArgs["skull"].Bounds;
     mSkullRitem = skullRitem.get();
     mAllRitems.push_back(std::move(skullRitem));
 
@@ -1004,6 +1061,7 @@ void QuatApp::BuildRenderItems()
 	boxRitem->IndexCount = boxRitem->Geo->DrawArgs["box"].IndexCount;
 	boxRitem->StartIndexLocation = boxRitem->Geo->DrawArgs["box"].StartIndexLocation;
 	boxRitem->BaseVertexLocation = boxRitem->Geo->DrawArgs["box"].BaseVertexLocation;
+	boxRitem->Bounds = boxRitem->Geo->DrawArgs["box"].Bounds;
 	mAllRitems.push_back(std::move(boxRitem));
 
     auto gridRitem = std::make_unique<RenderItem>();
@@ -1016,6 +1074,7 @@ void QuatApp::BuildRenderItems()
     gridRitem->IndexCount = gridRitem->Geo->DrawArgs["grid"].IndexCount;
     gridRitem->StartIndexLocation = gridRitem->Geo->DrawArgs["grid"].StartIndexLocation;
     gridRitem->BaseVertexLocation = gridRitem->Geo->DrawArgs["grid"].BaseVertexLocation;
+    gridRitem->Bounds = gridRitem->Geo->DrawArgs["grid"].Bounds;
 	mAllRitems.push_back(std::move(gridRitem));
 
 	XMMATRIX brickTexTransform = XMMatrixScaling(1.5f, 2.0f, 1.0f);
@@ -1042,6 +1101,7 @@ void QuatApp::BuildRenderItems()
 		leftCylRitem->IndexCount = leftCylRitem->Geo->DrawArgs["cylinder"].IndexCount;
 		leftCylRitem->StartIndexLocation = leftCylRitem->Geo->DrawArgs["cylinder"].StartIndexLocation;
 		leftCylRitem->BaseVertexLocation = leftCylRitem->Geo->DrawArgs["cylinder"].BaseVertexLocation;
+		leftCylRitem->Bounds = leftCylRitem->Geo->DrawArgs["cylinder"].Bounds;
 
 		XMStoreFloat4x4(&rightCylRitem->World, leftCylWorld);
 		XMStoreFloat4x4(&rightCylRitem->TexTransform, brickTexTransform);
@@ -1052,6 +1112,7 @@ void QuatApp::BuildRenderItems()
 		rightCylRitem->IndexCount = rightCylRitem->Geo->DrawArgs["cylinder"].IndexCount;
 		rightCylRitem->StartIndexLocation = rightCylRitem->Geo->DrawArgs["cylinder"].StartIndexLocation;
 		rightCylRitem->BaseVertexLocation = rightCylRitem->Geo->DrawArgs["cylinder"].BaseVertexLocation;
+		rightCylRitem->Bounds = rightCylRitem->Geo->DrawArgs["cylinder"].Bounds;
 
 		XMStoreFloat4x4(&leftSphereRitem->World, leftSphereWorld);
 		leftSphereRitem->TexTransform = MathHelper::Identity4x4();
@@ -1062,6 +1123,7 @@ void QuatApp::BuildRenderItems()
 		leftSphereRitem->IndexCount = leftSphereRitem->Geo->DrawArgs["sphere"].IndexCount;
 		leftSphereRitem->StartIndexLocation = leftSphereRitem->Geo->DrawArgs["sphere"].StartIndexLocation;
 		leftSphereRitem->BaseVertexLocation = leftSphereRitem->Geo->DrawArgs["sphere"].BaseVertexLocation;
+		leftSphereRitem->Bounds = leftSphereRitem->Geo->DrawArgs["sphere"].Bounds;
 
 		XMStoreFloat4x4(&rightSphereRitem->World, rightSphereWorld);
 		rightSphereRitem->TexTransform = MathHelper::Identity4x4();
@@ -1072,6 +1134,7 @@ void QuatApp::BuildRenderItems()
 		rightSphereRitem->IndexCount = rightSphereRitem->Geo->DrawArgs["sphere"].IndexCount;
 		rightSphereRitem->StartIndexLocation = rightSphereRitem->Geo->DrawArgs["sphere"].StartIndexLocation;
 		rightSphereRitem->BaseVertexLocation = rightSphereRitem->Geo->DrawArgs["sphere"].BaseVertexLocation;
+		rightSphereRitem->Bounds = rightSphereRitem->Geo->DrawArgs["sphere"].Bounds;
 
 		mAllRitems.push_back(std::move(leftCylRitem));
 		mAllRitems.push_back(std::move(rightCylRitem));
@@ -1082,6 +1145,18 @@ void QuatApp::BuildRenderItems()
 	// All the render items are opaque.
 	for(auto& e : mAllRitems)
 		mOpaqueRitems.push_back(e.get());
+
+	// The grid is 20x30 and the skull flies within it, a few units up.
+	mOctree.Reset(XMFLOAT3(0.0f, 0.0f, 0.0f), 16.0f, 4);
+	for(auto& e : mAllRitems)
+	{
+		BoundingBox worldBounds;
+		e->Bounds.Transform(worldBounds, XMLoadFloat4x4(&e->World));
+
+		e->OctreeHandle = mOctree.Insert(worldBounds);
+		mOctreeItems.resize(MathHelper::Max(mOctreeItems.size(), (size_t)e->OctreeHandle + 1));
+		mOctreeItems[e->OctreeHandle] = e.get();
+	}
 }
 
 void QuatApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems)
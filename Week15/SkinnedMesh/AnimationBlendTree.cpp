@@ -0,0 +1,207 @@
+//***************************************************************************************
+// AnimationBlendTree.cpp
+//***************************************************************************************
+
+#include "AnimationBlendTree.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// Quaternion lerp followed by a normalize.  q1 is negated first when it
+	// lies in the other hemisphere so the blend takes the short way round.
+	XMVECTOR XM_CALLCONV QuaternionNlerp(FXMVECTOR q0, FXMVECTOR q1, FXMVECTOR t)
+	{
+		XMVECTOR negative = XMVectorLess(XMVector4Dot(q0, q1), XMVectorZero());
+		XMVECTOR q = XMVectorSelect(q1, XMVectorNegate(q1), negative);
+
+		return XMVector4Normalize(XMVectorLerpV(q0, q, t));
+	}
+
+	void BlendPoses(const BonePose* a, const BonePose* b, float weight, UINT boneCount, BonePose* out)
+	{
+		XMVECTOR t = XMVectorReplicate(weight);
+
+		for(UINT i = 0; i < boneCount; ++i)
+		{
+			XMVECTOR s = XMVectorLerpV(XMLoadFloat4A(&a[i].Scale), XMLoadFloat4A(&b[i].Scale), t);
+			XMVECTOR p = XMVectorLerpV(XMLoadFloat4A(&a[i].Translation), XMLoadFloat4A(&b[i].Translation), t);
+			XMVECTOR q = QuaternionNlerp(XMLoadFloat4A(&a[i].Rotation), XMLoadFloat4A(&b[i].Rotation), t);
+
+			XMStoreFloat4A(&out[i].Scale, s);
+			XMStoreFloat4A(&out[i].Translation, p);
+			XMStoreFloat4A(&out[i].Rotation, q);
+		}
+	}
+
+	// out = base + weight*(additive - reference), where "+" composes the
+	// rotations and multiplies the scales.
+	void AddPoses(const BonePose* base, const BonePose* additive, const BonePose* reference,
+		float weight, UINT boneCount, BonePose* out)
+	{
+		XMVECTOR t = XMVectorReplicate(weight);
+		XMVECTOR one = XMVectorSplatOne();
+		XMVECTOR identity = XMQuaternionIdentity();
+
+		for(UINT i = 0; i < boneCount; ++i)
+		{
+			XMVECTOR refScale = XMLoadFloat4A(&reference[i].Scale);
+			XMVECTOR refTranslation = XMLoadFloat4A(&reference[i].Translation);
+			XMVECTOR refRotation = XMLoadFloat4A(&reference[i].Rotation);
+
+			// Scale w is unused, so keep it away from a divide by zero.
+			XMVECTOR deltaScale = XMVectorDivide(XMLoadFloat4A(&additive[i].Scale),
+				XMVectorSelect(one, refScale, g_XMSelect1110));
+			XMVECTOR deltaTranslation = XMVectorSubtract(XMLoadFloat4A(&additive[i].Translation), refTranslation);
+			// In the bone's local space: ref^-1 * additive, applied after the base
+			// rotation as base * delta, so base = reference gives the additive
+			// pose back.  XMQuaternionMultiply(q1, q2) is q2 * q1.
+			XMVECTOR deltaRotation = XMQuaternionMultiply(XMLoadFloat4A(&additive[i].Rotation),
+				XMQuaternionConjugate(refRotation));
+
+			deltaScale = XMVectorLerpV(one, deltaScale, t);
+			deltaRotation = QuaternionNlerp(identity, deltaRotation, t);
+
+			XMVECTOR s = XMVectorMultiply(XMLoadFloat4A(&base[i].Scale), deltaScale);
+			XMVECTOR p = XMVectorMultiplyAdd(deltaTranslation, t, XMLoadFloat4A(&base[i].Translation));
+			XMVECTOR q = XMQuaternionMultiply(deltaRotation, XMLoadFloat4A(&base[i].Rotation));
+
+			XMStoreFloat4A(&out[i].Scale, s);
+			XMStoreFloat4A(&out[i].Translation, p);
+			XMStoreFloat4A(&out[i].Rotation, q);
+		}
+	}
+}
+
+AnimationBlendTree::AnimationBlendTree(const SkinnedData* skinnedInfo)
+	: mSkinnedInfo(skinnedInfo), mBoneCount(skinnedInfo->BoneCount())
+{
+	assert(mBoneCount <= SkinnedData::MaxBones);
+}
+
+int AnimationBlendTree::AddNode(Node&& node)
+{
+	mNodes.push_back(std::move(node));
+	mPoses.emplace_back(mBoneCount);
+
+	mRoot = (int)mNodes.size() - 1;
+	return mRoot;
+}
+
+int AnimationBlendTree::AddClip(const std::string& clipName, float timePos, float playbackRate)
+{
+	Node node;
+	node.Type = NodeType::Clip;
+	node.Clip = mSkinnedInfo->FindClip(clipName);
+	assert(node.Clip != nullptr);
+
+	node.TimePos = timePos;
+	node.PlaybackRate = playbackRate;
+	node.ClipStartTime = node.Clip->GetClipStartTime();
+	node.ClipEndTime = node.Clip->GetClipEndTime();
+
+	return AddNode(std::move(node));
+}
+
+int AnimationBlendTree::AddBlend(int a, int b, float weight)
+{
+	assert(a >= 0 && a < (int)mNodes.size());
+	assert(b >= 0 && b < (int)mNodes.size());
+
+	Node node;
+	node.Type = NodeType::Blend;
+	node.Children[0] = a;
+	node.Children[1] = b;
+	node.Weight = weight;
+
+	return AddNode(std::move(node));
+}
+
+int AnimationBlendTree::AddAdditive(int base, int additiveClip, float weight)
+{
+	assert(base >= 0 && base < (int)mNodes.size());
+	assert(additiveClip >= 0 && additiveClip < (int)mNodes.size());
+	assert(mNodes[additiveClip].Type == NodeType::Clip);
+
+	Node node;
+	node.Type = NodeType::Additive;
+	node.Children[0] = base;
+	node.Children[1] = additiveClip;
+	node.Weight = weight;
+
+	const Node& clipNode = mNodes[additiveClip];
+	node.ReferencePose.resize(mBoneCount);
+	clipNode.Clip->Sample(clipNode.ClipStartTime, node.ReferencePose.data());
+
+	return AddNode(std::move(node));
+}
+
+void AnimationBlendTree::SetWeight(int node, float weight)
+{
+	assert(mNodes[node].Type != NodeType::Clip);
+	mNodes[node].Weight = weight;
+}
+
+float AnimationBlendTree::GetWeight(int node)const
+{
+	return mNodes[node].Weight;
+}
+
+void AnimationBlendTree::SetRoot(int node)
+{
+	assert(node >= 0 && node < (int)mNodes.size());
+	mRoot = node;
+}
+
+void AnimationBlendTree::Advance(float dt)
+{
+	for(auto& node : mNodes)
+	{
+		if(node.Type != NodeType::Clip)
+			continue;
+
+		node.TimePos += node.PlaybackRate*dt;
+
+		// Loop animation
+		if(node.TimePos > node.ClipEndTime)
+			node.TimePos = node.ClipStartTime;
+	}
+}
+
+const BonePose* AnimationBlendTree::EvaluateNode(int index)
+{
+	Node& node = mNodes[index];
+	BonePose* pose = mPoses[index].data();
+
+	switch(node.Type)
+	{
+	case NodeType::Clip:
+		node.Clip->Sample(node.TimePos, pose);
+		return pose;
+
+	case NodeType::Blend:
+		if(node.Weight <= 0.0f)
+			return EvaluateNode(node.Children[0]);
+		if(node.Weight >= 1.0f)
+			return EvaluateNode(node.Children[1]);
+
+		BlendPoses(EvaluateNode(node.Children[0]), EvaluateNode(node.Children[1]),
+			node.Weight, mBoneCount, pose);
+		return pose;
+
+	default:
+		if(node.Weight <= 0.0f)
+			return EvaluateNode(node.Children[0]);
+
+		AddPoses(EvaluateNode(node.Children[0]), EvaluateNode(node.Children[1]),
+			node.ReferencePose.data(), node.Weight, mBoneCount, pose);
+		return pose;
+	}
+}
+
+void AnimationBlendTree::Evaluate(BoneTransform3x4* finalTransforms)
+{
+	assert(mRoot >= 0);
+
+	mSkinnedInfo->GetFinalTransforms(EvaluateNode(mRoot), finalTransforms);
+}
@@ -0,0 +1,94 @@
+//***************************************************************************************
+// AnimationBlendTree.h
+//
+// Plays several clips on one skinned model at once.  The tree is a flat array of nodes:
+//   -clip nodes sample a clip into a local-space pose (scale, rotation, translation),
+//   -blend nodes cross-fade two child poses by a weight,
+//   -additive nodes layer the difference between a clip and its first frame on top of
+//    a base pose.
+// Poses are blended per bone with SIMD lerps and normalized quaternion lerps, and only
+// the root pose is run through the bone hierarchy, so a 2-4 clip blend costs little
+// more than a single clip.  A blend node whose weight is 0 or 1 only evaluates the
+// child that contributes.
+//***************************************************************************************
+
+#pragma once
+
+#include "SkinnedData.h"
+
+class AnimationBlendTree
+{
+public:
+	explicit AnimationBlendTree(const SkinnedData* skinnedInfo);
+	AnimationBlendTree(const AnimationBlendTree& rhs) = delete;
+	AnimationBlendTree& operator=(const AnimationBlendTree& rhs) = delete;
+	~AnimationBlendTree() = default;
+
+	// The Add methods return the index of the new node.  Children must be
+	// added before their parents.  The last node added becomes the root.
+	int AddClip(const std::string& clipName, float timePos = 0.0f, float playbackRate = 1.0f);
+
+	// weight = 0 gives pose a, weight = 1 gives pose b.
+	int AddBlend(int a, int b, float weight);
+
+	// Adds weight times the difference between the additive clip and its
+	// first frame to the base pose.  additiveClip must be a clip node.
+	int AddAdditive(int base, int additiveClip, float weight);
+
+	void SetWeight(int node, float weight);
+	float GetWeight(int node)const;
+
+	void SetRoot(int node);
+
+	// Advances every clip node by dt and loops it.
+	void Advance(float dt);
+
+	// Blends the tree into a local pose and writes the BoneCount() final
+	// transforms, ready to be set for processing in the vertex shader.
+	// Uses per-tree scratch memory, so one tree may not be evaluated on
+	// two threads at once.
+	void Evaluate(BoneTransform3x4* finalTransforms);
+
+private:
+	enum class NodeType
+	{
+		Clip,
+		Blend,
+		Additive
+	};
+
+	struct Node
+	{
+		NodeType Type = NodeType::Clip;
+
+		// Clip nodes.
+		const AnimationClip* Clip = nullptr;
+		float TimePos = 0.0f;
+		float PlaybackRate = 1.0f;
+		float ClipStartTime = 0.0f;
+		float ClipEndTime = 0.0f;
+
+		// Blend and additive nodes.
+		int Children[2] = { -1, -1 };
+		float Weight = 0.0f;
+
+		// Additive nodes: the first frame of the additive clip.
+		std::vector<BonePose> ReferencePose;
+	};
+
+	int AddNode(Node&& node);
+
+	// Returns the pose of the node, which is either its own scratch pose
+	// or, when a weight makes the node a pass-through, a child's pose.
+	const BonePose* EvaluateNode(int node);
+
+private:
+	const SkinnedData* mSkinnedInfo = nullptr;
+	UINT mBoneCount = 0;
+
+	std::vector<Node> mNodes;
+	int mRoot = -1;
+
+	// One scratch pose of mBoneCount bones per node.
+	std::vector<std::vector<BonePose>> mPoses;
+};
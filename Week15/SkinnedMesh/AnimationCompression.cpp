@@ -0,0 +1,238 @@
+//***************************************************************************************
+// AnimationCompression.cpp
+//***************************************************************************************
+
+#include "AnimationCompression.h"
+
+using namespace DirectX;
+
+namespace
+{
+	enum class Channel
+	{
+		Translation,
+		Scale,
+		Rotation
+	};
+
+	// sqrt(1/2) bounds every component except the largest of a unit quaternion.
+	const float SmallestThreeRange = 0.70710678f;
+
+	XMVECTOR XM_CALLCONV KeyValue(const Keyframe& key, Channel channel)
+	{
+		switch(channel)
+		{
+		case Channel::Translation: return XMLoadFloat3(&key.Translation);
+		case Channel::Scale:       return XMLoadFloat3(&key.Scale);
+		default:                   return XMLoadFloat4(&key.RotationQuat);
+		}
+	}
+
+	// Distance for translation and scale, angle in radians for rotation.
+	float XM_CALLCONV ValueError(FXMVECTOR a, FXMVECTOR b, Channel channel)
+	{
+		if(channel == Channel::Rotation)
+		{
+			float cosHalfAngle = fabsf(XMVectorGetX(XMQuaternionDot(a, b)));
+			return 2.0f*acosf(MathHelper::Min(cosHalfAngle, 1.0f));
+		}
+
+		return XMVectorGetX(XMVector3Length(XMVectorSubtract(a, b)));
+	}
+
+	// Error of rebuilding key k by interpolating keys a and b.
+	float InterpolationError(const std::vector<Keyframe>& keys, UINT a, UINT b, UINT k, Channel channel)
+	{
+		float duration = keys[b].TimePos - keys[a].TimePos;
+		float lerpPercent = duration > 0.0f ? (keys[k].TimePos - keys[a].TimePos) / duration : 0.0f;
+
+		XMVECTOR v0 = KeyValue(keys[a], channel);
+		XMVECTOR v1 = KeyValue(keys[b], channel);
+
+		XMVECTOR v = (channel == Channel::Rotation) ?
+			XMQuaternionSlerp(v0, v1, lerpPercent) :
+			XMVectorLerp(v0, v1, lerpPercent);
+
+		return ValueError(v, KeyValue(keys[k], channel), channel);
+	}
+
+	// Picks the keys of one channel that must be kept.  A constant channel
+	// keeps its first key only.  Otherwise we walk the keys and extend the
+	// current segment for as long as every key inside it can be rebuilt by
+	// interpolating the segment's end points.
+	void ReduceKeys(const std::vector<Keyframe>& keys, Channel channel, float tolerance, std::vector<UINT>& kept)
+	{
+		UINT keyCount = (UINT)keys.size();
+
+		kept.clear();
+		kept.push_back(0);
+
+		bool constant = true;
+		for(UINT k = 1; k < keyCount && constant; ++k)
+		{
+			constant = ValueError(KeyValue(keys[0], channel), KeyValue(keys[k], channel), channel) <= tolerance;
+		}
+
+		if(constant)
+			return;
+
+		UINT anchor = 0;
+		for(UINT end = 2; end < keyCount; ++end)
+		{
+			bool fits = true;
+			for(UINT k = anchor + 1; k < end && fits; ++k)
+			{
+				fits = InterpolationError(keys, anchor, end, k, channel) <= tolerance;
+			}
+
+			// Key end-1 was the last one the segment could reach.
+			if(!fits)
+			{
+				anchor = end - 1;
+				kept.push_back(anchor);
+			}
+		}
+
+		kept.push_back(keyCount - 1);
+	}
+
+	void CompressTrack(const std::vector<Keyframe>& keys, Channel channel, float tolerance,
+		float startTime, float duration, CompressedTrack& track)
+	{
+		std::vector<UINT> kept;
+		ReduceKeys(keys, channel, tolerance, kept);
+
+		// Translation and scale are quantized against the range of the kept keys.
+		if(channel != Channel::Rotation)
+		{
+			XMVECTOR vMin = KeyValue(keys[kept[0]], channel);
+			XMVECTOR vMax = vMin;
+			for(UINT k : kept)
+			{
+				vMin = XMVectorMin(vMin, KeyValue(keys[k], channel));
+				vMax = XMVectorMax(vMax, KeyValue(keys[k], channel));
+			}
+
+			XMStoreFloat3(&track.Min, vMin);
+			XMStoreFloat3(&track.Extent, XMVectorSubtract(vMax, vMin));
+		}
+
+		track.Times.resize(kept.size());
+		track.Values.resize(3*kept.size());
+
+		for(UINT i = 0; i < (UINT)kept.size(); ++i)
+		{
+			const Keyframe& key = keys[kept[i]];
+
+			float u = duration > 0.0f ? (key.TimePos - startTime) / duration : 0.0f;
+			track.Times[i] = (USHORT)(MathHelper::Clamp(u, 0.0f, 1.0f)*65535.0f + 0.5f);
+
+			if(channel == Channel::Rotation)
+				AnimationCompression::EncodeQuaternion(KeyValue(key, channel), &track.Values[3*i]);
+			else
+				AnimationCompression::EncodeVector(KeyValue(key, channel), track.Min, track.Extent, &track.Values[3*i]);
+		}
+	}
+}
+
+float AnimationCompressionStats::CompressionRatio()const
+{
+	return CompressedBytes > 0 ? (float)SourceBytes / (float)CompressedBytes : 0.0f;
+}
+
+void AnimationCompression::CompressClip(const AnimationClip& clip,
+	const AnimationCompressionSettings& settings,
+	std::vector<CompressedBoneAnimation>& compressed)
+{
+	float startTime = clip.GetClipStartTime();
+	float duration = clip.GetClipEndTime() - startTime;
+
+	compressed.resize(clip.BoneAnimations.size());
+	for(UINT i = 0; i < (UINT)clip.BoneAnimations.size(); ++i)
+	{
+		const std::vector<Keyframe>& keys = clip.BoneAnimations[i].Keyframes;
+
+		CompressTrack(keys, Channel::Translation, settings.TranslationTolerance, startTime, duration, compressed[i].Translation);
+		CompressTrack(keys, Channel::Scale, settings.ScaleTolerance, startTime, duration, compressed[i].Scale);
+		CompressTrack(keys, Channel::Rotation, settings.RotationTolerance, startTime, duration, compressed[i].Rotation);
+	}
+}
+
+void AnimationCompression::EncodeQuaternion(FXMVECTOR q, USHORT packed[3])
+{
+	XMFLOAT4 v;
+	XMStoreFloat4(&v, XMQuaternionNormalize(q));
+	float c[4] = { v.x, v.y, v.z, v.w };
+
+	UINT largest = 0;
+	for(UINT i = 1; i < 4; ++i)
+	{
+		if(fabsf(c[i]) > fabsf(c[largest]))
+			largest = i;
+	}
+
+	// q and -q are the same rotation, so flip the sign to make the dropped
+	// component positive; the decoder then only needs its magnitude.
+	float sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+
+	UINT64 bits = largest;
+	for(UINT i = 0; i < 4; ++i)
+	{
+		if(i == largest)
+			continue;
+
+		float x = 0.5f*(sign*c[i] / SmallestThreeRange) + 0.5f;
+		bits = (bits << 15) | (UINT64)(MathHelper::Clamp(x, 0.0f, 1.0f)*32767.0f + 0.5f);
+	}
+
+	packed[0] = (USHORT)(bits >> 32);
+	packed[1] = (USHORT)(bits >> 16);
+	packed[2] = (USHORT)(bits);
+}
+
+XMVECTOR XM_CALLCONV AnimationCompression::DecodeQuaternion(const USHORT packed[3])
+{
+	UINT64 bits = ((UINT64)packed[0] << 32) | ((UINT64)packed[1] << 16) | (UINT64)packed[2];
+	UINT largest = (UINT)(bits >> 45);
+
+	float c[4];
+	float sumSquares = 0.0f;
+	UINT shift = 30;
+	for(UINT i = 0; i < 4; ++i)
+	{
+		if(i == largest)
+			continue;
+
+		float x = (float)((bits >> shift) & 0x7FFF) / 32767.0f;
+		c[i] = (2.0f*x - 1.0f)*SmallestThreeRange;
+		sumSquares += c[i]*c[i];
+		shift -= 15;
+	}
+
+	c[largest] = sqrtf(MathHelper::Max(1.0f - sumSquares, 0.0f));
+
+	return XMVectorSet(c[0], c[1], c[2], c[3]);
+}
+
+void AnimationCompression::EncodeVector(FXMVECTOR v, const XMFLOAT3& min, const XMFLOAT3& extent, USHORT packed[3])
+{
+	XMFLOAT3 f;
+	XMStoreFloat3(&f, v);
+
+	float value[3] = { f.x - min.x, f.y - min.y, f.z - min.z };
+	float range[3] = { extent.x, extent.y, extent.z };
+
+	for(UINT i = 0; i < 3; ++i)
+	{
+		float x = range[i] > 0.0f ? value[i] / range[i] : 0.0f;
+		packed[i] = (USHORT)(MathHelper::Clamp(x, 0.0f, 1.0f)*65535.0f + 0.5f);
+	}
+}
+
+XMVECTOR XM_CALLCONV AnimationCompression::DecodeVector(const USHORT packed[3], const XMFLOAT3& min, const XMFLOAT3& extent)
+{
+	XMVECTOR x = XMVectorSet((float)packed[0], (float)packed[1], (float)packed[2], 0.0f);
+	XMVECTOR scale = XMVectorScale(XMLoadFloat3(&extent), 1.0f / 65535.0f);
+
+	return XMVectorMultiplyAdd(x, scale, XMLoadFloat3(&min));
+}
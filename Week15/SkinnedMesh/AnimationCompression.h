@@ -0,0 +1,76 @@
+//***************************************************************************************
+// AnimationCompression.h
+//
+// Lossy compression of AnimationClip keyframes.  A Keyframe stores time, translation,
+// scale and rotation as 44 bytes of floats for every bone.  The compressor
+//   -splits every bone into separate translation, scale and rotation tracks,
+//   -collapses constant tracks to a single key,
+//   -drops keys that interpolating their neighbours rebuilds within the error budget,
+//   -stores key times as 16-bit fractions of the clip duration,
+//   -quantizes translation and scale to 16 bits per component against the track's
+//    range, and rotations to 48 bits with the smallest-three encoding.
+// The keys are decompressed on the fly by CompressedBoneAnimation::Interpolate.
+//***************************************************************************************
+
+#pragma once
+
+#include "SkinnedData.h"
+
+struct AnimationCompressionSettings
+{
+	// Largest local-space error a removed key may have, measured against the
+	// interpolation of the keys kept around it.
+	float TranslationTolerance = 0.01f;
+	float ScaleTolerance = 0.001f;
+	float RotationTolerance = 0.001f; // radians
+
+	// Keep BoneAnimations after compressing.  Only useful for comparing the
+	// two forms; the memory saving comes from dropping them.
+	bool KeepSourceKeyframes = false;
+
+	// The bone error is measured at the bone origin and at points this far
+	// along the bone's local x and y axes, so rotation errors show up too.
+	float ErrorPointDistance = 10.0f;
+
+	// Rate at which both forms of the clip are sampled to measure the error.
+	float ErrorSamplesPerSecond = 120.0f;
+};
+
+struct AnimationCompressionStats
+{
+	UINT SourceKeyCount = 0;
+	UINT CompressedKeyCount = 0;
+
+	size_t SourceBytes = 0;
+	size_t CompressedBytes = 0;
+
+	// Worst model-space distance between a sampled point on a bone in the
+	// source clip and the same point in the compressed clip.
+	float MaxBoneError = 0.0f;
+	std::string MaxErrorClip;
+	UINT MaxErrorBone = 0;
+
+	float CompressionRatio()const;
+};
+
+class AnimationCompression
+{
+public:
+	// Builds the compressed tracks of every bone in the clip.  The key times
+	// are stored relative to [clip.GetClipStartTime(), clip.GetClipEndTime()].
+	static void CompressClip(const AnimationClip& clip,
+		const AnimationCompressionSettings& settings,
+		std::vector<CompressedBoneAnimation>& compressed);
+
+	// Smallest-three quaternion codec: 2 bits for the index of the largest
+	// component, which is dropped and rebuilt from the unit length, and 15
+	// bits for each of the other three.  48 bits in total.
+	static void EncodeQuaternion(DirectX::FXMVECTOR q, USHORT packed[3]);
+	static DirectX::XMVECTOR XM_CALLCONV DecodeQuaternion(const USHORT packed[3]);
+
+	// Range quantization of translation and scale, 16 bits per component.
+	static void EncodeVector(DirectX::FXMVECTOR v, const DirectX::XMFLOAT3& min,
+		const DirectX::XMFLOAT3& extent, USHORT packed[3]);
+	static DirectX::XMVECTOR XM_CALLCONV DecodeVector(const USHORT packed[3],
+		const DirectX::XMFLOAT3& min, const DirectX::XMFLOAT3& extent);
+};
@@ -0,0 +1,75 @@
+//***************************************************************************************
+// AnimationLod.h
+//
+// Animation level of detail settings and counters for CrowdAnimator.  Each level
+// covers a range of distances from the eye and sets
+//   -how often the instance's pose is evaluated; on the frames in between its palette
+//    is interpolated from the last two evaluations,
+//   -how deep into the bone hierarchy the clip is sampled; deeper bones keep the local
+//    transform they had the last time they were sampled.
+// Instances on the same level are updated on different frames, staggered by their
+// index, so the evaluation cost is spread evenly over the update period.
+//***************************************************************************************
+
+#pragma once
+
+#include "../../Common/d3dUtil.h"
+#include "../../Common/MathHelper.h"
+#include <climits>
+
+struct AnimationLodLevel
+{
+	// The level is used up to this distance from the eye.
+	float MaxDistance = MathHelper::Infinity;
+
+	// Evaluate the pose every UpdatePeriod frames.
+	UINT UpdatePeriod = 1;
+
+	// Only sample bones with at most this many parents.
+	UINT MaxBoneDepth = UINT_MAX;
+};
+
+struct AnimationLodSettings
+{
+	// Sorted by MaxDistance.  Instances beyond the last level use the last level.
+	std::vector<AnimationLodLevel> Levels =
+	{
+		{ 10.0f, 1, UINT_MAX },
+		{ 20.0f, 2, UINT_MAX },
+		{ 40.0f, 4, 6 },
+		{ MathHelper::Infinity, 8, 3 },
+	};
+
+	// Distance is scaled by this before selecting the level, e.g. to account
+	// for the field of view or resolution.
+	float DistanceScale = 1.0f;
+};
+
+struct AnimationLodStats
+{
+	static const UINT MaxLevels = 8;
+
+	// Instances on each level this frame.
+	UINT InstanceCount[MaxLevels] = { 0 };
+
+	// Instances whose pose was evaluated, and instances whose palette was
+	// interpolated from earlier evaluations.
+	UINT EvaluatedInstances = 0;
+	UINT InterpolatedInstances = 0;
+
+	// Bones sampled from a clip, and bones a full update of every instance
+	// would have sampled but LOD skipped.
+	UINT BoneEvaluations = 0;
+	UINT SkippedBoneEvaluations = 0;
+
+	void Add(const AnimationLodStats& rhs)
+	{
+		for(UINT i = 0; i < MaxLevels; ++i)
+			InstanceCount[i] += rhs.InstanceCount[i];
+
+		EvaluatedInstances += rhs.EvaluatedInstances;
+		InterpolatedInstances += rhs.InterpolatedInstances;
+		BoneEvaluations += rhs.BoneEvaluations;
+		SkippedBoneEvaluations += rhs.SkippedBoneEvaluations;
+	}
+};
@@ -0,0 +1,279 @@
+//***************************************************************************************
+// CrowdAnimator.cpp
+//***************************************************************************************
+
+#include "CrowdAnimator.h"
+#include <ppl.h>
+
+using namespace DirectX;
+
+void SkinnedModelInstance::SetClip(const std::string& clipName)
+{
+    ClipName = clipName;
+
+    mClip = SkinnedInfo->FindClip(clipName);
+    assert(mClip != nullptr);
+
+    // GetClipEndTime walks every bone, so only do it when the clip changes.
+    mClipEndTime = mClip->GetClipEndTime();
+}
+
+void SkinnedModelInstance::Advance(float dt)
+{
+    if(BlendTree != nullptr)
+    {
+        BlendTree->Advance(PlaybackRate*dt);
+        return;
+    }
+
+    TimePos += PlaybackRate*dt;
+
+    // Loop animation
+    if(TimePos > mClipEndTime)
+        TimePos = 0.0f;
+}
+
+float SkinnedModelInstance::TimeAfter(float dt)const
+{
+    float timePos = TimePos + PlaybackRate*dt;
+    return timePos > mClipEndTime ? 0.0f : timePos;
+}
+
+const AnimationClip* SkinnedModelInstance::GetClip()const
+{
+    return mClip;
+}
+
+void SkinnedModelInstance::GetFinalTransforms(BoneTransform3x4* finalTransforms)const
+{
+    if(BlendTree != nullptr)
+        BlendTree->Evaluate(finalTransforms);
+    else
+        SkinnedInfo->GetFinalTransforms(*mClip, TimePos, finalTransforms);
+}
+
+void CrowdAnimator::AddInstance(SkinnedModelInstance* instance)
+{
+    mInstances.push_back(instance);
+}
+
+void CrowdAnimator::Clear()
+{
+    mInstances.clear();
+    mLodStates.clear();
+}
+
+UINT CrowdAnimator::InstanceCount()const
+{
+    return (UINT)mInstances.size();
+}
+
+UINT CrowdAnimator::GetBatchSize()const
+{
+    return mBatchSize;
+}
+
+void CrowdAnimator::SetBatchSize(UINT batchSize)
+{
+    mBatchSize = MathHelper::Max(batchSize, 1u);
+}
+
+template<typename GetPalette>
+void CrowdAnimator::UpdateBatches(float dt, GetPalette getPalette)
+{
+    UINT instanceCount = (UINT)mInstances.size();
+    UINT batchCount = (instanceCount + mBatchSize - 1) / mBatchSize;
+
+    if(mLodEnabled)
+        mLodStates.resize(instanceCount);
+
+    // Each worker thread counts into its own stats; they are summed below.
+    concurrency::combinable<AnimationLodStats> stats;
+
+    // Every instance owns its own palette slot, so the batches never touch the
+    // same memory and need no synchronization.
+    concurrency::parallel_for(0u, batchCount, [&](UINT batch)
+    {
+        AnimationLodStats& batchStats = stats.local();
+
+        UINT first = batch*mBatchSize;
+        UINT last = MathHelper::Min(first + mBatchSize, instanceCount);
+
+        for(UINT i = first; i < last; ++i)
+        {
+            SkinnedModelInstance* instance = mInstances[i];
+
+            instance->Advance(dt);
+
+            SkinnedConstants* palette = getPalette(instance->SkinnedCBIndex);
+            if(mLodEnabled && instance->BlendTree == nullptr)
+            {
+                UpdateLodInstance(i, dt, &palette->BoneTransforms[0], batchStats);
+            }
+            else
+            {
+                instance->GetFinalTransforms(&palette->BoneTransforms[0]);
+
+                batchStats.InstanceCount[0]++;
+                batchStats.EvaluatedInstances++;
+                batchStats.BoneEvaluations += instance->SkinnedInfo->BoneCount();
+            }
+        }
+    });
+
+    mLodStats = AnimationLodStats();
+    stats.combine_each([this](const AnimationLodStats& batchStats)
+    {
+        mLodStats.Add(batchStats);
+    });
+
+    ++mFrameIndex;
+}
+
+void CrowdAnimator::UpdateLodInstance(UINT index, float dt, BoneTransform3x4* palette, AnimationLodStats& stats)
+{
+    const SkinnedModelInstance& instance = *mInstances[index];
+    const SkinnedData& skinnedInfo = *instance.SkinnedInfo;
+    LodState& state = mLodStates[index];
+
+    UINT boneCount = skinnedInfo.BoneCount();
+    UINT level = SelectLodLevel(instance);
+    const AnimationLodLevel& lod = mLodSettings.Levels[level];
+
+    stats.InstanceCount[level]++;
+
+    // First frame, or the level changed: evaluate the current pose and hold
+    // it until the instance's next staggered update.  A new instance samples
+    // every bone so the bones a far level skips start out posed.
+    if(!state.HasPose || state.Level != level)
+    {
+        state.LocalPose.resize(boneCount);
+        state.PrevPalette.resize(boneCount);
+        state.NextPalette.resize(boneCount);
+
+        UINT maxDepth = state.HasPose ? lod.MaxBoneDepth : UINT_MAX;
+        UINT sampled = skinnedInfo.Sample(*instance.GetClip(), instance.TimePos, maxDepth, state.LocalPose.data());
+        skinnedInfo.GetFinalTransforms(state.LocalPose.data(), state.NextPalette.data());
+        state.PrevPalette = state.NextPalette;
+
+        state.Level = level;
+        state.HasPose = true;
+        state.FramesSinceUpdate = 0;
+
+        stats.EvaluatedInstances++;
+        stats.BoneEvaluations += sampled;
+        stats.SkippedBoneEvaluations += boneCount - sampled;
+
+        std::copy(state.NextPalette.begin(), state.NextPalette.end(), palette);
+        return;
+    }
+
+    UINT period = lod.UpdatePeriod;
+    if((mFrameIndex + index) % period == 0)
+    {
+        // The old target pose is where the instance is now.  The new target
+        // is where it will be at the next update, so the palettes in between
+        // are interpolated without lagging behind.
+        std::swap(state.PrevPalette, state.NextPalette);
+
+        float timePos = period > 1 ? instance.TimeAfter(period*dt) : instance.TimePos;
+        UINT sampled = skinnedInfo.Sample(*instance.GetClip(), timePos, lod.MaxBoneDepth, state.LocalPose.data());
+        skinnedInfo.GetFinalTransforms(state.LocalPose.data(), state.NextPalette.data());
+
+        state.FramesSinceUpdate = 0;
+
+        stats.EvaluatedInstances++;
+        stats.BoneEvaluations += sampled;
+        stats.SkippedBoneEvaluations += boneCount - sampled;
+
+        if(period == 1)
+        {
+            std::copy(state.NextPalette.begin(), state.NextPalette.end(), palette);
+            return;
+        }
+    }
+    else
+    {
+        state.FramesSinceUpdate++;
+
+        stats.InterpolatedInstances++;
+        stats.SkippedBoneEvaluations += boneCount;
+    }
+
+    // Blending the palettes row by row is not a true pose blend, but the two
+    // poses are at most a few frames apart and the character is far away.
+    float t = MathHelper::Min((float)state.FramesSinceUpdate / period, 1.0f);
+    for(UINT i = 0; i < boneCount; ++i)
+    {
+        for(UINT row = 0; row < 3; ++row)
+        {
+            XMVECTOR prev = XMLoadFloat4(&state.PrevPalette[i].Rows[row]);
+            XMVECTOR next = XMLoadFloat4(&state.NextPalette[i].Rows[row]);
+            XMStoreFloat4(&palette[i].Rows[row], XMVectorLerp(prev, next, t));
+        }
+    }
+}
+
+UINT CrowdAnimator::SelectLodLevel(const SkinnedModelInstance& instance)const
+{
+    XMVECTOR toEye = XMVectorSubtract(XMLoadFloat3(&mEyePosW), XMLoadFloat3(&instance.PositionW));
+    float distance = mLodSettings.DistanceScale*XMVectorGetX(XMVector3Length(toEye));
+
+    UINT levelCount = (UINT)mLodSettings.Levels.size();
+    for(UINT i = 0; i < levelCount - 1; ++i)
+    {
+        if(distance <= mLodSettings.Levels[i].MaxDistance)
+            return i;
+    }
+
+    return levelCount - 1;
+}
+
+void CrowdAnimator::Update(float dt, UploadBuffer<SkinnedConstants>* skinnedCB)
+{
+    UpdateBatches(dt, [skinnedCB](UINT skinnedCBIndex)
+    {
+        return skinnedCB->MappedElement(skinnedCBIndex);
+    });
+}
+
+void CrowdAnimator::Update(float dt, SkinnedConstants* palettes)
+{
+    UpdateBatches(dt, [palettes](UINT skinnedCBIndex)
+    {
+        return &palettes[skinnedCBIndex];
+    });
+}
+
+void CrowdAnimator::EnableLod(const AnimationLodSettings& settings)
+{
+    assert(!settings.Levels.empty() && settings.Levels.size() <= AnimationLodStats::MaxLevels);
+
+    mLodSettings = settings;
+    for(auto& level : mLodSettings.Levels)
+        level.UpdatePeriod = MathHelper::Max(level.UpdatePeriod, 1u);
+
+    mLodEnabled = true;
+    mLodStates.clear();
+}
+
+void CrowdAnimator::DisableLod()
+{
+    mLodEnabled = false;
+    mLodStates.clear();
+}
+
+bool CrowdAnimator::IsLodEnabled()const
+{
+    return mLodEnabled;
+}
+
+void CrowdAnimator::SetEyePosW(const XMFLOAT3& eyePosW)
+{
+    mEyePosW = eyePosW;
+}
+
+const AnimationLodStats& CrowdAnimator::GetLodStats()const
+{
+    return mLodStats;
+}
@@ -0,0 +1,143 @@
+//***************************************************************************************
+// CrowdAnimator.h
+//
+// Animates many skinned model instances at once.  Instances are split into small
+// batches that are sampled, propagated through the bone hierarchy and turned into
+// bone palettes on the PPL worker threads.  Each batch writes its palettes straight
+// into the mapped SkinnedCB upload buffer, so there is no per-instance copy on the
+// main thread.
+//
+// With animation LOD enabled, distant instances are evaluated less often and with
+// fewer bones; see AnimationLod.h.
+//***************************************************************************************
+
+#pragma once
+
+#include "../../Common/d3dUtil.h"
+#include "../../Common/UploadBuffer.h"
+#include "FrameResource.h"
+#include "SkinnedData.h"
+#include "AnimationBlendTree.h"
+#include "AnimationLod.h"
+
+struct SkinnedModelInstance
+{
+    SkinnedData* SkinnedInfo = nullptr;
+    std::string ClipName;
+    float TimePos = 0.0f;
+
+    // Scales dt so instances playing the same clip do not move in lock step.
+    float PlaybackRate = 1.0f;
+
+    // Index of this instance's bone palette in the SkinnedCB.
+    UINT SkinnedCBIndex = 0;
+
+    // World position of the model, used to pick its animation LOD.
+    DirectX::XMFLOAT3 PositionW = { 0.0f, 0.0f, 0.0f };
+
+    // When set, the instance plays this tree instead of ClipName.  The
+    // instance does not own the tree, and no two instances may share one.
+    AnimationBlendTree* BlendTree = nullptr;
+
+    // Looks up ClipName and caches the clip and its end time.  Call again
+    // after changing ClipName.
+    void SetClip(const std::string& clipName);
+
+    // Increments the time position and loops the animation.
+    void Advance(float dt);
+
+    // The time position Advance(dt) would move to, without moving.
+    float TimeAfter(float dt)const;
+
+    const AnimationClip* GetClip()const;
+
+    // Interpolates the animations for each bone based on the current clip
+    // and writes the final transforms, ready to be set for processing in
+    // the vertex shader.
+    void GetFinalTransforms(BoneTransform3x4* finalTransforms)const;
+
+private:
+    const AnimationClip* mClip = nullptr;
+    float mClipEndTime = 0.0f;
+};
+
+class CrowdAnimator
+{
+public:
+    CrowdAnimator() = default;
+    CrowdAnimator(const CrowdAnimator& rhs) = delete;
+    CrowdAnimator& operator=(const CrowdAnimator& rhs) = delete;
+    ~CrowdAnimator() = default;
+
+    // The crowd does not own its instances.
+    void AddInstance(SkinnedModelInstance* instance);
+    void Clear();
+
+    UINT InstanceCount()const;
+
+    // Number of instances each parallel job animates.  Small batches balance
+    // better, large batches amortize the scheduling cost.
+    UINT GetBatchSize()const;
+    void SetBatchSize(UINT batchSize);
+
+    // Advances every instance by dt and writes its palette into element
+    // SkinnedCBIndex of the given per-frame buffer.
+    void Update(float dt, UploadBuffer<SkinnedConstants>* skinnedCB);
+
+    // Same as above, but writes palettes[SkinnedCBIndex].  Used when there is
+    // no device, e.g. by the headless benchmark.
+    void Update(float dt, SkinnedConstants* palettes);
+
+    // Turns animation LOD on for clip instances.  Instances playing a blend
+    // tree are always fully evaluated.
+    void EnableLod(const AnimationLodSettings& settings);
+    void DisableLod();
+    bool IsLodEnabled()const;
+
+    // The LOD level of each instance is picked by its distance to this point.
+    void SetEyePosW(const DirectX::XMFLOAT3& eyePosW);
+
+    // Counters of the last Update.
+    const AnimationLodStats& GetLodStats()const;
+
+private:
+    // Per-instance data kept between frames for animation LOD.
+    struct LodState
+    {
+        UINT Level = 0;
+        bool HasPose = false;
+
+        // Frames since the pose was last evaluated.
+        UINT FramesSinceUpdate = 0;
+
+        // Local pose of the last evaluation; bones below the level's depth
+        // keep their old transforms here.
+        std::vector<BonePose> LocalPose;
+
+        // Palettes the instance is interpolated between: the pose at the
+        // last evaluation and the pose UpdatePeriod frames later.
+        std::vector<BoneTransform3x4> PrevPalette;
+        std::vector<BoneTransform3x4> NextPalette;
+    };
+
+    template<typename GetPalette>
+    void UpdateBatches(float dt, GetPalette getPalette);
+
+    void UpdateLodInstance(UINT index, float dt, BoneTransform3x4* palette, AnimationLodStats& stats);
+
+    UINT SelectLodLevel(const SkinnedModelInstance& instance)const;
+
+private:
+    std::vector<SkinnedModelInstance*> mInstances;
+
+    UINT mBatchSize = 8;
+
+    bool mLodEnabled = false;
+    AnimationLodSettings mLodSettings;
+    std::vector<LodState> mLodStates;
+    AnimationLodStats mLodStats;
+    DirectX::XMFLOAT3 mEyePosW = { 0.0f, 0.0f, 0.0f };
+
+    // Counts updates, to stagger the instances' evaluation frames.
+    UINT mFrameIndex = 0;
+};
@@ -0,0 +1,317 @@
+//***************************************************************************************
+// CrowdBenchmark.cpp
+//
+// Headless console benchmark for CrowdAnimator and the skinning palettes.  Build it as its own console project
+// with SkinnedData.cpp, LoadM3d.cpp, CrowdAnimator.cpp and the Common folder (leave
+// SkinnedMeshApp.cpp out).  Run it from this folder so Models\soldier.m3d is found.
+//
+// For each core count it animates the crowd for a number of frames and reports how
+// many characters are animated per millisecond, next to the old serial path
+// (one GetFinalTransforms call per instance on the main thread).  Next it times
+// blend trees of 1 to 4 clips against the single clip path, checks that an additive
+// layer on top of its own reference pose gives back the additive clip, and the crowd spread
+// out in front of the eye with animation LOD on.  It then
+// compresses the clips and reports the compression ratio, the worst bone error and
+// the crowd throughput when sampling the compressed clips.
+//
+// Finally it builds every palette both as the old transposed 4x4 matrices and as the
+// 3x4 matrices the shaders now read, checks that they hold the same transforms and
+// compares the time and the bytes uploaded per frame.
+//***************************************************************************************
+
+#include <windows.h>
+#include <iostream>
+#include <iomanip>
+#include <ppl.h>
+#include "LoadM3d.h"
+#include "CrowdAnimator.h"
+#include "AnimationCompression.h"
+#include "AnimationBlendTree.h"
+
+using namespace std;
+using namespace DirectX;
+
+const int gNumFrameResources = 3;
+
+const UINT gCharacterCount = 1024;
+const UINT gFrameCount = 100;
+
+double Milliseconds(const LARGE_INTEGER& start, const LARGE_INTEGER& end)
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+
+	return 1000.0 * (double)(end.QuadPart - start.QuadPart) / (double)frequency.QuadPart;
+}
+
+// Average time of one crowd update, in milliseconds, when the PPL scheduler
+// may only use the given number of cores.
+double TimeCrowd(CrowdAnimator& crowd, SkinnedConstants* palettes, UINT cores)
+{
+	const float dt = 1.0f / 60.0f;
+	LARGE_INTEGER start, end;
+
+	concurrency::CurrentScheduler::Create(concurrency::SchedulerPolicy(2,
+		concurrency::MinConcurrency, cores,
+		concurrency::MaxConcurrency, cores));
+
+	// Warm up the worker threads before timing.
+	crowd.Update(dt, palettes);
+
+	QueryPerformanceCounter(&start);
+	for(UINT frame = 0; frame < gFrameCount; ++frame)
+	{
+		crowd.Update(dt, palettes);
+	}
+	QueryPerformanceCounter(&end);
+
+	concurrency::CurrentScheduler::Detach();
+
+	return Milliseconds(start, end) / gFrameCount;
+}
+
+int main()
+{
+	std::vector<M3DLoader::SkinnedVertex> vertices;
+	std::vector<USHORT> indices;
+	std::vector<M3DLoader::Subset> subsets;
+	std::vector<M3DLoader::M3dMaterial> mats;
+	SkinnedData skinnedInfo;
+
+	M3DLoader m3dLoader;
+	if(!m3dLoader.LoadM3d("Models\\soldier.m3d", vertices, indices, subsets, mats, skinnedInfo))
+	{
+		cout << "Could not open Models\\soldier.m3d" << endl;
+		return 1;
+	}
+
+	std::vector<std::unique_ptr<SkinnedModelInstance>> instances;
+	CrowdAnimator crowd;
+
+	float clipEndTime = skinnedInfo.GetClipEndTime("Take1");
+	for(UINT i = 0; i < gCharacterCount; ++i)
+	{
+		auto instance = std::make_unique<SkinnedModelInstance>();
+		instance->SkinnedInfo = &skinnedInfo;
+		instance->SetClip("Take1");
+		instance->TimePos = MathHelper::RandF(0.0f, clipEndTime);
+		instance->SkinnedCBIndex = i;
+
+		crowd.AddInstance(instance.get());
+		instances.push_back(std::move(instance));
+	}
+
+	// Stands in for the mapped SkinnedCB upload buffer.
+	std::vector<SkinnedConstants> palettes(gCharacterCount);
+
+	const float dt = 1.0f / 60.0f;
+	LARGE_INTEGER start, end;
+
+	cout << skinnedInfo.BoneCount() << " bones, " << gCharacterCount << " characters, "
+		<< gFrameCount << " frames" << endl << endl;
+
+	// The old path: one instance at a time on the calling thread, uploading
+	// full 4x4 palettes.
+	std::vector<XMFLOAT4X4> finalTransforms(skinnedInfo.BoneCount());
+	std::vector<XMFLOAT4X4> palettes4x4(gCharacterCount*SkinnedData::MaxBones);
+	QueryPerformanceCounter(&start);
+	for(UINT frame = 0; frame < gFrameCount; ++frame)
+	{
+		for(auto& instance : instances)
+		{
+			instance->Advance(dt);
+			skinnedInfo.GetFinalTransforms(instance->ClipName, instance->TimePos, finalTransforms);
+			std::copy(finalTransforms.begin(), finalTransforms.end(),
+				&palettes4x4[instance->SkinnedCBIndex*SkinnedData::MaxBones]);
+		}
+	}
+	QueryPerformanceCounter(&end);
+
+	double serialMs = Milliseconds(start, end) / gFrameCount;
+	cout << fixed << setprecision(2);
+	cout << "serial GetFinalTransforms: " << serialMs << " ms/frame, "
+		<< gCharacterCount / serialMs << " characters/ms" << endl << endl;
+
+	cout << "cores   ms/frame   characters/ms   speedup" << endl;
+
+	// 1, 2, 4, ... and finally every core.
+	std::vector<UINT> coreCounts;
+	UINT processorCount = concurrency::GetProcessorCount();
+	for(UINT cores = 1; cores < processorCount; cores *= 2)
+		coreCounts.push_back(cores);
+	coreCounts.push_back(processorCount);
+
+	for(UINT cores : coreCounts)
+	{
+		double ms = TimeCrowd(crowd, palettes.data(), cores);
+		cout << setw(5) << cores << setw(11) << ms << setw(16) << gCharacterCount / ms
+			<< setw(10) << serialMs / ms << "x" << endl;
+	}
+
+	//
+	// Blend trees.  soldier.m3d has a single clip, so the trees play it at
+	// different offsets; the sampling and blending cost is the same.
+	//
+
+	cout << endl << "clips   ms/frame   characters/ms   vs single clip" << endl;
+
+	double singleClipMs = TimeCrowd(crowd, palettes.data(), processorCount);
+	for(UINT clipCount = 1; clipCount <= 4; ++clipCount)
+	{
+		std::vector<std::unique_ptr<AnimationBlendTree>> trees;
+		for(auto& instance : instances)
+		{
+			auto tree = std::make_unique<AnimationBlendTree>(&skinnedInfo);
+
+			// 1: clip, 2: blend, 3: blend + additive, 4: blend of blends + additive.
+			int root = tree->AddClip("Take1", instance->TimePos);
+			if(clipCount >= 2)
+				root = tree->AddBlend(root, tree->AddClip("Take1", 0.25f*clipEndTime), 0.5f);
+			if(clipCount == 4)
+				root = tree->AddBlend(root, tree->AddClip("Take1", 0.5f*clipEndTime), 0.3f);
+			if(clipCount >= 3)
+				root = tree->AddAdditive(root, tree->AddClip("Take1", 0.75f*clipEndTime), 0.5f);
+			tree->SetRoot(root);
+
+			instance->BlendTree = tree.get();
+			trees.push_back(std::move(tree));
+		}
+
+		double ms = TimeCrowd(crowd, palettes.data(), processorCount);
+		cout << setw(5) << clipCount << setw(11) << ms << setw(16) << gCharacterCount / ms
+			<< setw(14) << ms / singleClipMs << "x" << endl;
+
+		for(auto& instance : instances)
+			instance->BlendTree = nullptr;
+	}
+
+	// With the base at the additive clip's first frame, its reference pose, and
+	// a weight of 1, an additive node has to give the additive clip's pose.
+	{
+		float clipStartTime = skinnedInfo.GetClipStartTime("Take1");
+
+		AnimationBlendTree additiveTree(&skinnedInfo);
+		additiveTree.AddAdditive(additiveTree.AddClip("Take1", clipStartTime),
+			additiveTree.AddClip("Take1", 0.75f*clipEndTime), 1.0f);
+
+		AnimationBlendTree clipTree(&skinnedInfo);
+		clipTree.AddClip("Take1", 0.75f*clipEndTime);
+
+		std::vector<BoneTransform3x4> additivePalette(skinnedInfo.BoneCount());
+		std::vector<BoneTransform3x4> clipPalette(skinnedInfo.BoneCount());
+		additiveTree.Evaluate(additivePalette.data());
+		clipTree.Evaluate(clipPalette.data());
+
+		float maxError = 0.0f;
+		for(UINT i = 0; i < skinnedInfo.BoneCount(); ++i)
+		{
+			for(UINT row = 0; row < 3; ++row)
+			{
+				XMVECTOR diff = XMVectorAbs(XMVectorSubtract(XMLoadFloat4(&additivePalette[i].Rows[row]),
+					XMLoadFloat4(&clipPalette[i].Rows[row])));
+				maxError = MathHelper::Max(maxError, XMVectorGetX(XMVector4Length(diff)));
+			}
+		}
+
+		cout << "additive on its reference pose: max palette error " << setprecision(6) << maxError
+			<< (maxError < 1e-3f ? ", ok" : ", WRONG") << setprecision(2) << endl;
+	}
+
+	//
+	// Animation LOD.  Spread the crowd over 0-80 units from the eye.
+	//
+
+	for(UINT i = 0; i < gCharacterCount; ++i)
+		instances[i]->PositionW = XMFLOAT3(0.0f, 0.0f, 80.0f*i / gCharacterCount);
+
+	crowd.EnableLod(AnimationLodSettings());
+	double lodMs = TimeCrowd(crowd, palettes.data(), processorCount);
+
+	const AnimationLodStats& lodStats = crowd.GetLodStats();
+	cout << endl << "animation LOD, " << processorCount << " cores: " << lodMs << " ms/frame, "
+		<< gCharacterCount / lodMs << " characters/ms, " << singleClipMs / lodMs << "x" << endl;
+	cout << "instances per level:";
+	for(UINT level = 0; level < AnimationLodSettings().Levels.size(); ++level)
+		cout << " " << lodStats.InstanceCount[level];
+	cout << endl << "evaluated " << lodStats.EvaluatedInstances << ", interpolated "
+		<< lodStats.InterpolatedInstances << " instances; " << lodStats.BoneEvaluations
+		<< " bones evaluated, " << lodStats.SkippedBoneEvaluations << " skipped per frame" << endl;
+
+	crowd.DisableLod();
+
+	//
+	// Compress the clips in place; the instances keep pointing at the same clips.
+	//
+
+	AnimationCompressionSettings compressionSettings;
+	AnimationCompressionStats compressionStats = skinnedInfo.CompressAnimations(compressionSettings);
+
+	cout << endl << "compression: " << compressionStats.SourceKeyCount << " -> "
+		<< compressionStats.CompressedKeyCount << " keys, " << compressionStats.SourceBytes << " -> "
+		<< compressionStats.CompressedBytes << " bytes, ratio " << compressionStats.CompressionRatio() << ":1" << endl;
+	cout << setprecision(4) << "max bone error: " << compressionStats.MaxBoneError << " (clip "
+		<< compressionStats.MaxErrorClip << ", bone " << compressionStats.MaxErrorBone << ")" << endl;
+
+	double compressedMs = TimeCrowd(crowd, palettes.data(), processorCount);
+	cout << setprecision(2) << "compressed clips, " << processorCount << " cores: " << compressedMs << " ms/frame, "
+		<< gCharacterCount / compressedMs << " characters/ms" << endl;
+
+	//
+	// 4x4 and 3x4 palettes, both on one thread so only the store differs.
+	//
+
+	UINT boneCount = skinnedInfo.BoneCount();
+	std::vector<BoneTransform3x4> palettes3x4(gCharacterCount*SkinnedData::MaxBones);
+
+	QueryPerformanceCounter(&start);
+	for(UINT frame = 0; frame < gFrameCount; ++frame)
+	{
+		for(auto& instance : instances)
+			skinnedInfo.GetFinalTransforms(*instance->GetClip(), instance->TimePos,
+				&palettes4x4[instance->SkinnedCBIndex*SkinnedData::MaxBones]);
+	}
+	QueryPerformanceCounter(&end);
+	double ms4x4 = Milliseconds(start, end) / gFrameCount;
+
+	QueryPerformanceCounter(&start);
+	for(UINT frame = 0; frame < gFrameCount; ++frame)
+	{
+		for(auto& instance : instances)
+			skinnedInfo.GetFinalTransforms(*instance->GetClip(), instance->TimePos,
+				&palettes3x4[instance->SkinnedCBIndex*SkinnedData::MaxBones]);
+	}
+	QueryPerformanceCounter(&end);
+	double ms3x4 = Milliseconds(start, end) / gFrameCount;
+
+	// The 3x4 rows must be the first three rows of the 4x4, and the dropped
+	// row must be 0,0,0,1.
+	float maxRowError = 0.0f;
+	float maxLastRowError = 0.0f;
+	for(UINT i = 0; i < gCharacterCount*SkinnedData::MaxBones; ++i)
+	{
+		if(i % SkinnedData::MaxBones >= boneCount)
+			continue;
+
+		XMMATRIX M = XMLoadFloat4x4(&palettes4x4[i]);
+		for(UINT row = 0; row < 3; ++row)
+		{
+			XMVECTOR diff = XMVectorAbs(XMVectorSubtract(M.r[row], XMLoadFloat4(&palettes3x4[i].Rows[row])));
+			maxRowError = MathHelper::Max(maxRowError, XMVectorGetX(XMVector4Length(diff)));
+		}
+
+		XMVECTOR lastRowDiff = XMVectorSubtract(M.r[3], g_XMIdentityR3);
+		maxLastRowError = MathHelper::Max(maxLastRowError, XMVectorGetX(XMVector4Length(lastRowDiff)));
+	}
+
+	size_t bytes4x4 = (size_t)gCharacterCount*boneCount*sizeof(XMFLOAT4X4);
+	size_t bytes3x4 = (size_t)gCharacterCount*boneCount*sizeof(BoneTransform3x4);
+
+	cout << endl << "palette   ms/frame   bytes/frame" << endl;
+	cout << "    4x4" << setw(11) << ms4x4 << setw(14) << bytes4x4 << endl;
+	cout << "    3x4" << setw(11) << ms3x4 << setw(14) << bytes3x4 << endl;
+	cout << setprecision(6) << "max row difference " << maxRowError << ", max dropped row difference "
+		<< maxLastRowError << (maxRowError == 0.0f && maxLastRowError < 1e-5f ? " (match)" : " (MISMATCH)") << endl;
+
+	system("pause");
+	return 0;
+}
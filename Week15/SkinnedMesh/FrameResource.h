@@ -3,6 +3,7 @@
 #include "../../Common/d3dUtil.h"
 #include "../../Common/MathHelper.h"
 #include "../../Common/UploadBuffer.h"
+#include "SkinnedData.h"
 
 struct ObjectConstants
 {
@@ -16,7 +17,8 @@ struct ObjectConstants
 
 struct SkinnedConstants
 {
-    DirectX::XMFLOAT4X4 BoneTransforms[96];
+    // 3x4 palettes upload 48 instead of 64 bytes per bone.
+    BoneTransform3x4 BoneTransforms[96];
 };
 
 struct PassConstants
@@ -64,7 +64,9 @@ cbuffer cbPerObject : register(b0)
 
 cbuffer cbSkinned : register(b1)
 {
-    float4x4 gBoneTransforms[96];
+    // Transposed bone transforms without their constant 0,0,0,1 row, so
+    // transform with mul(gBoneTransforms[i], v).
+    row_major float3x4 gBoneTransforms[96];
 };
 
 // Constant data that varies per material.
@@ -40,7 +40,7 @@ VertexOut VS(VertexIn vin)
         // Assume no nonuniform scaling when transforming normals, so 
         // that we do not have to use the inverse-transpose.
 
-        posL += weights[i] * mul(float4(vin.PosL, 1.0f), gBoneTransforms[vin.BoneIndices[i]]).xyz;
+        posL += weights[i] * mul(gBoneTransforms[vin.BoneIndices[i]], float4(vin.PosL, 1.0f));
     }
 
     vin.PosL = posL;
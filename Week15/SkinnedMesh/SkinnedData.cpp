@@ -1,4 +1,5 @@
 #include "SkinnedData.h"
+#include "AnimationCompression.h"
 
 using namespace DirectX;
 
@@ -29,57 +30,150 @@ float BoneAnimation::GetEndTime()const
 }
 
 void BoneAnimation::Interpolate(float t, XMFLOAT4X4& M)const
+{
+	BonePose pose;
+	Sample(t, pose);
+
+	XMStoreFloat4x4(&M, pose.ToMatrix());
+}
+
+void BoneAnimation::Sample(float t, BonePose& pose)const
 {
 	if( t <= Keyframes.front().TimePos )
 	{
-		XMVECTOR S = XMLoadFloat3(&Keyframes.front().Scale);
-		XMVECTOR P = XMLoadFloat3(&Keyframes.front().Translation);
-		XMVECTOR Q = XMLoadFloat4(&Keyframes.front().RotationQuat);
-
-		XMVECTOR zero = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
-		XMStoreFloat4x4(&M, XMMatrixAffineTransformation(S, zero, Q, P));
+		XMStoreFloat4A(&pose.Scale, XMLoadFloat3(&Keyframes.front().Scale));
+		XMStoreFloat4A(&pose.Translation, XMLoadFloat3(&Keyframes.front().Translation));
+		XMStoreFloat4A(&pose.Rotation, XMLoadFloat4(&Keyframes.front().RotationQuat));
 	}
 	else if( t >= Keyframes.back().TimePos )
 	{
-		XMVECTOR S = XMLoadFloat3(&Keyframes.back().Scale);
-		XMVECTOR P = XMLoadFloat3(&Keyframes.back().Translation);
-		XMVECTOR Q = XMLoadFloat4(&Keyframes.back().RotationQuat);
-
-		XMVECTOR zero = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
-		XMStoreFloat4x4(&M, XMMatrixAffineTransformation(S, zero, Q, P));
+		XMStoreFloat4A(&pose.Scale, XMLoadFloat3(&Keyframes.back().Scale));
+		XMStoreFloat4A(&pose.Translation, XMLoadFloat3(&Keyframes.back().Translation));
+		XMStoreFloat4A(&pose.Rotation, XMLoadFloat4(&Keyframes.back().RotationQuat));
 	}
 	else
 	{
-		for(UINT i = 0; i < Keyframes.size()-1; ++i)
-		{
-			if( t >= Keyframes[i].TimePos && t <= Keyframes[i+1].TimePos )
-			{
-				float lerpPercent = (t - Keyframes[i].TimePos) / (Keyframes[i+1].TimePos - Keyframes[i].TimePos);
+		// Keyframes are sorted by time, so binary search for the first key
+		// after t instead of scanning the whole track.
+		auto next = std::upper_bound(Keyframes.begin(), Keyframes.end(), t,
+			[](float time, const Keyframe& key) { return time < key.TimePos; });
+		UINT i = (UINT)(next - Keyframes.begin()) - 1;
 
-				XMVECTOR s0 = XMLoadFloat3(&Keyframes[i].Scale);
-				XMVECTOR s1 = XMLoadFloat3(&Keyframes[i+1].Scale);
+		float lerpPercent = (t - Keyframes[i].TimePos) / (Keyframes[i+1].TimePos - Keyframes[i].TimePos);
 
-				XMVECTOR p0 = XMLoadFloat3(&Keyframes[i].Translation);
-				XMVECTOR p1 = XMLoadFloat3(&Keyframes[i+1].Translation);
+		XMVECTOR s0 = XMLoadFloat3(&Keyframes[i].Scale);
+		XMVECTOR s1 = XMLoadFloat3(&Keyframes[i+1].Scale);
 
-				XMVECTOR q0 = XMLoadFloat4(&Keyframes[i].RotationQuat);
-				XMVECTOR q1 = XMLoadFloat4(&Keyframes[i+1].RotationQuat);
+		XMVECTOR p0 = XMLoadFloat3(&Keyframes[i].Translation);
+		XMVECTOR p1 = XMLoadFloat3(&Keyframes[i+1].Translation);
 
-				XMVECTOR S = XMVectorLerp(s0, s1, lerpPercent);
-				XMVECTOR P = XMVectorLerp(p0, p1, lerpPercent);
-				XMVECTOR Q = XMQuaternionSlerp(q0, q1, lerpPercent);
+		XMVECTOR q0 = XMLoadFloat4(&Keyframes[i].RotationQuat);
+		XMVECTOR q1 = XMLoadFloat4(&Keyframes[i+1].RotationQuat);
 
-				XMVECTOR zero = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
-				XMStoreFloat4x4(&M, XMMatrixAffineTransformation(S, zero, Q, P));
+		XMStoreFloat4A(&pose.Scale, XMVectorLerp(s0, s1, lerpPercent));
+		XMStoreFloat4A(&pose.Translation, XMVectorLerp(p0, p1, lerpPercent));
+		XMStoreFloat4A(&pose.Rotation, XMQuaternionSlerp(q0, q1, lerpPercent));
+	}
+}
 
-				break;
-			}
+namespace
+{
+	// Finds the keys of a compressed track that bound u and how far u is
+	// between them.
+	void FindKeys(const CompressedTrack& track, float u, UINT& k0, UINT& k1, float& lerpPercent)
+	{
+		UINT keyCount = track.KeyCount();
+
+		if(keyCount == 1 || u <= (float)track.Times.front())
+		{
+			k0 = k1 = 0;
+			lerpPercent = 0.0f;
+		}
+		else if(u >= (float)track.Times.back())
+		{
+			k0 = k1 = keyCount - 1;
+			lerpPercent = 0.0f;
+		}
+		else
+		{
+			auto next = std::upper_bound(track.Times.begin(), track.Times.end(), u,
+				[](float time, USHORT key) { return time < (float)key; });
+			k1 = (UINT)(next - track.Times.begin());
+			k0 = k1 - 1;
+
+			lerpPercent = (u - (float)track.Times[k0]) / (float)(track.Times[k1] - track.Times[k0]);
 		}
 	}
+
+	XMVECTOR XM_CALLCONV SampleVector(const CompressedTrack& track, float u)
+	{
+		UINT k0, k1;
+		float lerpPercent;
+		FindKeys(track, u, k0, k1, lerpPercent);
+
+		XMVECTOR v0 = AnimationCompression::DecodeVector(&track.Values[3*k0], track.Min, track.Extent);
+		if(k0 == k1)
+			return v0;
+
+		XMVECTOR v1 = AnimationCompression::DecodeVector(&track.Values[3*k1], track.Min, track.Extent);
+		return XMVectorLerp(v0, v1, lerpPercent);
+	}
+
+	XMVECTOR XM_CALLCONV SampleRotation(const CompressedTrack& track, float u)
+	{
+		UINT k0, k1;
+		float lerpPercent;
+		FindKeys(track, u, k0, k1, lerpPercent);
+
+		XMVECTOR q0 = AnimationCompression::DecodeQuaternion(&track.Values[3*k0]);
+		if(k0 == k1)
+			return q0;
+
+		XMVECTOR q1 = AnimationCompression::DecodeQuaternion(&track.Values[3*k1]);
+		return XMQuaternionSlerp(q0, q1, lerpPercent);
+	}
+}
+
+UINT CompressedTrack::KeyCount()const
+{
+	return (UINT)Times.size();
+}
+
+size_t CompressedTrack::ByteSize()const
+{
+	return (Times.size() + Values.size())*sizeof(USHORT) + sizeof(Min) + sizeof(Extent);
+}
+
+void CompressedBoneAnimation::Interpolate(float u, XMFLOAT4X4& M)const
+{
+	BonePose pose;
+	Sample(u, pose);
+
+	XMStoreFloat4x4(&M, pose.ToMatrix());
+}
+
+void CompressedBoneAnimation::Sample(float u, BonePose& pose)const
+{
+	XMStoreFloat4A(&pose.Scale, SampleVector(Scale, u));
+	XMStoreFloat4A(&pose.Translation, SampleVector(Translation, u));
+	XMStoreFloat4A(&pose.Rotation, SampleRotation(Rotation, u));
+}
+
+XMMATRIX XM_CALLCONV BonePose::ToMatrix()const
+{
+	XMVECTOR S = XMLoadFloat4A(&Scale);
+	XMVECTOR P = XMLoadFloat4A(&Translation);
+	XMVECTOR Q = XMLoadFloat4A(&Rotation);
+
+	XMVECTOR zero = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+	return XMMatrixAffineTransformation(S, zero, Q, P);
 }
 
 float AnimationClip::GetClipStartTime()const
 {
+	if(IsCompressed())
+		return CompressedStartTime;
+
 	// Find smallest start time over all bones in this clip.
 	float t = MathHelper::Infinity;
 	for(UINT i = 0; i < BoneAnimations.size(); ++i)
@@ -92,6 +186,9 @@ float AnimationClip::GetClipStartTime()const
 
 float AnimationClip::GetClipEndTime()const
 {
+	if(IsCompressed())
+		return CompressedEndTime;
+
 	// Find largest end time over all bones in this clip.
 	float t = 0.0f;
 	for(UINT i = 0; i < BoneAnimations.size(); ++i)
@@ -104,12 +201,75 @@ float AnimationClip::GetClipEndTime()const
 
 void AnimationClip::Interpolate(float t, std::vector<XMFLOAT4X4>& boneTransforms)const
 {
+	Interpolate(t, boneTransforms.data());
+}
+
+void AnimationClip::Interpolate(float t, XMFLOAT4X4* boneTransforms)const
+{
+	if(IsCompressed())
+	{
+		float u = CompressedTime(t);
+		for(UINT i = 0; i < CompressedBoneAnimations.size(); ++i)
+		{
+			CompressedBoneAnimations[i].Interpolate(u, boneTransforms[i]);
+		}
+		return;
+	}
+
 	for(UINT i = 0; i < BoneAnimations.size(); ++i)
 	{
 		BoneAnimations[i].Interpolate(t, boneTransforms[i]);
 	}
 }
 
+void AnimationClip::Sample(float t, BonePose* pose)const
+{
+	if(IsCompressed())
+	{
+		float u = CompressedTime(t);
+		for(UINT i = 0; i < CompressedBoneAnimations.size(); ++i)
+		{
+			CompressedBoneAnimations[i].Sample(u, pose[i]);
+		}
+		return;
+	}
+
+	for(UINT i = 0; i < BoneAnimations.size(); ++i)
+	{
+		BoneAnimations[i].Sample(t, pose[i]);
+	}
+}
+
+void AnimationClip::Sample(float t, const UINT* bones, UINT boneCount, BonePose* pose)const
+{
+	if(IsCompressed())
+	{
+		float u = CompressedTime(t);
+		for(UINT i = 0; i < boneCount; ++i)
+		{
+			CompressedBoneAnimations[bones[i]].Sample(u, pose[bones[i]]);
+		}
+		return;
+	}
+
+	for(UINT i = 0; i < boneCount; ++i)
+	{
+		BoneAnimations[bones[i]].Sample(t, pose[bones[i]]);
+	}
+}
+
+float AnimationClip::CompressedTime(float t)const
+{
+	// Compressed key times are 16-bit fractions of the clip duration.
+	float duration = CompressedEndTime - CompressedStartTime;
+	return duration > 0.0f ? 65535.0f*(t - CompressedStartTime) / duration : 0.0f;
+}
+
+bool AnimationClip::IsCompressed()const
+{
+	return !CompressedBoneAnimations.empty();
+}
+
 float SkinnedData::GetClipStartTime(const std::string& clipName)const
 {
 	auto clip = mAnimations.find(clipName);
@@ -134,23 +294,147 @@ void SkinnedData::Set(std::vector<int>& boneHierarchy,
 	mBoneHierarchy = boneHierarchy;
 	mBoneOffsets   = boneOffsets;
 	mAnimations    = animations;
+
+	// Parents come before their children, so one pass finds every depth.
+	UINT numBones = (UINT)mBoneHierarchy.size();
+	UINT maxDepth = 0;
+	mBoneDepths.resize(numBones);
+	for(UINT i = 0; i < numBones; ++i)
+	{
+		int parentIndex = mBoneHierarchy[i];
+		mBoneDepths[i] = parentIndex < 0 ? 0 : mBoneDepths[parentIndex] + 1;
+		maxDepth = MathHelper::Max(maxDepth, mBoneDepths[i]);
+	}
+
+	mBonesByDepth.resize(numBones);
+	for(UINT i = 0; i < numBones; ++i)
+		mBonesByDepth[i] = i;
+
+	std::stable_sort(mBonesByDepth.begin(), mBonesByDepth.end(),
+		[this](UINT a, UINT b) { return mBoneDepths[a] < mBoneDepths[b]; });
+
+	mDepthBoneCounts.assign(maxDepth + 1, 0);
+	for(UINT i = 0; i < numBones; ++i)
+		mDepthBoneCounts[mBoneDepths[i]]++;
+	for(UINT depth = 1; depth <= maxDepth; ++depth)
+		mDepthBoneCounts[depth] += mDepthBoneCounts[depth - 1];
+}
+
+UINT SkinnedData::BoneDepth(UINT bone)const
+{
+	return mBoneDepths[bone];
+}
+
+UINT SkinnedData::Sample(const AnimationClip& clip, float timePos, UINT maxDepth, BonePose* localPose)const
+{
+	UINT boneCount = maxDepth < mDepthBoneCounts.size() ?
+		mDepthBoneCounts[maxDepth] : (UINT)mBonesByDepth.size();
+
+	clip.Sample(timePos, mBonesByDepth.data(), boneCount, localPose);
+	return boneCount;
 }
  
+const AnimationClip* SkinnedData::FindClip(const std::string& clipName)const
+{
+	auto clip = mAnimations.find(clipName);
+	return clip != mAnimations.end() ? &clip->second : nullptr;
+}
+
 void SkinnedData::GetFinalTransforms(const std::string& clipName, float timePos,  std::vector<XMFLOAT4X4>& finalTransforms)const
 {
-	UINT numBones = mBoneOffsets.size();
+	auto clip = mAnimations.find(clipName);
+	GetFinalTransforms(clip->second, timePos, finalTransforms.data());
+}
+
+void SkinnedData::GetFinalTransforms(const AnimationClip& clip, float timePos, XMFLOAT4X4* finalTransforms)const
+{
+	XMFLOAT4X4 toRootTransforms[MaxBones];
+	ToRootTransforms(clip, timePos, toRootTransforms);
+	ToFinalTransforms(toRootTransforms, finalTransforms);
+}
+
+void SkinnedData::GetFinalTransforms(const BonePose* localPose, XMFLOAT4X4* finalTransforms)const
+{
+	XMFLOAT4X4 toRootTransforms[MaxBones];
+	ToRootTransforms(localPose, toRootTransforms);
+	ToFinalTransforms(toRootTransforms, finalTransforms);
+}
+
+void SkinnedData::GetFinalTransforms(const AnimationClip& clip, float timePos, BoneTransform3x4* finalTransforms)const
+{
+	XMFLOAT4X4 toRootTransforms[MaxBones];
+	ToRootTransforms(clip, timePos, toRootTransforms);
+	ToFinalTransforms(toRootTransforms, finalTransforms);
+}
 
-	std::vector<XMFLOAT4X4> toParentTransforms(numBones);
+void SkinnedData::GetFinalTransforms(const BonePose* localPose, BoneTransform3x4* finalTransforms)const
+{
+	XMFLOAT4X4 toRootTransforms[MaxBones];
+	ToRootTransforms(localPose, toRootTransforms);
+	ToFinalTransforms(toRootTransforms, finalTransforms);
+}
+
+void SkinnedData::ToRootTransforms(const AnimationClip& clip, float timePos, XMFLOAT4X4* toRootTransforms)const
+{
+	assert(mBoneOffsets.size() <= MaxBones);
+
+	XMFLOAT4X4 toParentTransforms[MaxBones];
 
 	// Interpolate all the bones of this clip at the given time instance.
-	auto clip = mAnimations.find(clipName);
-	clip->second.Interpolate(timePos, toParentTransforms);
+	clip.Interpolate(timePos, toParentTransforms);
 
-	//
 	// Traverse the hierarchy and transform all the bones to the root space.
-	//
+	ToRootTransforms(toParentTransforms, toRootTransforms);
+}
+
+void SkinnedData::ToRootTransforms(const BonePose* localPose, XMFLOAT4X4* toRootTransforms)const
+{
+	UINT numBones = (UINT)mBoneOffsets.size();
+	assert(numBones <= MaxBones);
+
+	XMFLOAT4X4 toParentTransforms[MaxBones];
+	for(UINT i = 0; i < numBones; ++i)
+	{
+		XMStoreFloat4x4(&toParentTransforms[i], localPose[i].ToMatrix());
+	}
+
+	ToRootTransforms(toParentTransforms, toRootTransforms);
+}
+
+void SkinnedData::ToFinalTransforms(const XMFLOAT4X4* toRootTransforms, XMFLOAT4X4* finalTransforms)const
+{
+	UINT numBones = (UINT)mBoneOffsets.size();
+
+	// Premultiply by the bone offset transform to get the final transform.
+	for(UINT i = 0; i < numBones; ++i)
+	{
+		XMMATRIX offset = XMLoadFloat4x4(&mBoneOffsets[i]);
+		XMMATRIX toRoot = XMLoadFloat4x4(&toRootTransforms[i]);
+		XMMATRIX finalTransform = XMMatrixMultiply(offset, toRoot);
+		XMStoreFloat4x4(&finalTransforms[i], XMMatrixTranspose(finalTransform));
+	}
+}
 
-	std::vector<XMFLOAT4X4> toRootTransforms(numBones);
+void SkinnedData::ToFinalTransforms(const XMFLOAT4X4* toRootTransforms, BoneTransform3x4* finalTransforms)const
+{
+	UINT numBones = (UINT)mBoneOffsets.size();
+
+	for(UINT i = 0; i < numBones; ++i)
+	{
+		XMMATRIX offset = XMLoadFloat4x4(&mBoneOffsets[i]);
+		XMMATRIX toRoot = XMLoadFloat4x4(&toRootTransforms[i]);
+		XMMATRIX finalTransform = XMMatrixTranspose(XMMatrixMultiply(offset, toRoot));
+
+		// The last row of the transpose is always 0,0,0,1; do not store it.
+		XMStoreFloat4(&finalTransforms[i].Rows[0], finalTransform.r[0]);
+		XMStoreFloat4(&finalTransforms[i].Rows[1], finalTransform.r[1]);
+		XMStoreFloat4(&finalTransforms[i].Rows[2], finalTransform.r[2]);
+	}
+}
+
+void SkinnedData::ToRootTransforms(const XMFLOAT4X4* toParentTransforms, XMFLOAT4X4* toRootTransforms)const
+{
+	UINT numBones = (UINT)mBoneHierarchy.size();
 
 	// The root bone has index 0.  The root bone has no parent, so its toRootTransform
 	// is just its local bone transform.
@@ -168,13 +452,100 @@ void SkinnedData::GetFinalTransforms(const std::string& clipName, float timePos,
 
 		XMStoreFloat4x4(&toRootTransforms[i], toRoot);
 	}
+}
 
-	// Premultiply by the bone offset transform to get the final transform.
-	for(UINT i = 0; i < numBones; ++i)
+AnimationCompressionStats SkinnedData::CompressAnimations(const AnimationCompressionSettings& settings)
+{
+	AnimationCompressionStats stats;
+
+	UINT numBones = (UINT)mBoneHierarchy.size();
+	assert(numBones <= MaxBones);
+
+	// Points on each bone that the error is measured at.
+	const float d = settings.ErrorPointDistance;
+	XMVECTOR errorPoints[3] =
 	{
-		XMMATRIX offset = XMLoadFloat4x4(&mBoneOffsets[i]);
-		XMMATRIX toRoot = XMLoadFloat4x4(&toRootTransforms[i]);
-        XMMATRIX finalTransform = XMMatrixMultiply(offset, toRoot);
-		XMStoreFloat4x4(&finalTransforms[i], XMMatrixTranspose(finalTransform));
+		XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f),
+		XMVectorSet(d, 0.0f, 0.0f, 1.0f),
+		XMVectorSet(0.0f, d, 0.0f, 1.0f)
+	};
+
+	for(auto& e : mAnimations)
+	{
+		AnimationClip& clip = e.second;
+		if(clip.IsCompressed())
+			continue;
+
+		for(const BoneAnimation& bone : clip.BoneAnimations)
+		{
+			stats.SourceKeyCount += (UINT)bone.Keyframes.size();
+			stats.SourceBytes += bone.Keyframes.size()*sizeof(Keyframe);
+		}
+
+		float startTime = clip.GetClipStartTime();
+		float endTime = clip.GetClipEndTime();
+
+		// Once CompressedBoneAnimations is filled, clip.Interpolate samples
+		// the compressed form.
+		AnimationCompression::CompressClip(clip, settings, clip.CompressedBoneAnimations);
+		clip.CompressedStartTime = startTime;
+		clip.CompressedEndTime = endTime;
+
+		for(const CompressedBoneAnimation& bone : clip.CompressedBoneAnimations)
+		{
+			stats.CompressedKeyCount += bone.Translation.KeyCount() + bone.Scale.KeyCount() + bone.Rotation.KeyCount();
+			stats.CompressedBytes += bone.Translation.ByteSize() + bone.Scale.ByteSize() + bone.Rotation.ByteSize();
+		}
+
+		//
+		// Sample both forms through the hierarchy and compare points on the bones.
+		//
+
+		XMFLOAT4X4 sourceToParent[MaxBones];
+		XMFLOAT4X4 sourceToRoot[MaxBones];
+		XMFLOAT4X4 compressedToParent[MaxBones];
+		XMFLOAT4X4 compressedToRoot[MaxBones];
+
+		UINT sampleCount = MathHelper::Max((UINT)((endTime - startTime)*settings.ErrorSamplesPerSecond), 1u) + 1;
+		for(UINT sample = 0; sample < sampleCount; ++sample)
+		{
+			float t = startTime + (endTime - startTime)*sample / (sampleCount - 1);
+
+			for(UINT i = 0; i < numBones; ++i)
+			{
+				clip.BoneAnimations[i].Interpolate(t, sourceToParent[i]);
+			}
+			clip.Interpolate(t, compressedToParent);
+
+			ToRootTransforms(sourceToParent, sourceToRoot);
+			ToRootTransforms(compressedToParent, compressedToRoot);
+
+			for(UINT i = 0; i < numBones; ++i)
+			{
+				XMMATRIX source = XMLoadFloat4x4(&sourceToRoot[i]);
+				XMMATRIX compressed = XMLoadFloat4x4(&compressedToRoot[i]);
+
+				for(XMVECTOR p : errorPoints)
+				{
+					XMVECTOR diff = XMVector3Transform(p, source) - XMVector3Transform(p, compressed);
+					float error = XMVectorGetX(XMVector3Length(diff));
+
+					if(error > stats.MaxBoneError)
+					{
+						stats.MaxBoneError = error;
+						stats.MaxErrorClip = e.first;
+						stats.MaxErrorBone = i;
+					}
+				}
+			}
+		}
+
+		if(!settings.KeepSourceKeyframes)
+		{
+			clip.BoneAnimations.clear();
+			clip.BoneAnimations.shrink_to_fit();
+		}
 	}
-}
\ No newline at end of file
+
+	return stats;
+}
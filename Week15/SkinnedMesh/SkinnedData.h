@@ -18,6 +18,31 @@ struct Keyframe
     DirectX::XMFLOAT4 RotationQuat;
 };
 
+///<summary>
+/// A final bone transform in the form the skinning shaders read it: the
+/// transposed 4x4 with its constant 0,0,0,1 row dropped.  Matches a
+/// row_major float3x4 in HLSL, so a palette is 25% smaller than with
+/// XMFLOAT4X4.
+///</summary>
+struct BoneTransform3x4
+{
+	DirectX::XMFLOAT4 Rows[3];
+};
+
+///<summary>
+/// The to-parent transform of one bone kept as scale, rotation and
+/// translation, so that poses can be blended before they go through
+/// the hierarchy.  The w components of Translation and Scale are unused.
+///</summary>
+struct BonePose
+{
+	DirectX::XMFLOAT4A Translation = { 0.0f, 0.0f, 0.0f, 0.0f };
+	DirectX::XMFLOAT4A Rotation = { 0.0f, 0.0f, 0.0f, 1.0f };
+	DirectX::XMFLOAT4A Scale = { 1.0f, 1.0f, 1.0f, 0.0f };
+
+	DirectX::XMMATRIX XM_CALLCONV ToMatrix()const;
+};
+
 ///<summary>
 /// A BoneAnimation is defined by a list of keyframes.  For time
 /// values inbetween two keyframes, we interpolate between the
@@ -31,10 +56,46 @@ struct BoneAnimation
 	float GetEndTime()const;
 
     void Interpolate(float t, DirectX::XMFLOAT4X4& M)const;
+    void Sample(float t, BonePose& pose)const;
 
 	std::vector<Keyframe> Keyframes; 	
 };
 
+///<summary>
+/// One compressed channel (translation, scale or rotation) of a bone.
+/// Keys that can be rebuilt by interpolating their neighbours are dropped,
+/// key times are 16-bit fractions of the clip duration, and every key value
+/// is three 16-bit integers.  Translation and scale are quantized against
+/// the track's [Min, Min+Extent] box; rotations use the smallest-three
+/// 48-bit encoding.  See AnimationCompression.h.
+///</summary>
+struct CompressedTrack
+{
+	std::vector<USHORT> Times;
+	std::vector<USHORT> Values;
+
+	DirectX::XMFLOAT3 Min = { 0.0f, 0.0f, 0.0f };
+	DirectX::XMFLOAT3 Extent = { 0.0f, 0.0f, 0.0f };
+
+	UINT KeyCount()const;
+	size_t ByteSize()const;
+};
+
+///<summary>
+/// A BoneAnimation after compression.  The keys are decompressed on the
+/// fly while interpolating.
+///</summary>
+struct CompressedBoneAnimation
+{
+	// u is the sample time mapped to [0, 65535] over the clip duration.
+	void Interpolate(float u, DirectX::XMFLOAT4X4& M)const;
+	void Sample(float u, BonePose& pose)const;
+
+	CompressedTrack Translation;
+	CompressedTrack Scale;
+	CompressedTrack Rotation;
+};
+
 ///<summary>
 /// Examples of AnimationClips are "Walk", "Run", "Attack", "Defend".
 /// An AnimationClip requires a BoneAnimation for every bone to form
@@ -46,13 +107,38 @@ struct AnimationClip
 	float GetClipEndTime()const;
 
     void Interpolate(float t, std::vector<DirectX::XMFLOAT4X4>& boneTransforms)const;
+    void Interpolate(float t, DirectX::XMFLOAT4X4* boneTransforms)const;
+
+	// Writes the local pose of every bone at time t.
+	void Sample(float t, BonePose* pose)const;
+
+	// Same as above but only for the given bones; the other entries of
+	// pose are left untouched.
+	void Sample(float t, const UINT* bones, UINT boneCount, BonePose* pose)const;
+
+	// True once SkinnedData::CompressAnimations has run.  Interpolate then
+	// reads CompressedBoneAnimations, and BoneAnimations may be empty.
+	bool IsCompressed()const;
 
     std::vector<BoneAnimation> BoneAnimations; 	
+
+	std::vector<CompressedBoneAnimation> CompressedBoneAnimations;
+	float CompressedStartTime = 0.0f;
+	float CompressedEndTime = 0.0f;
+
+private:
+	// Maps t to the [0, 65535] range the compressed key times use.
+	float CompressedTime(float t)const;
 };
 
+struct AnimationCompressionSettings;
+struct AnimationCompressionStats;
+
 class SkinnedData
 {
 public:
+	// Size of the bone palette in SkinnedConstants.
+	static const UINT MaxBones = 96;
 
 	UINT BoneCount()const;
 
@@ -70,11 +156,67 @@ public:
     void GetFinalTransforms(const std::string& clipName, float timePos, 
 		 std::vector<DirectX::XMFLOAT4X4>& finalTransforms)const;
 
+	// Returns nullptr if there is no clip with the given name.
+	const AnimationClip* FindClip(const std::string& clipName)const;
+
+	// Same as above but for an already looked-up clip, writing BoneCount()
+	// matrices to finalTransforms.  Only uses stack scratch memory, so it
+	// can be called concurrently for different instances.
+	void GetFinalTransforms(const AnimationClip& clip, float timePos,
+		DirectX::XMFLOAT4X4* finalTransforms)const;
+
+	// Runs a local pose, e.g. one blended from several clips, through the
+	// hierarchy once and writes the BoneCount() palette matrices.
+	void GetFinalTransforms(const BonePose* localPose,
+		DirectX::XMFLOAT4X4* finalTransforms)const;
+
+	// Same as the two above but write 3x4 palettes.
+	void GetFinalTransforms(const AnimationClip& clip, float timePos,
+		BoneTransform3x4* finalTransforms)const;
+	void GetFinalTransforms(const BonePose* localPose,
+		BoneTransform3x4* finalTransforms)const;
+
+	// Number of parents between the bone and the root; the root has depth 0.
+	UINT BoneDepth(UINT bone)const;
+
+	// Samples only the bones no deeper than maxDepth into localPose, leaving
+	// the deeper bones as they are, and returns how many bones were sampled.
+	// Used by animation LOD to stop evaluating fingers and other small bones
+	// of distant characters.
+	UINT Sample(const AnimationClip& clip, float timePos, UINT maxDepth,
+		BonePose* localPose)const;
+
+	// Compresses every clip in place and reports how much memory was saved
+	// and the worst bone position error it introduced.
+	AnimationCompressionStats CompressAnimations(const AnimationCompressionSettings& settings);
+
+private:
+	// Multiplies the bones' to-parent transforms down the hierarchy.
+	void ToRootTransforms(const DirectX::XMFLOAT4X4* toParentTransforms,
+		DirectX::XMFLOAT4X4* toRootTransforms)const;
+	void ToRootTransforms(const AnimationClip& clip, float timePos,
+		DirectX::XMFLOAT4X4* toRootTransforms)const;
+	void ToRootTransforms(const BonePose* localPose,
+		DirectX::XMFLOAT4X4* toRootTransforms)const;
+
+	// Premultiplies by the bone offsets and stores the palette.
+	void ToFinalTransforms(const DirectX::XMFLOAT4X4* toRootTransforms,
+		DirectX::XMFLOAT4X4* finalTransforms)const;
+	void ToFinalTransforms(const DirectX::XMFLOAT4X4* toRootTransforms,
+		BoneTransform3x4* finalTransforms)const;
+
 private:
     // Gives parentIndex of ith bone.
 	std::vector<int> mBoneHierarchy;
 
 	std::vector<DirectX::XMFLOAT4X4> mBoneOffsets;
+
+	std::vector<UINT> mBoneDepths;
+
+	// Bone indices sorted by depth, and the number of bones at each depth
+	// or above, so the bones down to a depth are a prefix of mBonesByDepth.
+	std::vector<UINT> mBonesByDepth;
+	std::vector<UINT> mDepthBoneCounts;
    
 	std::unordered_map<std::string, AnimationClip> mAnimations;
 };
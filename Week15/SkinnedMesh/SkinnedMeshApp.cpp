@@ -12,6 +12,8 @@
 #include "Ssao.h"
 #include "SkinnedData.h"
 #include "LoadM3d.h"
+#include "CrowdAnimator.h"
+#include "AnimationCompression.h"
 
 using Microsoft::WRL::ComPtr;
 using namespace DirectX;
@@ -19,29 +21,9 @@ using namespace DirectX::PackedVector;
 
 const int gNumFrameResources = 3;
 
-struct SkinnedModelInstance
-{
-    SkinnedData* SkinnedInfo = nullptr;
-    std::vector<DirectX::XMFLOAT4X4> FinalTransforms;
-    std::string ClipName;
-    float TimePos = 0.0f;
-
-    // Called every frame and increments the time position, interpolates the 
-    // animations for each bone based on the current animation clip, and 
-    // generates the final transforms which are ultimately set to the effect
-    // for processing in the vertex shader.
-    void UpdateSkinnedAnimation(float dt)
-    {
-        TimePos += dt;
-
-        // Loop animation
-        if(TimePos > SkinnedInfo->GetClipEndTime(ClipName))
-            TimePos = 0.0f;
-
-        // Compute the final transforms for this time position.
-        SkinnedInfo->GetFinalTransforms(ClipName, TimePos, FinalTransforms);
-    }
-};
+// The soldiers are laid out on a gCrowdRows x gCrowdColumns grid.
+const int gCrowdRows = 10;
+const int gCrowdColumns = 10;
 
 // Lightweight structure stores parameters to draw a shape.  This will
 // vary from app-to-app.
@@ -187,7 +169,8 @@ private:
 
     UINT mSkinnedSrvHeapStart = 0;
     std::string mSkinnedModelFilename = "Models\\soldier.m3d";
-    std::unique_ptr<SkinnedModelInstance> mSkinnedModelInst; 
+    std::vector<std::unique_ptr<SkinnedModelInstance>> mSkinnedModelInsts;
+    CrowdAnimator mCrowd;
     SkinnedData mSkinnedInfo;
     std::vector<M3DLoader::Subset> mSkinnedSubsets;
     std::vector<M3DLoader::M3dMaterial> mSkinnedMats;
@@ -591,17 +574,13 @@ void SkinnedMeshApp::UpdateObjectCBs(const GameTimer& gt)
 void SkinnedMeshApp::UpdateSkinnedCBs(const GameTimer& gt)
 {
     auto currSkinnedCB = mCurrFrameResource->SkinnedCB.get();
-   
-    // We only have one skinned model being animated.
-    mSkinnedModelInst->UpdateSkinnedAnimation(gt.DeltaTime());
-        
-    SkinnedConstants skinnedConstants;
-    std::copy(
-        std::begin(mSkinnedModelInst->FinalTransforms),
-        std::end(mSkinnedModelInst->FinalTransforms),
-        &skinnedConstants.BoneTransforms[0]);
-
-    currSkinnedCB->CopyData(0, skinnedConstants);
+
+    // Distant soldiers are evaluated less often and with fewer bones.
+    mCrowd.SetEyePosW(mCamera.GetPosition3f());
+
+    // Animates every soldier on the worker threads and writes the palettes
+    // directly into this frame's skinned constant buffer.
+    mCrowd.Update(gt.DeltaTime(), currSkinnedCB);
 }
  
 void SkinnedMeshApp::UpdateMaterialBuffer(const GameTimer& gt)
@@ -1283,11 +1262,40 @@ void SkinnedMeshApp::LoadSkinnedModel()
 	m3dLoader.LoadM3d(mSkinnedModelFilename, vertices, indices, 
         mSkinnedSubsets, mSkinnedMats, mSkinnedInfo);
 
-    mSkinnedModelInst = std::make_unique<SkinnedModelInstance>();
-    mSkinnedModelInst->SkinnedInfo = &mSkinnedInfo;
-    mSkinnedModelInst->FinalTransforms.resize(mSkinnedInfo.BoneCount());
-    mSkinnedModelInst->ClipName = "Take1";
-    mSkinnedModelInst->TimePos = 0.0f;
+    // Every soldier samples the compressed clips from here on.
+    AnimationCompressionSettings compressionSettings;
+    AnimationCompressionStats compressionStats = mSkinnedInfo.CompressAnimations(compressionSettings);
+
+    std::wstring text =
+        L"***Animation compression: " + std::to_wstring(compressionStats.SourceBytes) +
+        L" -> " + std::to_wstring(compressionStats.CompressedBytes) + L" bytes, ratio " +
+        std::to_wstring(compressionStats.CompressionRatio()) + L", max bone error " +
+        std::to_wstring(compressionStats.MaxBoneError) + L"\n";
+    ::OutputDebugString(text.c_str());
+
+    float clipEndTime = mSkinnedInfo.GetClipEndTime("Take1");
+    for(int i = 0; i < gCrowdRows*gCrowdColumns; ++i)
+    {
+        auto skinnedModelInst = std::make_unique<SkinnedModelInstance>();
+        skinnedModelInst->SkinnedInfo = &mSkinnedInfo;
+        skinnedModelInst->SetClip("Take1");
+
+        // Start everyone at a different point in the clip so the crowd does
+        // not march in lock step.
+        skinnedModelInst->TimePos = MathHelper::RandF(0.0f, clipEndTime);
+        skinnedModelInst->PlaybackRate = MathHelper::RandF(0.8f, 1.2f);
+        skinnedModelInst->SkinnedCBIndex = (UINT)i;
+
+        // Same grid as BuildRenderItems.
+        int row = i / gCrowdColumns;
+        int col = i % gCrowdColumns;
+        skinnedModelInst->PositionW = XMFLOAT3(-6.75f + col*1.5f, 0.0f, -12.0f + row*1.5f);
+
+        mCrowd.AddInstance(skinnedModelInst.get());
+        mSkinnedModelInsts.push_back(std::move(skinnedModelInst));
+    }
+
+    mCrowd.EnableLod(AnimationLodSettings());
  
 	const UINT vbByteSize = (UINT)vertices.size() * sizeof(SkinnedVertex);
     const UINT ibByteSize = (UINT)indices.size()  * sizeof(std::uint16_t);
@@ -1540,7 +1548,7 @@ void SkinnedMeshApp::BuildFrameResources()
     {
         mFrameResources.push_back(std::make_unique<FrameResource>(md3dDevice.Get(),
             2, (UINT)mAllRitems.size(), 
-            1,
+            (UINT)mSkinnedModelInsts.size(),
             (UINT)mMaterials.size()));
     }
 }
@@ -1729,34 +1737,43 @@ void SkinnedMeshApp::BuildRenderItems()
 		mAllRitems.push_back(std::move(rightSphereRitem));
 	}
 
-    for(UINT i = 0; i < mSkinnedMats.size(); ++i)
+    for(int row = 0; row < gCrowdRows; ++row)
     {
-        std::string submeshName = "sm_" + std::to_string(i);
-
-        auto ritem = std::make_unique<RenderItem>();
-
-        // Reflect to change coordinate system from the RHS the data was exported out as.
-        XMMATRIX modelScale = XMMatrixScaling(0.05f, 0.05f, -0.05f);
-        XMMATRIX modelRot = XMMatrixRotationY(MathHelper::Pi);
-        XMMATRIX modelOffset = XMMatrixTranslation(0.0f, 0.0f, -5.0f);
-        XMStoreFloat4x4(&ritem->World, modelScale*modelRot*modelOffset);
-
-        ritem->TexTransform = MathHelper::Identity4x4();
-        ritem->ObjCBIndex = objCBIndex++;
-        ritem->Mat = mMaterials[mSkinnedMats[i].Name].get();
-        ritem->Geo = mGeometries[mSkinnedModelFilename].get();
-        ritem->PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-        ritem->IndexCount = ritem->Geo->DrawArgs[submeshName].IndexCount;
-        ritem->StartIndexLocation = ritem->Geo->DrawArgs[submeshName].StartIndexLocation;
-        ritem->BaseVertexLocation = ritem->Geo->DrawArgs[submeshName].BaseVertexLocation;
-
-        // All render items for this solider.m3d instance share
-        // the same skinned model instance.
-        ritem->SkinnedCBIndex = 0;
-        ritem->SkinnedModelInst = mSkinnedModelInst.get();
-
-        mRitemLayer[(int)RenderLayer::SkinnedOpaque].push_back(ritem.get());
-        mAllRitems.push_back(std::move(ritem));
+        for(int col = 0; col < gCrowdColumns; ++col)
+        {
+            SkinnedModelInstance* skinnedModelInst = mSkinnedModelInsts[row*gCrowdColumns + col].get();
+
+            // Reflect to change coordinate system from the RHS the data was exported out as.
+            XMMATRIX modelScale = XMMatrixScaling(0.05f, 0.05f, -0.05f);
+            XMMATRIX modelRot = XMMatrixRotationY(MathHelper::Pi);
+            XMMATRIX modelOffset = XMMatrixTranslation(-6.75f + col*1.5f, 0.0f, -12.0f + row*1.5f);
+
+            for(UINT i = 0; i < mSkinnedMats.size(); ++i)
+            {
+                std::string submeshName = "sm_" + std::to_string(i);
+
+                auto ritem = std::make_unique<RenderItem>();
+
+                XMStoreFloat4x4(&ritem->World, modelScale*modelRot*modelOffset);
+
+                ritem->TexTransform = MathHelper::Identity4x4();
+                ritem->ObjCBIndex = objCBIndex++;
+                ritem->Mat = mMaterials[mSkinnedMats[i].Name].get();
+                ritem->Geo = mGeometries[mSkinnedModelFilename].get();
+                ritem->PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+                ritem->IndexCount = ritem->Geo->DrawArgs[submeshName].IndexCount;
+                ritem->StartIndexLocation = ritem->Geo->DrawArgs[submeshName].StartIndexLocation;
+                ritem->BaseVertexLocation = ritem->Geo->DrawArgs[submeshName].BaseVertexLocation;
+
+                // All render items for this solider.m3d instance share
+                // the same skinned model instance.
+                ritem->SkinnedCBIndex = skinnedModelInst->SkinnedCBIndex;
+                ritem->SkinnedModelInst = skinnedModelInst;
+
+                mRitemLayer[(int)RenderLayer::SkinnedOpaque].push_back(ritem.get());
+                mAllRitems.push_back(std::move(ritem));
+            }
+        }
     }
 }
 